@@ -0,0 +1,435 @@
+// batch_runner.cpp
+#include "batch_runner.h"
+#include "meshutils/my_traits.h"
+#include "meshutils/decimation.h"
+#include "meshutils/remeshing.h"
+#include "meshutils/parameterization.h"
+#include "meshutils/geodesics.h"
+#include "meshutils/mesh_analysis.h"
+#include "meshutils/repair.h"
+#include "meshutils/self_intersection.h"
+#include "meshutils/point_grid.h"
+#include "meshutils/mesh_bvh.h"
+#include "meshutils/icp.h"
+#include "meshutils/surface_sampling.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace BatchRunner {
+
+    bool isBatchInvocation(int argc, char *argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--batch") == 0) return true;
+        }
+        return false;
+    }
+
+    int run(int argc, char *argv[]) {
+        QCoreApplication app(argc, argv);
+        QTextStream out(stdout);
+        QTextStream err(stderr);
+        
+        QCommandLineParser parser;
+        parser.setApplicationDescription("Headless mesh processing");
+        parser.addHelpOption();
+        parser.addPositionalArgument("input", "Input mesh file");
+        parser.addPositionalArgument("output", "Output mesh file");
+        QCommandLineOption batchOption("batch", "Run without GUI");
+        QCommandLineOption textureOption("texture", "Load and save texture coordinates (hvt_index)");
+        QCommandLineOption decimateOption("decimate", "Keep this fraction of the triangles (0-1)", "ratio");
+        QCommandLineOption targetOption("target-faces", "Decimate to this many triangles", "count");
+        QCommandLineOption blockOption("block-faces", "Maximum triangles per decimation block", "count");
+        QCommandLineOption noBoundaryOption("no-preserve-boundary", "Allow boundary vertices to move inward");
+        QCommandLineOption noSeamOption("no-preserve-seams", "Do not constrain texture seams");
+        QCommandLineOption remeshOption("remesh", "Isotropic remeshing to this edge length (0 = mean edge length)", "length");
+        QCommandLineOption remeshIterOption("remesh-iterations", "Isotropic remeshing iterations (default 10)", "count");
+        QCommandLineOption paramOption("parameterize", "Compute UVs of a disk-topology mesh (lscm or arap) and save them", "method");
+        QCommandLineOption arapIterOption("arap-iterations", "ARAP local/global iterations (default 10)", "count");
+        QCommandLineOption geodesicOption("geodesic-benchmark", "Time heat-method geodesics from this many single-vertex sources", "queries");
+        QCommandLineOption repairOption("repair", "Weld duplicate vertices, remove degenerate/duplicate faces and fill holes");
+        QCommandLineOption weldOption("weld-tolerance", "Repair weld distance (default 1e-6 x bounding box diagonal)", "distance");
+        QCommandLineOption holeOption("max-hole-edges", "Fill holes with at most this many edges (default 500, 0 = none)", "count");
+        QCommandLineOption noFairOption("no-fair", "Do not fair the filled holes");
+        QCommandLineOption analyzeOption("analyze", "Print components, boundary loops, genus, area and volume (after --repair)");
+        QCommandLineOption selfIntersectOption("self-intersections", "Report intersecting face pairs (after --repair)");
+        QCommandLineOption knnOption("knn-benchmark", "Time the vertex k-nearest-neighbour grid with this k", "k");
+        QCommandLineOption rayOption("ray-benchmark", "Time this many random BVH ray casts and check them by brute force", "rays");
+        QCommandLineOption sampleOption("sample", "Write this many area-weighted random surface samples to a PLY file", "count");
+        QCommandLineOption poissonOption("poisson-radius", "Write Poisson-disk surface samples with this minimum distance to a PLY file", "radius");
+        QCommandLineOption samplesPlyOption("samples-ply", "PLY file for --sample/--poisson-radius (default <output>.samples.ply)", "path");
+        QCommandLineOption alignOption("align", "Rigidly align the mesh to this target with point-to-plane ICP (after --repair)", "target");
+        parser.addOptions({batchOption, textureOption, decimateOption, targetOption, blockOption,
+                           noBoundaryOption, noSeamOption, remeshOption, remeshIterOption,
+                           paramOption, arapIterOption, geodesicOption, analyzeOption,
+                           repairOption, weldOption, holeOption, noFairOption, selfIntersectOption,
+                           knnOption, rayOption, alignOption, sampleOption, poissonOption, samplesPlyOption});
+        parser.process(app);
+        
+        const QStringList args = parser.positionalArguments();
+        if (args.size() != 2) {
+            err << "Expected <input> <output>\n";
+            return 1;
+        }
+        bool texture = parser.isSet(textureOption);
+        
+        QElapsedTimer timer;
+        timer.start();
+        Mesh mesh;
+        if (!Mesh_doubleIO::load_mesh(mesh, args[0].toLocal8Bit().constData(), texture)) {
+            err << "Failed to load " << args[0] << '\n';
+            return 1;
+        }
+        out << "Loaded " << mesh.n_vertices() << " vertices, " << mesh.n_faces() << " faces in "
+            << timer.elapsed() << " ms\n";
+        
+        // 修复放在分析和其他处理之前
+        if (parser.isSet(repairOption)) {
+            repair::Options options;
+            if (parser.isSet(weldOption)) {
+                options.weld_tolerance = parser.value(weldOption).toDouble();
+            }
+            if (parser.isSet(holeOption)) {
+                options.max_hole_edges = parser.value(holeOption).toULongLong();
+            }
+            options.fair_holes = !parser.isSet(noFairOption);
+            
+            repair::Stats stats;
+            if (!repair::repair(mesh, options, &stats)) {
+                err << "Repair failed (empty mesh)\n";
+                return 1;
+            }
+            out << "Repaired: welded " << stats.welded_vertices << " vertices (" << stats.weld_ms << " ms), removed "
+                << stats.degenerate_faces << " degenerate, " << stats.duplicate_faces << " duplicate and "
+                << stats.non_manifold_faces << " non-manifold faces (" << stats.clean_ms << " ms)\n";
+            out << "  filled " << stats.holes_filled << " holes with " << stats.hole_faces << " faces, skipped "
+                << stats.holes_skipped << " (" << stats.fill_ms << " ms, fairing " << stats.fair_ms << " ms)\n";
+        }
+        
+        // 配准在原始文件坐标系中进行，输出的是变换后的网格
+        if (parser.isSet(alignOption)) {
+            Mesh targetMesh;
+            if (!Mesh_doubleIO::load_mesh(targetMesh, parser.value(alignOption).toLocal8Bit().constData(), false)) {
+                err << "Failed to load alignment target " << parser.value(alignOption) << '\n';
+                return 1;
+            }
+            QElapsedTimer alignTimer;
+            alignTimer.start();
+            icp::Target target;
+            target.build(targetMesh);
+            double buildMs = alignTimer.nsecsElapsed() / 1.0e6;
+            
+            icp::Options options;
+            icp::Result result;
+            if (!icp::align(mesh, target, Eigen::Matrix4d::Identity(), options, result)) {
+                err << "Alignment failed (fewer than 6 correspondences)\n";
+                return 1;
+            }
+            Eigen::Matrix3d R = result.transform.block<3, 3>(0, 0);
+            Eigen::Vector3d t = result.transform.block<3, 1>(0, 3);
+            for (auto vh : mesh.vertices()) {
+                const Mesh::Point& p = mesh.point(vh);
+                Eigen::Vector3d q = R * Eigen::Vector3d(p[0], p[1], p[2]) + t;
+                mesh.set_point(vh, Mesh::Point(q[0], q[1], q[2]));
+            }
+            out << "Aligned: target " << target.points.size() << " vertices (" << buildMs << " ms), rms "
+                << result.initial_rms << " -> " << result.rms << " over " << result.correspondences << " pairs, "
+                << result.iterations << " iterations" << (result.converged ? "" : " (not converged)") << ", "
+                << result.ms << " ms\n";
+        }
+        
+        if (parser.isSet(analyzeOption)) {
+            mesh_analysis::Report report = mesh_analysis::analyze(mesh);
+            out << "Analysis (" << report.milliseconds << " ms): " << report.components << " components, "
+                << report.boundary_loops << " boundary loops, " << report.boundary_edges << " boundary edges, genus "
+                << report.genus << ", Euler characteristic " << report.euler_characteristic << "\n";
+            out << "  " << report.non_manifold_vertices << " non-manifold vertices, " << report.isolated_vertices
+                << " isolated vertices, " << report.degenerate_faces << " degenerate faces\n";
+            out << "  area " << report.area;
+            if (report.closed) {
+                out << ", volume " << report.volume;
+            }
+            out << "\n";
+        }
+        
+        if (parser.isSet(selfIntersectOption)) {
+            std::vector<std::pair<int, int>> pairs;
+            self_intersection::Stats stats;
+            self_intersection::find(mesh, pairs, &stats);
+            out << "Self-intersections: " << pairs.size() << " face pairs (" << stats.candidate_pairs
+                << " candidate triangle pairs, BVH " << stats.build_ms << " ms, tests " << stats.test_ms << " ms)\n";
+            for (size_t i = 0; i < pairs.size() && i < 20; ++i) {
+                out << "  faces " << pairs[i].first << " " << pairs[i].second << "\n";
+            }
+        }
+        
+        if (parser.isSet(decimateOption) || parser.isSet(targetOption)) {
+            decimation::Options options;
+            size_t triangleCount = 0;
+            for (auto fh : mesh.faces()) {
+                triangleCount += mesh.valence(fh) - 2;
+            }
+            if (parser.isSet(targetOption)) {
+                options.target_faces = parser.value(targetOption).toULongLong();
+            } else {
+                double ratio = parser.value(decimateOption).toDouble();
+                if (ratio <= 0.0 || ratio >= 1.0) {
+                    err << "--decimate expects a ratio between 0 and 1\n";
+                    return 1;
+                }
+                options.target_faces = size_t(triangleCount * ratio);
+            }
+            if (parser.isSet(blockOption)) {
+                options.max_block_faces = std::max<size_t>(1, parser.value(blockOption).toULongLong());
+            }
+            options.preserve_boundary = !parser.isSet(noBoundaryOption);
+            options.preserve_seams = !parser.isSet(noSeamOption);
+            
+            decimation::Stats stats;
+            if (!decimation::decimate(mesh, options, &stats)) {
+                err << "Decimation failed\n";
+                return 1;
+            }
+            out << "Decimated " << stats.input_faces << " -> " << stats.output_faces << " triangles, "
+                << stats.blocks << " blocks (block phase " << stats.block_ms << " ms, border pass "
+                << stats.border_ms << " ms)\n";
+        }
+        
+        if (parser.isSet(remeshOption)) {
+            remeshing::Options options;
+            options.target_length = parser.value(remeshOption).toDouble();
+            if (parser.isSet(remeshIterOption)) {
+                options.iterations = parser.value(remeshIterOption).toInt();
+            }
+            options.preserve_boundary = !parser.isSet(noBoundaryOption);
+            
+            remeshing::Stats stats;
+            if (!remeshing::isotropic_remesh(mesh, options, &stats)) {
+                err << "Remeshing failed\n";
+                return 1;
+            }
+            out << "Remeshed to edge length " << stats.target_length << ", " << mesh.n_faces() << " faces\n";
+            for (size_t i = 0; i < stats.passes.size(); ++i) {
+                const remeshing::PassTiming& pass = stats.passes[i];
+                out << "  pass " << i << ": split " << pass.split_ms << " ms, collapse " << pass.collapse_ms
+                    << " ms, flip " << pass.flip_ms << " ms, relax " << pass.relax_ms << " ms\n";
+            }
+        }
+        
+        if (parser.isSet(paramOption)) {
+            parameterization::Options options;
+            QString method = parser.value(paramOption).toLower();
+            if (method == "arap") {
+                options.method = parameterization::Method::arap;
+            } else if (method != "lscm") {
+                err << "--parameterize expects lscm or arap\n";
+                return 1;
+            }
+            if (parser.isSet(arapIterOption)) {
+                options.arap_iterations = parser.value(arapIterOption).toInt();
+            }
+            
+            parameterization::Parameterizer parameterizer;
+            parameterization::Stats stats;
+            if (!parameterizer.compute(mesh, options, &stats)) {
+                err << "Parameterization failed (triangle mesh with disk topology required)\n";
+                return 1;
+            }
+            out << "Parameterized: setup " << stats.setup_ms << " ms, factorize " << stats.factorize_ms
+                << " ms, solve " << stats.solve_ms << " ms, local " << stats.local_ms << " ms, "
+                << stats.flipped_faces << " flipped faces\n";
+            texture = true;
+        }
+        
+        if (parser.isSet(geodesicOption) && mesh.n_vertices() == 0) {
+            // 源点按顶点数取模，前面的步骤可能把网格删空
+            err << "Skipping geodesic benchmark: mesh has no vertices\n";
+        } else if (parser.isSet(geodesicOption)) {
+            // 第一次查询包含分解，之后每次只有两次回代和梯度/散度
+            int queries = std::max(1, parser.value(geodesicOption).toInt());
+            geodesics::HeatSolver solver;
+            std::vector<double> distance;
+            double queryTotal = 0.0;
+            double queryMax = 0.0;
+            for (int q = 0; q < queries; ++q) {
+                std::vector<unsigned int> sources(1, (unsigned int)((size_t(q) * 7919 * 104729) % mesh.n_vertices()));
+                geodesics::Stats stats;
+                if (!solver.compute(mesh, sources, distance, &stats)) {
+                    err << "Geodesic distance failed (triangle mesh required)\n";
+                    return 1;
+                }
+                double query = stats.heat_ms + stats.gradient_ms + stats.poisson_ms;
+                if (q == 0) {
+                    out << "Geodesics: t = " << stats.time_step << ", setup " << stats.setup_ms
+                        << " ms, factorize " << stats.factorize_ms << " ms\n";
+                }
+                out << "  query " << q << ": heat " << stats.heat_ms << " ms, gradient " << stats.gradient_ms
+                    << " ms, poisson " << stats.poisson_ms << " ms\n";
+                queryTotal += query;
+                queryMax = std::max(queryMax, query);
+            }
+            out << "Geodesic query latency: mean " << queryTotal / queries << " ms, max " << queryMax << " ms\n";
+        }
+        
+        if (parser.isSet(knnOption)) {
+            // 所有顶点作为查询点做批量k近邻，再抽样和暴力搜索对比
+            int k = std::max(1, parser.value(knnOption).toInt());
+            std::vector<OpenMesh::Vec3d> points(mesh.n_vertices());
+            for (auto vh : mesh.vertices()) {
+                points[vh.idx()] = mesh.point(vh);
+            }
+            PointGrid grid;
+            QElapsedTimer knnTimer;
+            knnTimer.start();
+            grid.build(points);
+            double buildMs = knnTimer.nsecsElapsed() / 1.0e6;
+            
+            std::vector<int> ids;
+            std::vector<double> dist2;
+            knnTimer.restart();
+            grid.knn_batch(points, k, ids, dist2);
+            double queryMs = knnTimer.nsecsElapsed() / 1.0e6;
+            
+            // 半径取第一个顶点的第k近距离
+            double r = dist2.empty() || !std::isfinite(dist2[k - 1]) ? 0.0 : std::sqrt(dist2[k - 1]);
+            std::vector<unsigned int> offsets, found;
+            knnTimer.restart();
+            grid.radius_batch(points, r, offsets, found);
+            double radiusMs = knnTimer.nsecsElapsed() / 1.0e6;
+            
+            size_t mismatches = 0, checked = 0;
+            std::vector<double> all(points.size());
+            for (size_t q = 0; q < points.size(); q += std::max<size_t>(1, points.size() / 100)) {
+                for (size_t i = 0; i < points.size(); ++i) {
+                    all[i] = (points[i] - points[q]).sqrnorm();
+                }
+                size_t kk = std::min(all.size(), size_t(k));
+                std::partial_sort(all.begin(), all.begin() + kk, all.end());
+                for (size_t j = 0; j < kk; ++j) {
+                    if (all[j] != dist2[q * k + j]) mismatches++;
+                }
+                checked++;
+            }
+            out << "k-NN grid: " << points.size() << " points in " << grid.cell_count() << " cells of size "
+                << grid.cell_size() << ", build " << buildMs << " ms\n";
+            out << "  " << k << "-NN of every vertex: " << queryMs << " ms ("
+                << (queryMs > 0.0 ? points.size() / queryMs / 1000.0 : 0.0) << " M queries/s)\n";
+            out << "  radius " << r << " around every vertex: " << radiusMs << " ms, " << found.size() << " hits\n";
+            out << "  brute-force check on " << checked << " queries: " << mismatches << " mismatches\n";
+        }
+        
+        if (parser.isSet(rayOption) && mesh.n_faces() > 0) {
+            // 包围盒外的随机点射向盒内的随机点，与逐三角形求交的最近距离对比
+            int rays = std::max(1, parser.value(rayOption).toInt());
+            QElapsedTimer rayTimer;
+            rayTimer.start();
+            MeshBVH bvh;
+            bvh.build(mesh);
+            double buildMs = rayTimer.nsecsElapsed() / 1.0e6;
+            
+            Mesh::Point lo = mesh.point(*mesh.vertices_begin()), hi = lo;
+            for (auto vh : mesh.vertices()) {
+                lo.minimize(mesh.point(vh));
+                hi.maximize(mesh.point(vh));
+            }
+            Mesh::Point extent = hi - lo;
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            auto randomIn = [&](double margin) {
+                return Mesh::Point(lo[0] - margin * extent[0] + (1.0 + 2.0 * margin) * extent[0] * unit(rng),
+                                   lo[1] - margin * extent[1] + (1.0 + 2.0 * margin) * extent[1] * unit(rng),
+                                   lo[2] - margin * extent[2] + (1.0 + 2.0 * margin) * extent[2] * unit(rng));
+            };
+            std::vector<OpenMesh::Vec3d> origins(rays), dirs(rays);
+            for (int i = 0; i < rays; ++i) {
+                origins[i] = randomIn(1.0);
+                dirs[i] = randomIn(0.0) - origins[i];
+            }
+            
+            std::vector<MeshBVH::Hit> hits(rays);
+            std::vector<unsigned char> found(rays, 0);
+            rayTimer.restart();
+            for (int i = 0; i < rays; ++i) {
+                found[i] = bvh.ray_cast(origins[i], dirs[i], hits[i]);
+            }
+            double castMs = rayTimer.nsecsElapsed() / 1.0e6;
+            
+            // 双面Moller-Trumbore，与MeshBVH相同的判定
+            size_t mismatches = 0, hitCount = 0;
+            rayTimer.restart();
+            for (int i = 0; i < rays; ++i) {
+                double best = std::numeric_limits<double>::max();
+                for (size_t tri = 0; tri < bvh.triangle_count(); ++tri) {
+                    const unsigned int* v = bvh.triangle_vertices(int(tri));
+                    OpenMesh::Vec3d e1 = bvh.vertex(v[1]) - bvh.vertex(v[0]);
+                    OpenMesh::Vec3d e2 = bvh.vertex(v[2]) - bvh.vertex(v[0]);
+                    OpenMesh::Vec3d p = dirs[i] % e2;
+                    double det = e1 | p;
+                    if (std::fabs(det) < 1e-20) continue;
+                    double invDet = 1.0 / det;
+                    OpenMesh::Vec3d s0 = origins[i] - bvh.vertex(v[0]);
+                    double u = (s0 | p) * invDet;
+                    if (u < 0.0 || u > 1.0) continue;
+                    OpenMesh::Vec3d q = s0 % e1;
+                    double w = (dirs[i] | q) * invDet;
+                    if (w < 0.0 || u + w > 1.0) continue;
+                    double t = (e2 | q) * invDet;
+                    if (t >= 0.0 && t < best) best = t;
+                }
+                bool bruteHit = best < std::numeric_limits<double>::max();
+                if (bruteHit) hitCount++;
+                if (bruteHit != bool(found[i]) || (bruteHit && std::abs(hits[i].t - best) > 1e-9 * std::max(1.0, best))) {
+                    mismatches++;
+                }
+            }
+            double bruteMs = rayTimer.nsecsElapsed() / 1.0e6;
+            out << "Ray BVH: " << bvh.triangle_count() << " triangles, build " << buildMs << " ms\n";
+            out << "  " << rays << " random rays (" << hitCount << " hits): " << castMs * 1000.0 / rays
+                << " us/ray, brute force " << bruteMs * 1000.0 / rays << " us/ray, " << mismatches << " mismatches\n";
+        }
+        
+        if (parser.isSet(sampleOption) || parser.isSet(poissonOption)) {
+            surface_sampling::Samples samples;
+            surface_sampling::Stats stats;
+            bool ok;
+            if (parser.isSet(poissonOption)) {
+                surface_sampling::PoissonOptions options;
+                options.radius = parser.value(poissonOption).toDouble();
+                ok = surface_sampling::poisson_disk(mesh, options, samples, &stats);
+            } else {
+                ok = surface_sampling::random(mesh, size_t(std::max(1LL, parser.value(sampleOption).toLongLong())), 1, samples, &stats);
+            }
+            if (!ok) {
+                err << "Surface sampling failed (mesh has no area or invalid radius)\n";
+                return 1;
+            }
+            QString plyPath = parser.isSet(samplesPlyOption) ? parser.value(samplesPlyOption) : args[1] + ".samples.ply";
+            if (!surface_sampling::write_ply(plyPath.toLocal8Bit().constData(), samples)) {
+                err << "Failed to write " << plyPath << '\n';
+                return 1;
+            }
+            out << "Sampled " << samples.size() << " points (area " << stats.area << ", setup " << stats.setup_ms
+                << " ms, sampling " << stats.sample_ms << " ms";
+            if (stats.candidates > 0) {
+                out << ", " << stats.candidates << " candidates in " << stats.rounds << " rounds, selection "
+                    << stats.select_ms << " ms";
+            }
+            out << ") to " << plyPath << "\n";
+        }
+        
+        timer.restart();
+        if (!Mesh_doubleIO::save_mesh(mesh, args[1].toLocal8Bit().constData(), texture)) {
+            err << "Failed to save " << args[1] << '\n';
+            return 1;
+        }
+        out << "Saved " << args[1] << " in " << timer.elapsed() << " ms\n";
+        return 0;
+    }
+
+} // namespace BatchRunner
@@ -0,0 +1,15 @@
+// batch_runner.h
+#pragma once
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+// 无界面批处理模式：objViewer --batch <input> <output> [操作...]
+// 不创建窗口和OpenGL上下文，只依赖meshutils中的算法
+namespace BatchRunner {
+    // 命令行中是否带有--batch，需在创建QApplication之前判断
+    bool isBatchInvocation(int argc, char *argv[]);
+    // 执行批处理，返回进程退出码
+    int run(int argc, char *argv[]);
+}
+
+#endif // BATCH_RUNNER_H
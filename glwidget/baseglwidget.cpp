@@ -1,5 +1,11 @@
 // baseglwidget.cpp
 #include "baseglwidget.h"
+#include "shader_utils.h"
+#include "../meshutils/parallel_utils.h"
+#include "../meshutils/decimation.h"
+#include "../meshutils/remeshing.h"
+#include "../meshutils/repair.h"
+#include "../meshutils/self_intersection.h"
 #include <QFile>
 #include <QDebug>
 #include <QMouseEvent>
@@ -14,7 +20,11 @@
 #include <QPainter>
 #include <QFont>
 #include <cfloat>
+#include <cmath>
 #include <set>
+#include <limits>
+#include <QElapsedTimer>
+#include <QFileInfo>
 
 BaseGLWidget::BaseGLWidget(QWidget *parent) : QOpenGLWidget(parent),
     vbo(QOpenGLBuffer::VertexBuffer),
@@ -23,7 +33,18 @@ BaseGLWidget::BaseGLWidget(QWidget *parent) : QOpenGLWidget(parent),
     axisVbo(QOpenGLBuffer::VertexBuffer),
     axisEbo(QOpenGLBuffer::IndexBuffer),
     showWireframeOverlay(true),
-    hideFaces(false)
+    hideFaces(false),
+    highlightEbo(QOpenGLBuffer::IndexBuffer),
+    selectionEbo(QOpenGLBuffer::IndexBuffer),
+    previewVbo(QOpenGLBuffer::VertexBuffer),
+    previewEbo(QOpenGLBuffer::IndexBuffer),
+    previewEdgeEbo(QOpenGLBuffer::IndexBuffer),
+    uvVbo(QOpenGLBuffer::VertexBuffer),
+    uvEbo(QOpenGLBuffer::IndexBuffer),
+    scalarVbo(QOpenGLBuffer::VertexBuffer),
+    targetVbo(QOpenGLBuffer::VertexBuffer),
+    targetEbo(QOpenGLBuffer::IndexBuffer),
+    sampleVbo(QOpenGLBuffer::VertexBuffer)
 {
     QSurfaceFormat format;
     format.setSamples(4);
@@ -31,6 +52,13 @@ BaseGLWidget::BaseGLWidget(QWidget *parent) : QOpenGLWidget(parent),
     setFormat(format);
     
     setFocusPolicy(Qt::StrongFocus);
+    
+    renderScheduler = new RenderScheduler(this);
+    renderScheduler->setStateHashFunction([this]() { return renderStateHash(); });
+    
+    pickPollTimer.setInterval(1);
+    connect(&pickPollTimer, &QTimer::timeout, this, &BaseGLWidget::pollPickResults);
+    
     rotation = QQuaternion();
     zoom = 1.0f;
     modelLoaded = false;
@@ -56,30 +84,65 @@ BaseGLWidget::BaseGLWidget(QWidget *parent) : QOpenGLWidget(parent),
 
 void BaseGLWidget::setShowAxis(bool show) {
     showAxis = show;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::setViewScale(float scale) {
     viewScale = scale;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::setHideFaces(bool hide) {
     hideFaces = hide;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::setShowWireframeOverlay(bool show) {
     showWireframeOverlay = show;
-    update();
+    requestRedraw();
+}
+
+void BaseGLWidget::setRenderMode(RenderMode mode) {
+    currentRenderMode = mode;
+    requestRedraw();
+}
+
+void BaseGLWidget::requestRedraw() {
+    renderScheduler->requestUpdate();
+}
+
+void BaseGLWidget::setMaxInteractiveFps(int fps) {
+    renderScheduler->setMaxInteractiveFps(fps);
+}
+
+quint64 BaseGLWidget::renderStateHash() const {
+    // 所有影响画面的状态；网格和缓冲区的变化通过markDirty()单独标记
+    RenderStateHash h;
+    h.add(rotation).add(zoom).add(modelCenter).add(viewDistance).add(viewScale)
+     .add(bgColor).add(surfaceColor).add(wireframeColor).add(specularEnabled)
+     .add(int(currentRenderMode)).add(int(overlayStyle))
+     .add(showWireframeOverlay).add(hideFaces).add(showAxis).add(modelLoaded)
+     .add(int(highlightMode)).add(highlightIndex).add(showSubdivisionPreview)
+     .add(showUVView).add(showDistanceField).add(isolineCount).add(alignmentRevision)
+     .add(targetIndexCount).add(samplePointCount).add(showSamples)
+     .add(quint64(pointCloud.pointCount())).add(quint64(pointCloud.pointBudget())).add(pointCloud.pointSizeScale())
+     .add(pointCloud.normalShadingEnabled()).add(pointCloud.vertexColorsEnabled())
+     .add(scene.revision()).add(size());
+    return h.value();
+}
+
+void BaseGLWidget::setWireframeOverlayStyle(OverlayStyle style) {
+    overlayStyle = style;
+    requestRedraw();
 }
 
 void BaseGLWidget::setWireframeColor(const QVector4D& color) {
     wireframeColor = color;
-    update();
+    requestRedraw();
 }
 
 BaseGLWidget::~BaseGLWidget() {
+    waitForMeshAnalysis();
     makeCurrent();
     vao.destroy();
     vbo.destroy();
@@ -87,6 +150,26 @@ BaseGLWidget::~BaseGLWidget() {
     faceEbo.destroy();
     axisVbo.destroy();
     axisEbo.destroy();
+    if (edgeMaskBuffer) {
+        glDeleteBuffers(1, &edgeMaskBuffer);
+    }
+    if (faceColorBuffer) {
+        glDeleteBuffers(1, &faceColorBuffer);
+    }
+    highlightEbo.destroy();
+    selectionEbo.destroy();
+    previewVao.destroy();
+    previewVbo.destroy();
+    previewEbo.destroy();
+    previewEdgeEbo.destroy();
+    targetVao.destroy();
+    targetVbo.destroy();
+    targetEbo.destroy();
+    sampleVao.destroy();
+    sampleVbo.destroy();
+    pointCloud.release();
+    scene.release();
+    releasePickResources();
     doneCurrent();
 }
 
@@ -96,7 +179,7 @@ void BaseGLWidget::resetView() {
     modelCenter = initialModelCenter;
     viewDistance = initialViewDistance;
     viewScale = initialViewScale;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::setBackgroundColor(const QColor& color) {
@@ -104,13 +187,16 @@ void BaseGLWidget::setBackgroundColor(const QColor& color) {
     makeCurrent();
     glClearColor(bgColor.redF(), bgColor.greenF(), bgColor.blueF(), bgColor.alphaF());
     doneCurrent();
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::initializeGL() {
     initializeOpenGLFunctions();
     qDebug() << "OpenGL initialized. Version:" << (const char*)glGetString(GL_VERSION);
     qDebug() << "OpenGL renderer:" << (const char*)glGetString(GL_RENDERER);
+    QString renderer = QString::fromLatin1((const char*)glGetString(GL_RENDERER)).toLower();
+    softwareRenderer = renderer.contains("llvmpipe") || renderer.contains("softpipe")
+                       || renderer.contains("swiftshader") || renderer.contains("software");
     glClearColor(bgColor.redF(), bgColor.greenF(), bgColor.blueF(), bgColor.alphaF());
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
@@ -119,6 +205,25 @@ void BaseGLWidget::initializeGL() {
     vbo.create();
     ebo.create();
     faceEbo.create();
+    glGenBuffers(1, &edgeMaskBuffer);
+    glGenBuffers(1, &faceColorBuffer);
+    highlightEbo.create();
+    selectionEbo.create();
+    previewVao.create();
+    previewVbo.create();
+    previewEbo.create();
+    previewEdgeEbo.create();
+    uvVao.create();
+    uvVbo.create();
+    uvEbo.create();
+    scalarVbo.create();
+    targetVao.create();
+    targetVbo.create();
+    targetEbo.create();
+    sampleVao.create();
+    sampleVbo.create();
+    pointCloud.initialize();
+    scene.initialize();
     
     axisVbo.create();
     axisEbo.create();
@@ -170,6 +275,51 @@ void BaseGLWidget::initializeShaders() {
     flatProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/flat.frag");
     flatProgram.link();
 
+    // 单遍重心坐标线框：同一份着色器加几何着色器编译出的变体，
+    // 链接失败（驱动不支持几何着色器）时退回GL_LINES叠加
+    blinnPhongWireProgram.removeAllShaders();
+    flatWireProgram.removeAllShaders();
+    
+    blinnPhongWireProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/blinnphong.vert");
+    ShaderUtils::addShaderWithDefines(blinnPhongWireProgram, QOpenGLShader::Geometry, ":/glwidget/shaders/wireframe_overlay.geom", QByteArray());
+    ShaderUtils::addShaderWithDefines(blinnPhongWireProgram, QOpenGLShader::Fragment, ":/glwidget/shaders/blinnphong.frag", "#define BARY_WIREFRAME\n");
+    
+    flatWireProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/flat.vert");
+    ShaderUtils::addShaderWithDefines(flatWireProgram, QOpenGLShader::Geometry, ":/glwidget/shaders/wireframe_overlay.geom", "#define NO_NORMAL\n");
+    ShaderUtils::addShaderWithDefines(flatWireProgram, QOpenGLShader::Fragment, ":/glwidget/shaders/flat.frag", "#define BARY_WIREFRAME\n");
+    
+    baryOverlayAvailable = blinnPhongWireProgram.link() && flatWireProgram.link();
+    if (!baryOverlayAvailable) {
+        qWarning() << "Barycentric wireframe overlay unavailable, falling back to GL_LINES";
+    }
+
+    // 拾取着色器：顶点用gl_VertexID，面和边用gl_PrimitiveID
+    pickVertexProgram.removeAllShaders();
+    pickPrimitiveProgram.removeAllShaders();
+    
+    pickVertexProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/picking.vert");
+    pickVertexProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/picking.frag");
+    pickVertexProgram.link();
+    
+    pickPrimitiveProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/picking.vert");
+    pickPrimitiveProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/face_picking.frag");
+    pickPrimitiveProgram.link();
+
+    subdivisionProgram.removeAllShaders();
+    subdivisionProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/loop_subdivision.vert");
+    subdivisionProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/loop_subdivision.frag");
+    subdivisionProgram.link();
+
+    uvProgram.removeAllShaders();
+    uvProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/uv_vertex.glsl");
+    uvProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/uv_fragment.glsl");
+    uvProgram.link();
+
+    distanceProgram.removeAllShaders();
+    distanceProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/curvature.vert");
+    distanceProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/curvature.frag");
+    distanceProgram.link();
+
     if (modelLoaded) {
         updateBuffersFromOpenMesh();
     }
@@ -179,7 +329,6 @@ void BaseGLWidget::updateBuffersFromOpenMesh() {
     if (openMesh.n_vertices() == 0) return;
     
     std::vector<float> vertices(openMesh.n_vertices() * 3);
-    std::vector<float> normals(openMesh.n_vertices() * 3);
     
     for (auto vh : openMesh.vertices()) {
         int idx = vh.idx();
@@ -187,21 +336,17 @@ void BaseGLWidget::updateBuffersFromOpenMesh() {
         vertices[idx*3]   = p[0];
         vertices[idx*3+1] = p[1];
         vertices[idx*3+2] = p[2];
-        
-        const auto& n = openMesh.normal(vh);
-        normals[idx*3]   = n[0];
-        normals[idx*3+1] = n[1];
-        normals[idx*3+2] = n[2];
     }
     
     vao.bind();
     vbo.bind();
     
+    // 法线区域先只分配不写入，由ensureVertexNormals按需填充
     int vertexSize = vertices.size() * sizeof(float);
-    int normalSize = normals.size() * sizeof(float);
+    int normalSize = vertexSize;
     vbo.allocate(vertexSize + normalSize);
     vbo.write(0, vertices.data(), vertexSize);
-    vbo.write(vertexSize, normals.data(), normalSize);
+    vertexNormalsUploaded = false;
     
     wireframeProgram.bind();
     int posLoc = wireframeProgram.attributeLocation("aPos");
@@ -223,13 +368,82 @@ void BaseGLWidget::updateBuffersFromOpenMesh() {
         blinnPhongProgram.setAttributeBuffer(normalLoc, GL_FLOAT, vertexSize, 3, 3 * sizeof(float));
     }
 
-    ebo.bind();
-    ebo.allocate(edges.data(), edges.size() * sizeof(unsigned int));
-    
     faceEbo.bind();
     faceEbo.allocate(faces.data(), faces.size() * sizeof(unsigned int));
     
+    // 距离场属性对应旧的顶点，重新计算后再启用
+    glDisableVertexAttribArray(2);
+    distanceFieldUploaded = false;
+    
+    vao.release();
+    
+    // 边索引在需要时才生成上传
+    edgesUploaded = false;
+    
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, edgeMaskBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, triangleEdgeMasks.size() * sizeof(unsigned int),
+                 triangleEdgeMasks.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    
+    renderScheduler->markDirty();
+}
+
+void BaseGLWidget::ensureEdgeIndices() {
+    if (edgesUploaded) return;
+    
+    edges.clear();
+    prepareEdgeIndices();
+    
+    vao.bind();
+    ebo.bind();
+    ebo.allocate(edges.data(), edges.size() * sizeof(unsigned int));
     vao.release();
+    edgesUploaded = true;
+}
+
+void BaseGLWidget::setWireOverlayUniforms(QOpenGLShaderProgram& program) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, edgeMaskBuffer);
+    program.setUniformValue("useEdgeMasks", !triangleEdgeMasks.empty());
+    program.setUniformValue("lineColor", wireframeColor);
+    program.setUniformValue("lineWidth", 1.5f);
+}
+
+void BaseGLWidget::setFaceColorUniforms(QOpenGLShaderProgram& program) {
+    bool enabled = !triangleColors.empty() && triangleColors.size() * 3 == faces.size();
+    if (enabled) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, faceColorBuffer);
+    }
+    program.setUniformValue("faceColorsEnabled", enabled);
+}
+
+void BaseGLWidget::ensureVertexNormals() {
+    if (vertexNormalsUploaded || openMesh.n_vertices() == 0) return;
+    
+    // 新增属性会改动属性容器，不能和分析线程同时进行
+    waitForMeshAnalysis();
+    if (!openMesh.has_vertex_normals()) {
+        openMesh.request_vertex_normals();
+    }
+    if (!openMesh.has_face_normals()) {
+        openMesh.request_face_normals();
+    }
+    openMesh.update_normals();
+    
+    std::vector<float> normals(openMesh.n_vertices() * 3);
+    for (auto vh : openMesh.vertices()) {
+        int idx = vh.idx();
+        const auto& n = openMesh.normal(vh);
+        normals[idx*3]   = n[0];
+        normals[idx*3+1] = n[1];
+        normals[idx*3+2] = n[2];
+    }
+    
+    // 法线区域紧跟在位置区域之后，两者大小相同
+    int size = normals.size() * sizeof(float);
+    vbo.bind();
+    vbo.write(size, normals.data(), size);
+    vbo.release();
+    vertexNormalsUploaded = true;
 }
 
 void BaseGLWidget::resizeGL(int w, int h) {
@@ -237,21 +451,30 @@ void BaseGLWidget::resizeGL(int w, int h) {
 }
 
 void BaseGLWidget::paintGL() {
+    renderScheduler->frameStarted();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    if (!pointCloud.empty()) {
+        drawPointCloud();
+        renderScheduler->frameFinished();
+        return;
+    }
+
     if (!modelLoaded || openMesh.n_vertices() == 0) {
+        if (!scene.empty()) {
+            QMatrix4x4 model, view, projection;
+            computeViewMatrices(model, view, projection);
+            drawScene(view, projection);
+            if (showAxis) {
+                drawXYZAxis(view, projection);
+            }
+        }
+        renderScheduler->frameFinished();
         return;
     }
 
     QMatrix4x4 model, view, projection;
-    
-    model.rotate(rotation);
-    model.scale(zoom);
-    
-    QVector3D eyePosition(0, 0, viewDistance * viewScale);
-    view.lookAt(eyePosition, modelCenter, QVector3D(0, 1, 0));
-    
-    projection.perspective(45.0f, width() / float(height()), 0.1f, 100.0f);
+    computeViewMatrices(model, view, projection);
     
     QMatrix3x3 normalMatrix = model.normalMatrix();
 
@@ -270,74 +493,139 @@ void BaseGLWidget::paintGL() {
         QVector3D(1.0f, 1.0f, 1.0f)
     };
 
-    if (hideFaces) {
+    bool drawField = showDistanceField && !geodesicDistance.empty();
+
+    // 重心坐标线框：线框在填充同一遍中画出，仅对Blinn-Phong/平面着色有效
+    bool singlePassOverlay = showWireframeOverlay && overlayStyle == BarycentricOverlay
+                             && baryOverlayAvailable && !drawField
+                             && (currentRenderMode == BlinnPhong || currentRenderMode == FlatShading);
+
+    if (showSubdivisionPreview) {
+        drawSubdivisionPreview(model, view, projection);
+    } else if (hideFaces) {
         drawWireframe(model, view, projection);
     } else {
-        if (currentRenderMode == BlinnPhong) {
-            blinnPhongProgram.bind();
+        if (drawField) {
+            drawDistanceField(model, view, projection);
+        } else if (currentRenderMode == BlinnPhong) {
+            ensureVertexNormals();
+            QOpenGLShaderProgram& program = singlePassOverlay ? blinnPhongWireProgram : blinnPhongProgram;
+            program.bind();
             vao.bind();
             faceEbo.bind();
             
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            blinnPhongProgram.setUniformValue("model", model);
-            blinnPhongProgram.setUniformValue("view", view);
-            blinnPhongProgram.setUniformValue("projection", projection);
-            blinnPhongProgram.setUniformValue("normalMatrix", normalMatrix);
+            program.setUniformValue("model", model);
+            program.setUniformValue("view", view);
+            program.setUniformValue("projection", projection);
+            program.setUniformValue("normalMatrix", normalMatrix);
             
             // 设置三个光源的位置和颜色
             for (int i = 0; i < 3; i++) {
-                blinnPhongProgram.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
-                blinnPhongProgram.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
+                program.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+                program.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
             }
             
-            blinnPhongProgram.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
-            blinnPhongProgram.setUniformValue("objectColor", surfaceColor);
-            blinnPhongProgram.setUniformValue("specularEnabled", specularEnabled);
+            program.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
+            program.setUniformValue("objectColor", surfaceColor);
+            program.setUniformValue("specularEnabled", specularEnabled);
+            setFaceColorUniforms(program);
+            if (singlePassOverlay) {
+                setWireOverlayUniforms(program);
+            }
 
             glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
 
             faceEbo.release();
             vao.release();
-            blinnPhongProgram.release();
+            program.release();
         } else if (currentRenderMode == FlatShading) {
-            flatProgram.bind();
+            QOpenGLShaderProgram& program = singlePassOverlay ? flatWireProgram : flatProgram;
+            program.bind();
             vao.bind();
             faceEbo.bind();
             
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            flatProgram.setUniformValue("model", model);
-            flatProgram.setUniformValue("view", view);
-            flatProgram.setUniformValue("projection", projection);
-            flatProgram.setUniformValue("normalMatrix", normalMatrix);
+            program.setUniformValue("model", model);
+            program.setUniformValue("view", view);
+            program.setUniformValue("projection", projection);
             
             // 设置三个光源的位置和颜色
             for (int i = 0; i < 3; i++) {
-                flatProgram.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
-                flatProgram.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
+                program.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+                program.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
             }
             
-            flatProgram.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
-            flatProgram.setUniformValue("objectColor", surfaceColor);
-            flatProgram.setUniformValue("specularEnabled", specularEnabled);
+            program.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
+            program.setUniformValue("objectColor", surfaceColor);
+            program.setUniformValue("specularEnabled", specularEnabled);
+            setFaceColorUniforms(program);
+            if (singlePassOverlay) {
+                setWireOverlayUniforms(program);
+            }
 
             glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
 
             faceEbo.release();
             vao.release();
-            flatProgram.release();
+            program.release();
         }
 
-        if (showWireframeOverlay) {
+        if (showWireframeOverlay && !singlePassOverlay) {
             drawWireframeOverlay(model, view, projection);
         }
     }
     
+    if (selectedPointCount > 0 || !selectionUploaded) {
+        drawSelection(model, view, projection);
+    }
+    
+    if (highlightIndex >= 0) {
+        drawPickHighlight(model, view, projection);
+    }
+    
+    if (targetIndexCount > 0) {
+        drawAlignmentTarget(model, view, projection);
+    }
+    
+    if (showSamples && samplePointCount > 0) {
+        drawSamples(model, view, projection);
+    }
+    
+    if (!scene.empty()) {
+        drawScene(view, projection);
+    }
+    
     if (showAxis) {
         drawXYZAxis(view, projection);
     }
     
+    if (showUVView) {
+        drawUVView();
+    }
+    
     glPolygonMode(GL_FRONT, oldPolygonMode[0]);
     glPolygonMode(GL_BACK, oldPolygonMode[1]);
+    
+    if (selectingRegion) {
+        drawSelectionRegion();
+    }
+    
+    renderScheduler->frameFinished();
+}
+
+void BaseGLWidget::computeViewMatrices(QMatrix4x4& model, QMatrix4x4& view, QMatrix4x4& projection) const {
+    model.setToIdentity();
+    model.rotate(rotation);
+    model.scale(zoom);
+    model *= alignmentMatrix();
+    
+    QVector3D eyePosition(0, 0, viewDistance * viewScale);
+    view.setToIdentity();
+    view.lookAt(eyePosition, modelCenter, QVector3D(0, 1, 0));
+    
+    projection.setToIdentity();
+    projection.perspective(45.0f, width() / float(height()), 0.1f, 100.0f);
 }
 
 void BaseGLWidget::keyPressEvent(QKeyEvent *event) {
@@ -365,30 +653,68 @@ void BaseGLWidget::keyPressEvent(QKeyEvent *event) {
         break;
     case Qt::Key_A:
         showAxis = !showAxis;
-        update();
         break;
     default:
+        // 未处理的按键交给父类，不触发重绘
         QOpenGLWidget::keyPressEvent(event);
+        return;
     }
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::mousePressEvent(QMouseEvent *event) {
+    // Ctrl+左键：GPU拾取当前模式下的顶点/面/边
+    if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier)) {
+        if (modelLoaded) {
+            requestPick(event->pos(), pickMode);
+        }
+        return;
+    }
+    if (event->button() == Qt::LeftButton && selectionTool != NoSelectionTool && modelLoaded) {
+        selectingRegion = true;
+        selectionModifiers = event->modifiers();
+        selectionPath.clear();
+        selectionPath << event->pos() << event->pos();
+        return;
+    }
     if (event->button() == Qt::LeftButton) {
         isDragging = true;
         lastMousePos = event->pos();
         setCursor(Qt::ClosedHandCursor);
+        renderScheduler->beginInteraction();
     }
 }
 
 void BaseGLWidget::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton && selectingRegion) {
+        selectingRegion = false;
+        mesh_selection::Op op = mesh_selection::Op::replace;
+        if (selectionModifiers & Qt::ShiftModifier) {
+            op = mesh_selection::Op::add;
+        } else if (selectionModifiers & Qt::AltModifier) {
+            op = mesh_selection::Op::subtract;
+        }
+        applyRegionSelection(op);
+        return;
+    }
     if (event->button() == Qt::LeftButton) {
         isDragging = false;
         setCursor(Qt::ArrowCursor);
+        renderScheduler->endInteraction();
     }
 }
 
 void BaseGLWidget::mouseMoveEvent(QMouseEvent *event) {
+    if (selectingRegion) {
+        if (selectionTool == BoxSelection) {
+            selectionPath[1] = event->pos();
+        } else {
+            selectionPath << event->pos();
+        }
+        // 选框不在渲染状态哈希里，需要强制重绘
+        renderScheduler->markDirty();
+        return;
+    }
     if (isDragging) {
         QPoint currentPos = event->pos();
         
@@ -403,7 +729,7 @@ void BaseGLWidget::mouseMoveEvent(QMouseEvent *event) {
         rotation = newRot * rotation;
         
         lastMousePos = currentPos;
-        update();
+        requestRedraw();
     }
 }
 
@@ -430,23 +756,42 @@ void BaseGLWidget::wheelEvent(QWheelEvent *event) {
         float delta = numDegrees.y() > 0 ? 1.1f : 0.9f;
         zoom *= delta;
         zoom = qBound(0.1f, zoom, 10.0f);
-        update();
+        requestRedraw();
     }
     event->accept();
 }
 
 void BaseGLWidget::setSurfaceColor(const QVector3D& color) {
     surfaceColor = color;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::setSpecularEnabled(bool enabled) {
     specularEnabled = enabled;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::centerView() {
-    if (openMesh.n_vertices() == 0) return;
+    if (!pointCloud.empty()) {
+        // 点云加载时已归一化到原点处边长为2的立方体
+        modelCenter = QVector3D(0, 0, 0);
+        viewDistance = 4.0f;
+        rotation = QQuaternion();
+        zoom = 1.0f;
+        requestRedraw();
+        return;
+    }
+    if (openMesh.n_vertices() == 0) {
+        if (!scene.empty()) {
+            // 没有主网格时场景按自身包围盒归一化到原点处边长为2的立方体
+            modelCenter = QVector3D(0, 0, 0);
+            viewDistance = 4.0f;
+            rotation = QQuaternion();
+            zoom = 1.0f;
+            requestRedraw();
+        }
+        return;
+    }
     
     Mesh::Point min, max;
     min = max = openMesh.point(*openMesh.vertices_begin());
@@ -464,10 +809,11 @@ void BaseGLWidget::centerView() {
     
     rotation = QQuaternion();
     zoom = 1.0f;
-    update();
+    requestRedraw();
 }
 
 void BaseGLWidget::drawWireframe(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    ensureEdgeIndices();
     wireframeProgram.bind();
     vao.bind();
     ebo.bind();
@@ -486,6 +832,7 @@ void BaseGLWidget::drawWireframe(const QMatrix4x4& model, const QMatrix4x4& view
 }
 
 void BaseGLWidget::drawWireframeOverlay(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    ensureEdgeIndices();
     glEnable(GL_POLYGON_OFFSET_LINE);
     glPolygonOffset(-1.0, -1.0);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -551,10 +898,46 @@ void BaseGLWidget::drawXYZAxis(const QMatrix4x4& view, const QMatrix4x4& project
 }
 
 void BaseGLWidget::clearMeshData() {
+    waitForMeshAnalysis();
     openMesh.clear();
     faces.clear();
     edges.clear();
+    triangleEdgeMasks.clear();
+    triangleFaces.clear();
+    triangleColors.clear();
+    edgesUploaded = false;
     modelLoaded = false;
+    meshGeneration++;
+    pickBvh.clear();
+    highlightIndex = -1;
+    highlightIndices.clear();
+    selectedVertices = SelectionBitset();
+    selectedFaces = SelectionBitset();
+    selectionEboCapacity = 0;
+    selectedPointCount = 0;
+    selectedTriangleIndexCount = 0;
+    selectionUploaded = true;
+    showSubdivisionPreview = false;
+    subdivisionResult = subdivision::FlatMesh();
+    laplacianCache.topology_changed();
+    parameterizer.topology_changed();
+    clearTexCoords();
+    geodesicSolver.topology_changed();
+    geodesicDistance.clear();
+    analysisReport = mesh_analysis::Report();
+    loadHalfExtent = 1.0;
+    loadCenter = Mesh::Point(0, 0, 0);
+    alignmentTarget.clear();
+    alignment.setIdentity();
+    alignmentRevision++;
+    targetIndexCount = 0;
+    surfaceSamples.clear();
+    samplePointCount = 0;
+    if (!pointCloud.empty()) {
+        makeCurrent();
+        pointCloud.clear();
+        doneCurrent();
+    }
 }
 
 bool BaseGLWidget::loadOBJToOpenMesh(const QString &path) {
@@ -583,6 +966,11 @@ void BaseGLWidget::centerAndScaleMesh(const Mesh::Point& center, float maxSize)
 
 void BaseGLWidget::prepareFaceIndices() {
     faces.clear();
+    triangleFaces.clear();
+    // 面高亮按三角形存放，三角化变了就作废
+    triangleColors.clear();
+    std::vector<unsigned char> edgeMasks;
+    edgeMasks.reserve(openMesh.n_faces() * 2);
     for (auto fh : openMesh.faces()) {
         auto fv_it = openMesh.fv_ccwbegin(fh);
         auto fv_end = openMesh.fv_ccwend(fh);
@@ -594,6 +982,8 @@ void BaseGLWidget::prepareFaceIndices() {
             faces.push_back((*fv_it).idx()); ++fv_it;
             faces.push_back((*fv_it).idx()); ++fv_it;
             faces.push_back((*fv_it).idx());
+            edgeMasks.push_back(7);
+            triangleFaces.push_back(fh.idx());
         } else {
             unsigned int centerIdx = (*fv_it).idx();
             ++fv_it;
@@ -605,11 +995,19 @@ void BaseGLWidget::prepareFaceIndices() {
                 faces.push_back(centerIdx);
                 faces.push_back(prevIdx);
                 faces.push_back(currentIdx);
+                // 扇形三角化：只有第一条和最后一条扇边是多边形的真实边
+                edgeMasks.push_back(2 | (i == 2 ? 1 : 0) | (i == vertexCount - 1 ? 4 : 0));
+                triangleFaces.push_back(fh.idx());
                 prevIdx = currentIdx;
                 ++fv_it;
             }
         }
     }
+    
+    triangleEdgeMasks.assign((edgeMasks.size() + 7) / 8, 0u);
+    for (size_t t = 0; t < edgeMasks.size(); t++) {
+        triangleEdgeMasks[t >> 3] |= (unsigned int)edgeMasks[t] << ((t & 7) * 4);
+    }
 }
 
 void BaseGLWidget::prepareEdgeIndices() {
@@ -637,6 +1035,11 @@ void BaseGLWidget::saveOriginalMesh() {
 }
 
 void BaseGLWidget::loadOBJ(const QString &path) {
+    // 没有面的文件走点云路径，不经过OpenMesh
+    if (point_cloud::is_point_cloud_file(path.toStdString())) {
+        loadPointCloud(path);
+        return;
+    }
     clearMeshData();
     if (!loadOBJToOpenMesh(path)) {
         qWarning() << "Failed to load mesh:" << path;
@@ -651,6 +1054,8 @@ void BaseGLWidget::loadOBJ(const QString &path) {
     float maxSize = std::max({size[0], size[1], size[2]});
     
     centerAndScaleMesh(center, maxSize);
+    loadHalfExtent = maxSize / 2.0;
+    loadCenter = center;
     
     Mesh::Point min_norm, max_norm;
     computeBoundingBox(min_norm, max_norm);
@@ -667,12 +1072,7 @@ void BaseGLWidget::loadOBJ(const QString &path) {
     initialViewDistance = viewDistance;
     initialViewScale = viewScale;
 
-    openMesh.request_vertex_normals();
-    openMesh.request_face_normals();
-    openMesh.update_normals();
-    
     prepareFaceIndices();
-    prepareEdgeIndices();
     
     saveOriginalMesh();
     modelLoaded = true;
@@ -683,5 +1083,1626 @@ void BaseGLWidget::loadOBJ(const QString &path) {
     
     rotation = QQuaternion();
     zoom = 1.0f;
-    update();
-}
\ No newline at end of file
+    startMeshAnalysis();
+    requestRedraw();
+}
+void BaseGLWidget::ensurePickResources() {
+    if (pickFbo) return;
+    
+    glGenTextures(1, &pickColorTex);
+    glBindTexture(GL_TEXTURE_2D, pickColorTex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, PickRegionSize, PickRegionSize);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glGenRenderbuffers(1, &pickDepthRb);
+    glBindRenderbuffer(GL_RENDERBUFFER, pickDepthRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, PickRegionSize, PickRegionSize);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    glGenFramebuffers(1, &pickFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, pickFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pickColorTex, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, pickDepthRb);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        qWarning() << "Picking framebuffer incomplete";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    
+    for (PendingPick& slot : pickSlots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, PickRegionSize * PickRegionSize * sizeof(GLuint),
+                     nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void BaseGLWidget::releasePickResources() {
+    pickPollTimer.stop();
+    for (PendingPick& slot : pickSlots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.pbo) {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+    }
+    if (pickFbo) {
+        glDeleteFramebuffers(1, &pickFbo);
+        glDeleteTextures(1, &pickColorTex);
+        glDeleteRenderbuffers(1, &pickDepthRb);
+        pickFbo = pickColorTex = pickDepthRb = 0;
+    }
+}
+
+void BaseGLWidget::requestPick(const QPoint& screenPos, PickMode mode) {
+    if (!modelLoaded || faces.empty()) return;
+    
+    if (usesCpuPicking()) {
+        // 射线拾取是同步的，结果直接给出
+        MeshBVH::Hit hit;
+        int index = -1;
+        if (rayPick(screenPos, hit)) {
+            if (mode == PickFace) {
+                index = hit.face;
+            } else if (mode == PickVertex) {
+                index = hit.vertex;
+            } else {
+                // 离命中点最近的边对着最小的重心坐标；扇形三角化的对角线不是真实的边，跳过
+                int order[3] = {0, 1, 2};
+                std::sort(order, order + 3, [&hit](int a, int b) {
+                    return hit.barycentric[a] < hit.barycentric[b];
+                });
+                for (int k : order) {
+                    Mesh::VertexHandle v0(hit.tri_vertices[(k + 1) % 3]);
+                    Mesh::VertexHandle v1(hit.tri_vertices[(k + 2) % 3]);
+                    Mesh::HalfedgeHandle heh = openMesh.find_halfedge(v0, v1);
+                    if (heh.is_valid()) {
+                        index = openMesh.edge_handle(heh).idx();
+                        break;
+                    }
+                }
+            }
+        }
+        finishPick(mode, index);
+        return;
+    }
+    
+    makeCurrent();
+    ensurePickResources();
+    
+    // 两个PBO轮流使用；若槽位上一次的结果还没取走，直接丢弃
+    PendingPick& slot = pickSlots[nextPickSlot];
+    nextPickSlot = (nextPickSlot + 1) % 2;
+    if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    
+    QMatrix4x4 model, view, projection;
+    computeViewMatrices(model, view, projection);
+    
+    // 拾取矩阵（同gluPickMatrix）：把光标周围PickRegionSize像素放大到整个视口
+    float dpr = devicePixelRatioF();
+    float w = width() * dpr;
+    float h = height() * dpr;
+    float x = (screenPos.x() + 0.5f) * dpr;
+    float y = h - (screenPos.y() + 0.5f) * dpr;
+    float r = float(PickRegionSize);
+    QMatrix4x4 pickMatrix;
+    pickMatrix.translate((w - 2.0f * x) / r, (h - 2.0f * y) / r, 0.0f);
+    pickMatrix.scale(w / r, h / r, 1.0f);
+    projection = pickMatrix * projection;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, pickFbo);
+    glViewport(0, 0, PickRegionSize, PickRegionSize);
+    const GLuint clearId[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, clearId);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    
+    vao.bind();
+    
+    pickPrimitiveProgram.bind();
+    pickPrimitiveProgram.setUniformValue("model", model);
+    pickPrimitiveProgram.setUniformValue("view", view);
+    pickPrimitiveProgram.setUniformValue("projection", projection);
+    
+    faceEbo.bind();
+    if (mode == PickFace) {
+        glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
+    } else {
+        // 顶点/边拾取：先只写深度，让被遮挡的元素不可选中
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.0f, 1.0f);
+        glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_LEQUAL);
+    }
+    
+    if (mode == PickEdge) {
+        ensureEdgeIndices();
+        ebo.bind();
+        glLineWidth(3.0f);
+        glDrawElements(GL_LINES, edges.size(), GL_UNSIGNED_INT, 0);
+    } else if (mode == PickVertex) {
+        pickPrimitiveProgram.release();
+        pickVertexProgram.bind();
+        pickVertexProgram.setUniformValue("model", model);
+        pickVertexProgram.setUniformValue("view", view);
+        pickVertexProgram.setUniformValue("projection", projection);
+        pickVertexProgram.setUniformValue("pointSize", 9.0f * dpr);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glDrawArrays(GL_POINTS, 0, openMesh.n_vertices());
+        glDisable(GL_PROGRAM_POINT_SIZE);
+        pickVertexProgram.release();
+    }
+    glDepthFunc(GL_LESS);
+    pickPrimitiveProgram.release();
+    vao.release();
+    
+    // 读到PBO中立即返回，GPU完成后再映射，界面线程不会在glReadPixels上等待
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, PickRegionSize, PickRegionSize, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.mode = mode;
+    slot.generation = meshGeneration;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(0, 0, int(w), int(h));
+    glFlush();
+    doneCurrent();
+    
+    if (!pickPollTimer.isActive()) {
+        pickPollTimer.start();
+    }
+}
+
+void BaseGLWidget::pollPickResults() {
+    makeCurrent();
+    bool pending = false;
+    for (PendingPick& slot : pickSlots) {
+        if (!slot.fence) continue;
+        
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            pending = true;
+            continue;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        
+        // 取离区域中心最近的非背景像素
+        unsigned int id = 0;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const GLuint* pixels = static_cast<const GLuint*>(glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, PickRegionSize * PickRegionSize * sizeof(GLuint), GL_MAP_READ_BIT));
+        if (pixels) {
+            int center = PickRegionSize / 2;
+            int bestDist = std::numeric_limits<int>::max();
+            for (int py = 0; py < PickRegionSize; py++) {
+                for (int px = 0; px < PickRegionSize; px++) {
+                    GLuint value = pixels[py * PickRegionSize + px];
+                    int dist = (px - center) * (px - center) + (py - center) * (py - center);
+                    if (value != 0 && dist < bestDist) {
+                        bestDist = dist;
+                        id = value;
+                    }
+                }
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        
+        if (slot.generation == meshGeneration) {
+            finishPick(slot.mode, id ? resolvePickId(slot.mode, id - 1) : -1);
+        }
+    }
+    doneCurrent();
+    
+    if (!pending) {
+        pickPollTimer.stop();
+    }
+}
+
+int BaseGLWidget::resolvePickId(PickMode mode, unsigned int id) const {
+    switch (mode) {
+    case PickVertex:
+        return id < openMesh.n_vertices() ? int(id) : -1;
+    case PickFace:
+        return id < triangleFaces.size() ? triangleFaces[id] : -1;
+    case PickEdge: {
+        if (2 * size_t(id) + 1 >= edges.size()) return -1;
+        Mesh::VertexHandle v0(edges[2 * id]);
+        Mesh::VertexHandle v1(edges[2 * id + 1]);
+        Mesh::HalfedgeHandle heh = openMesh.find_halfedge(v0, v1);
+        return heh.is_valid() ? openMesh.edge_handle(heh).idx() : -1;
+    }
+    }
+    return -1;
+}
+
+bool BaseGLWidget::usesCpuPicking() const {
+    if (pickBackend == AutoPickBackend) {
+        return softwareRenderer;
+    }
+    return pickBackend == CpuRayPickBackend;
+}
+
+bool BaseGLWidget::rayPick(const QPoint& screenPos, MeshBVH::Hit& hit) {
+    if (!modelLoaded || faces.empty()) return false;
+    
+    QElapsedTimer timer;
+    if (pickBvh.empty()) {
+        // 用与渲染相同的三角形，保证三角形序号和面的对应一致
+        timer.start();
+        std::vector<OpenMesh::Vec3d> points(openMesh.n_vertices());
+        for (auto vh : openMesh.vertices()) {
+            points[vh.idx()] = openMesh.point(vh);
+        }
+        pickBvh.build(points, faces, triangleFaces);
+        qDebug() << "Picking BVH built:" << pickBvh.triangle_count() << "triangles in"
+                 << timer.elapsed() << "ms";
+    }
+    
+    // 与projectToTrackball相同的归一化设备坐标，再经MVP的逆变换回网格坐标系
+    float x = (2.0f * screenPos.x()) / width() - 1.0f;
+    float y = 1.0f - (2.0f * screenPos.y()) / height();
+    QMatrix4x4 model, view, projection;
+    computeViewMatrices(model, view, projection);
+    bool invertible = false;
+    QMatrix4x4 inverse = (projection * view * model).inverted(&invertible);
+    if (!invertible) return false;
+    
+    QVector3D nearPoint = inverse.map(QVector3D(x, y, -1.0f));
+    QVector3D farPoint = inverse.map(QVector3D(x, y, 1.0f));
+    QVector3D dir = farPoint - nearPoint;
+    
+    bool found = pickBvh.ray_cast(OpenMesh::Vec3d(nearPoint.x(), nearPoint.y(), nearPoint.z()),
+                                  OpenMesh::Vec3d(dir.x(), dir.y(), dir.z()), hit, 1.0);
+    
+    if (found) {
+        emit surfaceHit(hit.face, hit.vertex,
+                        QVector3D(hit.barycentric[0], hit.barycentric[1], hit.barycentric[2]),
+                        QVector3D(hit.point[0], hit.point[1], hit.point[2]));
+    }
+    return found;
+}
+
+void BaseGLWidget::finishPick(PickMode mode, int index) {
+    setPickHighlight(mode, index);
+    emit elementPicked(mode, index);
+}
+
+void BaseGLWidget::clearPickHighlight() {
+    setPickHighlight(pickMode, -1);
+}
+
+void BaseGLWidget::setPickHighlight(PickMode mode, int index) {
+    highlightMode = mode;
+    highlightIndex = index;
+    highlightIndices.clear();
+    highlightUploaded = false;
+    
+    if (index >= 0) {
+        if (mode == PickVertex && index < int(openMesh.n_vertices())) {
+            highlightIndices.push_back(index);
+        } else if (mode == PickEdge && index < int(openMesh.n_edges())) {
+            Mesh::HalfedgeHandle heh = openMesh.halfedge_handle(openMesh.edge_handle(index), 0);
+            highlightIndices.push_back(openMesh.from_vertex_handle(heh).idx());
+            highlightIndices.push_back(openMesh.to_vertex_handle(heh).idx());
+        } else if (mode == PickFace && index < int(openMesh.n_faces())) {
+            // 与prepareFaceIndices相同的扇形三角化
+            Mesh::FaceHandle fh = openMesh.face_handle(index);
+            std::vector<unsigned int> loop;
+            for (auto fv_it = openMesh.fv_ccwbegin(fh); fv_it != openMesh.fv_ccwend(fh); ++fv_it) {
+                loop.push_back((*fv_it).idx());
+            }
+            for (size_t i = 2; i < loop.size(); i++) {
+                highlightIndices.push_back(loop[0]);
+                highlightIndices.push_back(loop[i - 1]);
+                highlightIndices.push_back(loop[i]);
+            }
+        }
+    }
+    if (highlightIndices.empty()) {
+        highlightIndex = -1;
+    }
+    requestRedraw();
+}
+
+void BaseGLWidget::drawPickHighlight(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    if (highlightIndices.empty()) return;
+    
+    vao.bind();
+    highlightEbo.bind();
+    if (!highlightUploaded) {
+        highlightEbo.allocate(highlightIndices.data(), highlightIndices.size() * sizeof(unsigned int));
+        highlightUploaded = true;
+    }
+    
+    wireframeProgram.bind();
+    wireframeProgram.setUniformValue("model", model);
+    wireframeProgram.setUniformValue("view", view);
+    wireframeProgram.setUniformValue("projection", projection);
+    wireframeProgram.setUniformValue("lineColor", QVector4D(1.0f, 0.6f, 0.0f, 1.0f));
+    
+    // 高亮画在表面之上
+    glDepthFunc(GL_LEQUAL);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    if (highlightMode == PickFace) {
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(-1.0f, -1.0f);
+        glDrawElements(GL_TRIANGLES, highlightIndices.size(), GL_UNSIGNED_INT, 0);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+    } else if (highlightMode == PickEdge) {
+        glLineWidth(4.0f);
+        glDrawElements(GL_LINES, highlightIndices.size(), GL_UNSIGNED_INT, 0);
+        glLineWidth(1.5f);
+    } else {
+        glPointSize(10.0f);
+        glDrawElements(GL_POINTS, highlightIndices.size(), GL_UNSIGNED_INT, 0);
+    }
+    glDepthFunc(GL_LESS);
+    
+    wireframeProgram.release();
+    highlightEbo.release();
+    vao.release();
+}
+
+void BaseGLWidget::setSelectionTool(SelectionTool tool) {
+    selectionTool = tool;
+    selectingRegion = false;
+    setCursor(tool == NoSelectionTool ? Qt::ArrowCursor : Qt::CrossCursor);
+}
+
+void BaseGLWidget::applyRegionSelection(mesh_selection::Op op) {
+    if (!modelLoaded) return;
+    
+    QMatrix4x4 model, view, projection;
+    computeViewMatrices(model, view, projection);
+    QMatrix4x4 mvp = projection * view * model;
+    // QMatrix4x4与Eigen默认都是列主序
+    Eigen::Matrix4d mvpEigen = Eigen::Map<const Eigen::Matrix4f>(mvp.constData()).cast<double>();
+    
+    std::vector<float> screenXY;
+    std::vector<unsigned char> visible;
+    mesh_selection::project_vertices(openMesh, mvpEigen, width(), height(), screenXY, visible);
+    
+    if (selectionTool == BoxSelection) {
+        QPoint a = selectionPath[0], b = selectionPath[1];
+        mesh_selection::select_in_rect(screenXY, visible, a.x(), a.y(), b.x(), b.y(), op, selectedVertices);
+    } else {
+        std::vector<OpenMesh::Vec2d> polygon;
+        polygon.reserve(selectionPath.size());
+        for (const QPoint& p : selectionPath) {
+            polygon.push_back(OpenMesh::Vec2d(p.x(), p.y()));
+        }
+        mesh_selection::select_in_polygon(screenXY, visible, polygon, op, selectedVertices);
+    }
+    
+    onSelectionChanged();
+}
+
+void BaseGLWidget::growSelection(int rings) {
+    if (!modelLoaded || !selectedVertices.any()) return;
+    mesh_selection::grow(openMesh, selectedVertices, rings);
+    onSelectionChanged();
+}
+
+void BaseGLWidget::shrinkSelection(int rings) {
+    if (!modelLoaded || !selectedVertices.any()) return;
+    mesh_selection::shrink(openMesh, selectedVertices, rings);
+    onSelectionChanged();
+}
+
+void BaseGLWidget::clearSelection() {
+    if (!modelLoaded) return;
+    selectedVertices.resize(openMesh.n_vertices());
+    onSelectionChanged();
+}
+
+void BaseGLWidget::onSelectionChanged() {
+    if (selectedVertices.size() != openMesh.n_vertices()) {
+        selectedVertices.resize(openMesh.n_vertices());
+    }
+    mesh_selection::faces_from_vertices(openMesh, selectedVertices, selectedFaces);
+    mesh_selection::write_to_status(openMesh, selectedVertices, selectedFaces);
+    
+    selectionUploaded = false;
+    renderScheduler->markDirty();
+    emit selectionChanged(int(selectedVertices.count()), int(selectedFaces.count()));
+}
+
+void BaseGLWidget::drawSelection(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    vao.bind();
+    selectionEbo.bind();
+    
+    if (!selectionUploaded) {
+        size_t capacity = openMesh.n_vertices() + faces.size();
+        if (selectionEboCapacity != capacity) {
+            // 每个网格只分配一次，之后只用glBufferSubData改写选中的部分
+            selectionEbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+            selectionEbo.allocate(capacity * sizeof(unsigned int));
+            selectionEboCapacity = capacity;
+        }
+        
+        std::vector<unsigned int> points;
+        selectedVertices.collect(points);
+        std::vector<unsigned int> triangles;
+        if (selectedFaces.any()) {
+            for (size_t t = 0; t < triangleFaces.size(); t++) {
+                if (selectedFaces.test(triangleFaces[t])) {
+                    triangles.insert(triangles.end(), faces.begin() + 3 * t, faces.begin() + 3 * t + 3);
+                }
+            }
+        }
+        
+        selectedPointCount = int(points.size());
+        selectedTriangleIndexCount = int(triangles.size());
+        if (!points.empty()) {
+            selectionEbo.write(0, points.data(), points.size() * sizeof(unsigned int));
+        }
+        if (!triangles.empty()) {
+            selectionEbo.write(openMesh.n_vertices() * sizeof(unsigned int), triangles.data(),
+                               triangles.size() * sizeof(unsigned int));
+        }
+        selectionUploaded = true;
+    }
+    
+    if (selectedPointCount > 0) {
+        wireframeProgram.bind();
+        wireframeProgram.setUniformValue("model", model);
+        wireframeProgram.setUniformValue("view", view);
+        wireframeProgram.setUniformValue("projection", projection);
+        
+        glDepthFunc(GL_LEQUAL);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        if (selectedTriangleIndexCount > 0) {
+            wireframeProgram.setUniformValue("lineColor", QVector4D(0.85f, 0.25f, 0.25f, 1.0f));
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(-0.5f, -0.5f);
+            glDrawElements(GL_TRIANGLES, selectedTriangleIndexCount, GL_UNSIGNED_INT,
+                           (const void*)(openMesh.n_vertices() * sizeof(unsigned int)));
+            glDisable(GL_POLYGON_OFFSET_FILL);
+        }
+        wireframeProgram.setUniformValue("lineColor", QVector4D(1.0f, 0.2f, 0.2f, 1.0f));
+        glPointSize(5.0f);
+        glDrawElements(GL_POINTS, selectedPointCount, GL_UNSIGNED_INT, 0);
+        glDepthFunc(GL_LESS);
+        wireframeProgram.release();
+    }
+    
+    selectionEbo.release();
+    vao.release();
+}
+
+void BaseGLWidget::drawSelectionRegion() {
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::white, 1, Qt::DashLine));
+    painter.setBrush(QColor(255, 255, 255, 40));
+    if (selectionTool == BoxSelection) {
+        painter.drawRect(QRect(selectionPath[0], selectionPath[1]).normalized());
+    } else {
+        painter.drawPolygon(selectionPath);
+    }
+    painter.end();
+    
+    // QPainter会改动GL状态
+    glEnable(GL_DEPTH_TEST);
+}
+
+bool BaseGLWidget::subdividePreview(SubdivisionScheme scheme, int levels, QString* error) {
+    if (!modelLoaded || levels < 1) {
+        if (error) *error = "No mesh loaded";
+        return false;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    subdivision::FlatMesh input;
+    subdivision::from_openmesh(openMesh, input);
+    if (scheme == LoopSubdivision && !input.is_triangle_mesh()) {
+        if (error) *error = "Loop requires a triangle mesh";
+        return false;
+    }
+    // 面数每层约乘4，先算出结果规模，超过上限时不分配任何内存
+    size_t faces = scheme == LoopSubdivision ? subdivision::loop_face_count(input, levels)
+                                             : subdivision::catmull_clark_face_count(input, levels);
+    if (faces > subdivision::kMaxFaces) {
+        if (error) {
+            *error = QString("%1 levels would exceed %2 faces").arg(levels).arg(qulonglong(subdivision::kMaxFaces));
+        }
+        return false;
+    }
+    if (scheme == LoopSubdivision) {
+        subdivision::loop(input, subdivisionResult, levels);
+    } else {
+        subdivision::catmull_clark(input, subdivisionResult, levels);
+    }
+    double elapsed = timer.nsecsElapsed() / 1.0e6;
+    
+    makeCurrent();
+    uploadSubdivisionPreview();
+    doneCurrent();
+    
+    showSubdivisionPreview = true;
+    renderScheduler->markDirty();
+    emit subdivisionFinished(int(subdivisionResult.n_vertices()), int(subdivisionResult.n_faces()), elapsed);
+    return true;
+}
+
+void BaseGLWidget::uploadSubdivisionPreview() {
+    const subdivision::FlatMesh& mesh = subdivisionResult;
+    size_t nv = mesh.n_vertices();
+    
+    std::vector<float> vertexData(6 * nv);
+    std::vector<float> normals;
+    subdivision::vertex_normals(mesh, normals);
+    parallel::for_each(0, 3 * nv, [&](size_t i) {
+        vertexData[i] = float(mesh.points[i]);
+        vertexData[3 * nv + i] = normals[i];
+    });
+    
+    std::vector<unsigned int> triangles;
+    std::vector<int> triangleFaceIds;
+    subdivision::triangulate(mesh, triangles, triangleFaceIds);
+    std::vector<unsigned int> lines;
+    subdivision::unique_edges(mesh, lines);
+    
+    previewVao.bind();
+    previewVbo.bind();
+    previewVbo.allocate(vertexData.data(), int(vertexData.size() * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+                          reinterpret_cast<void*>(3 * nv * sizeof(float)));
+    
+    previewEbo.bind();
+    previewEbo.allocate(triangles.data(), int(triangles.size() * sizeof(unsigned int)));
+    previewVao.release();
+    
+    previewEdgeEbo.bind();
+    previewEdgeEbo.allocate(lines.data(), int(lines.size() * sizeof(unsigned int)));
+    previewEdgeEbo.release();
+    
+    previewTriangleIndexCount = int(triangles.size());
+    previewEdgeIndexCount = int(lines.size());
+}
+
+void BaseGLWidget::drawSubdivisionPreview(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    previewVao.bind();
+    
+    if (!hideFaces) {
+        subdivisionProgram.bind();
+        subdivisionProgram.setUniformValue("model", model);
+        subdivisionProgram.setUniformValue("view", view);
+        subdivisionProgram.setUniformValue("projection", projection);
+        subdivisionProgram.setUniformValue("normalMatrix", model.normalMatrix());
+        
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.0f, 1.0f);
+        glDrawElements(GL_TRIANGLES, previewTriangleIndexCount, GL_UNSIGNED_INT, 0);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        subdivisionProgram.release();
+    }
+    
+    // 细分后的边直接来自细分时推导出的边表，用GL_LINES绘制
+    if (hideFaces || showWireframeOverlay) {
+        previewEdgeEbo.bind();
+        wireframeProgram.bind();
+        wireframeProgram.setUniformValue("model", model);
+        wireframeProgram.setUniformValue("view", view);
+        wireframeProgram.setUniformValue("projection", projection);
+        wireframeProgram.setUniformValue("lineColor", wireframeColor);
+        glLineWidth(1.0f);
+        glDrawElements(GL_LINES, previewEdgeIndexCount, GL_UNSIGNED_INT, 0);
+        glLineWidth(1.5f);
+        wireframeProgram.release();
+    }
+    
+    // 还原VAO中记录的面索引缓冲
+    previewEbo.bind();
+    previewVao.release();
+}
+
+void BaseGLWidget::applySubdivision() {
+    if (!showSubdivisionPreview) return;
+    
+    waitForMeshAnalysis();
+    subdivision::to_openmesh(subdivisionResult, openMesh);
+    subdivisionResult = subdivision::FlatMesh();
+    showSubdivisionPreview = false;
+    onMeshTopologyChanged();
+}
+
+// openMesh的拓扑已被替换：清掉依赖旧网格的拾取和选择状态，重建索引和缓冲
+void BaseGLWidget::onMeshTopologyChanged() {
+    meshGeneration++;
+    surfaceSamples.clear();
+    samplePointCount = 0;
+    laplacianCache.topology_changed();
+    parameterizer.topology_changed();
+    clearTexCoords();
+    geodesicSolver.topology_changed();
+    geodesicDistance.clear();
+    pickBvh.clear();
+    highlightIndex = -1;
+    highlightIndices.clear();
+    selectionEboCapacity = 0;
+    
+    prepareFaceIndices();
+    makeCurrent();
+    updateBuffersFromOpenMesh();
+    doneCurrent();
+    clearSelection();
+    startMeshAnalysis();
+    requestRedraw();
+}
+
+void BaseGLWidget::discardSubdivision() {
+    if (!showSubdivisionPreview) return;
+    showSubdivisionPreview = false;
+    subdivisionResult = subdivision::FlatMesh();
+    requestRedraw();
+}
+
+bool BaseGLWidget::decimateMesh(double ratio, bool preserveBoundary, bool preserveSeams) {
+    if (!modelLoaded || ratio <= 0.0 || ratio >= 1.0) return false;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // 预览中的细分结果基于旧网格，直接丢弃
+    showSubdivisionPreview = false;
+    subdivisionResult = subdivision::FlatMesh();
+    
+    decimation::Options options;
+    options.preserve_boundary = preserveBoundary;
+    options.preserve_seams = preserveSeams;
+    size_t triangleCount = 0;
+    for (auto fh : openMesh.faces()) {
+        triangleCount += openMesh.valence(fh) - 2;
+    }
+    options.target_faces = size_t(triangleCount * ratio);
+    
+    decimation::Stats stats;
+    waitForMeshAnalysis();
+    if (!decimation::decimate(openMesh, options, &stats)) return false;
+    double elapsed = timer.nsecsElapsed() / 1.0e6;
+    qDebug() << "Decimation:" << stats.input_faces << "->" << stats.output_faces << "faces,"
+             << stats.blocks << "blocks, block phase" << stats.block_ms << "ms, border pass" << stats.border_ms << "ms";
+    
+    onMeshTopologyChanged();
+    emit decimationFinished(int(stats.input_faces), int(stats.output_faces), stats.blocks, elapsed);
+    return true;
+}
+
+double BaseGLWidget::meanEdgeLength() const {
+    return remeshing::mean_edge_length(openMesh);
+}
+
+bool BaseGLWidget::remeshIsotropic(double targetLength, int iterations, bool preserveBoundary) {
+    if (!modelLoaded || iterations < 1) return false;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    showSubdivisionPreview = false;
+    subdivisionResult = subdivision::FlatMesh();
+    
+    remeshing::Options options;
+    options.target_length = targetLength;
+    options.iterations = iterations;
+    options.preserve_boundary = preserveBoundary;
+    remeshing::Stats stats;
+    waitForMeshAnalysis();
+    if (!remeshing::isotropic_remesh(openMesh, options, &stats)) return false;
+    double elapsed = timer.nsecsElapsed() / 1.0e6;
+    for (size_t i = 0; i < stats.passes.size(); ++i) {
+        const remeshing::PassTiming& pass = stats.passes[i];
+        qDebug() << "Remesh pass" << i << "split" << pass.splits << pass.split_ms << "ms, collapse"
+                 << pass.collapses << pass.collapse_ms << "ms, flip" << pass.flips << pass.flip_ms
+                 << "ms, relax" << pass.relax_ms << "ms," << pass.rounds << "rounds";
+    }
+    
+    onMeshTopologyChanged();
+    emit remeshFinished(int(openMesh.n_faces()), stats.target_length, elapsed);
+    return true;
+}
+
+bool BaseGLWidget::repairMesh(double weldTolerance, int maxHoleEdges, bool fairHoles) {
+    if (!modelLoaded) return false;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    showSubdivisionPreview = false;
+    subdivisionResult = subdivision::FlatMesh();
+    
+    repair::Options options;
+    options.weld_tolerance = weldTolerance * meanEdgeLength();
+    options.max_hole_edges = size_t(std::max(0, maxHoleEdges));
+    options.fair_holes = fairHoles;
+    repair::Stats stats;
+    waitForMeshAnalysis();
+    if (!repair::repair(openMesh, options, &stats)) return false;
+    double elapsed = timer.nsecsElapsed() / 1.0e6;
+    qDebug() << "Repair: welded" << stats.welded_vertices << "vertices in" << stats.weld_ms << "ms, removed"
+             << stats.degenerate_faces << "degenerate and" << stats.duplicate_faces << "duplicate faces in"
+             << stats.clean_ms << "ms, filled" << stats.holes_filled << "holes with" << stats.hole_faces
+             << "faces in" << stats.fill_ms << "ms, fairing" << stats.fair_ms << "ms";
+    
+    onMeshTopologyChanged();
+    emit repairFinished(int(stats.welded_vertices), int(stats.degenerate_faces + stats.duplicate_faces + stats.non_manifold_faces),
+                        int(stats.holes_filled), int(stats.holes_skipped), elapsed);
+    return true;
+}
+
+// 只读openMesh，可以和后台分析并行；相交面用逐三角形颜色标成红色，不改动当前选择，每次检测重新生成
+bool BaseGLWidget::checkSelfIntersections() {
+    if (!modelLoaded) return false;
+    
+    std::vector<std::pair<int, int>> pairs;
+    self_intersection::Stats stats;
+    self_intersection::find(openMesh, pairs, &stats);
+    
+    std::vector<unsigned char> marked(openMesh.n_faces(), 0);
+    for (const std::pair<int, int>& pair : pairs) {
+        marked[pair.first] = 1;
+        marked[pair.second] = 1;
+    }
+    int faceCount = int(std::count(marked.begin(), marked.end(), 1));
+    qDebug() << "Self-intersections:" << pairs.size() << "face pairs," << stats.candidate_pairs
+             << "candidate triangle pairs, BVH" << stats.build_ms << "ms, traversal and tests" << stats.test_ms << "ms";
+    
+    // 红色不透明，其余三角形alpha为0
+    triangleColors.assign(triangleFaces.size(), 0u);
+    for (size_t t = 0; t < triangleFaces.size(); t++) {
+        if (marked[triangleFaces[t]]) triangleColors[t] = 0xFF0000FFu;
+    }
+    if (faceCount == 0) triangleColors.clear();
+    uploadTriangleColors();
+    requestRedraw();
+    emit selfIntersectionsChecked(int(pairs.size()), faceCount, int(stats.candidate_pairs), stats.build_ms, stats.test_ms);
+    return true;
+}
+
+void BaseGLWidget::clearFaceHighlight() {
+    if (triangleColors.empty()) return;
+    triangleColors.clear();
+    renderScheduler->markDirty();
+    requestRedraw();
+}
+
+void BaseGLWidget::uploadTriangleColors() {
+    if (triangleColors.empty()) {
+        renderScheduler->markDirty();
+        return;
+    }
+    makeCurrent();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, faceColorBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, triangleColors.size() * sizeof(unsigned int),
+                 triangleColors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    doneCurrent();
+    renderScheduler->markDirty();
+}
+
+QMatrix4x4 BaseGLWidget::alignmentMatrix() const {
+    // QMatrix4x4从数组构造时按行主序读取
+    Eigen::Matrix<float, 4, 4, Eigen::RowMajor> m = alignment.cast<float>();
+    return QMatrix4x4(m.data());
+}
+
+// 目标网格不进入openMesh，只保留配准用的顶点、法向和显示用的缓冲
+bool BaseGLWidget::loadAlignmentTarget(const QString& path) {
+    if (!modelLoaded) return false;
+    
+    Mesh target;
+    OpenMesh::IO::Options opt = OpenMesh::IO::Options::Default;
+    if (!OpenMesh::IO::read_mesh(target, path.toStdString(), opt) || target.n_vertices() == 0) {
+        qWarning() << "Failed to load alignment target:" << path;
+        return false;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    double invScale = 1.0 / loadHalfExtent;
+    for (auto vh : target.vertices()) {
+        target.set_point(vh, (target.point(vh) - loadCenter) * invScale);
+    }
+    alignmentTarget.build(target);
+    
+    size_t nv = alignmentTarget.points.size();
+    std::vector<float> vertexData(6 * nv);
+    parallel::for_each(0, nv, [&](size_t v) {
+        for (int k = 0; k < 3; ++k) {
+            vertexData[3 * v + k] = float(alignmentTarget.points[v][k]);
+            vertexData[3 * (nv + v) + k] = float(alignmentTarget.normals[v][k]);
+        }
+    });
+    std::vector<unsigned int> triangles;
+    triangles.reserve(3 * target.n_faces());
+    std::vector<unsigned int> polygon;
+    for (auto fh : target.faces()) {
+        polygon.clear();
+        for (auto vh : target.fv_range(fh)) {
+            polygon.push_back((unsigned int)vh.idx());
+        }
+        for (size_t i = 2; i < polygon.size(); ++i) {
+            triangles.push_back(polygon[0]);
+            triangles.push_back(polygon[i - 1]);
+            triangles.push_back(polygon[i]);
+        }
+    }
+    
+    makeCurrent();
+    targetVao.bind();
+    targetVbo.bind();
+    targetVbo.allocate(vertexData.data(), int(vertexData.size() * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
+                          reinterpret_cast<void*>(3 * nv * sizeof(float)));
+    targetEbo.bind();
+    targetEbo.allocate(triangles.data(), int(triangles.size() * sizeof(unsigned int)));
+    targetVao.release();
+    doneCurrent();
+    targetIndexCount = int(triangles.size());
+    qDebug() << "Alignment target:" << nv << "vertices," << alignmentTarget.grid.cell_count()
+             << "grid cells, built in" << timer.nsecsElapsed() / 1.0e6 << "ms";
+    
+    renderScheduler->markDirty();
+    requestRedraw();
+    return true;
+}
+
+void BaseGLWidget::clearAlignmentTarget() {
+    alignmentTarget.clear();
+    targetIndexCount = 0;
+    requestRedraw();
+}
+
+// 只读openMesh，可以和后台分析并行
+bool BaseGLWidget::alignToTarget(int iterationsPerStage) {
+    if (!modelLoaded || alignmentTarget.empty()) return false;
+    
+    icp::Options options;
+    options.max_iterations = std::max(1, iterationsPerStage);
+    icp::Result result;
+    if (!icp::align(openMesh, alignmentTarget, alignment, options, result)) {
+        qWarning() << "ICP alignment failed: fewer than 6 correspondences";
+        return false;
+    }
+    qDebug() << "ICP:" << result.iterations << "iterations, rms" << result.initial_rms * loadHalfExtent << "->"
+             << result.rms * loadHalfExtent << "," << result.correspondences << "correspondences,"
+             << (result.converged ? "converged" : "not converged") << "in" << result.ms << "ms";
+    
+    alignment = result.transform;
+    alignmentRevision++;
+    requestRedraw();
+    emit alignmentFinished(result.initial_rms * loadHalfExtent, result.rms * loadHalfExtent, result.iterations,
+                           result.correspondences, result.converged, result.ms);
+    return true;
+}
+
+void BaseGLWidget::commitAlignment() {
+    if (!modelLoaded || alignment.isIdentity()) return;
+    
+    waitForMeshAnalysis();
+    Eigen::Matrix3d R = alignment.block<3, 3>(0, 0);
+    Eigen::Vector3d t = alignment.block<3, 1>(0, 3);
+    parallel::for_each(0, openMesh.n_vertices(), [&](size_t v) {
+        Mesh::VertexHandle vh(int(v));
+        const Mesh::Point& p = openMesh.point(vh);
+        Eigen::Vector3d q = R * Eigen::Vector3d(p[0], p[1], p[2]) + t;
+        openMesh.set_point(vh, Mesh::Point(q[0], q[1], q[2]));
+    });
+    alignment.setIdentity();
+    alignmentRevision++;
+    onMeshGeometryChanged();
+}
+
+void BaseGLWidget::resetAlignment() {
+    if (alignment.isIdentity()) return;
+    alignment.setIdentity();
+    alignmentRevision++;
+    requestRedraw();
+}
+
+void BaseGLWidget::drawAlignmentTarget(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    // model里含有网格的配准变换，目标留在加载坐标系中
+    QMatrix4x4 targetModel = model * alignmentMatrix().inverted();
+    
+    blinnPhongProgram.bind();
+    targetVao.bind();
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    blinnPhongProgram.setUniformValue("model", targetModel);
+    blinnPhongProgram.setUniformValue("view", view);
+    blinnPhongProgram.setUniformValue("projection", projection);
+    blinnPhongProgram.setUniformValue("normalMatrix", targetModel.normalMatrix());
+    
+    // 与paintGL中网格使用的光源相同
+    QVector3D lightPositions[3] = {
+        QVector3D(10.0f, 10.0f, -10.0f),
+        QVector3D(-10.0f, 10.0f, -10.0f),
+        QVector3D(0.0f, 0.0f, 10.0f)
+    };
+    for (int i = 0; i < 3; i++) {
+        blinnPhongProgram.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+        blinnPhongProgram.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), QVector3D(1.0f, 1.0f, 1.0f));
+    }
+    blinnPhongProgram.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
+    blinnPhongProgram.setUniformValue("objectColor", QVector3D(0.45f, 0.65f, 0.9f));
+    blinnPhongProgram.setUniformValue("specularEnabled", specularEnabled);
+    // 统一变量留在程序里：主网格的逐三角形颜色不能带到目标上，gl_PrimitiveID也对不上那个SSBO
+    blinnPhongProgram.setUniformValue("faceColorsEnabled", false);
+    glDrawElements(GL_TRIANGLES, targetIndexCount, GL_UNSIGNED_INT, 0);
+    targetVao.release();
+    blinnPhongProgram.release();
+}
+
+// 只读openMesh，可以和后台分析并行
+bool BaseGLWidget::sampleSurfaceRandom(int count, unsigned int seed) {
+    if (!modelLoaded || count < 1) return false;
+    
+    surface_sampling::Stats stats;
+    if (!surface_sampling::random(openMesh, size_t(count), seed, surfaceSamples, &stats)) {
+        qWarning() << "Surface sampling failed (mesh has no area)";
+        return false;
+    }
+    qDebug() << "Random sampling:" << surfaceSamples.size() << "samples, setup" << stats.setup_ms
+             << "ms, sampling" << stats.sample_ms << "ms";
+    
+    uploadSamples();
+    emit samplingFinished(int(surfaceSamples.size()), 0, stats.setup_ms, stats.sample_ms, 0.0);
+    return true;
+}
+
+bool BaseGLWidget::sampleSurfacePoisson(double radiusFactor, unsigned int seed) {
+    if (!modelLoaded || radiusFactor <= 0.0) return false;
+    
+    surface_sampling::PoissonOptions options;
+    options.radius = radiusFactor * meanEdgeLength();
+    options.seed = seed;
+    surface_sampling::Stats stats;
+    if (!surface_sampling::poisson_disk(openMesh, options, surfaceSamples, &stats)) {
+        qWarning() << "Poisson-disk sampling failed (mesh has no area or radius too small)";
+        return false;
+    }
+    qDebug() << "Poisson-disk sampling:" << surfaceSamples.size() << "samples from" << stats.candidates
+             << "candidates in" << stats.rounds << "rounds, setup" << stats.setup_ms << "ms, candidates"
+             << stats.sample_ms << "ms, selection" << stats.select_ms << "ms";
+    
+    uploadSamples();
+    emit samplingFinished(int(surfaceSamples.size()), int(stats.candidates), stats.setup_ms, stats.sample_ms, stats.select_ms);
+    return true;
+}
+
+bool BaseGLWidget::exportSamples(const QString& path) const {
+    if (surfaceSamples.size() == 0) return false;
+    surface_sampling::Samples exported = surfaceSamples;
+    parallel::for_each(0, exported.size(), [&](size_t i) {
+        exported.points[i] = exported.points[i] * loadHalfExtent + loadCenter;
+    });
+    return surface_sampling::write_ply(path.toLocal8Bit().constData(), exported);
+}
+
+void BaseGLWidget::clearSamples() {
+    surfaceSamples.clear();
+    samplePointCount = 0;
+    requestRedraw();
+}
+
+void BaseGLWidget::setShowSamples(bool show) {
+    showSamples = show;
+    requestRedraw();
+}
+
+void BaseGLWidget::uploadSamples() {
+    size_t n = surfaceSamples.size();
+    std::vector<float> positions(3 * n);
+    parallel::for_each(0, n, [&](size_t i) {
+        for (int k = 0; k < 3; ++k) {
+            positions[3 * i + k] = float(surfaceSamples.points[i][k]);
+        }
+    });
+    
+    makeCurrent();
+    sampleVao.bind();
+    sampleVbo.bind();
+    sampleVbo.allocate(positions.data(), int(positions.size() * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    sampleVao.release();
+    doneCurrent();
+    
+    samplePointCount = int(n);
+    renderScheduler->markDirty();
+    requestRedraw();
+}
+
+void BaseGLWidget::drawSamples(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    wireframeProgram.bind();
+    sampleVao.bind();
+    wireframeProgram.setUniformValue("model", model);
+    wireframeProgram.setUniformValue("view", view);
+    wireframeProgram.setUniformValue("projection", projection);
+    wireframeProgram.setUniformValue("lineColor", QVector4D(0.1f, 0.9f, 0.3f, 1.0f));
+    
+    // 样本就在表面上，放宽深度测试避免被所在的面遮住
+    glDepthFunc(GL_LEQUAL);
+    glPointSize(3.0f);
+    glDrawArrays(GL_POINTS, 0, samplePointCount);
+    glDepthFunc(GL_LESS);
+    
+    sampleVao.release();
+    wireframeProgram.release();
+}
+
+bool BaseGLWidget::loadPointCloud(const QString& path) {
+    clearMeshData();
+    
+    point_cloud::Cloud cloud;
+    double readMs = 0.0;
+    if (!point_cloud::read(path.toStdString(), cloud, &readMs)) {
+        qWarning() << "Failed to load point cloud:" << path;
+        return false;
+    }
+    
+    // 与网格相同的归一化：包围盒中心移到原点，最长边缩放到2
+    double center[3], halfExtent = 1.0;
+    point_cloud::normalize(cloud, center, halfExtent);
+    loadCenter = Mesh::Point(center[0], center[1], center[2]);
+    loadHalfExtent = halfExtent;
+    
+    PointOctree octree;
+    PointOctree::BuildOptions options;
+    PointOctree::BuildStats stats;
+    if (!octree.build(cloud, options, &stats)) {
+        qWarning() << "Point cloud too large:" << cloud.size() << "points";
+        return false;
+    }
+    
+    makeCurrent();
+    pointCloud.upload(cloud, std::move(octree));
+    doneCurrent();
+    
+    modelCenter = QVector3D(0, 0, 0);
+    viewDistance = 4.0f;
+    
+    initialRotation = QQuaternion();
+    initialZoom = 1.0f;
+    initialModelCenter = modelCenter;
+    initialViewDistance = viewDistance;
+    initialViewScale = viewScale;
+    
+    rotation = QQuaternion();
+    zoom = 1.0f;
+    reportedDrawnPoints = reportedDrawnNodes = 0;
+    emit pointCloudLoaded(int(pointCloud.pointCount()), int(pointCloud.nodeCount()),
+                          pointCloud.hasNormals(), pointCloud.hasColors(), readMs, stats.ms);
+    renderScheduler->markDirty();
+    requestRedraw();
+    return true;
+}
+
+void BaseGLWidget::setPointBudget(int points) {
+    pointCloud.setPointBudget(size_t(qMax(1, points)));
+    requestRedraw();
+}
+
+void BaseGLWidget::setPointSizeScale(float scale) {
+    pointCloud.setPointSizeScale(scale);
+    requestRedraw();
+}
+
+void BaseGLWidget::setPointNormalShading(bool enabled) {
+    pointCloud.setNormalShading(enabled);
+    requestRedraw();
+}
+
+void BaseGLWidget::setPointColors(bool enabled) {
+    pointCloud.setVertexColors(enabled);
+    requestRedraw();
+}
+
+void BaseGLWidget::drawPointCloud() {
+    QMatrix4x4 model, view, projection;
+    computeViewMatrices(model, view, projection);
+    
+    float dpr = devicePixelRatioF();
+    pointCloud.draw(model, view, projection, QSize(int(width() * dpr), int(height() * dpr)), surfaceColor);
+    
+    if (showAxis) {
+        drawXYZAxis(view, projection);
+    }
+    
+    if (pointCloud.drawnPoints() != reportedDrawnPoints || pointCloud.drawnNodes() != reportedDrawnNodes) {
+        reportedDrawnPoints = pointCloud.drawnPoints();
+        reportedDrawnNodes = pointCloud.drawnNodes();
+        emit pointCloudDrawn(int(reportedDrawnPoints), int(reportedDrawnNodes));
+    }
+}
+
+int BaseGLWidget::addSceneObject(const QString& path) {
+    Mesh part;
+    OpenMesh::IO::Options opt = OpenMesh::IO::Options::Default;
+    if (!OpenMesh::IO::read_mesh(part, path.toStdString(), opt)) {
+        qWarning() << "Failed to load scene object:" << path;
+        return -1;
+    }
+    
+    std::vector<float> positions;
+    positions.reserve(part.n_vertices() * 3);
+    for (auto vh : part.vertices()) {
+        const Mesh::Point& p = part.point(vh);
+        positions.push_back(float(p[0]));
+        positions.push_back(float(p[1]));
+        positions.push_back(float(p[2]));
+    }
+    // 多边形按扇形三角化，与prepareFaceIndices相同
+    std::vector<unsigned int> indices;
+    indices.reserve(part.n_faces() * 3);
+    for (auto fh : part.faces()) {
+        auto fv_it = part.fv_ccwbegin(fh);
+        int vertexCount = part.valence(fh);
+        if (vertexCount < 3) continue;
+        unsigned int centerIdx = (*fv_it).idx();
+        ++fv_it;
+        unsigned int prevIdx = (*fv_it).idx();
+        ++fv_it;
+        for (int i = 2; i < vertexCount; i++, ++fv_it) {
+            unsigned int currentIdx = (*fv_it).idx();
+            indices.push_back(centerIdx);
+            indices.push_back(prevIdx);
+            indices.push_back(currentIdx);
+            prevIdx = currentIdx;
+        }
+    }
+    
+    // 按黄金角取色相，相邻加入的零件颜色区分明显
+    double hue = std::fmod(0.618033988749895 * scene.objectCount() + 0.1, 1.0);
+    QColor color = QColor::fromHsvF(hue, 0.45, 0.9);
+    
+    bool wasEmpty = scene.empty();
+    makeCurrent();
+    int index = scene.addObject(QFileInfo(path).fileName(), positions, indices,
+                                QVector3D(color.redF(), color.greenF(), color.blueF()));
+    doneCurrent();
+    if (index < 0) {
+        qWarning() << "Scene object has no faces:" << path;
+        return -1;
+    }
+    
+    updateSceneNormalization();
+    if (wasEmpty && !modelLoaded && pointCloud.empty()) {
+        modelCenter = QVector3D(0, 0, 0);
+        viewDistance = 4.0f;
+        initialRotation = QQuaternion();
+        initialZoom = 1.0f;
+        initialModelCenter = modelCenter;
+        initialViewDistance = viewDistance;
+        initialViewScale = viewScale;
+        rotation = QQuaternion();
+        zoom = 1.0f;
+    }
+    emit sceneChanged();
+    requestRedraw();
+    return index;
+}
+
+void BaseGLWidget::removeSceneObject(int index) {
+    if (index < 0 || index >= scene.objectCount()) return;
+    makeCurrent();
+    scene.removeObject(index);
+    doneCurrent();
+    updateSceneNormalization();
+    emit sceneChanged();
+    requestRedraw();
+}
+
+void BaseGLWidget::clearScene() {
+    if (scene.empty()) return;
+    makeCurrent();
+    scene.clear();
+    doneCurrent();
+    emit sceneChanged();
+    requestRedraw();
+}
+
+void BaseGLWidget::setSceneObjectTransform(int index, const QVector3D& translation, const QVector3D& eulerDegrees, float scale) {
+    scene.setTransform(index, translation, QQuaternion::fromEulerAngles(eulerDegrees), scale);
+    requestRedraw();
+}
+
+void BaseGLWidget::setSceneObjectColor(int index, const QColor& color) {
+    scene.setColor(index, QVector3D(color.redF(), color.greenF(), color.blueF()));
+    requestRedraw();
+}
+
+void BaseGLWidget::setSceneObjectVisible(int index, bool visible) {
+    scene.setVisible(index, visible);
+    requestRedraw();
+}
+
+void BaseGLWidget::setSceneObjectArray(int index, int nx, int ny, int nz, float gap) {
+    if (index < 0 || index >= scene.objectCount()) return;
+    const MeshScene::Object& object = scene.object(index);
+    QVector3D step = (object.boundsMax - object.boundsMin) * (1.0f + gap);
+    
+    std::vector<QMatrix4x4> instances;
+    if (nx * ny * nz > 1) {
+        instances.reserve(size_t(nx) * ny * nz);
+        for (int k = 0; k < nz; k++) {
+            for (int j = 0; j < ny; j++) {
+                for (int i = 0; i < nx; i++) {
+                    QMatrix4x4 m;
+                    m.translate(step.x() * i, step.y() * j, step.z() * k);
+                    instances.push_back(m);
+                }
+            }
+        }
+    }
+    scene.setInstances(index, instances);
+    updateSceneNormalization();
+    emit sceneChanged();
+    requestRedraw();
+}
+
+// 只在增删对象时更新，编辑变换时视图不会跟着跳动
+void BaseGLWidget::updateSceneNormalization() {
+    QVector3D min, max;
+    if (!scene.bounds(min, max)) return;
+    sceneCenter = (min + max) * 0.5f;
+    QVector3D size = max - min;
+    float maxSize = std::max({ size.x(), size.y(), size.z() });
+    sceneHalfExtent = maxSize > 0.0f ? maxSize * 0.5f : 1.0f;
+}
+
+void BaseGLWidget::drawScene(const QMatrix4x4& view, const QMatrix4x4& projection) {
+    // 主网格的model矩阵含对齐变换，场景只用轨迹球旋转和缩放
+    QMatrix4x4 model;
+    model.rotate(rotation);
+    model.scale(zoom);
+    if (modelLoaded) {
+        model.scale(float(1.0 / loadHalfExtent));
+        model.translate(-QVector3D(loadCenter[0], loadCenter[1], loadCenter[2]));
+    } else {
+        model.scale(1.0f / sceneHalfExtent);
+        model.translate(-sceneCenter);
+    }
+    
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    scene.draw(model, view, projection, QVector3D(0, 0, viewDistance * viewScale), specularEnabled);
+    
+    if (scene.visibleCopies() != reportedSceneCopies || scene.drawCalls() != reportedSceneDrawCalls) {
+        reportedSceneCopies = scene.visibleCopies();
+        reportedSceneDrawCalls = scene.drawCalls();
+        emit sceneDrawn(int(reportedSceneCopies), reportedSceneDrawCalls);
+    }
+}
+
+// 只有顶点位置变化：拓扑、选择和拾取编号仍然有效
+void BaseGLWidget::onMeshGeometryChanged() {
+    surfaceSamples.clear();
+    samplePointCount = 0;
+    parameterizer.geometry_changed();
+    geodesicSolver.geometry_changed();
+    geodesicDistance.clear();
+    pickBvh.clear();
+    highlightIndex = -1;
+    highlightIndices.clear();
+    
+    makeCurrent();
+    updateBuffersFromOpenMesh();
+    doneCurrent();
+    startMeshAnalysis();
+    requestRedraw();
+}
+
+// 分析在std::async线程上进行；结果回到GUI线程后，若网格已被替换则丢弃
+void BaseGLWidget::startMeshAnalysis() {
+    waitForMeshAnalysis();
+    if (!modelLoaded) return;
+    
+    unsigned int generation = meshGeneration;
+    double scale = loadHalfExtent;
+    analysisTask = std::async(std::launch::async, [this, generation, scale]() {
+        mesh_analysis::Report report = mesh_analysis::analyze(openMesh);
+        report.area *= scale * scale;
+        report.volume *= scale * scale * scale;
+        QMetaObject::invokeMethod(this, [this, generation, report]() {
+            if (generation != meshGeneration) return;
+            analysisReport = report;
+            emit meshAnalyzed(analysisReport);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void BaseGLWidget::waitForMeshAnalysis() {
+    if (analysisTask.valid()) {
+        analysisTask.wait();
+    }
+}
+
+bool BaseGLWidget::smoothMesh(double strength, int iterations, bool selectionOnly) {
+    if (!modelLoaded) return false;
+    if (selectionOnly && !selectedVertices.any()) return false;
+    
+    double edge = meanEdgeLength();
+    laplacian::SolveStats stats;
+    waitForMeshAnalysis();
+    if (!laplacianCache.smooth(openMesh, selectionOnly ? &selectedVertices : nullptr,
+                               strength * edge * edge, iterations, &stats)) {
+        qWarning() << "Laplacian smoothing failed (triangle mesh required)";
+        return false;
+    }
+    
+    onMeshGeometryChanged();
+    emit laplacianSolved(stats.assemble_ms, stats.analyze_ms + stats.factorize_ms, stats.solve_ms, stats.reused_symbolic);
+    return true;
+}
+
+bool BaseGLWidget::fairSelection() {
+    if (!modelLoaded || !selectedVertices.any()) return false;
+    
+    laplacian::SolveStats stats;
+    waitForMeshAnalysis();
+    if (!laplacianCache.fair(openMesh, selectedVertices, &stats)) {
+        qWarning() << "Fairing failed (triangle mesh and unselected vertices required)";
+        return false;
+    }
+    
+    onMeshGeometryChanged();
+    emit laplacianSolved(stats.assemble_ms, stats.analyze_ms + stats.factorize_ms, stats.solve_ms, stats.reused_symbolic);
+    return true;
+}
+
+bool BaseGLWidget::computeParameterization(parameterization::Method method, int arapIterations) {
+    if (!modelLoaded) return false;
+    
+    parameterization::Options options;
+    options.method = method;
+    options.arap_iterations = arapIterations;
+    parameterization::Stats stats;
+    waitForMeshAnalysis();
+    if (!parameterizer.compute(openMesh, options, &stats)) {
+        qWarning() << "Parameterization requires a connected triangle mesh with a single boundary loop";
+        return false;
+    }
+    qDebug() << "Parameterization: setup" << stats.setup_ms << "ms, factorize" << stats.factorize_ms
+             << "ms, solve" << stats.solve_ms << "ms, local steps" << stats.local_ms << "ms,"
+             << stats.arap_iterations << "ARAP iterations," << stats.flipped_faces << "flipped faces";
+    
+    uvUploaded = false;
+    renderScheduler->markDirty();
+    emit parameterizationFinished(stats.factorize_ms, stats.solve_ms, stats.local_ms,
+                                  stats.reused_factorization, int(stats.flipped_faces));
+    return true;
+}
+
+void BaseGLWidget::setShowUVView(bool show) {
+    showUVView = show;
+    requestRedraw();
+}
+
+// 纹理坐标按半边索引（hvt_index），拓扑改变后旧的索引和坐标表都失效，整个删掉；
+// UV视图随之变空，直到重新参数化
+void BaseGLWidget::clearTexCoords() {
+    // 删除属性会改动属性容器，不能和分析线程同时进行
+    waitForMeshAnalysis();
+    OpenMesh::MPropHandleT<std::vector<Mesh::TexCoord2D>> mvt_list;
+    OpenMesh::HPropHandleT<int> hvt_index;
+    if (openMesh.get_property_handle(mvt_list, "mvt_list")) openMesh.remove_property(mvt_list);
+    if (openMesh.get_property_handle(hvt_index, "hvt_index")) openMesh.remove_property(hvt_index);
+    uvUploaded = false;
+    uvEdgeIndexCount = 0;
+}
+
+bool BaseGLWidget::hasTexCoords() const {
+    OpenMesh::MPropHandleT<std::vector<Mesh::TexCoord2D>> mvt_list;
+    return openMesh.get_property_handle(mvt_list, "mvt_list") && !openMesh.property(mvt_list).empty();
+}
+
+bool BaseGLWidget::saveMesh(const QString& path, bool withTexCoords) {
+    if (!modelLoaded) return false;
+    return Mesh_doubleIO::save_mesh(openMesh, path.toLocal8Bit().constData(), withTexCoords);
+}
+
+void BaseGLWidget::uploadUVView() {
+    uvUploaded = true;
+    uvEdgeIndexCount = 0;
+    
+    OpenMesh::MPropHandleT<std::vector<Mesh::TexCoord2D>> mvt_list;
+    OpenMesh::HPropHandleT<int> hvt_index;
+    if (!openMesh.get_property_handle(mvt_list, "mvt_list") || !openMesh.get_property_handle(hvt_index, "hvt_index")) return;
+    const std::vector<Mesh::TexCoord2D>& list = openMesh.property(mvt_list);
+    if (list.empty()) return;
+    
+    size_t n = list.size();
+    std::vector<float> vertexData(2 * (n + 4));
+    float lo[2] = { FLT_MAX, FLT_MAX };
+    float hi[2] = { -FLT_MAX, -FLT_MAX };
+    for (size_t i = 0; i < n; ++i) {
+        for (int k = 0; k < 2; ++k) {
+            float c = float(list[i][k]);
+            vertexData[2 * i + k] = c;
+            lo[k] = std::min(lo[k], c);
+            hi[k] = std::max(hi[k], c);
+        }
+    }
+    float corners[8] = { lo[0], lo[1], hi[0], lo[1], hi[0], hi[1], lo[0], hi[1] };
+    std::copy(corners, corners + 8, vertexData.begin() + 2 * n);
+    uvMin = QVector2D(lo[0], lo[1]);
+    uvMax = QVector2D(hi[0], hi[1]);
+    
+    // 角点的纹理坐标索引存在指向该角点的半边上，面内相邻两条半边给出一条UV边；
+    // 内部边在两侧各画一次，接缝两侧的UV边本来就不同
+    std::vector<unsigned int> lines;
+    lines.reserve(8 + 2 * openMesh.n_halfedges());
+    unsigned int base = (unsigned int)n;
+    unsigned int frame[8] = { base, base + 1, base + 1, base + 2, base + 2, base + 3, base + 3, base };
+    lines.insert(lines.end(), frame, frame + 8);
+    for (auto fh : openMesh.faces()) {
+        for (auto fh_h : openMesh.fh_range(fh)) {
+            int a = openMesh.property(hvt_index, fh_h);
+            int b = openMesh.property(hvt_index, openMesh.next_halfedge_handle(fh_h));
+            if (a < 0 || b < 0 || size_t(a) >= n || size_t(b) >= n) continue;
+            lines.push_back((unsigned int)a);
+            lines.push_back((unsigned int)b);
+        }
+    }
+    
+    uvVao.bind();
+    uvVbo.bind();
+    uvVbo.allocate(vertexData.data(), int(vertexData.size() * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    uvEbo.bind();
+    uvEbo.allocate(lines.data(), int(lines.size() * sizeof(unsigned int)));
+    uvVao.release();
+    
+    uvEdgeIndexCount = int(lines.size()) - 8;
+}
+
+void BaseGLWidget::drawUVView() {
+    if (!uvUploaded) {
+        uploadUVView();
+    }
+    if (uvEdgeIndexCount <= 0) return;
+    
+    // 右下角的正方形区域，先清成深色背景
+    float dpr = devicePixelRatioF();
+    int fullWidth = int(width() * dpr);
+    int fullHeight = int(height() * dpr);
+    int side = std::min(fullWidth, fullHeight) * 2 / 5;
+    int margin = int(10 * dpr);
+    int x = fullWidth - side - margin;
+    int y = margin;
+    
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x, y, side, side);
+    glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(bgColor.redF(), bgColor.greenF(), bgColor.blueF(), bgColor.alphaF());
+    glViewport(x, y, side, side);
+    glDisable(GL_DEPTH_TEST);
+    
+    // 保持宽高比，四周留5%
+    QVector2D center = (uvMin + uvMax) * 0.5f;
+    QVector2D extent = uvMax - uvMin;
+    float half = 0.55f * std::max({ extent.x(), extent.y(), 1e-6f });
+    QMatrix4x4 projection;
+    projection.ortho(center.x() - half, center.x() + half, center.y() - half, center.y() + half, -1.0f, 1.0f);
+    
+    uvProgram.bind();
+    uvVao.bind();
+    uvProgram.setUniformValue("projection", projection);
+    glLineWidth(1.0f);
+    uvProgram.setUniformValue("pointColor", QVector3D(0.45f, 0.45f, 0.45f));
+    glDrawElements(GL_LINES, 8, GL_UNSIGNED_INT, 0);
+    uvProgram.setUniformValue("pointColor", QVector3D(0.9f, 0.9f, 0.9f));
+    glDrawElements(GL_LINES, uvEdgeIndexCount, GL_UNSIGNED_INT, reinterpret_cast<void*>(8 * sizeof(unsigned int)));
+    glLineWidth(1.5f);
+    uvVao.release();
+    uvProgram.release();
+    
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, fullWidth, fullHeight);
+}
+
+bool BaseGLWidget::computeGeodesics() {
+    if (!modelLoaded || !selectedVertices.any()) return false;
+    
+    std::vector<unsigned int> sources;
+    selectedVertices.collect(sources);
+    geodesics::Stats stats;
+    if (!geodesicSolver.compute(openMesh, sources, geodesicDistance, &stats)) {
+        qWarning() << "Geodesic distance requires a triangle mesh";
+        geodesicDistance.clear();
+        return false;
+    }
+    double maxDistance = 0.0;
+    for (double d : geodesicDistance) {
+        if (std::isfinite(d)) maxDistance = std::max(maxDistance, d);
+    }
+    qDebug() << "Geodesics from" << sources.size() << "sources: t =" << stats.time_step
+             << ", setup" << stats.setup_ms << "ms, factorize" << stats.factorize_ms << "ms, heat"
+             << stats.heat_ms << "ms, gradient" << stats.gradient_ms << "ms, poisson" << stats.poisson_ms << "ms";
+    
+    showDistanceField = true;
+    distanceFieldUploaded = false;
+    renderScheduler->markDirty();
+    emit geodesicsComputed(maxDistance, stats.factorize_ms, stats.heat_ms, stats.gradient_ms, stats.poisson_ms);
+    return true;
+}
+
+void BaseGLWidget::setShowDistanceField(bool show) {
+    showDistanceField = show;
+    requestRedraw();
+}
+
+void BaseGLWidget::setIsolineCount(int count) {
+    isolineCount = std::max(0, count);
+    requestRedraw();
+}
+
+void BaseGLWidget::uploadDistanceField() {
+    // 归一化到[0,1]，不可达的顶点取1
+    double maxDistance = 0.0;
+    for (double d : geodesicDistance) {
+        if (std::isfinite(d)) maxDistance = std::max(maxDistance, d);
+    }
+    std::vector<float> scalars(geodesicDistance.size());
+    parallel::for_each(0, scalars.size(), [&](size_t i) {
+        double d = geodesicDistance[i];
+        scalars[i] = std::isfinite(d) && maxDistance > 0.0 ? float(d / maxDistance) : 1.0f;
+    });
+    
+    vao.bind();
+    scalarVbo.bind();
+    scalarVbo.allocate(scalars.data(), int(scalars.size() * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr);
+    vao.release();
+    distanceFieldUploaded = true;
+}
+
+void BaseGLWidget::drawDistanceField(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    if (!distanceFieldUploaded) {
+        uploadDistanceField();
+    }
+    
+    distanceProgram.bind();
+    vao.bind();
+    faceEbo.bind();
+    
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    distanceProgram.setUniformValue("model", model);
+    distanceProgram.setUniformValue("view", view);
+    distanceProgram.setUniformValue("projection", projection);
+    distanceProgram.setUniformValue("normalMatrix", model.normalMatrix());
+    distanceProgram.setUniformValue("isolineCount", isolineCount);
+    
+    glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
+    
+    faceEbo.release();
+    vao.release();
+    distanceProgram.release();
+}
@@ -2,19 +2,35 @@
 #ifndef BASEGLWIDGET_H
 #define BASEGLWIDGET_H
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
 #include <QMatrix4x4>
+#include <QVector2D>
 #include <QVector3D>
 #include <QColor>
 #include <vector>
 #include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
 #include <QQuaternion>
+#include <QTimer>
+#include <QPolygon>
+#include "renderscheduler.h"
+#include "pointcloudrenderer.h"
+#include "meshscene.h"
 #include "../meshutils/my_traits.h"
+#include "../meshutils/mesh_bvh.h"
+#include "../meshutils/mesh_selection.h"
+#include "../meshutils/subdivision.h"
+#include "../meshutils/laplacian.h"
+#include "../meshutils/parameterization.h"
+#include "../meshutils/geodesics.h"
+#include "../meshutils/mesh_analysis.h"
+#include "../meshutils/icp.h"
+#include "../meshutils/surface_sampling.h"
+#include <future>
 
-class BaseGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
+class BaseGLWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 
@@ -27,11 +43,45 @@ public:
         FlatShading
     };
 
+    // 线框叠加方式：重心坐标单遍绘制，或传统的第二遍GL_LINES
+    enum OverlayStyle {
+        BarycentricOverlay,
+        LineOverlay
+    };
+
+    // GPU拾取的对象类型
+    enum PickMode {
+        PickVertex,
+        PickFace,
+        PickEdge
+    };
+    Q_ENUM(PickMode)
+
+    // 拾取实现：GPU ID缓冲，或在CPU上对BVH做射线求交（软件光栅化时更快）
+    enum PickBackend {
+        AutoPickBackend,
+        GpuPickBackend,
+        CpuRayPickBackend
+    };
+
+    // 区域选择工具：启用后左键拖动进行选择，而不是旋转视图
+    enum SelectionTool {
+        NoSelectionTool,
+        BoxSelection,
+        LassoSelection
+    };
+
+    enum SubdivisionScheme {
+        LoopSubdivision,        // 仅三角形网格
+        CatmullClarkSubdivision // 任意多边形网格，输出四边形
+    };
+
     void setBackgroundColor(const QColor& color);
     void setWireframeColor(const QVector4D& color);
     void setSurfaceColor(const QVector3D& color);
     void setSpecularEnabled(bool enabled);
     void setShowWireframeOverlay(bool show);
+    void setWireframeOverlayStyle(OverlayStyle style);
     void setHideFaces(bool hide);
     void setShowAxis(bool show);
     void resetView();
@@ -39,6 +89,114 @@ public:
     void loadOBJ(const QString &path);
     void clearMeshData();
     void setViewScale(float scale);
+    void setRenderMode(RenderMode mode);
+
+    // 经调度器合并后的重绘请求，状态未变化时不会真正重绘
+    void requestRedraw();
+    void setMaxInteractiveFps(int fps);
+    RenderScheduler* scheduler() const { return renderScheduler; }
+
+    // 异步GPU拾取：只在光标周围渲染ID，结果在回读完成后由elementPicked信号给出
+    void requestPick(const QPoint& screenPos, PickMode mode);
+    void setPickMode(PickMode mode) { pickMode = mode; }
+    void setPickBackend(PickBackend backend) { pickBackend = backend; }
+    bool usesCpuPicking() const;
+    // 同步射线拾取：命中时返回面、最近顶点和重心坐标（网格坐标系）
+    bool rayPick(const QPoint& screenPos, MeshBVH::Hit& hit);
+    void clearPickHighlight();
+
+    // 顶点选择：Shift拖动为添加，Alt拖动为减去，否则替换
+    void setSelectionTool(SelectionTool tool);
+    void growSelection(int rings = 1);
+    void shrinkSelection(int rings = 1);
+    void clearSelection();
+    size_t selectedVertexCount() const { return selectedVertices.count(); }
+    size_t selectedFaceCount() const { return selectedFaces.count(); }
+
+    // 细分预览：在扁平数组上细分并直接上传渲染，不修改openMesh；
+    // applySubdivision()把结果写回openMesh，discardSubdivision()恢复显示原网格
+    bool subdividePreview(SubdivisionScheme scheme, int levels, QString* error = nullptr);
+    void applySubdivision();
+    void discardSubdivision();
+    bool hasSubdivisionPreview() const { return showSubdivisionPreview; }
+
+    // QEM简化openMesh到原三角形数的ratio倍，分块并行后在块边界上收尾
+    bool decimateMesh(double ratio, bool preserveBoundary, bool preserveSeams);
+    // 各向同性重网格化；targetLength<=0时取当前平均边长
+    bool remeshIsotropic(double targetLength, int iterations, bool preserveBoundary);
+    double meanEdgeLength() const;
+
+    // 隐式拉普拉斯平滑，时间步为strength倍平均边长的平方；selectionOnly时只移动选中顶点
+    bool smoothMesh(double strength, int iterations, bool selectionOnly);
+    // 选中区域的双拉普拉斯光顺，未选中的顶点作为边界条件
+    bool fairSelection();
+    void setLaplacianSolver(laplacian::SolverType type) { laplacianCache.set_solver(type); }
+
+    // 圆盘拓扑网格的LSCM/ARAP参数化，结果写入mvt_list和hvt_index
+    bool computeParameterization(parameterization::Method method, int arapIterations);
+    // 右下角的二维UV视图，显示mvt_list/hvt_index中的纹理坐标
+    void setShowUVView(bool show);
+    bool hasTexCoords() const;
+    // 写出openMesh，withTexCoords时OBJ带vt
+    bool saveMesh(const QString& path, bool withTexCoords);
+
+    // 以选中顶点为源点的热方法测地距离，以色带加等值线显示
+    bool computeGeodesics();
+    void setShowDistanceField(bool show);
+    void setIsolineCount(int count);
+    void setGeodesicTimeScale(double scale) { geodesicSolver.set_time_scale(scale); }
+    const std::vector<double>& geodesicDistances() const { return geodesicDistance; }
+
+    // 焊接容差内的顶点、删除退化面和重复面、补不超过maxHoleEdges条边的洞；weldTolerance为平均边长的倍数
+    bool repairMesh(double weldTolerance, int maxHoleEdges, bool fairHoles);
+    // BVH粗测加三角形求交，相交面标成红色（不改动选择），clearFaceHighlight()清除
+    bool checkSelfIntersections();
+    void clearFaceHighlight();
+
+    // ICP配准：目标网格按当前网格的加载归一化放到同一坐标系；配准结果只作为网格的模型变换显示，
+    // commitAlignment()才把变换写入openMesh的顶点，resetAlignment()放弃
+    bool loadAlignmentTarget(const QString& path);
+    void clearAlignmentTarget();
+    bool hasAlignmentTarget() const { return !alignmentTarget.empty(); }
+    // 从当前变换出发做点到面ICP，iterationsPerStage为每级采样的最大迭代次数
+    bool alignToTarget(int iterationsPerStage);
+    void commitAlignment();
+    void resetAlignment();
+    bool hasPendingAlignment() const { return !alignment.isIdentity(); }
+
+    // 表面采样：面积加权随机采样或泊松圆盘采样（radiusFactor为平均边长的倍数），结果以点显示；
+    // 网格改变后样本作废。exportSamples写出二进制PLY，坐标换算回文件中的单位
+    bool sampleSurfaceRandom(int count, unsigned int seed);
+    bool sampleSurfacePoisson(double radiusFactor, unsigned int seed);
+    bool exportSamples(const QString& path) const;
+    void clearSamples();
+    void setShowSamples(bool show);
+    size_t sampleCount() const { return surfaceSamples.size(); }
+
+    // 点云：没有面的OBJ和PLY由loadOBJ转到这里，按八叉树LOD以点精灵绘制，openMesh保持为空。
+    // pointBudget为每帧最多绘制的点数，sizeScale为点精灵直径相对点间距的倍数
+    bool loadPointCloud(const QString& path);
+    bool hasPointCloud() const { return !pointCloud.empty(); }
+    void setPointBudget(int points);
+    void setPointSizeScale(float scale);
+    void setPointNormalShading(bool enabled);
+    void setPointColors(bool enabled);
+
+    // 多对象场景：零件保持文件坐标，各自带平移、旋转、缩放、颜色和可见性，共享一块arena一次画出。
+    // 主网格已加载时场景沿用主网格的归一化（同一坐标系的零件与主网格对齐），否则按场景自身的包围盒归一化
+    int addSceneObject(const QString& path);
+    void removeSceneObject(int index);
+    void clearScene();
+    const MeshScene& meshScene() const { return scene; }
+    void setSceneObjectTransform(int index, const QVector3D& translation, const QVector3D& eulerDegrees, float scale);
+    void setSceneObjectColor(int index, const QColor& color);
+    void setSceneObjectVisible(int index, bool visible);
+    // 把对象变成nx×ny×nz个实例的阵列（几何不重复上传），相邻实例间隔为包围盒尺寸的(1 + gap)倍；
+    // 三个数都为1时恢复为单个对象
+    void setSceneObjectArray(int index, int nx, int ny, int nz, float gap);
+
+    // 最近一次完成的网格统计（加载和编辑后在工作线程上重新计算）
+    const mesh_analysis::Report& meshReport() const { return analysisReport; }
 
     QVector3D surfaceColor = QVector3D(1.0f, 1.0f, 0.0f);
     bool specularEnabled = true;
@@ -57,6 +215,9 @@ public:
     float zoom;
     
     bool showWireframeOverlay;
+    OverlayStyle overlayStyle = BarycentricOverlay;
+    PickMode pickMode = PickFace;
+    PickBackend pickBackend = AutoPickBackend;
     bool hideFaces;
     bool modelLoaded;
 
@@ -65,6 +226,34 @@ public:
     float viewScale = 1.5f;
     QVector3D eyePosition;
 
+signals:
+    // index为OpenMesh中的顶点/面/边索引，未命中时为-1
+    void elementPicked(BaseGLWidget::PickMode mode, int index);
+    // CPU射线拾取的完整结果
+    void surfaceHit(int face, int vertex, const QVector3D& barycentric, const QVector3D& point);
+    void selectionChanged(int vertexCount, int faceCount);
+    void subdivisionFinished(int vertexCount, int faceCount, double milliseconds);
+    void decimationFinished(int inputFaces, int outputFaces, int blocks, double milliseconds);
+    void remeshFinished(int faceCount, double targetLength, double milliseconds);
+    void laplacianSolved(double assembleMs, double factorizeMs, double solveMs, bool reusedSymbolic);
+    void parameterizationFinished(double factorizeMs, double solveMs, double localMs, bool reusedFactorization, int flippedFaces);
+    void geodesicsComputed(double maxDistance, double factorizeMs, double heatMs, double gradientMs, double poissonMs);
+    // 在GUI线程上发出，面积和体积已换算回文件中的单位
+    void meshAnalyzed(const mesh_analysis::Report& report);
+    void repairFinished(int weldedVertices, int removedFaces, int holesFilled, int holesSkipped, double milliseconds);
+    void selfIntersectionsChecked(int intersectingPairs, int faceCount, int candidatePairs, double buildMs, double testMs);
+    // rms为加载时的文件单位
+    void alignmentFinished(double initialRms, double rms, int iterations, int correspondences, bool converged, double milliseconds);
+    // candidates只在泊松圆盘采样时非零
+    void samplingFinished(int sampleCount, int candidates, double setupMs, double sampleMs, double selectMs);
+    void pointCloudLoaded(int pointCount, int nodeCount, bool hasNormals, bool hasColors, double readMs, double buildMs);
+    // 每帧实际绘制的点数和节点区间数，变化时发出
+    void pointCloudDrawn(int pointCount, int nodeCount);
+    // 场景中对象增删或实例变化后发出（变换、颜色、可见性的修改不发出）
+    void sceneChanged();
+    // 每帧剔除后画出的副本数和绘制调用数，变化时发出
+    void sceneDrawn(int visibleCopies, int drawCalls);
+
 protected:
     void initializeGL() override;
     void resizeGL(int w, int h) override;
@@ -82,11 +271,51 @@ protected:
     void prepareEdgeIndices();
     void saveOriginalMesh();
     void updateBuffersFromOpenMesh();
+    void ensureVertexNormals();
     void initializeShaders();
     void drawWireframe(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
     void drawWireframeOverlay(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    void setWireOverlayUniforms(QOpenGLShaderProgram& program);
+    void setFaceColorUniforms(QOpenGLShaderProgram& program);
+    void uploadTriangleColors();
+    void ensureEdgeIndices();
     void drawXYZAxis(const QMatrix4x4& view, const QMatrix4x4& projection);
     QVector3D projectToTrackball(const QPoint& screenPos);
+    quint64 renderStateHash() const;
+    void computeViewMatrices(QMatrix4x4& model, QMatrix4x4& view, QMatrix4x4& projection) const;
+    
+    void ensurePickResources();
+    void releasePickResources();
+    void pollPickResults();
+    int resolvePickId(PickMode mode, unsigned int id) const;
+    void finishPick(PickMode mode, int index);
+    void setPickHighlight(PickMode mode, int index);
+    void drawPickHighlight(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    
+    void applyRegionSelection(mesh_selection::Op op);
+    void onSelectionChanged();
+    void drawSelection(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    void drawSelectionRegion();
+    
+    void onMeshTopologyChanged();
+    void onMeshGeometryChanged();
+    // 在工作线程上分析openMesh；修改openMesh之前必须先waitForMeshAnalysis()
+    void startMeshAnalysis();
+    void waitForMeshAnalysis();
+    void uploadSubdivisionPreview();
+    void drawSubdivisionPreview(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    void uploadUVView();
+    void clearTexCoords();
+    void drawUVView();
+    void uploadDistanceField();
+    void drawDistanceField(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    QMatrix4x4 alignmentMatrix() const;
+    void drawAlignmentTarget(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    void uploadSamples();
+    void drawSamples(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    void drawPointCloud();
+    void updateSceneNormalization();
+    void drawScene(const QMatrix4x4& view, const QMatrix4x4& projection);
 
     // 初始视图状态
     QQuaternion initialRotation;
@@ -106,14 +335,153 @@ protected:
     bool isDragging;
     QPoint lastMousePos;
 
+    RenderScheduler* renderScheduler;
+
     QOpenGLShaderProgram wireframeProgram;
     QOpenGLShaderProgram blinnPhongProgram;
     QOpenGLShaderProgram flatProgram;
+    QOpenGLShaderProgram blinnPhongWireProgram;  // 带几何着色器的单遍线框变体
+    QOpenGLShaderProgram flatWireProgram;
+    bool baryOverlayAvailable = false;
 
     QOpenGLVertexArrayObject vao;
     QOpenGLBuffer vbo;
     QOpenGLBuffer ebo;
     QOpenGLBuffer faceEbo;
+
+    // 顶点法线只有Blinn-Phong需要，按需计算并上传；平面着色完全在GPU端完成
+    bool vertexNormalsUploaded = false;
+
+    // 每个三角形4位的边掩码（见wireframe_overlay.geom），以SSBO形式上传
+    std::vector<unsigned int> triangleEdgeMasks;
+    GLuint edgeMaskBuffer = 0;
+    // edges索引只在隐藏面或GL_LINES叠加时才需要，按需生成
+    bool edgesUploaded = false;
+
+    // 每个渲染三角形所属的OpenMesh面，用于把gl_PrimitiveID映射回面
+    std::vector<int> triangleFaces;
+    // 每个三角形一个RGBA8颜色，alpha为0时使用surfaceColor；以SSBO形式上传到binding 1
+    std::vector<unsigned int> triangleColors;
+    GLuint faceColorBuffer = 0;
+
+    // GPU拾取：PickRegionSize见方的R32UI离屏缓冲，经两个PBO轮流异步回读
+    static const int PickRegionSize = 15;
+    struct PendingPick {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        PickMode mode = PickFace;
+        unsigned int generation = 0;
+    };
+    QOpenGLShaderProgram pickVertexProgram;
+    QOpenGLShaderProgram pickPrimitiveProgram;
+    GLuint pickFbo = 0;
+    GLuint pickColorTex = 0;
+    GLuint pickDepthRb = 0;
+    PendingPick pickSlots[2];
+    int nextPickSlot = 0;
+    unsigned int meshGeneration = 0;  // 网格重载后丢弃尚未完成的拾取
+    QTimer pickPollTimer;
+    bool softwareRenderer = false;  // llvmpipe等软件实现，默认改用CPU拾取
+
+    // CPU拾取用的BVH，首次射线拾取时构建
+    MeshBVH pickBvh;
+
+    // 拾取结果高亮
+    PickMode highlightMode = PickFace;
+    int highlightIndex = -1;
+    std::vector<unsigned int> highlightIndices;
+    bool highlightUploaded = false;
+    QOpenGLBuffer highlightEbo;
+
+    // 选择集（每个元素1位），变化后同步到OpenMesh的status
+    SelectionBitset selectedVertices;
+    SelectionBitset selectedFaces;
+    SelectionTool selectionTool = NoSelectionTool;
+    bool selectingRegion = false;
+    QPolygon selectionPath;  // 框选时为起止两点，套索时为整条轨迹
+    Qt::KeyboardModifiers selectionModifiers;
+
+    // 选中元素的索引子缓冲：按网格大小一次分配，选择变化时只改写前面有效的部分
+    // 布局为[选中顶点 | 选中面的三角形]
+    QOpenGLBuffer selectionEbo;
+    size_t selectionEboCapacity = 0;
+    int selectedPointCount = 0;
+    int selectedTriangleIndexCount = 0;
+    bool selectionUploaded = true;
+
+    // 细分预览：独立的VAO/缓冲，VBO布局为[位置 | 法线]
+    subdivision::FlatMesh subdivisionResult;
+    bool showSubdivisionPreview = false;
+    QOpenGLShaderProgram subdivisionProgram;
+    QOpenGLVertexArrayObject previewVao;
+    QOpenGLBuffer previewVbo;
+    QOpenGLBuffer previewEbo;
+    QOpenGLBuffer previewEdgeEbo;
+    int previewTriangleIndexCount = 0;
+    int previewEdgeIndexCount = 0;
+
+    // 拉普拉斯矩阵和分解在多次平滑/光顺之间复用
+    laplacian::OperatorCache laplacianCache;
+
+    // 参数化的边界、固定点和分解在多次计算之间复用
+    parameterization::Parameterizer parameterizer;
+
+    // UV视图：VBO为[纹理坐标 | 包围框四角]，EBO为[包围框的4条边 | 各面的边]
+    bool showUVView = false;
+    bool uvUploaded = false;
+    QOpenGLShaderProgram uvProgram;
+    QOpenGLVertexArrayObject uvVao;
+    QOpenGLBuffer uvVbo;
+    QOpenGLBuffer uvEbo;
+    int uvEdgeIndexCount = 0;
+    QVector2D uvMin;
+    QVector2D uvMax;
+
+    // 测地距离场：归一化后放在独立的VBO里作为VAO的属性2，用curvature着色器绘制
+    geodesics::HeatSolver geodesicSolver;
+    std::vector<double> geodesicDistance;
+    bool showDistanceField = false;
+    bool distanceFieldUploaded = false;
+    int isolineCount = 20;
+    QOpenGLShaderProgram distanceProgram;
+    QOpenGLBuffer scalarVbo;
+
+    // 网格统计：工作线程只读openMesh，结果按meshGeneration丢弃过期的
+    std::future<void> analysisTask;
+    mesh_analysis::Report analysisReport;
+    // 加载时的归一化：p' = (p - loadCenter) / loadHalfExtent，loadHalfExtent为包围盒最长边的一半。
+    // 与CGALGLWidget的loadScale（乘数，2 / 最长边）互为倒数
+    double loadHalfExtent = 1.0;
+    Mesh::Point loadCenter = Mesh::Point(0, 0, 0);  // 加载时归一化前的包围盒中心
+
+    // ICP配准：目标的顶点、法向和近邻索引在多次配准间复用；alignment作用在openMesh上，
+    // 由computeViewMatrices并入model矩阵，拾取和区域选择因此与显示一致。
+    // 目标VAO的VBO布局为[位置 | 法线]，用blinnPhongProgram绘制
+    icp::Target alignmentTarget;
+    Eigen::Matrix4d alignment = Eigen::Matrix4d::Identity();
+    int alignmentRevision = 0;
+    QOpenGLVertexArrayObject targetVao;
+    QOpenGLBuffer targetVbo;
+    QOpenGLBuffer targetEbo;
+    int targetIndexCount = 0;
+
+    // 表面采样点：独立的VAO只有位置属性，用wireframeProgram以GL_POINTS绘制
+    surface_sampling::Samples surfaceSamples;
+    bool showSamples = true;
+    QOpenGLVertexArrayObject sampleVao;
+    QOpenGLBuffer sampleVbo;
+    int samplePointCount = 0;
+
+    PointCloudRenderer pointCloud;
+    size_t reportedDrawnPoints = 0;
+    size_t reportedDrawnNodes = 0;
+
+    MeshScene scene;
+    // 未加载主网格时场景的归一化：(p - sceneCenter) / sceneHalfExtent
+    QVector3D sceneCenter;
+    float sceneHalfExtent = 1.0f;
+    size_t reportedSceneCopies = 0;
+    int reportedSceneDrawCalls = 0;
 };
 
 #endif // BASEGLWIDGET_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 // cgalglwidget.cpp
 #include "cgalglwidget.h"
+#include "shader_utils.h"
 #include <QFile>
 #include <QDebug>
 #include <QMouseEvent>
@@ -9,6 +10,7 @@
 #include <QVector3D>
 #include <QtMath>
 #include <QResource>
+#include <QElapsedTimer>
 #include <algorithm>
 #include <QPainter>
 #include <QFont>
@@ -18,7 +20,140 @@
 #include <CGAL/Polygon_mesh_processing/compute_normal.h>
 #include <CGAL/Polygon_mesh_processing/measure.h>
 #include <CGAL/Polygon_mesh_processing/distance.h>
+#include <CGAL/Polygon_mesh_processing/self_intersections.h>
+#include <CGAL/Polygon_mesh_processing/corefinement.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
 #include <CGAL/Side_of_triangle_mesh.h>
+#include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
+#include <CGAL/boost/graph/helpers.h>
+#include <numeric>
+#include <functional>
+#include "../meshutils/parallel_utils.h"
+
+// 链接了TBB时CGAL算法走并行版本
+#ifdef CGAL_LINKED_WITH_TBB
+typedef CGAL::Parallel_tag Concurrency_tag;
+#else
+typedef CGAL::Sequential_tag Concurrency_tag;
+#endif
+
+namespace {
+    // 控件析构时由进度点抛出，让工作线程尽快退出
+    struct BooleanCancelled {};
+    
+    // corefinement各阶段的进度映射到0-100，百分比变化时才回调。
+    // 访问者在命名参数中会被复制，状态放在共享对象里
+    struct BooleanProgress {
+        std::function<void(int, const char*)> callback;
+        std::shared_ptr<std::atomic<bool>> cancel;
+        int last = -1;
+        int base = 0;
+        int span = 0;
+        size_t total = 0;
+        size_t done = 0;
+        const char* stage = "";
+        
+        void set(int percent, const char* name) {
+            if (cancel && *cancel) throw BooleanCancelled();
+            stage = name;
+            if (percent == last) return;
+            last = percent;
+            callback(percent, name);
+        }
+        void start(int from, int width, size_t count, const char* name) {
+            base = from;
+            span = width;
+            total = count;
+            done = 0;
+            set(from, name);
+        }
+        void step() {
+            ++done;
+            if (total > 0) set(base + int(span * std::min(done, total) / total), stage);
+        }
+    };
+    
+    struct BooleanProgressVisitor : public PMP::Corefinement::Default_visitor<CgalMesh> {
+        std::shared_ptr<BooleanProgress> progress;
+        
+        explicit BooleanProgressVisitor(std::shared_ptr<BooleanProgress> p) : progress(std::move(p)) {}
+        
+        void start_filtering_intersections() const { progress->set(10, "Filtering intersections"); }
+        void progress_filtering_intersections(double d) const { progress->set(10 + int(30 * d), "Filtering intersections"); }
+        void start_handling_edge_face_intersections(std::size_t n) const { progress->start(40, 15, n, "Intersecting edges and faces"); }
+        void edge_face_intersections_step() const { progress->step(); }
+        void start_handling_intersection_of_coplanar_faces(std::size_t n) const { progress->start(55, 5, n, "Intersecting coplanar faces"); }
+        void intersection_of_coplanar_faces_step() const { progress->step(); }
+        void start_triangulating_faces(std::size_t n) const { progress->start(60, 30, n, "Triangulating faces"); }
+        void triangulating_faces_step() const { progress->step(); }
+        void start_building_output() const { progress->set(90, "Building output"); }
+    };
+}
+
+CachedAABBTree::CachedAABBTree(const std::shared_ptr<CgalMesh>& mesh) : mesh(mesh) {
+}
+
+CachedAABBTree::~CachedAABBTree() {
+    if (pending.valid()) {
+        pending.wait();
+    }
+}
+
+CachedAABBTree::TreePtr CachedAABBTree::tree() {
+    return treeAsync().get();
+}
+
+std::shared_future<CachedAABBTree::TreePtr> CachedAABBTree::treeAsync() {
+    if (pending.valid()) {
+        return pending;
+    }
+    // 构建线程只碰自己持有的网格指针；结构体把树和它引用的网格放在一起
+    struct TreeWithMesh {
+        std::shared_ptr<const CgalMesh> mesh;
+        AABBTree tree;
+        explicit TreeWithMesh(std::shared_ptr<const CgalMesh> source)
+            : mesh(std::move(source)), tree(faces(*mesh).first, faces(*mesh).second, *mesh) {}
+    };
+    std::shared_ptr<const CgalMesh> source = mesh;
+    std::atomic<qint64>* time = &buildTimeMs;
+    pending = std::async(std::launch::async, [source, time]() {
+        QElapsedTimer timer;
+        timer.start();
+        std::shared_ptr<TreeWithMesh> built = std::make_shared<TreeWithMesh>(source);
+        built->tree.build();
+        // 为最近点/距离查询预建kd树
+        built->tree.accelerate_distance_queries();
+        *time = timer.elapsed();
+        qDebug() << "AABB tree built:" << source->number_of_faces() << "faces in" << qint64(*time) << "ms";
+        return TreePtr(built, &built->tree);
+    }).share();
+    return pending;
+}
+
+void CachedAABBTree::buildAsync() {
+    if (mesh->number_of_faces() == 0) {
+        return;
+    }
+    treeAsync();
+}
+
+void CachedAABBTree::invalidate() {
+    // 构建线程只读它自己持有的网格，之后可以放心替换网格；
+    // 没有其他持有者时，丢弃std::async的结果仍会等构建结束
+    pending = std::shared_future<TreePtr>();
+    closed = -1;
+}
+
+bool CachedAABBTree::isBuilt() const {
+    return pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool CachedAABBTree::isClosed() {
+    if (closed < 0) {
+        closed = CGAL::is_closed(*mesh) ? 1 : 0;
+    }
+    return closed == 1;
+}
 
 CGALGLWidget::CGALGLWidget(QWidget *parent) : QOpenGLWidget(parent),
     vbo(QOpenGLBuffer::VertexBuffer),
@@ -35,6 +170,10 @@ CGALGLWidget::CGALGLWidget(QWidget *parent) : QOpenGLWidget(parent),
     setFormat(format);
     
     setFocusPolicy(Qt::StrongFocus);
+    
+    renderScheduler = new RenderScheduler(this);
+    renderScheduler->setStateHashFunction([this]() { return renderStateHash(); });
+    
     rotation = QQuaternion();
     zoom = 1.0f;
     modelLoaded = false;
@@ -60,30 +199,65 @@ CGALGLWidget::CGALGLWidget(QWidget *parent) : QOpenGLWidget(parent),
 
 void CGALGLWidget::setShowAxis(bool show) {
     showAxis = show;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::setViewScale(float scale) {
     viewScale = scale;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::setHideFaces(bool hide) {
     hideFaces = hide;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::setShowWireframeOverlay(bool show) {
     showWireframeOverlay = show;
-    update();
+    requestRedraw();
+}
+
+void CGALGLWidget::setRenderMode(RenderMode mode) {
+    currentRenderMode = mode;
+    requestRedraw();
+}
+
+void CGALGLWidget::requestRedraw() {
+    renderScheduler->requestUpdate();
+}
+
+void CGALGLWidget::setMaxInteractiveFps(int fps) {
+    renderScheduler->setMaxInteractiveFps(fps);
+}
+
+quint64 CGALGLWidget::renderStateHash() const {
+    // 所有影响画面的状态；网格和缓冲区的变化通过markDirty()单独标记
+    RenderStateHash h;
+    h.add(rotation).add(zoom).add(modelCenter).add(viewDistance).add(viewScale)
+     .add(bgColor).add(surfaceColor).add(wireframeColor).add(specularEnabled)
+     .add(int(currentRenderMode)).add(int(overlayStyle))
+     .add(showWireframeOverlay).add(hideFaces).add(showAxis).add(modelLoaded)
+     .add(quint64(pointCloud.pointCount())).add(quint64(pointCloud.pointBudget())).add(pointCloud.pointSizeScale())
+     .add(pointCloud.normalShadingEnabled()).add(pointCloud.vertexColorsEnabled()).add(size());
+    return h.value();
+}
+
+void CGALGLWidget::setWireframeOverlayStyle(OverlayStyle style) {
+    overlayStyle = style;
+    requestRedraw();
 }
 
 void CGALGLWidget::setWireframeColor(const QVector4D& color) {
     wireframeColor = color;
-    update();
+    requestRedraw();
 }
 
 CGALGLWidget::~CGALGLWidget() {
+    // 排队的回调指向this，必须等工作线程退出；先让它在下一个进度点放弃
+    if (booleanCancel) {
+        *booleanCancel = true;
+    }
+    waitForBoolean();
     makeCurrent();
     vao.destroy();
     vbo.destroy();
@@ -91,6 +265,13 @@ CGALGLWidget::~CGALGLWidget() {
     faceEbo.destroy();
     axisVbo.destroy();
     axisEbo.destroy();
+    if (edgeMaskBuffer) {
+        glDeleteBuffers(1, &edgeMaskBuffer);
+    }
+    if (faceColorBuffer) {
+        glDeleteBuffers(1, &faceColorBuffer);
+    }
+    pointCloud.release();
     doneCurrent();
 }
 
@@ -100,7 +281,7 @@ void CGALGLWidget::resetView() {
     modelCenter = initialModelCenter;
     viewDistance = initialViewDistance;
     viewScale = initialViewScale;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::setBackgroundColor(const QColor& color) {
@@ -108,7 +289,7 @@ void CGALGLWidget::setBackgroundColor(const QColor& color) {
     makeCurrent();
     glClearColor(bgColor.redF(), bgColor.greenF(), bgColor.blueF(), bgColor.alphaF());
     doneCurrent();
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::initializeGL() {
@@ -121,6 +302,9 @@ void CGALGLWidget::initializeGL() {
     vbo.create();
     ebo.create();
     faceEbo.create();
+    glGenBuffers(1, &edgeMaskBuffer);
+    glGenBuffers(1, &faceColorBuffer);
+    pointCloud.initialize();
     
     axisVbo.create();
     axisEbo.create();
@@ -158,13 +342,13 @@ void CGALGLWidget::initializeGL() {
 void CGALGLWidget::computeNormals() {
     // 计算面法线
     face_normals.clear();
-    face_normals.reserve(mesh.number_of_faces());
+    face_normals.reserve(mesh->number_of_faces());
     
-    for(auto face : mesh.faces()) {
+    for(auto face : mesh->faces()) {
         // 获取面的顶点
         std::vector<Point> points;
-        for(auto vertex : CGAL::vertices_around_face(mesh.halfedge(face), mesh)) {
-            points.push_back(mesh.point(vertex));
+        for(auto vertex : CGAL::vertices_around_face(mesh->halfedge(face), *mesh)) {
+            points.push_back(mesh->point(vertex));
         }
         
         // 计算面法线
@@ -181,11 +365,11 @@ void CGALGLWidget::computeNormals() {
     
     // 计算顶点法线（平均相邻面的法线）
     vertex_normals.clear();
-    vertex_normals.resize(mesh.number_of_vertices(), Vector(0, 0, 0));
+    vertex_normals.resize(mesh->number_of_vertices(), Vector(0, 0, 0));
     
     int face_idx = 0;
-    for(auto face : mesh.faces()) {
-        for(auto vertex : CGAL::vertices_around_face(mesh.halfedge(face), mesh)) {
+    for(auto face : mesh->faces()) {
+        for(auto vertex : CGAL::vertices_around_face(mesh->halfedge(face), *mesh)) {
             vertex_normals[vertex.idx()] = vertex_normals[vertex.idx()] + face_normals[face_idx];
         }
         face_idx++;
@@ -198,12 +382,14 @@ void CGALGLWidget::computeNormals() {
             normal = normal / length;
         }
     }
+    normalsDirty = false;
 }
 
 void CGALGLWidget::initializeShaders() {
     wireframeProgram.removeAllShaders();
     blinnPhongProgram.removeAllShaders();
     flatProgram.removeAllShaders();  // 确保清除旧的着色器
+    curvatureProgram.removeAllShaders();
 
     wireframeProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/wireframe.vert");
     wireframeProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/wireframe.frag");
@@ -217,6 +403,28 @@ void CGALGLWidget::initializeShaders() {
     flatProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/flat.vert");
     flatProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/flat.frag");
     flatProgram.link();
+    
+    curvatureProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/curvature.vert");
+    curvatureProgram.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/curvature.frag");
+    curvatureProgram.link();
+
+    // 单遍重心坐标线框：同一份着色器加几何着色器编译出的变体，
+    // 链接失败（驱动不支持几何着色器）时退回GL_LINES叠加
+    blinnPhongWireProgram.removeAllShaders();
+    flatWireProgram.removeAllShaders();
+    
+    blinnPhongWireProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/blinnphong.vert");
+    ShaderUtils::addShaderWithDefines(blinnPhongWireProgram, QOpenGLShader::Geometry, ":/glwidget/shaders/wireframe_overlay.geom", QByteArray());
+    ShaderUtils::addShaderWithDefines(blinnPhongWireProgram, QOpenGLShader::Fragment, ":/glwidget/shaders/blinnphong.frag", "#define BARY_WIREFRAME\n");
+    
+    flatWireProgram.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/flat.vert");
+    ShaderUtils::addShaderWithDefines(flatWireProgram, QOpenGLShader::Geometry, ":/glwidget/shaders/wireframe_overlay.geom", "#define NO_NORMAL\n");
+    ShaderUtils::addShaderWithDefines(flatWireProgram, QOpenGLShader::Fragment, ":/glwidget/shaders/flat.frag", "#define BARY_WIREFRAME\n");
+    
+    baryOverlayAvailable = blinnPhongWireProgram.link() && flatWireProgram.link();
+    if (!baryOverlayAvailable) {
+        qWarning() << "Barycentric wireframe overlay unavailable, falling back to GL_LINES";
+    }
 
     if (modelLoaded) {
         updateBuffersFromCGALMesh();
@@ -224,39 +432,36 @@ void CGALGLWidget::initializeShaders() {
 }
 
 void CGALGLWidget::updateBuffersFromCGALMesh() {
-    if (mesh.number_of_vertices() == 0) return;
+    if (mesh->number_of_vertices() == 0) return;
     
     std::vector<float> vertices;
-    std::vector<float> normals;
+    vertices.reserve(mesh->number_of_vertices() * 3);
     
     // 提取顶点数据
-    for(auto v : mesh.vertices()) {
-        const Point& p = mesh.point(v);
+    for(auto v : mesh->vertices()) {
+        const Point& p = mesh->point(v);
         vertices.push_back(p.x());
         vertices.push_back(p.y());
         vertices.push_back(p.z());
-        
-        // 使用计算的法线
-        if(v.idx() < vertex_normals.size()) {
-            const Vector& n = vertex_normals[v.idx()];
-            normals.push_back(n.x());
-            normals.push_back(n.y());
-            normals.push_back(n.z());
-        } else {
-            normals.push_back(0.0f);
-            normals.push_back(1.0f);
-            normals.push_back(0.0f);
-        }
     }
     
     vao.bind();
     vbo.bind();
     
+    // 法线区域先只分配不写入，由ensureVertexNormals按需填充
     int vertexSize = vertices.size() * sizeof(float);
-    int normalSize = normals.size() * sizeof(float);
-    vbo.allocate(vertexSize + normalSize);
+    int normalSize = vertexSize;
+    int scalarSize = mesh->number_of_vertices() * sizeof(float);
+    vbo.allocate(vertexSize + normalSize + scalarSize);
     vbo.write(0, vertices.data(), vertexSize);
-    vbo.write(vertexSize, normals.data(), normalSize);
+    vertexNormalsUploaded = false;
+    
+    // 标量区域（距离/曲率）放在法线之后，由uploadVertexScalars单独更新
+    std::vector<float> scalars(mesh->number_of_vertices(), 0.0f);
+    if (vertexScalars.size() == scalars.size()) {
+        scalars = vertexScalars;
+    }
+    vbo.write(vertexSize + normalSize, scalars.data(), scalarSize);
     
     wireframeProgram.bind();
     int posLoc = wireframeProgram.attributeLocation("aPos");
@@ -277,14 +482,79 @@ void CGALGLWidget::updateBuffersFromCGALMesh() {
         blinnPhongProgram.enableAttributeArray(normalLoc);
         blinnPhongProgram.setAttributeBuffer(normalLoc, GL_FLOAT, vertexSize, 3, 3 * sizeof(float));
     }
-
-    ebo.bind();
-    ebo.allocate(edges.data(), edges.size() * sizeof(unsigned int));
     
+    curvatureProgram.bind();
+    int scalarLoc = curvatureProgram.attributeLocation("aCurvature");
+    if (scalarLoc != -1) {
+        curvatureProgram.enableAttributeArray(scalarLoc);
+        curvatureProgram.setAttributeBuffer(scalarLoc, GL_FLOAT, vertexSize + normalSize, 1, sizeof(float));
+    }
+
     faceEbo.bind();
     faceEbo.allocate(faces.data(), faces.size() * sizeof(unsigned int));
     
     vao.release();
+    
+    // 边索引在需要时才生成上传
+    edgesUploaded = false;
+    
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, edgeMaskBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, triangleEdgeMasks.size() * sizeof(unsigned int),
+                 triangleEdgeMasks.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    
+    renderScheduler->markDirty();
+}
+
+void CGALGLWidget::ensureEdgeIndices() {
+    if (edgesUploaded) return;
+    
+    edges.clear();
+    prepareEdgeIndices();
+    
+    vao.bind();
+    ebo.bind();
+    ebo.allocate(edges.data(), edges.size() * sizeof(unsigned int));
+    vao.release();
+    edgesUploaded = true;
+}
+
+void CGALGLWidget::setWireOverlayUniforms(QOpenGLShaderProgram& program) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, edgeMaskBuffer);
+    program.setUniformValue("useEdgeMasks", !triangleEdgeMasks.empty());
+    program.setUniformValue("lineColor", wireframeColor);
+    program.setUniformValue("lineWidth", 1.5f);
+}
+
+void CGALGLWidget::setFaceColorUniforms(QOpenGLShaderProgram& program) {
+    bool enabled = !triangleColors.empty() && triangleColors.size() * 3 == faces.size();
+    if (enabled) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, faceColorBuffer);
+    }
+    program.setUniformValue("faceColorsEnabled", enabled);
+}
+
+void CGALGLWidget::ensureVertexNormals() {
+    if (vertexNormalsUploaded || mesh->number_of_vertices() == 0) return;
+    
+    if (normalsDirty) {
+        computeNormals();
+    }
+    
+    std::vector<float> normals;
+    normals.reserve(vertex_normals.size() * 3);
+    for (const Vector& n : vertex_normals) {
+        normals.push_back(n.x());
+        normals.push_back(n.y());
+        normals.push_back(n.z());
+    }
+    
+    // 法线区域紧跟在位置区域之后，两者大小相同
+    int size = normals.size() * sizeof(float);
+    vbo.bind();
+    vbo.write(size, normals.data(), size);
+    vbo.release();
+    vertexNormalsUploaded = true;
 }
 
 void CGALGLWidget::resizeGL(int w, int h) {
@@ -292,21 +562,22 @@ void CGALGLWidget::resizeGL(int w, int h) {
 }
 
 void CGALGLWidget::paintGL() {
+    renderScheduler->frameStarted();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (!modelLoaded || mesh.number_of_vertices() == 0) {
+    if (!pointCloud.empty()) {
+        drawPointCloud();
+        renderScheduler->frameFinished();
+        return;
+    }
+
+    if (!modelLoaded || mesh->number_of_vertices() == 0) {
+        renderScheduler->frameFinished();
         return;
     }
 
     QMatrix4x4 model, view, projection;
-    
-    model.rotate(rotation);
-    model.scale(zoom);
-    
-    QVector3D eyePosition(0, 0, viewDistance * viewScale);
-    view.lookAt(eyePosition, modelCenter, QVector3D(0, 1, 0));
-    
-    projection.perspective(45.0f, width() / float(height()), 0.1f, 100.0f);
+    computeViewMatrices(model, view, projection);
     
     QMatrix3x3 normalMatrix = model.normalMatrix();
 
@@ -325,65 +596,96 @@ void CGALGLWidget::paintGL() {
         QVector3D(1.0f, 1.0f, 1.0f)
     };
 
+    // 重心坐标线框：线框在填充同一遍中画出，仅对Blinn-Phong/平面着色有效
+    bool singlePassOverlay = showWireframeOverlay && overlayStyle == BarycentricOverlay
+                             && baryOverlayAvailable
+                             && (currentRenderMode == BlinnPhong || currentRenderMode == FlatShading);
+
     if (hideFaces) {
         drawWireframe(model, view, projection);
     } else {
         if (currentRenderMode == BlinnPhong) {
-            blinnPhongProgram.bind();
+            ensureVertexNormals();
+            QOpenGLShaderProgram& program = singlePassOverlay ? blinnPhongWireProgram : blinnPhongProgram;
+            program.bind();
             vao.bind();
             faceEbo.bind();
             
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            blinnPhongProgram.setUniformValue("model", model);
-            blinnPhongProgram.setUniformValue("view", view);
-            blinnPhongProgram.setUniformValue("projection", projection);
-            blinnPhongProgram.setUniformValue("normalMatrix", normalMatrix);
+            program.setUniformValue("model", model);
+            program.setUniformValue("view", view);
+            program.setUniformValue("projection", projection);
+            program.setUniformValue("normalMatrix", normalMatrix);
             
             // 设置三个光源的位置和颜色
             for (int i = 0; i < 3; i++) {
-                blinnPhongProgram.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
-                blinnPhongProgram.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
+                program.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+                program.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
             }
             
-            blinnPhongProgram.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
-            blinnPhongProgram.setUniformValue("objectColor", surfaceColor);
-            blinnPhongProgram.setUniformValue("specularEnabled", specularEnabled);
+            program.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
+            program.setUniformValue("objectColor", surfaceColor);
+            program.setUniformValue("specularEnabled", specularEnabled);
+            setFaceColorUniforms(program);
+            if (singlePassOverlay) {
+                setWireOverlayUniforms(program);
+            }
 
             glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
 
             faceEbo.release();
             vao.release();
-            blinnPhongProgram.release();
+            program.release();
         } else if (currentRenderMode == FlatShading) {
             // Flat Shading渲染
-            flatProgram.bind();
+            QOpenGLShaderProgram& program = singlePassOverlay ? flatWireProgram : flatProgram;
+            program.bind();
             vao.bind();
             faceEbo.bind();
             
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            flatProgram.setUniformValue("model", model);
-            flatProgram.setUniformValue("view", view);
-            flatProgram.setUniformValue("projection", projection);
-            flatProgram.setUniformValue("normalMatrix", normalMatrix);
+            program.setUniformValue("model", model);
+            program.setUniformValue("view", view);
+            program.setUniformValue("projection", projection);
             
             // 设置三个光源的位置和颜色
             for (int i = 0; i < 3; i++) {
-                flatProgram.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
-                flatProgram.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
+                program.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+                program.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
             }
             
-            flatProgram.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
-            flatProgram.setUniformValue("objectColor", surfaceColor);
-            flatProgram.setUniformValue("specularEnabled", specularEnabled);
+            program.setUniformValue("viewPos", QVector3D(0, 0, viewDistance * viewScale));
+            program.setUniformValue("objectColor", surfaceColor);
+            program.setUniformValue("specularEnabled", specularEnabled);
+            setFaceColorUniforms(program);
+            if (singlePassOverlay) {
+                setWireOverlayUniforms(program);
+            }
 
             glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
 
             faceEbo.release();
             vao.release();
-            flatProgram.release();
+            program.release();
+        } else if (currentRenderMode == DistanceError) {
+            curvatureProgram.bind();
+            vao.bind();
+            faceEbo.bind();
+            
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            curvatureProgram.setUniformValue("model", model);
+            curvatureProgram.setUniformValue("view", view);
+            curvatureProgram.setUniformValue("projection", projection);
+            curvatureProgram.setUniformValue("normalMatrix", normalMatrix);
+
+            glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
+
+            faceEbo.release();
+            vao.release();
+            curvatureProgram.release();
         }
 
-        if (showWireframeOverlay) {
+        if (showWireframeOverlay && !singlePassOverlay) {
             drawWireframeOverlay(model, view, projection);
         }
     }
@@ -394,6 +696,21 @@ void CGALGLWidget::paintGL() {
     
     glPolygonMode(GL_FRONT, oldPolygonMode[0]);
     glPolygonMode(GL_BACK, oldPolygonMode[1]);
+    
+    renderScheduler->frameFinished();
+}
+
+void CGALGLWidget::computeViewMatrices(QMatrix4x4& model, QMatrix4x4& view, QMatrix4x4& projection) const {
+    model.setToIdentity();
+    model.rotate(rotation);
+    model.scale(zoom);
+    
+    QVector3D eyePosition(0, 0, viewDistance * viewScale);
+    view.setToIdentity();
+    view.lookAt(eyePosition, modelCenter, QVector3D(0, 1, 0));
+    
+    projection.setToIdentity();
+    projection.perspective(45.0f, width() / float(height()), 0.1f, 100.0f);
 }
 
 void CGALGLWidget::keyPressEvent(QKeyEvent *event) {
@@ -421,19 +738,30 @@ void CGALGLWidget::keyPressEvent(QKeyEvent *event) {
         break;
     case Qt::Key_A:
         showAxis = !showAxis;
-        update();
         break;
     default:
+        // 未处理的按键交给父类，不触发重绘
         QOpenGLWidget::keyPressEvent(event);
+        return;
     }
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::mousePressEvent(QMouseEvent *event) {
+    // Ctrl+左键：用AABB树拾取面
+    if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier)) {
+        CgalMesh::Face_index face;
+        Point hit;
+        if (modelLoaded && pickFace(event->pos(), face, hit)) {
+            emit facePicked(int(face.idx()), QVector3D(hit.x(), hit.y(), hit.z()));
+        }
+        return;
+    }
     if (event->button() == Qt::LeftButton) {
         isDragging = true;
         lastMousePos = event->pos();
         setCursor(Qt::ClosedHandCursor);
+        renderScheduler->beginInteraction();
     }
 }
 
@@ -441,6 +769,7 @@ void CGALGLWidget::mouseReleaseEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton) {
         isDragging = false;
         setCursor(Qt::ArrowCursor);
+        renderScheduler->endInteraction();
     }
 }
 
@@ -459,7 +788,7 @@ void CGALGLWidget::mouseMoveEvent(QMouseEvent *event) {
         rotation = newRot * rotation;
         
         lastMousePos = currentPos;
-        update();
+        requestRedraw();
     }
 }
 
@@ -486,23 +815,32 @@ void CGALGLWidget::wheelEvent(QWheelEvent *event) {
         float delta = numDegrees.y() > 0 ? 1.1f : 0.9f;
         zoom *= delta;
         zoom = qBound(0.1f, zoom, 10.0f);
-        update();
+        requestRedraw();
     }
     event->accept();
 }
 
 void CGALGLWidget::setSurfaceColor(const QVector3D& color) {
     surfaceColor = color;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::setSpecularEnabled(bool enabled) {
     specularEnabled = enabled;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::centerView() {
-    if (mesh.number_of_vertices() == 0) return;
+    if (!pointCloud.empty()) {
+        // 点云加载时已归一化到原点处边长为2的立方体
+        modelCenter = QVector3D(0, 0, 0);
+        viewDistance = 4.0f;
+        rotation = QQuaternion();
+        zoom = 1.0f;
+        requestRedraw();
+        return;
+    }
+    if (mesh->number_of_vertices() == 0) return;
     
     Point min, max;
     computeBoundingBox(min, max);
@@ -520,10 +858,11 @@ void CGALGLWidget::centerView() {
     
     rotation = QQuaternion();
     zoom = 1.0f;
-    update();
+    requestRedraw();
 }
 
 void CGALGLWidget::drawWireframe(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    ensureEdgeIndices();
     wireframeProgram.bind();
     vao.bind();
     ebo.bind();
@@ -542,6 +881,7 @@ void CGALGLWidget::drawWireframe(const QMatrix4x4& model, const QMatrix4x4& view
 }
 
 void CGALGLWidget::drawWireframeOverlay(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection) {
+    ensureEdgeIndices();
     glEnable(GL_POLYGON_OFFSET_LINE);
     glPolygonOffset(-1.0, -1.0);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -606,13 +946,82 @@ void CGALGLWidget::drawXYZAxis(const QMatrix4x4& view, const QMatrix4x4& project
     axisProgram.release();
 }
 
+CachedAABBTree::TreePtr CGALGLWidget::aabbTree() {
+    return meshTree.tree();
+}
+
+bool CGALGLWidget::pickFace(const QPoint& screenPos, CgalMesh::Face_index& face, Point& hitPoint) {
+    if (mesh->number_of_faces() == 0) return false;
+
+    QMatrix4x4 model, view, projection;
+    computeViewMatrices(model, view, projection);
+    QMatrix4x4 inverseMvp = (projection * view * model).inverted();
+
+    // 把鼠标位置反投影到近/远裁剪面，得到网格坐标系下的射线
+    float x = (2.0f * screenPos.x()) / width() - 1.0f;
+    float y = 1.0f - (2.0f * screenPos.y()) / height();
+    QVector3D nearPoint = inverseMvp.map(QVector3D(x, y, -1.0f));
+    QVector3D farPoint = inverseMvp.map(QVector3D(x, y, 1.0f));
+
+    Point origin(nearPoint.x(), nearPoint.y(), nearPoint.z());
+    Ray ray(origin, Point(farPoint.x(), farPoint.y(), farPoint.z()));
+
+    auto hit = aabbTree()->first_intersected_primitive(ray);
+    if (!hit) return false;
+    face = *hit;
+
+    // 射线与面所在平面求交得到命中点
+    auto h = mesh->halfedge(face);
+    const Point& p0 = mesh->point(mesh->source(h));
+    const Point& p1 = mesh->point(mesh->target(h));
+    const Point& p2 = mesh->point(mesh->target(mesh->next(h)));
+    Vector n = CGAL::cross_product(p1 - p0, p2 - p0);
+    Vector d = ray.to_vector();
+    double denom = n * d;
+    double t = std::abs(denom) > 0 ? ((p0 - origin) * n) / denom : 0.0;
+    hitPoint = origin + t * d;
+    return true;
+}
+
+CGAL::Bounded_side CGALGLWidget::sideOfMesh(const Point& p) {
+    // 只对闭合网格有意义；闭合与否和树一起缓存，不在每次查询时遍历边界
+    if (mesh->number_of_faces() == 0 || !meshTree.isClosed()) {
+        return CGAL::ON_UNBOUNDED_SIDE;
+    }
+    CachedAABBTree::TreePtr tree = aabbTree();
+    SideOfMesh inside(*tree);
+    return inside(p);
+}
+
+double CGALGLWidget::squaredDistanceToMesh(const Point& p) {
+    return CGAL::to_double(aabbTree()->squared_distance(p));
+}
+
+Point CGALGLWidget::closestPointOnMesh(const Point& p) {
+    return aabbTree()->closest_point(p);
+}
+
 void CGALGLWidget::clearMeshData() {
-    mesh.clear();
+    operandGeneration++;
+    // 几何即将改变，先丢弃AABB树；旧网格可能仍被树或布尔运算持有，换成新对象
+    meshTree.invalidate();
+    mesh = std::make_shared<CgalMesh>();
     faces.clear();
     edges.clear();
+    triangleEdgeMasks.clear();
+    triangleFaces.clear();
+    triangleColors.clear();
+    edgesUploaded = false;
     vertex_normals.clear();
     face_normals.clear();
+    normalsDirty = true;
+    vertexScalars.clear();
     modelLoaded = false;
+    if (!pointCloud.empty()) {
+        makeCurrent();
+        pointCloud.clear();
+        doneCurrent();
+    }
 }
 
 bool CGALGLWidget::loadOBJToCGALMesh(const QString &path) {
@@ -621,17 +1030,17 @@ bool CGALGLWidget::loadOBJToCGALMesh(const QString &path) {
         return false;
     }
     
-    return CGAL::IO::read_OBJ(in, mesh);
+    return CGAL::IO::read_OBJ(in, *mesh);
 }
 
 void CGALGLWidget::computeBoundingBox(Point& min, Point& max) {
-    if (mesh.number_of_vertices() > 0) {
-        auto v_it = mesh.vertices_begin();
-        Point first = mesh.point(*v_it);
+    if (mesh->number_of_vertices() > 0) {
+        auto v_it = mesh->vertices_begin();
+        Point first = mesh->point(*v_it);
         min = max = first;
         
-        for (auto v : mesh.vertices()) {
-            const Point& p = mesh.point(v);
+        for (auto v : mesh->vertices()) {
+            const Point& p = mesh->point(v);
             min = Point(std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z()));
             max = Point(std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z()));
         }
@@ -640,19 +1049,23 @@ void CGALGLWidget::computeBoundingBox(Point& min, Point& max) {
 
 void CGALGLWidget::centerAndScaleMesh(const Point& center, float maxSize) {
     float scaleFactor = 2.0f / maxSize;
-    for (auto v : mesh.vertices()) {
-        Point p = mesh.point(v);
+    for (auto v : mesh->vertices()) {
+        Point p = mesh->point(v);
         p = Point((p.x() - center.x()) * scaleFactor, 
                   (p.y() - center.y()) * scaleFactor, 
                   (p.z() - center.z()) * scaleFactor);
-        mesh.point(v) = p;
+        mesh->point(v) = p;
     }
+    normalsDirty = true;
 }
 
 void CGALGLWidget::prepareFaceIndices() {
-    for (auto f : mesh.faces()) {
+    triangleFaces.clear();
+    std::vector<unsigned char> edgeMasks;
+    edgeMasks.reserve(mesh->number_of_faces());
+    for (auto f : mesh->faces()) {
         std::vector<unsigned int> faceVertices;
-        for (auto v : CGAL::vertices_around_face(mesh.halfedge(f), mesh)) {
+        for (auto v : CGAL::vertices_around_face(mesh->halfedge(f), *mesh)) {
             faceVertices.push_back(v.idx());
         }
         
@@ -660,25 +1073,36 @@ void CGALGLWidget::prepareFaceIndices() {
         
         if (faceVertices.size() == 3) {
             faces.insert(faces.end(), faceVertices.begin(), faceVertices.end());
+            edgeMasks.push_back(7);
+            triangleFaces.push_back(int(f.idx()));
         } else {
             // 简单三角化：使用扇形三角化
             unsigned int centerIdx = faceVertices[0];
+            size_t last = faceVertices.size() - 2;
             for (size_t i = 1; i < faceVertices.size() - 1; i++) {
                 faces.push_back(centerIdx);
                 faces.push_back(faceVertices[i]);
                 faces.push_back(faceVertices[i + 1]);
+                // 只有第一条和最后一条扇边是多边形的真实边
+                edgeMasks.push_back(2 | (i == 1 ? 1 : 0) | (i == last ? 4 : 0));
+                triangleFaces.push_back(int(f.idx()));
             }
         }
     }
+    
+    triangleEdgeMasks.assign((edgeMasks.size() + 7) / 8, 0u);
+    for (size_t t = 0; t < edgeMasks.size(); t++) {
+        triangleEdgeMasks[t >> 3] |= (unsigned int)edgeMasks[t] << ((t & 7) * 4);
+    }
 }
 
 void CGALGLWidget::prepareEdgeIndices() {
     std::set<std::pair<unsigned int, unsigned int>> uniqueEdges;
     
-    for (auto e : mesh.edges()) {
-        auto h = mesh.halfedge(e);
-        unsigned int from = mesh.source(h).idx();
-        unsigned int to = mesh.target(h).idx();
+    for (auto e : mesh->edges()) {
+        auto h = mesh->halfedge(e);
+        unsigned int from = mesh->source(h).idx();
+        unsigned int to = mesh->target(h).idx();
         
         if (from > to) std::swap(from, to);
         uniqueEdges.insert({from, to});
@@ -697,12 +1121,23 @@ void CGALGLWidget::saveOriginalMesh() {
 }
 
 void CGALGLWidget::loadOBJ(const QString &path) {
+    // 没有面的文件走点云路径，不经过Surface_mesh
+    if (point_cloud::is_point_cloud_file(path.toStdString())) {
+        loadPointCloud(path);
+        return;
+    }
     clearMeshData();
     if (!loadOBJToCGALMesh(path)) {
         qWarning() << "Failed to load mesh:" << path;
         return;
     }
     
+    // AABB树和内外判断都要求三角网格
+    if (!CGAL::is_triangle_mesh(*mesh)) {
+        PMP::triangulate_faces(*mesh);
+        normalsDirty = true;
+    }
+    
     Point min, max;
     computeBoundingBox(min, max);
     
@@ -715,6 +1150,9 @@ void CGALGLWidget::loadOBJ(const QString &path) {
     double maxSize = std::max({size_x, size_y, size_z});
     
     centerAndScaleMesh(center, maxSize);
+    loadCenter = center;
+    loadScale = 2.0 / maxSize;
+    normalizeReference();
     
     Point min_norm, max_norm;
     computeBoundingBox(min_norm, max_norm);
@@ -735,20 +1173,499 @@ void CGALGLWidget::loadOBJ(const QString &path) {
     initialViewDistance = viewDistance;
     initialViewScale = viewScale;
 
-    // 计算法线
-    computeNormals();
-    
     prepareFaceIndices();
-    prepareEdgeIndices();
     
     saveOriginalMesh();
     modelLoaded = true;
     
+    // AABB树在后台构建，与下面的缓冲区上传并行
+    meshTree.buildAsync();
+    
     makeCurrent();
     initializeShaders();
     doneCurrent();
     
     rotation = QQuaternion();
     zoom = 1.0f;
-    update();
-}
\ No newline at end of file
+    requestRedraw();
+}
+
+bool CGALGLWidget::loadPointCloud(const QString& path) {
+    clearMeshData();
+    
+    point_cloud::Cloud cloud;
+    double readMs = 0.0;
+    if (!point_cloud::read(path.toStdString(), cloud, &readMs)) {
+        qWarning() << "Failed to load point cloud:" << path;
+        return false;
+    }
+    
+    double center[3], halfExtent = 1.0;
+    point_cloud::normalize(cloud, center, halfExtent);
+    loadCenter = Point(center[0], center[1], center[2]);
+    loadScale = 1.0 / halfExtent;
+    normalizeReference();
+    
+    PointOctree octree;
+    PointOctree::BuildOptions options;
+    PointOctree::BuildStats stats;
+    if (!octree.build(cloud, options, &stats)) {
+        qWarning() << "Point cloud too large:" << cloud.size() << "points";
+        return false;
+    }
+    
+    makeCurrent();
+    pointCloud.upload(cloud, std::move(octree));
+    doneCurrent();
+    
+    modelCenter = QVector3D(0, 0, 0);
+    viewDistance = 4.0f;
+    
+    initialRotation = QQuaternion();
+    initialZoom = 1.0f;
+    initialModelCenter = modelCenter;
+    initialViewDistance = viewDistance;
+    initialViewScale = viewScale;
+    
+    rotation = QQuaternion();
+    zoom = 1.0f;
+    reportedDrawnPoints = reportedDrawnNodes = 0;
+    emit pointCloudLoaded(int(pointCloud.pointCount()), int(pointCloud.nodeCount()),
+                          pointCloud.hasNormals(), pointCloud.hasColors(), readMs, stats.ms);
+    renderScheduler->markDirty();
+    requestRedraw();
+    return true;
+}
+
+void CGALGLWidget::setPointBudget(int points) {
+    pointCloud.setPointBudget(size_t(qMax(1, points)));
+    requestRedraw();
+}
+
+void CGALGLWidget::setPointSizeScale(float scale) {
+    pointCloud.setPointSizeScale(scale);
+    requestRedraw();
+}
+
+void CGALGLWidget::setPointNormalShading(bool enabled) {
+    pointCloud.setNormalShading(enabled);
+    requestRedraw();
+}
+
+void CGALGLWidget::setPointColors(bool enabled) {
+    pointCloud.setVertexColors(enabled);
+    requestRedraw();
+}
+
+void CGALGLWidget::drawPointCloud() {
+    QMatrix4x4 model, view, projection;
+    computeViewMatrices(model, view, projection);
+    
+    float dpr = devicePixelRatioF();
+    pointCloud.draw(model, view, projection, QSize(int(width() * dpr), int(height() * dpr)), surfaceColor);
+    
+    if (showAxis) {
+        drawXYZAxis(view, projection);
+    }
+    
+    if (pointCloud.drawnPoints() != reportedDrawnPoints || pointCloud.drawnNodes() != reportedDrawnNodes) {
+        reportedDrawnPoints = pointCloud.drawnPoints();
+        reportedDrawnNodes = pointCloud.drawnNodes();
+        emit pointCloudDrawn(int(reportedDrawnPoints), int(reportedDrawnNodes));
+    }
+}
+
+bool CGALGLWidget::loadReferenceOBJ(const QString &path) {
+    if (!modelLoaded) {
+        qWarning() << "Load the primary mesh before the reference mesh";
+        return false;
+    }
+    
+    operandGeneration++;
+    fixtureState = -1;
+    referenceTree.invalidate();
+    referenceMesh = std::make_shared<CgalMesh>();
+    std::ifstream in(path.toStdString());
+    if (!in || !CGAL::IO::read_OBJ(in, *referenceMesh) || referenceMesh->number_of_faces() == 0) {
+        qWarning() << "Failed to load reference mesh:" << path;
+        referenceMesh->clear();
+        return false;
+    }
+    if (!CGAL::is_triangle_mesh(*referenceMesh)) {
+        PMP::triangulate_faces(*referenceMesh);
+    }
+    
+    // 刚读入时在文件坐标中
+    referenceCenter = Point(0, 0, 0);
+    referenceScale = 1.0;
+    normalizeReference();
+    return true;
+}
+
+// 把参考网格从它当前的归一化换到主网格的归一化，保证两者可以直接比较；
+// 主网格重新载入时也要调用，否则距离和布尔运算会在错误的坐标系中进行
+void CGALGLWidget::normalizeReference() {
+    if (!hasReferenceMesh()) return;
+    if (referenceCenter == loadCenter && referenceScale == loadScale) return;
+    
+    operandGeneration++;
+    fixtureState = -1;
+    referenceTree.invalidate();
+    // 已经建过树的网格可能还被布尔运算持有，不能原地修改
+    if (referenceMesh.use_count() > 1) {
+        referenceMesh = std::make_shared<CgalMesh>(*referenceMesh);
+    }
+    for (auto v : referenceMesh->vertices()) {
+        const Point& p = referenceMesh->point(v);
+        // 先回到文件坐标：p / referenceScale + referenceCenter
+        Point file(p.x() / referenceScale + referenceCenter.x(),
+                   p.y() / referenceScale + referenceCenter.y(),
+                   p.z() / referenceScale + referenceCenter.z());
+        referenceMesh->point(v) = Point((file.x() - loadCenter.x()) * loadScale,
+                                       (file.y() - loadCenter.y()) * loadScale,
+                                       (file.z() - loadCenter.z()) * loadScale);
+    }
+    referenceCenter = loadCenter;
+    referenceScale = loadScale;
+    referenceTree.buildAsync();
+}
+
+bool CGALGLWidget::computeDistanceToReference(DistanceReport& report, double samplesPerAreaUnit) {
+    if (!modelLoaded || !hasReferenceMesh()) return false;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // 先在主线程拿到树，之后的并行查询只读
+    CachedAABBTree::TreePtr referenceAabb = referenceTree.tree();
+    const AABBTree& tree = *referenceAabb;
+    report.treeBuildMs = timer.restart();
+    
+    // 逐顶点到参考网格的最近距离，按顶点区间并行
+    const size_t nv = mesh->number_of_vertices();
+    std::vector<double> distances(nv, 0.0);
+    parallel::for_each(0, nv, [&](size_t i) {
+        const Point& p = mesh->point(CgalMesh::Vertex_index(static_cast<CgalMesh::size_type>(i)));
+        distances[i] = std::sqrt(CGAL::to_double(tree.squared_distance(p)));
+    });
+    report.vertexPassMs = timer.restart();
+    
+    double maxDistance = nv > 0 ? *std::max_element(distances.begin(), distances.end()) : 0.0;
+    double sumDistance = std::accumulate(distances.begin(), distances.end(), 0.0);
+    report.maxVertexDistance = maxDistance / loadScale;
+    report.meanVertexDistance = nv > 0 ? sumDistance / nv / loadScale : 0.0;
+    
+    // 双向近似Hausdorff距离：表面采样 + AABB最近点
+    auto np = PMP::parameters::number_of_points_per_area_unit(samplesPerAreaUnit);
+    double toReference = PMP::approximate_Hausdorff_distance<Concurrency_tag>(*mesh, *referenceMesh, np, np);
+    double fromReference = PMP::approximate_Hausdorff_distance<Concurrency_tag>(*referenceMesh, *mesh, np, np);
+    report.hausdorffToReference = toReference / loadScale;
+    report.hausdorffFromReference = fromReference / loadScale;
+    report.hausdorffMs = timer.elapsed();
+    
+    qDebug() << "Distance to reference:" << nv << "vertices,"
+             << "tree" << report.treeBuildMs << "ms,"
+             << "vertex pass" << report.vertexPassMs << "ms,"
+             << "Hausdorff" << report.hausdorffMs << "ms";
+    
+    // 颜色映射使用最大误差归一化
+    vertexScalars.resize(nv);
+    for (size_t i = 0; i < nv; i++) {
+        vertexScalars[i] = maxDistance > 0 ? float(distances[i] / maxDistance) : 0.0f;
+    }
+    uploadVertexScalars();
+    
+    currentRenderMode = DistanceError;
+    requestRedraw();
+    return true;
+}
+
+bool CGALGLWidget::checkSelfIntersections(SelfIntersectionReport& report) {
+    if (!modelLoaded) return false;
+    
+    report = SelfIntersectionReport();
+#ifdef CGAL_LINKED_WITH_TBB
+    report.parallel = true;
+#endif
+    if (!CGAL::is_triangle_mesh(*mesh)) {
+        report.triangleMesh = false;
+        return false;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<std::pair<CgalMesh::Face_index, CgalMesh::Face_index>> pairs;
+    PMP::self_intersections<Concurrency_tag>(mesh->faces(), *mesh, std::back_inserter(pairs));
+    report.milliseconds = timer.elapsed();
+    report.intersectingPairs = int(pairs.size());
+    
+    std::vector<unsigned char> marked(mesh->num_faces(), 0);
+    for (const auto& pair : pairs) {
+        marked[pair.first.idx()] = 1;
+        marked[pair.second.idx()] = 1;
+    }
+    report.faces = int(std::count(marked.begin(), marked.end(), 1));
+    qDebug() << "Self-intersections:" << report.intersectingPairs << "pairs," << report.faces << "faces in"
+             << report.milliseconds << "ms" << (report.parallel ? "(parallel)" : "(sequential)");
+    
+    // 红色不透明，其余三角形alpha为0
+    triangleColors.assign(triangleFaces.size(), 0u);
+    for (size_t t = 0; t < triangleFaces.size(); t++) {
+        if (marked[triangleFaces[t]]) triangleColors[t] = 0xFF0000FFu;
+    }
+    if (report.faces == 0) triangleColors.clear();
+    uploadTriangleColors();
+    
+    if (currentRenderMode != BlinnPhong && currentRenderMode != FlatShading) {
+        currentRenderMode = FlatShading;
+    }
+    requestRedraw();
+    return true;
+}
+
+void CGALGLWidget::clearFaceHighlight() {
+    if (triangleColors.empty()) return;
+    triangleColors.clear();
+    renderScheduler->markDirty();
+    requestRedraw();
+}
+
+void CGALGLWidget::uploadTriangleColors() {
+    if (triangleColors.empty()) {
+        renderScheduler->markDirty();
+        return;
+    }
+    makeCurrent();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, faceColorBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, triangleColors.size() * sizeof(unsigned int),
+                 triangleColors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    doneCurrent();
+    renderScheduler->markDirty();
+}
+
+bool CGALGLWidget::booleanRunning() const {
+    return booleanTask.valid()
+        && booleanTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void CGALGLWidget::waitForBoolean() {
+    if (booleanTask.valid()) {
+        booleanTask.wait();
+    }
+}
+
+bool CGALGLWidget::startBoolean(BooleanOp op) {
+    if (!modelLoaded || !hasReferenceMesh() || booleanRunning()) return false;
+    
+    // GUI线程上只取共享指针，不等待也不复制：两棵树通常已在载入时后台建好，没建好的在后台开始构建，
+    // 由工作线程等待。网格在运算期间被替换也不影响工作线程持有的对象
+    bool fixtureCached = fixtureState >= 0 && referenceTree.isBuilt();
+    std::shared_future<CachedAABBTree::TreePtr> meshTreeFuture = meshTree.treeAsync();
+    std::shared_future<CachedAABBTree::TreePtr> fixtureTreeFuture = referenceTree.treeAsync();
+    std::shared_ptr<const CgalMesh> meshSource = mesh;
+    std::shared_ptr<const CgalMesh> fixtureSource = referenceMesh;
+    int fixture = fixtureState;
+    unsigned int generation = operandGeneration;
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    booleanCancel = cancel;
+    
+    auto work = [=]() {
+        QElapsedTimer total, timer;
+        total.start();
+        timer.start();
+        BooleanReport report;
+        report.fixtureCached = fixtureCached;
+        auto result = std::make_shared<CgalMesh>();
+        int fixtureResult = fixture;
+        
+        auto progress = std::make_shared<BooleanProgress>();
+        progress->cancel = cancel;
+        progress->callback = [this, generation](int percent, const char* stage) {
+            QString text = QString::fromLatin1(stage);
+            QMetaObject::invokeMethod(this, [this, generation, percent, text]() {
+                if (generation == operandGeneration) emit booleanProgress(percent, text);
+            }, Qt::QueuedConnection);
+        };
+        
+        // 所有出口都经过这里，提前结束时进度也补到100
+        auto finish = [&]() {
+            progress->set(100, "Done");
+            report.totalMs = total.elapsed();
+            if (report.success) report.faces = int(result->number_of_faces());
+            qDebug() << "Boolean:" << (report.success ? "ok" : qPrintable(report.error)) << report.faces << "faces,"
+                     << "validate" << report.validateMs << "ms, filter" << report.filterMs << "ms, corefine"
+                     << report.corefineMs << "ms, total" << report.totalMs << "ms"
+                     << (report.fixtureCached ? "(cached fixture)" : "");
+            QMetaObject::invokeMethod(this, [this, generation, report, result, fixtureResult]() {
+                if (generation != operandGeneration) return;
+                fixtureState = fixtureResult;
+                if (report.success) {
+                    replaceMesh(std::move(*result));
+                }
+                emit booleanFinished(report);
+            }, Qt::QueuedConnection);
+        };
+        
+        // 1. 输入校验，每一步之间检查取消：参考网格的结果缓存；主网格检查闭合并围成体积，
+        // 整体的自相交检查太贵，由corefinement在交线附近检查
+        if (fixtureResult < 0) {
+            const CgalMesh& fixtureMesh = *fixtureSource;
+            progress->set(0, "Validating reference mesh");
+            fixtureResult = 0;
+            if (CGAL::is_closed(fixtureMesh)) {
+                progress->set(1, "Checking reference for self-intersections");
+                if (!PMP::does_self_intersect<Concurrency_tag>(fixtureMesh)) {
+                    progress->set(2, "Checking reference orientation");
+                    fixtureResult = PMP::does_bound_a_volume(fixtureMesh) ? 1 : 0;
+                }
+            }
+        }
+        if (fixtureResult == 0) {
+            report.validateMs = timer.restart();
+            report.error = "Reference mesh must be closed, free of self-intersections and bound a volume";
+            finish();
+            return;
+        }
+        progress->set(3, "Validating mesh");
+        if (!CGAL::is_closed(*meshSource)) {
+            report.validateMs = timer.restart();
+            report.error = "Mesh must be closed";
+            finish();
+            return;
+        }
+        progress->set(4, "Checking mesh orientation");
+        if (!PMP::does_bound_a_volume(*meshSource)) {
+            report.validateMs = timer.restart();
+            report.error = "Mesh must bound a volume";
+            finish();
+            return;
+        }
+        report.validateMs = timer.restart();
+        
+        // corefinement会修改两个输入，所以在副本上进行；树在后台构建时在这里等待
+        progress->set(5, "Waiting for AABB trees");
+        CachedAABBTree::TreePtr meshAabb = meshTreeFuture.get();
+        CachedAABBTree::TreePtr fixtureAabb = fixtureTreeFuture.get();
+        auto a = std::make_shared<CgalMesh>(*meshSource);
+        auto b = std::make_shared<CgalMesh>(*fixtureSource);
+        
+        // 2. 用参考网格的AABB树找出与它相交的面，一个都没有时结果由包含关系直接决定
+        progress->set(6, "Filtering with AABB trees");
+        std::vector<int> touching(parallel::thread_count(), 0);
+        parallel::for_each_range(0, a->number_of_faces(), [&](size_t begin, size_t end, unsigned int tid) {
+            for (size_t i = begin; i < end; i++) {
+                CgalMesh::Halfedge_index h = a->halfedge(CgalMesh::Face_index(static_cast<CgalMesh::size_type>(i)));
+                Kernel::Triangle_3 t(a->point(a->source(h)), a->point(a->target(h)),
+                                     a->point(a->target(a->next(h))));
+                if (fixtureAabb->do_intersect(t)) touching[tid]++;
+            }
+        }, 256);
+        report.touchingFaces = std::accumulate(touching.begin(), touching.end(), 0);
+        report.filterMs = timer.restart();
+        
+        if (report.touchingFaces == 0) {
+            bool aInB = SideOfMesh(*fixtureAabb)(a->point(*a->vertices().begin())) == CGAL::ON_BOUNDED_SIDE;
+            bool bInA = SideOfMesh(*meshAabb)(b->point(*b->vertices().begin())) == CGAL::ON_BOUNDED_SIDE;
+            switch (op) {
+            case BooleanUnion:
+                *result = aInB ? *b : *a;
+                if (!aInB && !bInA) *result += *b;
+                break;
+            case BooleanIntersection:
+                if (aInB) *result = *a;
+                else if (bInA) *result = *b;
+                break;
+            case BooleanDifference:
+                if (!aInB) *result = *a;
+                if (bInA) {
+                    // 参考网格整个在内部：反向后成为空腔
+                    PMP::reverse_face_orientations(*b);
+                    *result += *b;
+                }
+                break;
+            }
+            report.success = result->number_of_faces() > 0;
+            if (!report.success) report.error = "Result is empty";
+            finish();
+            return;
+        }
+        
+        // 3. corefinement：CGAL不接受外部的AABB树，交线在副本上用自己的包围盒求交重新计算
+        bool ok = false;
+        BooleanProgressVisitor visitor(progress);
+        auto np = PMP::parameters::visitor(visitor).throw_on_self_intersection(true);
+        try {
+            switch (op) {
+            case BooleanUnion:
+                ok = PMP::corefine_and_compute_union(*a, *b, *result, np);
+                break;
+            case BooleanIntersection:
+                ok = PMP::corefine_and_compute_intersection(*a, *b, *result, np);
+                break;
+            case BooleanDifference:
+                ok = PMP::corefine_and_compute_difference(*a, *b, *result, np);
+                break;
+            }
+        } catch (const PMP::Corefinement::Self_intersection_exception&) {
+            report.error = "Mesh self-intersects near the intersection curve";
+        }
+        report.corefineMs = timer.restart();
+        if (ok) {
+            result->collect_garbage();
+            report.success = result->number_of_faces() > 0;
+            if (!report.success) report.error = "Result is empty";
+        } else if (report.error.isEmpty()) {
+            report.error = "Corefinement failed (non-manifold result)";
+        }
+        finish();
+    };
+    booleanTask = std::async(std::launch::async, [work]() {
+        try {
+            work();
+        } catch (const BooleanCancelled&) {
+            // 控件正在析构，不再报告结果
+        }
+    });
+    return true;
+}
+
+// 结果网格沿用载入时的归一化，视图保持不变
+void CGALGLWidget::replaceMesh(CgalMesh&& result) {
+    meshTree.invalidate();
+    mesh = std::make_shared<CgalMesh>(std::move(result));
+    faces.clear();
+    edges.clear();
+    triangleEdgeMasks.clear();
+    triangleFaces.clear();
+    triangleColors.clear();
+    edgesUploaded = false;
+    vertex_normals.clear();
+    face_normals.clear();
+    normalsDirty = true;
+    vertexScalars.clear();
+    if (currentRenderMode == DistanceError) {
+        currentRenderMode = FlatShading;
+    }
+    
+    prepareFaceIndices();
+    meshTree.buildAsync();
+    
+    makeCurrent();
+    updateBuffersFromCGALMesh();
+    doneCurrent();
+    requestRedraw();
+}
+
+void CGALGLWidget::uploadVertexScalars() {
+    if (!modelLoaded || vertexScalars.size() != mesh->number_of_vertices()) return;
+    
+    int vertexSize = mesh->number_of_vertices() * 3 * sizeof(float);
+    makeCurrent();
+    vbo.bind();
+    vbo.write(2 * vertexSize, vertexScalars.data(), vertexScalars.size() * sizeof(float));
+    vbo.release();
+    doneCurrent();
+    
+    renderScheduler->markDirty();
+}
@@ -3,7 +3,7 @@
 #define CGALGLWIDGET_H
 
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
@@ -11,25 +11,75 @@
 #include <QVector3D>
 #include <QColor>
 #include <vector>
+#include <memory>
+#include <future>
+#include <atomic>
 #include <QQuaternion>
+#include "renderscheduler.h"
+#include "pointcloudrenderer.h"
 #include <CGAL/Simple_cartesian.h>
 #include <CGAL/Surface_mesh.h>
 #include <CGAL/Polygon_mesh_processing/compute_normal.h>
 #include <CGAL/Polygon_mesh_processing/measure.h>
 #include <CGAL/Polygon_mesh_processing/distance.h>
+#include <CGAL/Polygon_mesh_processing/self_intersections.h>
 #include <CGAL/AABB_tree.h>
 #include <CGAL/AABB_traits.h>
 #include <CGAL/AABB_face_graph_triangle_primitive.h>
+#include <CGAL/Side_of_triangle_mesh.h>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 
+// 定义CGAL_VIEWER_USE_EPICK时使用EPICK内核（谓词精确，构造为double）
+#ifdef CGAL_VIEWER_USE_EPICK
+typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
+#else
 typedef CGAL::Simple_cartesian<double> Kernel;
+#endif
 typedef Kernel::Point_3 Point;
 typedef Kernel::Vector_3 Vector;
+typedef Kernel::Ray_3 Ray;
 typedef CGAL::Surface_mesh<Point> CgalMesh;
 
+typedef CGAL::AABB_face_graph_triangle_primitive<CgalMesh> AABBPrimitive;
+typedef CGAL::AABB_traits<Kernel, AABBPrimitive> AABBTraits;
+typedef CGAL::AABB_tree<AABBTraits> AABBTree;
+typedef CGAL::Side_of_triangle_mesh<CgalMesh, Kernel, CGAL::Default, AABBTree> SideOfMesh;
+
 namespace PMP = CGAL::Polygon_mesh_processing;
 
-class CGALGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
+// 绑定到某个网格的AABB树缓存：第一次查询时构建，之后一直复用，
+// 只有几何改变时调用invalidate()才会丢弃。
+// 树和它引用的网格由调用者共同持有，网格被替换、缓存被丢弃后，已经交出去的树仍然有效；
+// 因此网格对象一旦建过树就不能原地修改，几何改变时先invalidate()，再换成新的网格对象。
+// 除返回的future外，只在GUI线程上使用
+class CachedAABBTree
+{
+public:
+    typedef std::shared_ptr<const AABBTree> TreePtr;
+
+    explicit CachedAABBTree(const std::shared_ptr<CgalMesh>& mesh);
+    ~CachedAABBTree();
+
+    // 返回已构建的树；如果后台正在构建则等待，尚未构建则当场构建
+    TreePtr tree();
+    // 不阻塞：尚未开始时在后台构建，返回的结果可以交给工作线程等待
+    std::shared_future<TreePtr> treeAsync();
+    // 在后台线程预构建，与GPU上传等工作并行
+    void buildAsync();
+    void invalidate();
+    bool isBuilt() const;
+    // 网格是否闭合，只看拓扑，不需要树；与树一起丢弃
+    bool isClosed();
+    qint64 lastBuildTimeMs() const { return buildTimeMs; }
+
+private:
+    const std::shared_ptr<CgalMesh>& mesh;
+    std::shared_future<TreePtr> pending;
+    std::atomic<qint64> buildTimeMs{0};
+    int closed = -1;  // -1未计算
+};
+
+class CGALGLWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 
@@ -42,7 +92,53 @@ public:
         FlatShading,  // 添加Flat Shading模式
         GaussianCurvature,
         MeanCurvature,
-        MaxCurvature
+        MaxCurvature,
+        DistanceError  // 与参考网格的逐顶点距离，走曲率着色器的色表
+    };
+
+    // 网格对比结果，距离均换算回原始模型单位
+    struct DistanceReport {
+        double maxVertexDistance = 0.0;
+        double meanVertexDistance = 0.0;
+        double hausdorffToReference = 0.0;
+        double hausdorffFromReference = 0.0;
+        qint64 treeBuildMs = 0;
+        qint64 vertexPassMs = 0;
+        qint64 hausdorffMs = 0;
+    };
+
+    // 自相交检测结果
+    struct SelfIntersectionReport {
+        int intersectingPairs = 0;
+        int faces = 0;          // 至少与一个面相交的面
+        qint64 milliseconds = 0;
+        bool parallel = false;  // CGAL链接了TBB时为true
+        bool triangleMesh = true;
+    };
+
+    // 主网格与参考网格的布尔运算
+    enum BooleanOp {
+        BooleanUnion,
+        BooleanIntersection,
+        BooleanDifference  // 主网格减去参考网格
+    };
+
+    struct BooleanReport {
+        bool success = false;
+        QString error;
+        int faces = 0;
+        int touchingFaces = 0;       // 与参考网格相交的主网格面，为0时不做corefinement
+        bool fixtureCached = false;  // 参考网格的校验结果和AABB树都来自缓存
+        qint64 validateMs = 0;
+        qint64 filterMs = 0;
+        qint64 corefineMs = 0;
+        qint64 totalMs = 0;
+    };
+
+    // 线框叠加方式：重心坐标单遍绘制，或传统的第二遍GL_LINES
+    enum OverlayStyle {
+        BarycentricOverlay,
+        LineOverlay
     };
 
     void setBackgroundColor(const QColor& color);
@@ -50,6 +146,7 @@ public:
     void setSurfaceColor(const QVector3D& color);
     void setSpecularEnabled(bool enabled);
     void setShowWireframeOverlay(bool show);
+    void setWireframeOverlayStyle(OverlayStyle style);
     void setHideFaces(bool hide);
     void setShowAxis(bool show);
     void resetView();
@@ -57,6 +154,42 @@ public:
     void loadOBJ(const QString &path);
     void clearMeshData();
     void setViewScale(float scale);
+    void setRenderMode(RenderMode mode);
+
+    // 经调度器合并后的重绘请求，状态未变化时不会真正重绘
+    void requestRedraw();
+    void setMaxInteractiveFps(int fps);
+    RenderScheduler* scheduler() const { return renderScheduler; }
+
+    // 基于缓存AABB树的查询（网格坐标系，即归一化后的坐标）；持有返回值期间树一直有效
+    CachedAABBTree::TreePtr aabbTree();
+    bool pickFace(const QPoint& screenPos, CgalMesh::Face_index& face, Point& hitPoint);
+    CGAL::Bounded_side sideOfMesh(const Point& p);
+    double squaredDistanceToMesh(const Point& p);
+    Point closestPointOnMesh(const Point& p);
+
+    // 参考网格（如原始扫描），使用与主网格相同的归一化变换
+    bool loadReferenceOBJ(const QString &path);
+    bool hasReferenceMesh() const { return referenceMesh->number_of_faces() > 0; }
+    bool computeDistanceToReference(DistanceReport& report, double samplesPerAreaUnit = 1000.0);
+
+    // PMP::self_intersections（有TBB时并行），相交的面通过逐三角形颜色缓冲标红；仅三角形网格
+    bool checkSelfIntersections(SelfIntersectionReport& report);
+    void clearFaceHighlight();
+
+    // 在工作线程上做corefinement布尔运算，完成后用结果替换主网格；参考网格保持不变，
+    // 它的校验结果和AABB树在重复运算之间复用。缓存的树只用于预筛和不相交时的包含判断，
+    // corefinement本身每次都在副本上重新求交。已有运算在进行时返回false
+    bool startBoolean(BooleanOp op);
+    bool booleanRunning() const;
+
+    // 点云：没有面的OBJ和PLY由loadOBJ转到这里，与基础控件共用PointCloudRenderer，mesh保持为空
+    bool loadPointCloud(const QString& path);
+    bool hasPointCloud() const { return !pointCloud.empty(); }
+    void setPointBudget(int points);
+    void setPointSizeScale(float scale);
+    void setPointNormalShading(bool enabled);
+    void setPointColors(bool enabled);
 
     QVector3D surfaceColor = QVector3D(1.0f, 1.0f, 0.0f);
     bool specularEnabled = true;
@@ -64,18 +197,26 @@ public:
     QColor bgColor;
     RenderMode currentRenderMode;
     
-    CgalMesh mesh;
+    // 两个网格都通过共享指针持有：AABB树和布尔运算的工作线程共同持有它们，
+    // 替换时换成新对象，不原地修改已经交出去的网格
+    std::shared_ptr<CgalMesh> mesh = std::make_shared<CgalMesh>();
     bool hasOriginalMesh = false;
     
     std::vector<unsigned int> faces;
     std::vector<unsigned int> edges;
     std::vector<Vector> vertex_normals;
     std::vector<Vector> face_normals;
+    // 任何修改几何或拓扑的操作都要置位，computeNormals()清除
+    bool normalsDirty = true;
+    std::vector<float> vertexScalars;  // 归一化到[0,1]的逐顶点标量
+    
+    std::shared_ptr<CgalMesh> referenceMesh = std::make_shared<CgalMesh>();
     
     QQuaternion rotation;
     float zoom;
     
     bool showWireframeOverlay;
+    OverlayStyle overlayStyle = BarycentricOverlay;
     bool hideFaces;
     bool modelLoaded;
 
@@ -84,6 +225,14 @@ public:
     float viewScale = 1.5f;
     QVector3D eyePosition;
 
+signals:
+    void facePicked(int faceIndex, const QVector3D& point);
+    // 均在GUI线程上发出
+    void booleanProgress(int percent, const QString& stage);
+    void booleanFinished(const CGALGLWidget::BooleanReport& report);
+    void pointCloudLoaded(int pointCount, int nodeCount, bool hasNormals, bool hasColors, double readMs, double buildMs);
+    void pointCloudDrawn(int pointCount, int nodeCount);
+
 protected:
     void initializeGL() override;
     void resizeGL(int w, int h) override;
@@ -104,10 +253,41 @@ protected:
     void initializeShaders();
     void drawWireframe(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
     void drawWireframeOverlay(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection);
+    void setWireOverlayUniforms(QOpenGLShaderProgram& program);
+    void ensureEdgeIndices();
     void drawXYZAxis(const QMatrix4x4& view, const QMatrix4x4& projection);
     QVector3D projectToTrackball(const QPoint& screenPos);
+    quint64 renderStateHash() const;
+    void computeViewMatrices(QMatrix4x4& model, QMatrix4x4& view, QMatrix4x4& projection) const;
+    void drawPointCloud();
     
     void computeNormals();
+    void ensureVertexNormals();
+    void uploadVertexScalars();
+    void uploadTriangleColors();
+    void waitForBoolean();
+    void replaceMesh(CgalMesh&& result);
+    void normalizeReference();
+    void setFaceColorUniforms(QOpenGLShaderProgram& program);
+
+    CachedAABBTree meshTree{mesh};
+    CachedAABBTree referenceTree{referenceMesh};
+
+    // 布尔运算的工作线程，持有两个输入的副本和两棵树的共享所有权，不读控件的成员；
+    // 主网格或参考网格被替换时只递增operandGeneration，过期的结果被丢弃，不等待工作线程。
+    // 只有析构时设置booleanCancel并等待，工作线程在下一个进度点退出
+    std::future<void> booleanTask;
+    std::shared_ptr<std::atomic<bool>> booleanCancel;
+    unsigned int operandGeneration = 0;
+    // 参考网格是否闭合、无自相交并围成体积：-1未校验，0否，1是
+    int fixtureState = -1;
+
+    // 载入时的归一化参数：p' = (p - loadCenter) * loadScale
+    Point loadCenter = Point(0, 0, 0);
+    double loadScale = 1.0;
+    // referenceMesh当前所在的归一化；主网格重新载入后由normalizeReference()换到新的loadCenter/loadScale
+    Point referenceCenter = Point(0, 0, 0);
+    double referenceScale = 1.0;
 
     // 初始视图状态
     QQuaternion initialRotation;
@@ -127,14 +307,38 @@ protected:
     bool isDragging;
     QPoint lastMousePos;
 
+    RenderScheduler* renderScheduler;
+
     QOpenGLShaderProgram wireframeProgram;
     QOpenGLShaderProgram blinnPhongProgram;
     QOpenGLShaderProgram flatProgram;
+    QOpenGLShaderProgram blinnPhongWireProgram;  // 带几何着色器的单遍线框变体
+    QOpenGLShaderProgram flatWireProgram;
+    bool baryOverlayAvailable = false;
+    QOpenGLShaderProgram curvatureProgram;
 
     QOpenGLVertexArrayObject vao;
     QOpenGLBuffer vbo;
     QOpenGLBuffer ebo;
     QOpenGLBuffer faceEbo;
+
+    // 顶点法线只有Blinn-Phong需要，按需计算并上传；平面着色完全在GPU端完成
+    bool vertexNormalsUploaded = false;
+
+    // 每个三角形4位的边掩码（见wireframe_overlay.geom），以SSBO形式上传
+    std::vector<unsigned int> triangleEdgeMasks;
+    GLuint edgeMaskBuffer = 0;
+    // 每个三角形所属的面（扇形三角化后一个面可能对应多个三角形）
+    std::vector<int> triangleFaces;
+    // 每个三角形一个RGBA8颜色，alpha为0时使用surfaceColor；以SSBO形式上传到binding 1
+    std::vector<unsigned int> triangleColors;
+    GLuint faceColorBuffer = 0;
+    // edges索引只在隐藏面或GL_LINES叠加时才需要，按需生成
+    bool edgesUploaded = false;
+
+    PointCloudRenderer pointCloud;
+    size_t reportedDrawnPoints = 0;
+    size_t reportedDrawnNodes = 0;
 };
 
 #endif // CGALGLWIDGET_H
\ No newline at end of file
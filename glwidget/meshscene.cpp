@@ -0,0 +1,435 @@
+// meshscene.cpp
+#include "meshscene.h"
+#include "../meshutils/parallel_utils.h"
+#include <QOpenGLContext>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// arena的最小容量，避免加入小零件时频繁扩容
+const size_t MinArenaBytes = size_t(4) << 20;
+
+// 与glMultiDrawElementsIndirect的命令布局一致
+struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// 与scene.vert中SceneObject的std430布局一致
+struct ObjectData {
+    float transform[16];
+    float color[4];
+};
+
+// 从裁剪矩阵的行提取六个视锥平面（ax + by + cz + d >= 0为内侧），法向已归一化
+void frustumPlanes(const QMatrix4x4& clip, QVector4D planes[6]) {
+    QVector4D r0 = clip.row(0), r1 = clip.row(1), r2 = clip.row(2), r3 = clip.row(3);
+    planes[0] = r3 + r0;
+    planes[1] = r3 - r0;
+    planes[2] = r3 + r1;
+    planes[3] = r3 - r1;
+    planes[4] = r3 + r2;
+    planes[5] = r3 - r2;
+    for (int i = 0; i < 6; ++i) {
+        float len = planes[i].toVector3D().length();
+        if (len > 0.0f) planes[i] /= len;
+    }
+}
+
+// 包围球是否与视锥相交
+bool sphereVisible(const QVector4D planes[6], const QVector3D& center, float radius) {
+    for (int i = 0; i < 6; ++i) {
+        if (QVector3D::dotProduct(planes[i].toVector3D(), center) + planes[i].w() < -radius) return false;
+    }
+    return true;
+}
+
+// 矩阵左上3×3的最大列长，即包围球半径的放大倍数
+float maxAxisScale(const QMatrix4x4& m) {
+    return std::max({ m.column(0).toVector3D().length(), m.column(1).toVector3D().length(),
+                      m.column(2).toVector3D().length() });
+}
+
+} // namespace
+
+QMatrix4x4 MeshScene::Object::transform() const {
+    QMatrix4x4 m;
+    m.translate(translation);
+    m.rotate(rotation);
+    m.scale(scale);
+    return m;
+}
+
+MeshScene::MeshScene() {
+}
+
+void MeshScene::initialize() {
+    initializeOpenGLFunctions();
+    program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/scene.vert");
+    program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/scene.frag");
+    if (!program.link()) {
+        qWarning() << "Scene shader link failed:" << program.log();
+    }
+
+    // glMultiDrawElementsIndirect是桌面GL 4.3的函数，QOpenGLExtraFunctions（ES 3.1）里没有
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    if (context && !context->isOpenGLES()) {
+        multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirect>(
+            context->getProcAddress("glMultiDrawElementsIndirect"));
+    }
+    if (!multiDrawElementsIndirect) {
+        qWarning() << "glMultiDrawElementsIndirect unavailable, scene objects are drawn one by one";
+    }
+
+    vao.create();
+    glGenBuffers(1, &objectBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &objectIdBuffer);
+}
+
+void MeshScene::release() {
+    vao.destroy();
+    for (GLuint* buffer : { &vertexArena.buffer, &indexArena.buffer, &objectBuffer, &commandBuffer, &objectIdBuffer }) {
+        if (*buffer) {
+            glDeleteBuffers(1, buffer);
+            *buffer = 0;
+        }
+    }
+}
+
+void MeshScene::append(Arena& arena, const void* data, size_t bytes) {
+    size_t needed = arena.used + bytes;
+    if (needed > arena.capacity) {
+        // 按倍数扩容，旧内容在GPU上复制过去
+        size_t capacity = std::max(needed, std::max(arena.capacity * 2, MinArenaBytes));
+        GLuint grown = 0;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(capacity), nullptr, GL_STATIC_DRAW);
+        if (arena.buffer) {
+            if (arena.used > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, arena.buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, GLsizeiptr(arena.used));
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &arena.buffer);
+        }
+        arena.buffer = grown;
+        arena.capacity = capacity;
+        layoutDirty = true;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(arena.used), GLsizeiptr(bytes), data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    arena.used = needed;
+}
+
+int MeshScene::addObject(const QString& name, const std::vector<float>& positions,
+                         const std::vector<unsigned int>& indices, const QVector3D& color) {
+    if (positions.size() < 3 || indices.empty()) return -1;
+
+    Object object;
+    object.name = name;
+    object.color = color;
+    object.baseVertex = GLint(vertexArena.used / (3 * sizeof(float)));
+    object.vertexCount = GLuint(positions.size() / 3);
+    object.firstIndex = GLuint(indexArena.used / sizeof(unsigned int));
+    object.indexCount = GLuint(indices.size());
+
+    object.boundsMin = object.boundsMax = QVector3D(positions[0], positions[1], positions[2]);
+    for (size_t i = 3; i + 2 < positions.size(); i += 3) {
+        QVector3D p(positions[i], positions[i + 1], positions[i + 2]);
+        object.boundsMin = QVector3D(std::min(object.boundsMin.x(), p.x()), std::min(object.boundsMin.y(), p.y()),
+                                     std::min(object.boundsMin.z(), p.z()));
+        object.boundsMax = QVector3D(std::max(object.boundsMax.x(), p.x()), std::max(object.boundsMax.y(), p.y()),
+                                     std::max(object.boundsMax.z(), p.z()));
+    }
+
+    append(vertexArena, positions.data(), object.vertexCount * 3 * sizeof(float));
+    append(indexArena, indices.data(), indices.size() * sizeof(unsigned int));
+
+    objects.push_back(object);
+    ++revisionCounter;
+    return int(objects.size()) - 1;
+}
+
+void MeshScene::removeObject(int index) {
+    if (index < 0 || index >= int(objects.size())) return;
+    const Object& object = objects[index];
+    vertexArena.garbage += object.vertexCount * 3 * sizeof(float);
+    indexArena.garbage += object.indexCount * sizeof(unsigned int);
+    objects.erase(objects.begin() + index);
+
+    if (objects.empty()) {
+        vertexArena.used = vertexArena.garbage = 0;
+        indexArena.used = indexArena.garbage = 0;
+    } else if (vertexArena.garbage * 2 > vertexArena.used || indexArena.garbage * 2 > indexArena.used) {
+        compact();
+    }
+    ++revisionCounter;
+}
+
+void MeshScene::compact() {
+    // 存活对象的区间依次复制到新缓冲区，之后只需改写baseVertex和firstIndex，索引本身不变
+    auto relocate = [this](Arena& arena, size_t elementBytes, bool vertices) {
+        size_t live = arena.used - arena.garbage;
+        size_t capacity = std::max(live, MinArenaBytes);
+        GLuint packed = 0;
+        glGenBuffers(1, &packed);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, packed);
+        glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(capacity), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, arena.buffer);
+        size_t offset = 0;
+        for (Object& object : objects) {
+            size_t first = vertices ? size_t(object.baseVertex) : object.firstIndex;
+            size_t bytes = (vertices ? object.vertexCount : object.indexCount) * elementBytes;
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                GLintptr(first * elementBytes), GLintptr(offset), GLsizeiptr(bytes));
+            if (vertices) {
+                object.baseVertex = GLint(offset / elementBytes);
+            } else {
+                object.firstIndex = GLuint(offset / elementBytes);
+            }
+            offset += bytes;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &arena.buffer);
+        arena.buffer = packed;
+        arena.capacity = capacity;
+        arena.used = offset;
+        arena.garbage = 0;
+    };
+    relocate(vertexArena, 3 * sizeof(float), true);
+    relocate(indexArena, sizeof(unsigned int), false);
+    layoutDirty = true;
+}
+
+void MeshScene::clear() {
+    objects.clear();
+    // arena直接删除，下次加入对象时按最小容量重新分配
+    for (Arena* arena : { &vertexArena, &indexArena }) {
+        if (arena->buffer) {
+            glDeleteBuffers(1, &arena->buffer);
+            arena->buffer = 0;
+        }
+        *arena = Arena();
+    }
+    commandCount = 0;
+    lastDrawCalls = 0;
+    lastVisibleCopies = 0;
+    layoutDirty = true;
+    ++revisionCounter;
+}
+
+void MeshScene::setTransform(int index, const QVector3D& translation, const QQuaternion& rotation, float scale) {
+    if (index < 0 || index >= int(objects.size())) return;
+    objects[index].translation = translation;
+    objects[index].rotation = rotation;
+    objects[index].scale = scale;
+    ++revisionCounter;
+}
+
+void MeshScene::setColor(int index, const QVector3D& color) {
+    if (index < 0 || index >= int(objects.size())) return;
+    objects[index].color = color;
+    ++revisionCounter;
+}
+
+void MeshScene::setVisible(int index, bool visible) {
+    if (index < 0 || index >= int(objects.size())) return;
+    objects[index].visible = visible;
+    ++revisionCounter;
+}
+
+void MeshScene::setInstances(int index, const std::vector<QMatrix4x4>& instances) {
+    if (index < 0 || index >= int(objects.size())) return;
+    objects[index].instances = instances;
+    ++revisionCounter;
+}
+
+bool MeshScene::bounds(QVector3D& min, QVector3D& max) const {
+    bool found = false;
+    auto addBox = [&](const Object& object, const QMatrix4x4& m) {
+        for (int corner = 0; corner < 8; ++corner) {
+            QVector3D p(corner & 1 ? object.boundsMax.x() : object.boundsMin.x(),
+                        corner & 2 ? object.boundsMax.y() : object.boundsMin.y(),
+                        corner & 4 ? object.boundsMax.z() : object.boundsMin.z());
+            p = m.map(p);
+            if (!found) {
+                min = max = p;
+                found = true;
+            } else {
+                min = QVector3D(std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z()));
+                max = QVector3D(std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z()));
+            }
+        }
+    };
+    for (const Object& object : objects) {
+        QMatrix4x4 m = object.transform();
+        if (object.instances.empty()) {
+            addBox(object, m);
+        }
+        for (const QMatrix4x4& instance : object.instances) {
+            addBox(object, m * instance);
+        }
+    }
+    return found;
+}
+
+size_t MeshScene::copyCount() const {
+    size_t count = 0;
+    for (const Object& object : objects) {
+        count += std::max<size_t>(1, object.instances.size());
+    }
+    return count;
+}
+
+size_t MeshScene::triangleCount() const {
+    size_t count = 0;
+    for (const Object& object : objects) {
+        count += object.indexCount / 3;
+    }
+    return count;
+}
+
+void MeshScene::sync(const QMatrix4x4& sceneToClip) {
+    size_t copies = copyCount();
+    if (copies > objectIdCapacity) {
+        // 编号缓冲区只增不减，按倍数扩容
+        objectIdCapacity = std::max(copies, std::max(objectIdCapacity * 2, size_t(256)));
+        std::vector<GLuint> ids(objectIdCapacity);
+        std::iota(ids.begin(), ids.end(), 0u);
+        glBindBuffer(GL_ARRAY_BUFFER, objectIdBuffer);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(ids.size() * sizeof(GLuint)), ids.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        layoutDirty = true;
+    }
+
+    if (layoutDirty && vertexArena.buffer && indexArena.buffer) {
+        vao.bind();
+        glBindBuffer(GL_ARRAY_BUFFER, vertexArena.buffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+        glBindBuffer(GL_ARRAY_BUFFER, objectIdBuffer);
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+        glVertexAttribDivisor(1, 1);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexArena.buffer);
+        vao.release();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        layoutDirty = false;
+    }
+
+    // 每个对象的可见副本连续存放，对应命令的baseInstance指向第一个，instanceCount为个数
+    QVector4D planes[6];
+    frustumPlanes(sceneToClip, planes);
+    std::vector<ObjectData> data;
+    data.reserve(copies);
+    std::vector<DrawCommand> commands;
+    commands.reserve(objects.size());
+    for (const Object& object : objects) {
+        if (!object.visible) continue;
+        QMatrix4x4 m = object.transform();
+        QVector3D center = (object.boundsMin + object.boundsMax) * 0.5f;
+        float radius = (object.boundsMax - object.boundsMin).length() * 0.5f;
+        GLuint first = GLuint(data.size());
+        auto emitCopy = [&](const QMatrix4x4& transform) {
+            ObjectData entry;
+            std::copy(transform.constData(), transform.constData() + 16, entry.transform);
+            entry.color[0] = object.color.x();
+            entry.color[1] = object.color.y();
+            entry.color[2] = object.color.z();
+            entry.color[3] = 1.0f;
+            data.push_back(entry);
+        };
+
+        if (object.instances.empty()) {
+            if (sphereVisible(planes, m.map(center), radius * maxAxisScale(m))) {
+                emitCopy(m);
+            }
+        } else {
+            // 实例多时并行剔除，再按原顺序收集可见的实例
+            const std::vector<QMatrix4x4>& instances = object.instances;
+            copyVisible.resize(instances.size());
+            parallel::for_each(0, instances.size(), [&](size_t i) {
+                QMatrix4x4 world = m * instances[i];
+                copyVisible[i] = sphereVisible(planes, world.map(center), radius * maxAxisScale(world)) ? 1 : 0;
+            });
+            for (size_t i = 0; i < instances.size(); ++i) {
+                if (copyVisible[i]) emitCopy(m * instances[i]);
+            }
+        }
+
+        GLuint count = GLuint(data.size()) - first;
+        if (count > 0) {
+            DrawCommand command = { object.indexCount, count, object.firstIndex, object.baseVertex, first };
+            commands.push_back(command);
+        }
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(data.size() * sizeof(ObjectData)), data.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, GLsizeiptr(commands.size() * sizeof(DrawCommand)), commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    commandCount = int(commands.size());
+    lastVisibleCopies = data.size();
+}
+
+void MeshScene::draw(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection,
+                     const QVector3D& viewPos, bool specularEnabled) {
+    lastDrawCalls = 0;
+    lastVisibleCopies = 0;
+    if (objects.empty()) return;
+    sync(projection * view * model);
+    if (commandCount == 0) return;
+
+    // 与网格绘制相同的三个光源
+    QVector3D lightPositions[3] = {
+        QVector3D(10.0f, 10.0f, -10.0f),
+        QVector3D(-10.0f, 10.0f, -10.0f),
+        QVector3D(0.0f, 0.0f, 10.0f)
+    };
+    QVector3D lightColors[3] = {
+        QVector3D(1.0f, 1.0f, 1.0f),
+        QVector3D(1.0f, 1.0f, 1.0f),
+        QVector3D(1.0f, 1.0f, 1.0f)
+    };
+
+    program.bind();
+    vao.bind();
+    program.setUniformValue("model", model);
+    program.setUniformValue("view", view);
+    program.setUniformValue("projection", projection);
+    for (int i = 0; i < 3; i++) {
+        program.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+        program.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
+    }
+    program.setUniformValue("viewPos", viewPos);
+    program.setUniformValue("specularEnabled", specularEnabled);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, objectBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    if (multiDrawElementsIndirect) {
+        multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commandCount, 0);
+        lastDrawCalls = 1;
+    } else {
+        for (int i = 0; i < commandCount; ++i) {
+            glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                   reinterpret_cast<const void*>(size_t(i) * sizeof(DrawCommand)));
+        }
+        lastDrawCalls = commandCount;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    vao.release();
+    program.release();
+}
@@ -0,0 +1,115 @@
+// meshscene.h
+#ifndef MESHSCENE_H
+#define MESHSCENE_H
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QMatrix4x4>
+#include <QQuaternion>
+#include <QVector3D>
+#include <QString>
+#include <vector>
+
+// 多个网格对象组成的场景。所有对象的顶点和索引放在同一对大缓冲区（arena）中，
+// 逐对象的变换和颜色放在SSBO里，每帧用一次glMultiDrawElementsIndirect画出全部可见对象，
+// 绘制调用数不随对象数增长。arena容量不足时在GPU上复制扩容，删除对象留下的空洞过半时整理。
+// 带实例的对象几何只上传一次，每帧在CPU上逐实例做视锥剔除，留下的实例变换写入SSBO，
+// 以一条instanceCount为可见实例数的间接命令画出
+class MeshScene : protected QOpenGLExtraFunctions
+{
+public:
+    struct Object
+    {
+        QString name;
+        QVector3D translation;
+        QQuaternion rotation;
+        float scale = 1.0f;
+        QVector3D color;
+        bool visible = true;
+        // 为空时对象画一次；否则每个实例画在transform() * instances[i]处
+        std::vector<QMatrix4x4> instances;
+
+        // 在arena中的位置（以顶点和索引计）
+        GLint baseVertex = 0;
+        GLuint vertexCount = 0;
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+        // 局部坐标包围盒
+        QVector3D boundsMin;
+        QVector3D boundsMax;
+
+        // 局部坐标到场景坐标：先缩放、再旋转、最后平移
+        QMatrix4x4 transform() const;
+    };
+
+    MeshScene();
+
+    // 以下函数都要在控件的GL上下文中调用
+    void initialize();
+    void release();
+    // positions为每顶点x y z，indices为三角形列表；返回对象下标，网格为空时返回-1
+    int addObject(const QString& name, const std::vector<float>& positions,
+                  const std::vector<unsigned int>& indices, const QVector3D& color);
+    void removeObject(int index);
+    void clear();
+    void draw(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection,
+              const QVector3D& viewPos, bool specularEnabled);
+
+    bool empty() const { return objects.empty(); }
+    int objectCount() const { return int(objects.size()); }
+    const Object& object(int index) const { return objects[index]; }
+    void setTransform(int index, const QVector3D& translation, const QQuaternion& rotation, float scale);
+    void setColor(int index, const QVector3D& color);
+    void setVisible(int index, bool visible);
+    void setInstances(int index, const std::vector<QMatrix4x4>& instances);
+
+    // 全部对象在场景坐标中的包围盒，场景为空时返回false
+    bool bounds(QVector3D& min, QVector3D& max) const;
+    size_t triangleCount() const;
+    // 全部对象的副本数（无实例的对象算一个）；visibleCopies为上一帧剔除后实际画出的副本数
+    size_t copyCount() const;
+    size_t visibleCopies() const { return lastVisibleCopies; }
+    // arena已分配的显存字节数
+    size_t arenaBytes() const { return vertexArena.capacity + indexArena.capacity; }
+    // 上一帧的绘制调用数：支持多重间接绘制时为1，否则为可见对象数
+    int drawCalls() const { return lastDrawCalls; }
+    // 任何影响画面的修改都会递增，供重绘状态哈希使用
+    quint64 revision() const { return revisionCounter; }
+
+private:
+    struct Arena
+    {
+        GLuint buffer = 0;
+        size_t capacity = 0;   // 字节
+        size_t used = 0;       // 已写入的字节（含空洞）
+        size_t garbage = 0;    // 已删除对象留下的字节
+    };
+
+    void append(Arena& arena, const void* data, size_t bytes);
+    void compact();
+    void sync(const QMatrix4x4& sceneToClip);
+
+    typedef void (QOPENGLF_APIENTRYP MultiDrawElementsIndirect)(GLenum mode, GLenum type, const void* indirect,
+                                                                 GLsizei drawcount, GLsizei stride);
+    MultiDrawElementsIndirect multiDrawElementsIndirect = nullptr;
+
+    std::vector<Object> objects;
+    Arena vertexArena;
+    Arena indexArena;
+
+    QOpenGLShaderProgram program;
+    QOpenGLVertexArrayObject vao;
+    GLuint objectBuffer = 0;     // SSBO binding 2：每个可见副本一个变换和颜色，每帧重写
+    GLuint commandBuffer = 0;    // 可见对象的间接绘制命令
+    GLuint objectIdBuffer = 0;   // 0, 1, 2, ...，作为除数为1的实例属性
+    size_t objectIdCapacity = 0;
+
+    bool layoutDirty = true;     // arena或编号缓冲区换了名字，需要重新绑定VAO
+    int commandCount = 0;
+    int lastDrawCalls = 0;
+    size_t lastVisibleCopies = 0;
+    std::vector<unsigned char> copyVisible;
+    quint64 revisionCounter = 0;
+};
+
+#endif // MESHSCENE_H
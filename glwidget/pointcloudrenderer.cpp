@@ -0,0 +1,160 @@
+// pointcloudrenderer.cpp
+#include "pointcloudrenderer.h"
+#include "../meshutils/parallel_utils.h"
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 大缓冲区分块上传，避免驱动一次性复制上GB的数据
+const size_t UploadChunkBytes = size_t(64) << 20;
+
+// 单位法向打包成GL_INT_2_10_10_10_REV，每点4字节
+quint32 packNormal(const float* n) {
+    float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (len == 0.0f) return 0;
+    quint32 packed = 0;
+    for (int a = 0; a < 3; ++a) {
+        int q = qRound(qBound(-1.0f, n[a] / len, 1.0f) * 511.0f);
+        packed |= (quint32(q) & 0x3ffu) << (10 * a);
+    }
+    return packed;
+}
+
+} // namespace
+
+PointCloudRenderer::PointCloudRenderer()
+    : positionVbo(QOpenGLBuffer::VertexBuffer),
+      normalVbo(QOpenGLBuffer::VertexBuffer),
+      colorVbo(QOpenGLBuffer::VertexBuffer)
+{
+}
+
+void PointCloudRenderer::initialize() {
+    initializeOpenGLFunctions();
+    program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/pointcloud.vert");
+    program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/pointcloud.frag");
+    if (!program.link()) {
+        qWarning() << "Point cloud shader link failed:" << program.log();
+    }
+    spacingLocation = program.uniformLocation("spacing");
+
+    GLfloat range[2] = { 1.0f, 64.0f };
+    glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, range);
+    maxPointSize = qMin(64.0f, range[1]);
+
+    vao.create();
+    positionVbo.create();
+    normalVbo.create();
+    colorVbo.create();
+}
+
+void PointCloudRenderer::release() {
+    vao.destroy();
+    positionVbo.destroy();
+    normalVbo.destroy();
+    colorVbo.destroy();
+}
+
+void PointCloudRenderer::upload(const point_cloud::Cloud& cloud, PointOctree&& tree) {
+    octree = std::move(tree);
+    draws.clear();
+    lastDrawnPoints = 0;
+    size_t n = cloud.size();
+
+    // QOpenGLBuffer::allocate的长度是int，上亿个点时会溢出，直接用glBufferData
+    auto uploadBuffer = [this](QOpenGLBuffer& buffer, const void* data, size_t bytes) {
+        buffer.bind();
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bytes), nullptr, GL_STATIC_DRAW);
+        const char* src = static_cast<const char*>(data);
+        for (size_t offset = 0; offset < bytes; offset += UploadChunkBytes) {
+            size_t len = std::min(UploadChunkBytes, bytes - offset);
+            glBufferSubData(GL_ARRAY_BUFFER, GLintptr(offset), GLsizeiptr(len), src + offset);
+        }
+    };
+
+    vao.bind();
+    uploadBuffer(positionVbo, cloud.positions.data(), cloud.positions.size() * sizeof(float));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+
+    normalsUploaded = cloud.has_normals();
+    if (normalsUploaded) {
+        std::vector<quint32> packed(n);
+        parallel::for_each(0, n, [&](size_t i) {
+            packed[i] = packNormal(&cloud.normals[3 * i]);
+        });
+        uploadBuffer(normalVbo, packed.data(), packed.size() * sizeof(quint32));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 0, nullptr);
+    } else {
+        glDisableVertexAttribArray(1);
+    }
+
+    colorsUploaded = cloud.has_colors();
+    if (colorsUploaded) {
+        uploadBuffer(colorVbo, cloud.colors.data(), cloud.colors.size());
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, nullptr);
+    } else {
+        glDisableVertexAttribArray(2);
+    }
+    vao.release();
+    positionVbo.release();
+}
+
+void PointCloudRenderer::clear() {
+    octree.clear();
+    draws.clear();
+    lastDrawnPoints = 0;
+    normalsUploaded = false;
+    colorsUploaded = false;
+    // 释放显存，缓冲区对象本身保留
+    for (QOpenGLBuffer* buffer : { &positionVbo, &normalVbo, &colorVbo }) {
+        if (!buffer->isCreated()) continue;
+        buffer->bind();
+        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+        buffer->release();
+    }
+}
+
+void PointCloudRenderer::draw(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection,
+                              const QSize& viewportPixels, const QVector3D& color) {
+    if (octree.empty()) return;
+
+    // model为旋转加均匀缩放，点间距是对象空间的长度
+    float objectScale = model.column(0).toVector3D().length();
+    float pixelScale = 0.5f * viewportPixels.height() * projection(1, 1) * objectScale;
+
+    QMatrix4x4 mvp = projection * view * model;
+    PointOctree::View lodView;
+    std::copy(mvp.constData(), mvp.constData() + 16, lodView.mvp);
+    lodView.pixel_scale = pixelScale;
+    lodView.pixel_spacing = 1.0f;
+    lodView.point_budget = budget;
+    lastDrawnPoints = octree.select(lodView, draws);
+    if (draws.empty()) return;
+
+    program.bind();
+    vao.bind();
+    program.setUniformValue("model", model);
+    program.setUniformValue("view", view);
+    program.setUniformValue("projection", projection);
+    program.setUniformValue("pointScale", pixelScale * sizeScale);
+    program.setUniformValue("maxPointSize", maxPointSize);
+    program.setUniformValue("useNormals", normalShading && normalsUploaded);
+    program.setUniformValue("useColors", vertexColors && colorsUploaded);
+    program.setUniformValue("objectColor", color);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    for (const PointOctree::Draw& d : draws) {
+        program.setUniformValue(spacingLocation, d.spacing);
+        glDrawArrays(GL_POINTS, GLint(d.first), GLsizei(d.count));
+    }
+    glDisable(GL_PROGRAM_POINT_SIZE);
+
+    vao.release();
+    program.release();
+}
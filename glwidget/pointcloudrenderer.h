@@ -0,0 +1,73 @@
+// pointcloudrenderer.h
+#ifndef POINTCLOUDRENDERER_H
+#define POINTCLOUDRENDERER_H
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QSize>
+#include <vector>
+#include "../meshutils/point_cloud.h"
+#include "../meshutils/point_octree.h"
+
+// 没有面的点云的绘制，两个控件共用。点按PointOctree的先序布局一次性上传，
+// 每帧在CPU上选出视锥内的节点区间逐个glDrawArrays(GL_POINTS)，
+// 点精灵的直径按节点的点间距和距离衰减；每帧的点数受预算限制，帧时间不随点云规模增长
+class PointCloudRenderer : protected QOpenGLExtraFunctions
+{
+public:
+    PointCloudRenderer();
+
+    // 以下函数都要在控件的GL上下文中调用
+    void initialize();
+    void release();
+    // cloud须已用tree.build重排；上传后cloud可以释放，CPU端只保留八叉树节点
+    void upload(const point_cloud::Cloud& cloud, PointOctree&& tree);
+    void clear();
+    void draw(const QMatrix4x4& model, const QMatrix4x4& view, const QMatrix4x4& projection,
+              const QSize& viewportPixels, const QVector3D& color);
+
+    bool empty() const { return octree.empty(); }
+    size_t pointCount() const { return octree.point_count(); }
+    size_t nodeCount() const { return octree.nodes().size(); }
+    bool hasNormals() const { return normalsUploaded; }
+    bool hasColors() const { return colorsUploaded; }
+
+    void setPointBudget(size_t points) { budget = points; }
+    size_t pointBudget() const { return budget; }
+    // 点精灵直径相对点间距的倍数
+    void setPointSizeScale(float scale) { sizeScale = scale; }
+    float pointSizeScale() const { return sizeScale; }
+    void setNormalShading(bool enabled) { normalShading = enabled; }
+    bool normalShadingEnabled() const { return normalShading; }
+    void setVertexColors(bool enabled) { vertexColors = enabled; }
+    bool vertexColorsEnabled() const { return vertexColors; }
+
+    // 上一帧画出的点数和节点区间数
+    size_t drawnPoints() const { return lastDrawnPoints; }
+    size_t drawnNodes() const { return draws.size(); }
+
+private:
+    PointOctree octree;
+    std::vector<PointOctree::Draw> draws;
+
+    QOpenGLShaderProgram program;
+    QOpenGLVertexArrayObject vao;
+    QOpenGLBuffer positionVbo;
+    QOpenGLBuffer normalVbo;
+    QOpenGLBuffer colorVbo;
+    int spacingLocation = -1;
+    float maxPointSize = 64.0f;
+
+    bool normalsUploaded = false;
+    bool colorsUploaded = false;
+    size_t budget = 3000000;
+    float sizeScale = 1.5f;
+    bool normalShading = true;
+    bool vertexColors = true;
+    size_t lastDrawnPoints = 0;
+};
+
+#endif // POINTCLOUDRENDERER_H
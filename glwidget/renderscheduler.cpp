@@ -0,0 +1,80 @@
+// renderscheduler.cpp
+#include "renderscheduler.h"
+#include <QOpenGLWidget>
+#include <QtGlobal>
+
+RenderScheduler::RenderScheduler(QOpenGLWidget* widget)
+    : QObject(widget), widget(widget)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &RenderScheduler::dispatch);
+}
+
+void RenderScheduler::requestUpdate() {
+    // 已有待发的重绘，本次请求并入其中
+    if (timer.isActive()) return;
+
+    int delay = 0;
+    if (interacting && maxFps > 0 && sinceLastFrame.isValid()) {
+        qint64 minInterval = 1000 / maxFps;
+        delay = int(qMax<qint64>(0, minInterval - sinceLastFrame.elapsed()));
+    }
+    timer.start(delay);
+}
+
+void RenderScheduler::markDirty() {
+    dirty = true;
+    requestUpdate();
+}
+
+void RenderScheduler::beginInteraction() {
+    interacting = true;
+}
+
+void RenderScheduler::endInteraction() {
+    interacting = false;
+    // 松开后立即补上最后一帧
+    requestUpdate();
+}
+
+void RenderScheduler::setMaxInteractiveFps(int fps) {
+    maxFps = qMax(0, fps);
+}
+
+void RenderScheduler::dispatch() {
+    if (stateHash && !dirty && hasPainted && stateHash() == lastHash) {
+        skipped++;
+        return;
+    }
+    widget->update();
+}
+
+void RenderScheduler::frameStarted() {
+    // 帧间隔只在连续交互时有意义，空闲时两次重绘之间可能隔了几分钟
+    if (interacting && sinceLastFrame.isValid()) {
+        double interval = sinceLastFrame.nsecsElapsed() / 1.0e6;
+        avgIntervalMs = avgIntervalMs > 0.0 ? avgIntervalMs * 0.9 + interval * 0.1 : interval;
+    }
+    sinceLastFrame.restart();
+    frameClock.restart();
+
+    // 无论重绘来自调度器还是窗口系统（缩放、遮挡），都记下本帧对应的状态
+    if (stateHash) {
+        lastHash = stateHash();
+    }
+    hasPainted = true;
+    dirty = false;
+}
+
+void RenderScheduler::frameFinished() {
+    double frameMs = frameClock.nsecsElapsed() / 1.0e6;
+    avgFrameMs = avgFrameMs > 0.0 ? avgFrameMs * 0.9 + frameMs * 0.1 : frameMs;
+
+    // 连续交互时每30帧报告一次，单帧重绘时立即报告
+    framesSinceReport++;
+    if (!interacting || framesSinceReport >= 30) {
+        emit frameTimeUpdated(avgFrameMs, avgIntervalMs);
+        framesSinceReport = 0;
+    }
+}
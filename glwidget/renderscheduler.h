@@ -0,0 +1,103 @@
+// renderscheduler.h
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QColor>
+#include <QVector3D>
+#include <QVector4D>
+#include <QQuaternion>
+#include <QSize>
+#include <functional>
+#include <cstring>
+
+class QOpenGLWidget;
+
+// 渲染状态哈希：把相机、颜色、显示开关等影响画面的量混合成一个值，
+// 值不变说明上一帧仍然有效，不必重绘
+class RenderStateHash
+{
+public:
+    RenderStateHash& add(quint64 v) {
+        // FNV-1a风格的逐字节混合
+        for (int i = 0; i < 8; i++) {
+            h ^= (v >> (i * 8)) & 0xffu;
+            h *= 1099511628211ull;
+        }
+        return *this;
+    }
+    RenderStateHash& add(int v) { return add(quint64(quint32(v))); }
+    RenderStateHash& add(bool v) { return add(quint64(v ? 1 : 0)); }
+    RenderStateHash& add(float v) {
+        quint32 bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return add(quint64(bits));
+    }
+    RenderStateHash& add(const QVector3D& v) { return add(v.x()).add(v.y()).add(v.z()); }
+    RenderStateHash& add(const QVector4D& v) { return add(v.x()).add(v.y()).add(v.z()).add(v.w()); }
+    RenderStateHash& add(const QQuaternion& q) { return add(q.toVector4D()); }
+    RenderStateHash& add(const QColor& c) { return add(quint64(c.rgba())); }
+    RenderStateHash& add(const QSize& s) { return add(s.width()).add(s.height()); }
+
+    quint64 value() const { return h; }
+
+private:
+    quint64 h = 1469598103934665603ull;
+};
+
+// 按需渲染调度：合并重绘请求，状态未变时跳过，交互期间限制最高帧率
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderScheduler(QOpenGLWidget* widget);
+
+    // 由控件提供当前渲染状态的哈希
+    void setStateHashFunction(std::function<quint64()> fn) { stateHash = fn; }
+
+    // 请求重绘：同一间隔内的多次请求只触发一次update()
+    void requestUpdate();
+    // 缓冲区等无法通过哈希观察的变化，强制下一帧重绘
+    void markDirty();
+
+    // 鼠标拖动等连续交互期间按maxInteractiveFps限速
+    void beginInteraction();
+    void endInteraction();
+    void setMaxInteractiveFps(int fps);
+    int maxInteractiveFps() const { return maxFps; }
+
+    // 由paintGL首尾调用，统计实际帧时间
+    void frameStarted();
+    void frameFinished();
+
+    double averageFrameTimeMs() const { return avgFrameMs; }
+    int skippedRequests() const { return skipped; }
+
+signals:
+    // 帧时间为paintGL的CPU端耗时，帧间隔为相邻两帧开始的时间差
+    void frameTimeUpdated(double frameTimeMs, double frameIntervalMs);
+
+private:
+    void dispatch();
+
+    QOpenGLWidget* widget;
+    QTimer timer;
+    QElapsedTimer sinceLastFrame;
+    QElapsedTimer frameClock;
+    std::function<quint64()> stateHash;
+
+    quint64 lastHash = 0;
+    bool hasPainted = false;
+    bool dirty = true;
+    bool interacting = false;
+    int maxFps = 60;
+    int skipped = 0;
+
+    double avgFrameMs = 0.0;
+    double avgIntervalMs = 0.0;
+    int framesSinceReport = 0;
+};
+
+#endif // RENDERSCHEDULER_H
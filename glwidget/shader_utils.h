@@ -0,0 +1,32 @@
+// shader_utils.h
+#pragma once
+#ifndef SHADER_UTILS_H
+#define SHADER_UTILS_H
+
+#include <QOpenGLShaderProgram>
+#include <QFile>
+#include <QDebug>
+
+namespace ShaderUtils {
+
+    // 从资源文件读取着色器源码，并在#version行之后插入宏定义，
+    // 这样同一份着色器文件可以编译出多个变体
+    inline bool addShaderWithDefines(QOpenGLShaderProgram& program, QOpenGLShader::ShaderType type,
+                                     const QString& path, const QByteArray& defines) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << "Failed to open shader:" << path;
+            return false;
+        }
+        
+        QByteArray source = file.readAll();
+        if (!defines.isEmpty()) {
+            int insertPos = source.startsWith("#version") ? source.indexOf('\n') + 1 : 0;
+            source.insert(insertPos, defines);
+        }
+        return program.addShaderFromSourceCode(type, source);
+    }
+
+} // namespace ShaderUtils
+
+#endif // SHADER_UTILS_H
@@ -4,6 +4,7 @@ in vec3 Normal;
 in float Curvature;
 out vec4 FragColor;
 uniform int curvatureType;
+uniform int isolineCount;   // >0时在[0,1]上等距画这么多条等值线
 
 vec3 mapToColor(float c) {
     c = clamp(c, 0.0, 1.0);
@@ -40,5 +41,11 @@ vec3 mapToColor(float c) {
 
 void main() {
     vec3 color = mapToColor(Curvature);
+    if (isolineCount > 0) {
+        // 按屏幕空间导数取线宽，约1.5像素
+        float s = Curvature * float(isolineCount);
+        float d = abs(fract(s + 0.5) - 0.5) / max(fwidth(s), 1e-5);
+        color = mix(vec3(0.05), color, clamp(d - 0.75, 0.0, 1.0));
+    }
     FragColor = vec4(color, 1.0);
 }
\ No newline at end of file
@@ -1,9 +1,10 @@
 #version 430 core
 
-out vec4 FragColor;
+// 面/边拾取：gl_PrimitiveID即三角形（或线段）在绘制调用中的序号，
+// 由CPU端映射回网格的面或边；0保留给背景
+layout (location = 0) out uint FragID;
 
 void main()
 {
-    // 面元绘制为黑色
-    FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+    FragID = uint(gl_PrimitiveID) + 1u;
 }
\ No newline at end of file
@@ -1,6 +1,13 @@
 #version 430 core
+#ifdef BARY_WIREFRAME
+in WireData {
+    vec3 FragPos;
+    noperspective vec3 Bary;
+    flat uint EdgeMask;
+};
+#else
 in vec3 FragPos;
-in vec3 Normal;
+#endif
 
 out vec4 FragColor;
 
@@ -9,15 +16,41 @@ uniform vec3 lightColors[3];
 uniform vec3 viewPos;
 uniform vec3 objectColor;
 uniform bool specularEnabled;
+// 逐三角形颜色（RGBA8，按gl_PrimitiveID索引），alpha为0的三角形仍用objectColor
+layout(std430, binding = 1) readonly buffer FaceColors {
+    uint faceColors[];
+};
+uniform bool faceColorsEnabled;
+
+#ifdef BARY_WIREFRAME
+uniform vec4 lineColor;
+uniform float lineWidth;
+
+// 到最近的（未被屏蔽的）边的覆盖系数：边上为0，内部为1
+float edgeFactor() {
+    vec3 width = fwidth(Bary) * lineWidth;
+    vec3 a = smoothstep(vec3(0.0), width, Bary);
+    if ((EdgeMask & 1u) == 0u) a.z = 1.0;
+    if ((EdgeMask & 2u) == 0u) a.x = 1.0;
+    if ((EdgeMask & 4u) == 0u) a.y = 1.0;
+    return min(min(a.x, a.y), a.z);
+}
+#endif
 
 void main()
 {
-    // 使用面的法向量（通过求导计算得到）
+    // 使用面的法向量（通过求导计算得到）：FragPos在三角形内线性插值，
+    // 其屏幕空间偏导张成三角形所在平面，叉积即为精确的面法线（朝向观察者）
     vec3 fdx = dFdx(FragPos);
     vec3 fdy = dFdy(FragPos);
     vec3 faceNormal = normalize(cross(fdx, fdy));
     
     vec3 result = vec3(0.0);
+    vec3 baseColor = objectColor;
+    if (faceColorsEnabled) {
+        vec4 faceColor = unpackUnorm4x8(faceColors[gl_PrimitiveID]);
+        if (faceColor.a > 0.0) baseColor = faceColor.rgb;
+    }
     
     for(int i = 0; i < 3; i++) {
         // 环境光
@@ -40,8 +73,11 @@ void main()
             specular = vec3(0.0);
         }
         
-        result += (ambient + diffuse + specular) * objectColor;
+        result += (ambient + diffuse + specular) * baseColor;
     }
     
+#ifdef BARY_WIREFRAME
+    result = mix(lineColor.rgb, result, 1.0 - (1.0 - edgeFactor()) * lineColor.a);
+#endif
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
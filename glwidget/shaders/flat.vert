@@ -1,18 +1,16 @@
 #version 430 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
 
+// 平面着色不需要顶点法线：面法线在片元着色器中由屏幕空间导数求出，
+// 因此共享顶点的网格无需复制顶点，也无需上传逐面法线
 out vec3 FragPos;
-out vec3 Normal;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat3 normalMatrix;
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = normalMatrix * aNormal;
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+}
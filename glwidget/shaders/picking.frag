@@ -1,14 +1,10 @@
 #version 430 core
-flat in int vertexID;
+flat in uint vertexID;
 
-out vec4 FragColor;
+// 写入R32UI整数纹理，0保留给背景，因此ID整体加1
+layout (location = 0) out uint FragID;
 
 void main()
 {
-    // 将顶点ID编码为颜色
-    int r = (vertexID) & 0xFF;
-    int g = (vertexID >> 8) & 0xFF;
-    int b = (vertexID >> 16) & 0xFF;
-    
-    FragColor = vec4(float(r) / 255.0, float(g) / 255.0, float(b) / 255.0, 1.0);
+    FragID = vertexID + 1u;
 }
\ No newline at end of file
@@ -4,14 +4,15 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform float pointSize = 15.0;
 
-flat out int vertexID;
+flat out uint vertexID;
 
 void main()
 {
     vec4 worldPos = model * vec4(aPos, 1.0);
     vec4 viewPos = view * worldPos;
     gl_Position = projection * viewPos;
-    gl_PointSize = 15.0; // 可选：增加点大小以提高拾取精度
-    vertexID = gl_VertexID;
+    gl_PointSize = pointSize; // 顶点拾取时以点的形式绘制，加大点以提高拾取容差
+    vertexID = uint(gl_VertexID);
 }
\ No newline at end of file
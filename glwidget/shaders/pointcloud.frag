@@ -0,0 +1,19 @@
+#version 430 core
+in vec3 Normal;
+in vec3 Color;
+uniform bool useNormals;
+out vec4 FragColor;
+
+void main() {
+   // 圆形点精灵
+   vec2 d = gl_PointCoord * 2.0 - 1.0;
+   if (dot(d, d) > 1.0) discard;
+
+   vec3 color = Color;
+   if (useNormals) {
+      // 头灯照明；扫描数据的法向朝向常不一致，按双面处理
+      float diffuse = abs(normalize(Normal).z);
+      color *= 0.3 + 0.7 * diffuse;
+   }
+   FragColor = vec4(color, 1.0);
+}
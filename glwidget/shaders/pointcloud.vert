@@ -0,0 +1,23 @@
+#version 430 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aNormal;   // 打包的2_10_10_10法向
+layout(location = 2) in vec4 aColor;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float pointScale;   // 对象空间长度1在w处投影为pointScale / w个像素
+uniform float spacing;      // 当前节点的点间距
+uniform float maxPointSize;
+uniform bool useColors;
+uniform vec3 objectColor;
+out vec3 Normal;
+out vec3 Color;
+
+void main() {
+   mat4 modelView = view * model;
+   gl_Position = projection * modelView * vec4(aPos, 1.0);
+   // 点精灵的直径随距离衰减，覆盖到相邻点
+   gl_PointSize = clamp(pointScale * spacing / gl_Position.w, 1.0, maxPointSize);
+   Normal = mat3(modelView) * aNormal.xyz;
+   Color = useColors ? aColor.rgb : objectColor;
+}
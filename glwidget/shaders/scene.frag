@@ -0,0 +1,40 @@
+#version 430 core
+in vec3 FragPos;
+flat in vec3 Color;
+
+out vec4 FragColor;
+
+uniform vec3 lightPositions[3];
+uniform vec3 lightColors[3];
+uniform vec3 viewPos;
+uniform bool specularEnabled;
+
+void main()
+{
+    // 与flat.frag相同，面法线由屏幕空间导数求出，arena中只存顶点位置
+    vec3 fdx = dFdx(FragPos);
+    vec3 fdy = dFdy(FragPos);
+    vec3 faceNormal = normalize(cross(fdx, fdy));
+    
+    vec3 result = vec3(0.0);
+    for(int i = 0; i < 3; i++) {
+        float ambientStrength = 0.1;
+        vec3 ambient = ambientStrength * lightColors[i];
+        
+        vec3 lightDir = normalize(lightPositions[i] - FragPos);
+        float diff = max(dot(faceNormal, lightDir), 0.0);
+        vec3 diffuse = diff * lightColors[i];
+        
+        vec3 specular = vec3(0.0);
+        if (specularEnabled) {
+            float specularStrength = 0.5;
+            vec3 viewDir = normalize(viewPos - FragPos);
+            vec3 reflectDir = reflect(-lightDir, faceNormal);
+            float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+            specular = specularStrength * spec * lightColors[i];
+        }
+        
+        result += (ambient + diffuse + specular) * Color;
+    }
+    FragColor = vec4(result, 1.0);
+}
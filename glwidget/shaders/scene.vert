@@ -0,0 +1,26 @@
+#version 430 core
+layout(location = 0) in vec3 aPos;
+// 副本编号：除数为1的实例属性，读到的是间接绘制命令的baseInstance + gl_InstanceID
+layout(location = 1) in uint aObject;
+
+struct SceneObject {
+    mat4 transform;
+    vec4 color;
+};
+layout(std430, binding = 2) readonly buffer SceneObjects {
+    SceneObject objects[];
+};
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 FragPos;
+flat out vec3 Color;
+
+void main()
+{
+    FragPos = vec3(model * objects[aObject].transform * vec4(aPos, 1.0));
+    Color = objects[aObject].color.rgb;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
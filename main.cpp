@@ -4,6 +4,8 @@
 #include <QHBoxLayout>
 #include "menu_utils.h"
 #include "tab_manager.h"
+#include "batch_runner.h"
+#include "thumbnail_runner.h"
 
 namespace UIUtils {
     // 应用深色主题
@@ -33,6 +35,14 @@ namespace UIUtils {
 
 int main(int argc, char *argv[])
 {
+    // 批处理和缩略图模式不创建窗口
+    if (BatchRunner::isBatchInvocation(argc, argv)) {
+        return BatchRunner::run(argc, argv);
+    }
+    if (ThumbnailRunner::isThumbnailInvocation(argc, argv)) {
+        return ThumbnailRunner::run(argc, argv);
+    }
+
     QApplication app(argc, argv);
     UIUtils::applyDarkTheme(app);
 
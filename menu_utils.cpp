@@ -312,6 +312,18 @@ namespace UIUtils {
 
 namespace UIUtils {
 
+    QString buttonStyleSheet() {
+        return "QPushButton {"
+               "   background-color: #505050;"
+               "   color: white;"
+               "   border: none;"
+               "   padding: 10px 20px;"
+               "   font-size: 16px;"
+               "   border-radius: 5px;"
+               "}"
+               "QPushButton:hover { background-color: #606060; }";
+    }
+
     // 创建颜色设置组
     QGroupBox* createColorSettingsGroup(QWidget* glWidget) {
         QGroupBox *colorGroup = new QGroupBox("Color Settings");
@@ -319,45 +331,15 @@ namespace UIUtils {
         
         // 背景颜色按钮
         QPushButton *bgColorButton = new QPushButton("Change Background Color");
-        bgColorButton->setStyleSheet(
-            "QPushButton {"
-            "   background-color: #505050;"
-            "   color: white;"
-            "   border: none;"
-            "   padding: 10px 20px;"
-            "   font-size: 16px;"
-            "   border-radius: 5px;"
-            "}"
-            "QPushButton:hover { background-color: #606060; }"
-        );
+        bgColorButton->setStyleSheet(UIUtils::buttonStyleSheet());
         
         // 网格颜色按钮
         QPushButton *gridColorButton = new QPushButton("Change Grid Color");
-        gridColorButton->setStyleSheet(
-            "QPushButton {"
-            "   background-color: #505050;"
-            "   color: white;"
-            "   border: none;"
-            "   padding: 10px 20px;"
-            "   font-size: 16px;"
-            "   border-radius: 5px;"
-            "}"
-            "QPushButton:hover { background-color: #606060; }"
-        );
+        gridColorButton->setStyleSheet(UIUtils::buttonStyleSheet());
         
         // 模型颜色按钮
         QPushButton *modelColorButton = new QPushButton("Change Model Color");
-        modelColorButton->setStyleSheet(
-            "QPushButton {"
-            "   background-color: #505050;"
-            "   color: white;"
-            "   border: none;"
-            "   padding: 10px 20px;"
-            "   font-size: 16px;"
-            "   border-radius: 5px;"
-            "}"
-            "QPushButton:hover { background-color: #606060; }"
-        );
+        modelColorButton->setStyleSheet(UIUtils::buttonStyleSheet());
         
         colorLayout->addWidget(bgColorButton);
         colorLayout->addWidget(gridColorButton);
@@ -86,6 +86,9 @@ namespace UIUtils {
                            QList<TabInfo>& tabInfos, QMap<QString, QWidget*>& controlPanelMap,
                            std::function<void(const QString&, bool)> createTabFunc = nullptr);
 
+    // 控制面板按钮的统一样式（深灰底、白字、圆角）
+    QString buttonStyleSheet();
+
     // 创建模型信息组
     QGroupBox* createModelInfoGroup(QLabel** infoLabel = nullptr);
 
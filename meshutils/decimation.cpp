@@ -0,0 +1,727 @@
+#include "decimation.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+namespace decimation
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef Mesh::HalfedgeHandle HH;
+		typedef Mesh::FaceHandle FH;
+		typedef OpenMesh::Vec3d Vec3d;
+
+		// 面数太少时不值得再分块
+		const size_t kMinBlockFaces = 1 << 16;
+
+		// 对称4x4矩阵[A b; b^T c]，误差为p^T A p + 2 b·p + c
+		struct Quadric
+		{
+			double a2 = 0, ab = 0, ac = 0, ad = 0;
+			double b2 = 0, bc = 0, bd = 0;
+			double c2 = 0, cd = 0;
+			double d2 = 0;
+
+			Quadric() {}
+			// 平面n·x + d = 0，权重w
+			Quadric(const Vec3d& n, double d, double w)
+			{
+				a2 = w * n[0] * n[0]; ab = w * n[0] * n[1]; ac = w * n[0] * n[2]; ad = w * n[0] * d;
+				b2 = w * n[1] * n[1]; bc = w * n[1] * n[2]; bd = w * n[1] * d;
+				c2 = w * n[2] * n[2]; cd = w * n[2] * d;
+				d2 = w * d * d;
+			}
+
+			Quadric& operator+=(const Quadric& q)
+			{
+				a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+				b2 += q.b2; bc += q.bc; bd += q.bd;
+				c2 += q.c2; cd += q.cd;
+				d2 += q.d2;
+				return *this;
+			}
+
+			double evaluate(const Vec3d& p) const
+			{
+				double x = p[0], y = p[1], z = p[2];
+				return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+					+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+					+ c2 * z * z + 2.0 * cd * z
+					+ d2;
+			}
+
+			// 误差最小的位置；A接近奇异（平面或直线上）时返回false
+			bool optimize(Vec3d& p) const
+			{
+				Eigen::Matrix3d A;
+				A << a2, ab, ac,
+					ab, b2, bc,
+					ac, bc, c2;
+				Eigen::FullPivLU<Eigen::Matrix3d> lu(A);
+				lu.setThreshold(1e-10);
+				if (!lu.isInvertible()) return false;
+				Eigen::Vector3d x = lu.solve(Eigen::Vector3d(-ad, -bd, -cd));
+				p = Vec3d(x[0], x[1], x[2]);
+				return true;
+			}
+		};
+
+		// 多边形的Newell法线，长度为面积
+		Vec3d face_normal(const Mesh& mesh, FH fh, Vec3d& point)
+		{
+			Vec3d n(0.0, 0.0, 0.0);
+			HH h0 = mesh.halfedge_handle(fh);
+			HH h = h0;
+			point = mesh.point(mesh.to_vertex_handle(h0));
+			do
+			{
+				n += mesh.point(mesh.from_vertex_handle(h)) % mesh.point(mesh.to_vertex_handle(h));
+				h = mesh.next_halfedge_handle(h);
+			} while (h != h0);
+			return n * 0.5;
+		}
+
+		// 纹理接缝：边两侧面在同一端点上的纹理坐标索引不同
+		bool is_seam(const Mesh& mesh, HH h, const OpenMesh::HPropHandleT<int>& uv)
+		{
+			HH o = mesh.opposite_halfedge_handle(h);
+			if (mesh.is_boundary(h) || mesh.is_boundary(o)) return false;
+			return mesh.property(uv, h) != mesh.property(uv, mesh.prev_halfedge_handle(o))
+				|| mesh.property(uv, mesh.prev_halfedge_handle(h)) != mesh.property(uv, o);
+		}
+
+		// 过边h、垂直于h所在面的约束平面
+		Quadric edge_constraint(const Mesh& mesh, HH h, double weight)
+		{
+			Vec3d p;
+			Vec3d n = face_normal(mesh, mesh.face_handle(h), p);
+			Vec3d p0 = mesh.point(mesh.from_vertex_handle(h));
+			Vec3d e = mesh.point(mesh.to_vertex_handle(h)) - p0;
+			Vec3d c = e % n;
+			double len = c.norm();
+			if (len <= 0.0) return Quadric();
+			c /= len;
+			return Quadric(c, -(c | p0), weight * e.sqrnorm());
+		}
+
+		// 顶点的初始误差：相邻面按面积加权的平面，加上边界/接缝边的约束平面
+		Quadric vertex_quadric(const Mesh& mesh, VH vh, const Options& options, const OpenMesh::HPropHandleT<int>* uv)
+		{
+			Quadric q;
+			for (auto vf = mesh.cvf_iter(vh); vf.is_valid(); ++vf)
+			{
+				Vec3d p;
+				Vec3d n = face_normal(mesh, *vf, p);
+				double area = n.norm();
+				if (area <= 0.0) continue;
+				n /= area;
+				q += Quadric(n, -(n | p), area);
+			}
+			for (auto voh = mesh.cvoh_iter(vh); voh.is_valid(); ++voh)
+			{
+				HH h = *voh;
+				HH o = mesh.opposite_halfedge_handle(h);
+				if (mesh.is_boundary(h) || mesh.is_boundary(o))
+				{
+					if (options.preserve_boundary)
+					{
+						q += edge_constraint(mesh, mesh.is_boundary(h) ? o : h, options.constraint_weight);
+					}
+				}
+				else if (uv && options.preserve_seams && is_seam(mesh, h, *uv))
+				{
+					q += edge_constraint(mesh, h, options.constraint_weight);
+					q += edge_constraint(mesh, o, options.constraint_weight);
+				}
+			}
+			return q;
+		}
+
+		struct Candidate
+		{
+			double cost;
+			int vertex;
+			unsigned int version;
+			bool operator>(const Candidate& other) const { return cost > other.cost; }
+		};
+
+		// 贪心半边收缩：每个顶点维护一条代价最小的出边，堆中过期的条目用版本号剔除。
+		// 块内和最终收尾两个阶段共用；locked为空表示没有锁定顶点
+		class Collapser
+		{
+		public:
+			Collapser(Mesh& mesh, std::vector<Quadric>& quadrics, const std::vector<unsigned char>& locked,
+				const Options& options, const OpenMesh::HPropHandleT<int>* uv)
+				: mesh(mesh), quadrics(quadrics), locked(locked), options(options), uv(uv)
+			{
+				version.assign(mesh.n_vertices(), 0);
+				target.assign(mesh.n_vertices(), -1);
+				target_pos.resize(mesh.n_vertices());
+			}
+
+			// 收缩到面数不超过target_faces或误差超过上限，seeds为空时从所有顶点开始，返回剩余面数
+			size_t run(size_t face_count, size_t target_faces, const std::vector<int>* seeds)
+			{
+				if (seeds)
+				{
+					for (int v : *seeds) update(VH(v));
+				}
+				else
+				{
+					for (auto vh : mesh.vertices()) update(vh);
+				}
+
+				while (face_count > target_faces && !heap.empty())
+				{
+					Candidate c = heap.top();
+					heap.pop();
+					if (c.version != version[c.vertex]) continue;
+					if (c.cost > options.max_error) break;
+
+					HH h(target[c.vertex]);
+					VH v1 = mesh.to_vertex_handle(h);
+					face_count -= collapse(h, target_pos[c.vertex]);
+					version[c.vertex]++;
+
+					update(v1);
+					for (auto vv = mesh.cvv_iter(v1); vv.is_valid(); ++vv)
+					{
+						update(*vv);
+					}
+				}
+				return face_count;
+			}
+
+		private:
+			bool is_locked(int v) const { return !locked.empty() && locked[v]; }
+
+			void update(VH v)
+			{
+				int i = v.idx();
+				version[i]++;
+				target[i] = -1;
+				if (mesh.status(v).deleted() || is_locked(i)) return;
+
+				double best = std::numeric_limits<double>::max();
+				for (auto voh = mesh.cvoh_iter(v); voh.is_valid(); ++voh)
+				{
+					Vec3d pos;
+					double cost = evaluate(*voh, pos);
+					if (cost >= best || !is_legal(*voh, pos)) continue;
+					best = cost;
+					target[i] = (*voh).idx();
+					target_pos[i] = pos;
+				}
+				if (target[i] >= 0)
+				{
+					heap.push(Candidate{ best, i, version[i] });
+				}
+			}
+
+			// 保留v1原位置，或（无纹理且v1未锁定时）移到误差最小处
+			double evaluate(HH h, Vec3d& pos) const
+			{
+				VH v0 = mesh.from_vertex_handle(h);
+				VH v1 = mesh.to_vertex_handle(h);
+				Quadric q = quadrics[v0.idx()];
+				q += quadrics[v1.idx()];
+				pos = mesh.point(v1);
+				double cost = q.evaluate(pos);
+
+				Vec3d opt;
+				if (options.optimal_placement && !uv && !is_locked(v1.idx()) && q.optimize(opt))
+				{
+					double c = q.evaluate(opt);
+					if (c < cost)
+					{
+						cost = c;
+						pos = opt;
+					}
+				}
+				return std::max(cost, 0.0);
+			}
+
+			bool is_legal(HH h, const Vec3d& pos)
+			{
+				VH v0 = mesh.from_vertex_handle(h);
+				VH v1 = mesh.to_vertex_handle(h);
+				HH o = mesh.opposite_halfedge_handle(h);
+				bool boundary_edge = mesh.is_boundary(h) || mesh.is_boundary(o);
+				if (options.preserve_boundary && mesh.is_boundary(v0) && !boundary_edge) return false;
+				if (!mesh.is_collapse_ok(h)) return false;
+
+				// 连接条件：两端点的公共邻点只能是被删三角形的对顶点
+				VH left = mesh.is_boundary(h) ? VH() : mesh.to_vertex_handle(mesh.next_halfedge_handle(h));
+				VH right = mesh.is_boundary(o) ? VH() : mesh.to_vertex_handle(mesh.next_halfedge_handle(o));
+				ring.clear();
+				for (auto vv = mesh.cvv_iter(v1); vv.is_valid(); ++vv)
+				{
+					ring.push_back(*vv);
+				}
+				for (auto vv = mesh.cvv_iter(v0); vv.is_valid(); ++vv)
+				{
+					VH w = *vv;
+					if (w == v1 || w == left || w == right) continue;
+					if (std::find(ring.begin(), ring.end(), w) != ring.end()) return false;
+					// 块边界：v0的另一个锁定邻点可能与锁定的v1在相邻块里已经相连
+					if (is_locked(v1.idx()) && is_locked(w.idx())) return false;
+				}
+
+				if (!check_fold(v0, v1, pos)) return false;
+				if (pos != mesh.point(v1) && !check_fold(v1, v0, pos)) return false;
+
+				int from[2], to[2];
+				if (uv && !uv_map(h, from, to)) return false;
+				return true;
+			}
+
+			// v移到pos后，v周围不含other的三角形不能翻转或退化
+			bool check_fold(VH v, VH other, const Vec3d& pos) const
+			{
+				for (auto vf = mesh.cvf_iter(v); vf.is_valid(); ++vf)
+				{
+					Vec3d p[3], q[3];
+					int k = 0;
+					bool skip = false;
+					for (auto fv = mesh.cfv_iter(*vf); fv.is_valid() && k < 3; ++fv, ++k)
+					{
+						if (*fv == other) skip = true;
+						p[k] = mesh.point(*fv);
+						q[k] = (*fv == v) ? pos : p[k];
+					}
+					if (skip || k < 3) continue;
+
+					Vec3d n0 = (p[1] - p[0]) % (p[2] - p[0]);
+					Vec3d n1 = (q[1] - q[0]) % (q[2] - q[0]);
+					double l0 = n0.norm(), l1 = n1.norm();
+					if (l0 <= 0.0) continue;
+					if (l1 <= 1e-12 * l0) return false;
+					if ((n0 | n1) < 0.2 * l0 * l1) return false;
+				}
+				return true;
+			}
+
+			// 收缩h后v0各角点的纹理坐标索引改为v1在同一侧的索引；
+			// v0有不在这两侧的索引（接缝交汇点或接缝不沿这条边）时不允许收缩
+			bool uv_map(HH h, int from[2], int to[2]) const
+			{
+				HH o = mesh.opposite_halfedge_handle(h);
+				int n = 0;
+				if (!mesh.is_boundary(h))
+				{
+					from[n] = mesh.property(*uv, mesh.prev_halfedge_handle(h));
+					to[n] = mesh.property(*uv, h);
+					n++;
+				}
+				if (!mesh.is_boundary(o))
+				{
+					from[n] = mesh.property(*uv, o);
+					to[n] = mesh.property(*uv, mesh.prev_halfedge_handle(o));
+					n++;
+				}
+				if (n == 1)
+				{
+					from[1] = from[0];
+					to[1] = to[0];
+				}
+				if (from[0] == from[1] && to[0] != to[1]) return false;
+
+				for (auto vih = mesh.cvih_iter(mesh.from_vertex_handle(h)); vih.is_valid(); ++vih)
+				{
+					if (mesh.is_boundary(*vih)) continue;
+					int u = mesh.property(*uv, *vih);
+					if (u != from[0] && u != from[1]) return false;
+				}
+				return true;
+			}
+
+			// 返回删掉的面数
+			int collapse(HH h, const Vec3d& pos)
+			{
+				VH v0 = mesh.from_vertex_handle(h);
+				VH v1 = mesh.to_vertex_handle(h);
+				HH o = mesh.opposite_halfedge_handle(h);
+				int removed = (mesh.is_boundary(h) ? 0 : 1) + (mesh.is_boundary(o) ? 0 : 1);
+
+				if (uv)
+				{
+					int from[2], to[2];
+					uv_map(h, from, to);
+					for (auto vih = mesh.vih_iter(v0); vih.is_valid(); ++vih)
+					{
+						if (mesh.is_boundary(*vih)) continue;
+						int& u = mesh.property(*uv, *vih);
+						u = (u == from[0]) ? to[0] : to[1];
+					}
+				}
+
+				mesh.collapse(h);
+				mesh.set_point(v1, pos);
+				quadrics[v1.idx()] += quadrics[v0.idx()];
+				return removed;
+			}
+
+			Mesh& mesh;
+			std::vector<Quadric>& quadrics;
+			const std::vector<unsigned char>& locked;
+			const Options& options;
+			const OpenMesh::HPropHandleT<int>* uv;
+
+			std::vector<unsigned int> version;
+			std::vector<int> target;
+			std::vector<Vec3d> target_pos;
+			std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > heap;
+			std::vector<VH> ring;
+		};
+
+		// 一个块简化后的结果，顶点以原网格中的编号标识，便于拼接
+		struct BlockResult
+		{
+			std::vector<int> global_ids;
+			std::vector<Vec3d> points;
+			std::vector<Quadric> quadrics;
+			std::vector<unsigned char> locked;
+			std::vector<int> triangles;          // 指向上面几个数组的下标
+			std::vector<int> triangle_uv;        // 每个角点的纹理坐标索引，无纹理时为空
+			std::vector<int> passthrough;        // 无法加入子网格的三角形（原网格顶点编号），原样保留
+			std::vector<int> passthrough_uv;
+			size_t input_triangles = 0;
+		};
+
+		void simplify_block(const Mesh& src, const OpenMesh::HPropHandleT<int>* src_uv,
+			const unsigned int* faces, size_t n_faces, const std::vector<unsigned char>& vertex_locked,
+			const Options& options, double ratio, BlockResult& result)
+		{
+			// 块内用到的原网格顶点，排序去重后的下标即子网格中的编号
+			std::vector<int> globals;
+			globals.reserve(3 * n_faces);
+			for (size_t i = 0; i < n_faces; i++)
+			{
+				for (auto fv = src.cfv_iter(FH(int(faces[i]))); fv.is_valid(); ++fv)
+				{
+					globals.push_back((*fv).idx());
+				}
+			}
+			std::sort(globals.begin(), globals.end());
+			globals.erase(std::unique(globals.begin(), globals.end()), globals.end());
+			auto local_of = [&globals](int g)
+			{
+				return int(std::lower_bound(globals.begin(), globals.end(), g) - globals.begin());
+			};
+
+			Mesh sub;
+			sub.reserve(globals.size(), 3 * n_faces, 2 * n_faces);
+			for (int g : globals)
+			{
+				sub.add_vertex(src.point(VH(g)));
+			}
+			OpenMesh::HPropHandleT<int> sub_uv;
+			if (src_uv)
+			{
+				sub.add_property(sub_uv);
+			}
+
+			std::vector<unsigned char> locked(globals.size());
+			for (size_t i = 0; i < globals.size(); i++)
+			{
+				locked[i] = vertex_locked[globals[i]];
+			}
+
+			std::vector<int> corner_vertex, corner_uv;
+			std::vector<VH> tri(3);
+			size_t tri_count = 0;
+			for (size_t i = 0; i < n_faces; i++)
+			{
+				corner_vertex.clear();
+				corner_uv.clear();
+				for (auto fh = src.cfh_iter(FH(int(faces[i]))); fh.is_valid(); ++fh)
+				{
+					corner_vertex.push_back(src.to_vertex_handle(*fh).idx());
+					corner_uv.push_back(src_uv ? src.property(*src_uv, *fh) : -1);
+				}
+				for (size_t j = 2; j < corner_vertex.size(); j++)
+				{
+					size_t c[3] = { 0, j - 1, j };
+					for (int k = 0; k < 3; k++)
+					{
+						tri[k] = VH(local_of(corner_vertex[c[k]]));
+					}
+					FH nf = sub.add_face(tri);
+					if (!nf.is_valid())
+					{
+						for (int k = 0; k < 3; k++)
+						{
+							result.passthrough.push_back(corner_vertex[c[k]]);
+							result.passthrough_uv.push_back(corner_uv[c[k]]);
+							locked[tri[k].idx()] = 1;
+						}
+						continue;
+					}
+					tri_count++;
+					if (src_uv)
+					{
+						for (auto fh = sub.fh_iter(nf); fh.is_valid(); ++fh)
+						{
+							int local = sub.to_vertex_handle(*fh).idx();
+							for (int k = 0; k < 3; k++)
+							{
+								if (tri[k].idx() == local) sub.property(sub_uv, *fh) = corner_uv[c[k]];
+							}
+						}
+					}
+				}
+			}
+			result.input_triangles = tri_count + result.passthrough.size() / 3;
+
+			// 误差从原网格计算，块边界上的顶点也包含相邻块的面
+			std::vector<Quadric> quadrics(globals.size());
+			for (size_t i = 0; i < globals.size(); i++)
+			{
+				quadrics[i] = vertex_quadric(src, VH(globals[i]), options, src_uv);
+			}
+
+			size_t target = size_t(std::ceil(tri_count * ratio));
+			Collapser collapser(sub, quadrics, locked, options, src_uv ? &sub_uv : nullptr);
+			collapser.run(tri_count, target, nullptr);
+
+			// 导出存活的顶点和三角形；锁定顶点即使孤立也保留（可能被原样保留的三角形引用）
+			std::vector<int> new_local(globals.size(), -1);
+			for (auto vh : sub.vertices())
+			{
+				int i = vh.idx();
+				if (sub.status(vh).deleted() || (sub.is_isolated(vh) && !locked[i])) continue;
+				new_local[i] = int(result.global_ids.size());
+				result.global_ids.push_back(globals[i]);
+				result.points.push_back(sub.point(vh));
+				result.quadrics.push_back(quadrics[i]);
+				result.locked.push_back(locked[i]);
+			}
+			for (auto fh : sub.faces())
+			{
+				if (sub.status(fh).deleted()) continue;
+				for (auto fh_it = sub.cfh_iter(fh); fh_it.is_valid(); ++fh_it)
+				{
+					result.triangles.push_back(new_local[sub.to_vertex_handle(*fh_it).idx()]);
+					if (src_uv) result.triangle_uv.push_back(sub.property(sub_uv, *fh_it));
+				}
+			}
+		}
+
+		// 沿包围盒最长的方向依次加切分，直到块数不少于n
+		void grid_dims(const Vec3d& extent, size_t n, int dims[3])
+		{
+			dims[0] = dims[1] = dims[2] = 1;
+			while (size_t(dims[0]) * dims[1] * dims[2] < n)
+			{
+				int axis = 0;
+				for (int i = 1; i < 3; i++)
+				{
+					if (extent[i] / dims[i] > extent[axis] / dims[axis]) axis = i;
+				}
+				dims[axis]++;
+			}
+		}
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+
+	bool decimate(Mesh& mesh, const Options& options, Stats* stats)
+	{
+		const Mesh& src = mesh;
+		size_t nv = mesh.n_vertices();
+		size_t nf = mesh.n_faces();
+		if (nf == 0) return false;
+
+		auto start = std::chrono::steady_clock::now();
+		OpenMesh::HPropHandleT<int> hvt_index;
+		bool has_uv = mesh.get_property_handle(hvt_index, "hvt_index");
+		const OpenMesh::HPropHandleT<int>* uv = has_uv ? &hvt_index : nullptr;
+
+		// 1. 按面中心把面分到空间网格的块里
+		Vec3d bmin = src.point(VH(0)), bmax = bmin;
+		for (auto vh : src.vertices())
+		{
+			bmin.minimize(src.point(vh));
+			bmax.maximize(src.point(vh));
+		}
+		size_t total_tris = 0;
+		for (auto fh : src.faces())
+		{
+			total_tris += src.valence(fh) - 2;
+		}
+		size_t wanted = std::max<size_t>((total_tris + options.max_block_faces - 1) / options.max_block_faces,
+			std::min<size_t>(parallel::thread_count(), total_tris / kMinBlockFaces));
+		int dims[3];
+		grid_dims(bmax - bmin, std::max<size_t>(wanted, 1), dims);
+		size_t n_cells = size_t(dims[0]) * dims[1] * dims[2];
+
+		std::vector<int> face_block(nf, -1);
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			FH fh(int(f));
+			if (src.status(fh).deleted()) return;
+			Vec3d c(0.0, 0.0, 0.0);
+			int k = 0;
+			for (auto fv = src.cfv_iter(fh); fv.is_valid(); ++fv, ++k)
+			{
+				c += src.point(*fv);
+			}
+			c /= k;
+			int cell[3];
+			for (int i = 0; i < 3; i++)
+			{
+				double extent = bmax[i] - bmin[i];
+				int x = extent > 0.0 ? int((c[i] - bmin[i]) / extent * dims[i]) : 0;
+				cell[i] = std::min(std::max(x, 0), dims[i] - 1);
+			}
+			face_block[f] = (cell[2] * dims[1] + cell[1]) * dims[0] + cell[0];
+		});
+
+		std::vector<unsigned int> cell_offsets(n_cells + 1, 0);
+		for (size_t f = 0; f < nf; f++)
+		{
+			if (face_block[f] >= 0) cell_offsets[face_block[f] + 1]++;
+		}
+		for (size_t c = 0; c < n_cells; c++)
+		{
+			cell_offsets[c + 1] += cell_offsets[c];
+		}
+		std::vector<unsigned int> cell_faces(cell_offsets[n_cells]);
+		{
+			std::vector<unsigned int> cursor(cell_offsets.begin(), cell_offsets.end() - 1);
+			for (size_t f = 0; f < nf; f++)
+			{
+				if (face_block[f] >= 0) cell_faces[cursor[face_block[f]]++] = unsigned(f);
+			}
+		}
+		std::vector<int> blocks;
+		for (size_t c = 0; c < n_cells; c++)
+		{
+			if (cell_offsets[c + 1] > cell_offsets[c]) blocks.push_back(int(c));
+		}
+
+		// 与其他块共享的顶点锁定
+		std::vector<unsigned char> vertex_locked(nv, 0);
+		parallel::for_each(0, nv, [&](size_t v)
+		{
+			int b = -1;
+			for (auto vf = src.cvf_iter(VH(int(v))); vf.is_valid(); ++vf)
+			{
+				int fb = face_block[(*vf).idx()];
+				if (b < 0)
+				{
+					b = fb;
+				}
+				else if (fb != b)
+				{
+					vertex_locked[v] = 1;
+					break;
+				}
+			}
+		});
+
+		// 2. 各块并行简化，每个线程依次处理自己的块
+		double ratio = std::min(1.0, double(options.target_faces) / double(total_tris));
+		std::vector<BlockResult> results(blocks.size());
+		parallel::for_each(0, blocks.size(), [&](size_t b)
+		{
+			int c = blocks[b];
+			simplify_block(src, uv, cell_faces.data() + cell_offsets[c], cell_offsets[c + 1] - cell_offsets[c],
+				vertex_locked, options, ratio, results[b]);
+		}, 1);
+		double block_ms = elapsed_ms(start);
+		auto border_start = std::chrono::steady_clock::now();
+
+		// 3. 拼接：块边界上的顶点在多个块里出现，只加入一次
+		std::vector<int>().swap(face_block);
+		std::vector<unsigned int>().swap(cell_faces);
+		mesh.clear();
+
+		std::vector<int> new_index(nv, -1);
+		std::vector<Quadric> quadrics;
+		std::vector<int> seeds;
+		for (const BlockResult& r : results)
+		{
+			for (size_t i = 0; i < r.global_ids.size(); i++)
+			{
+				int& index = new_index[r.global_ids[i]];
+				if (index >= 0) continue;
+				index = mesh.add_vertex(r.points[i]).idx();
+				quadrics.push_back(r.quadrics[i]);
+				if (r.locked[i]) seeds.push_back(index);
+			}
+		}
+
+		size_t face_count = 0, dropped = 0;
+		std::vector<VH> tri(3);
+		auto add_triangle = [&](const int* vertices, const int* corner_uv)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				tri[k] = VH(new_index[vertices[k]]);
+			}
+			FH fh = mesh.add_face(tri);
+			if (!fh.is_valid())
+			{
+				dropped++;
+				return;
+			}
+			face_count++;
+			if (!corner_uv) return;
+			for (auto fh_it = mesh.fh_iter(fh); fh_it.is_valid(); ++fh_it)
+			{
+				VH to = mesh.to_vertex_handle(*fh_it);
+				for (int k = 0; k < 3; k++)
+				{
+					if (tri[k] == to) mesh.property(hvt_index, *fh_it) = corner_uv[k];
+				}
+			}
+		};
+		for (BlockResult& r : results)
+		{
+			// 三角形下标先换成原网格编号，与原样保留的三角形统一处理
+			for (size_t t = 0; t < r.triangles.size(); t += 3)
+			{
+				int g[3] = { r.global_ids[r.triangles[t]], r.global_ids[r.triangles[t + 1]], r.global_ids[r.triangles[t + 2]] };
+				add_triangle(g, has_uv ? &r.triangle_uv[t] : nullptr);
+			}
+			for (size_t t = 0; t < r.passthrough.size(); t += 3)
+			{
+				add_triangle(&r.passthrough[t], has_uv ? &r.passthrough_uv[t] : nullptr);
+			}
+			r = BlockResult();
+		}
+		if (dropped > 0)
+		{
+			std::cout << "decimation: dropped " << dropped << " non-manifold triangles while stitching" << std::endl;
+		}
+
+		// 4. 从块边界顶点出发收尾，邻域更新会把收缩自然扩散到附近
+		if (blocks.size() > 1 && face_count > options.target_faces)
+		{
+			std::vector<unsigned char> no_locks;
+			Collapser collapser(mesh, quadrics, no_locks, options, uv);
+			collapser.run(face_count, options.target_faces, &seeds);
+		}
+		mesh.garbage_collection();
+
+		if (stats)
+		{
+			stats->input_faces = total_tris;
+			stats->output_faces = mesh.n_faces();
+			stats->blocks = int(blocks.size());
+			stats->block_ms = block_ms;
+			stats->border_ms = elapsed_ms(border_start);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "my_traits.h"
+#include <limits>
+
+// 二次误差度量（QEM）网格简化。
+// 先按包围盒把网格切成空间块，跨块的顶点锁定，各块拷贝成独立的子网格并行简化；
+// 再把各块结果拼回一个网格，从原先锁定的块边界顶点出发做一次串行收尾。
+// 每个线程同一时刻只持有一个块的子网格，峰值内存约为输入网格加上线程数个块。
+namespace decimation
+{
+	struct Options
+	{
+		size_t target_faces = 0;                                 // 目标三角形数
+		double max_error = std::numeric_limits<double>::max();   // 单次收缩的二次误差上限
+		bool preserve_boundary = true;    // 边界加约束平面，边界顶点只能沿边界收缩
+		bool preserve_seams = true;       // 对hvt_index给出的纹理接缝加约束平面
+		bool optimal_placement = true;    // 保留顶点移到误差最小处；有纹理坐标时总是保留原位置
+		double constraint_weight = 1000.0;
+		size_t max_block_faces = 1 << 20; // 每块面数上限，决定分块数和峰值内存
+	};
+
+	struct Stats
+	{
+		size_t input_faces = 0;
+		size_t output_faces = 0;
+		int blocks = 0;
+		double block_ms = 0.0;    // 分块并行阶段
+		double border_ms = 0.0;   // 拼接与边界收尾
+	};
+
+	// 简化mesh，多边形面先扇形三角化。带hvt_index属性时收缩后纹理坐标索引仍然有效，
+	// 接缝交汇处的顶点不会被删除
+	bool decimate(Mesh& mesh, const Options& options, Stats* stats = nullptr);
+}
@@ -0,0 +1,218 @@
+#include "geodesics.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace geodesics
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef OpenMesh::Vec3d Vec3d;
+
+		const double kMaxCotangent = 1e5;
+		// 泊松矩阵只有半定，加上shift·M/h²消去常数零空间，对距离的影响可以忽略
+		const double kPoissonShift = 1e-8;
+		// 热核在约这么多个平均边长外仍可用双精度表示
+		const double kHeatRange = 500.0;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// A = a·L + diag(b)，与L同结构。孤立顶点的对角为0，置1使矩阵仍然正定
+		void combine(const laplacian::SparseMatrix& L, double a, const Eigen::VectorXd& b, laplacian::SparseMatrix& A)
+		{
+			A = L;
+			A *= a;
+			parallel::for_each(0, size_t(A.outerSize()), [&](size_t j)
+			{
+				for (laplacian::SparseMatrix::InnerIterator it(A, Eigen::Index(j)); it; ++it)
+				{
+					if (it.row() != it.col()) continue;
+					it.valueRef() += b[Eigen::Index(j)];
+					if (it.value() == 0.0) it.valueRef() = 1.0;
+				}
+			});
+		}
+	}
+
+	void HeatSolver::set_time_scale(double scale)
+	{
+		if (scale == time_scale) return;
+		time_scale = scale;
+		factorized = false;
+	}
+
+	void HeatSolver::topology_changed()
+	{
+		has_pattern = false;
+		analyzed = false;
+		factorized = false;
+	}
+
+	void HeatSolver::geometry_changed()
+	{
+		factorized = false;
+	}
+
+	bool HeatSolver::prepare(const Mesh& mesh, Stats* stats)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (!has_pattern)
+		{
+			if (!laplacian::build_pattern(mesh, L)) return false;
+			has_pattern = true;
+		}
+		laplacian::fill_values(mesh, L, mass);
+
+		face_data.resize(mesh.n_faces());
+		corner_div.resize(3 * mesh.n_faces());
+		std::vector<double> edge_sum(parallel::thread_count(), 0.0);
+		parallel::for_each_range(0, mesh.n_faces(), [&](size_t b, size_t e, unsigned int tid)
+		{
+			for (size_t f = b; f < e; f++)
+			{
+				FaceData& data = face_data[f];
+				Vec3d p[3];
+				int k = 0;
+				for (auto fv_it = mesh.cfv_iter(Mesh::FaceHandle(int(f))); fv_it.is_valid(); ++fv_it)
+				{
+					data.v[k] = (*fv_it).idx();
+					p[k] = mesh.point(*fv_it);
+					k++;
+				}
+				for (int c = 0; c < 3; c++)
+				{
+					data.e[c] = p[(c + 2) % 3] - p[(c + 1) % 3];
+					edge_sum[tid] += data.e[c].norm();
+				}
+				Vec3d normal = (p[1] - p[0]) % (p[2] - p[0]);
+				double area2 = normal.sqrnorm();
+				data.n = area2 > 0.0 ? normal / area2 : Vec3d(0.0, 0.0, 0.0);
+				for (int c = 0; c < 3; c++)
+				{
+					const Vec3d& a = data.e[(c + 2) % 3];    // c -> c+1
+					Vec3d b = -data.e[(c + 1) % 3];          // c -> c+2
+					double cot = (a | b) / std::max((a % b).norm(), 1e-300);
+					data.cot[c] = std::max(-kMaxCotangent, std::min(kMaxCotangent, cot));
+				}
+			}
+		});
+
+		double h = 0.0;
+		for (double s : edge_sum)
+		{
+			h += s;
+		}
+		h /= std::max<size_t>(1, 3 * mesh.n_faces());
+
+		// 离散热核每隔一个边长衰减约e^(-1/sqrt(scale))，按包围盒对角线上的边长数限制scale的下限
+		Vec3d lo = mesh.point(*mesh.vertices_begin()), hi = lo;
+		for (auto vh : mesh.vertices())
+		{
+			lo.minimize(mesh.point(vh));
+			hi.maximize(mesh.point(vh));
+		}
+		double rings = (hi - lo).norm() / std::max(h, 1e-300);
+		double scale = std::max(time_scale, (rings / kHeatRange) * (rings / kHeatRange));
+		time_step = scale * h * h;
+
+		laplacian::SparseMatrix heat, poisson;
+		combine(L, -time_step, mass, heat);
+		combine(L, -1.0, (kPoissonShift / std::max(h * h, 1e-300)) * mass, poisson);
+		if (stats) stats->setup_ms += elapsed_ms(start);
+
+		start = std::chrono::steady_clock::now();
+		if (!analyzed)
+		{
+			heat_solver.analyzePattern(heat);
+			poisson_solver.analyzePattern(poisson);
+			analyzed = true;
+		}
+		heat_solver.factorize(heat);
+		poisson_solver.factorize(poisson);
+		if (stats) stats->factorize_ms += elapsed_ms(start);
+		return heat_solver.info() == Eigen::Success && poisson_solver.info() == Eigen::Success;
+	}
+
+	bool HeatSolver::compute(const Mesh& mesh, const std::vector<unsigned int>& sources, std::vector<double>& distance,
+		Stats* stats)
+	{
+		if (stats) *stats = Stats();
+		if (sources.empty() || mesh.n_vertices() == 0) return false;
+		if (stats) stats->reused_factorization = factorized;
+		if (!factorized)
+		{
+			if (!prepare(mesh, stats)) return false;
+			factorized = true;
+		}
+		if (stats) stats->time_step = time_step;
+
+		size_t n = mesh.n_vertices();
+		auto start = std::chrono::steady_clock::now();
+		Eigen::VectorXd delta = Eigen::VectorXd::Zero(Eigen::Index(n));
+		for (unsigned int s : sources)
+		{
+			if (s < n) delta[s] = 1.0;
+		}
+		Eigen::VectorXd u = heat_solver.solve(delta);
+		if (stats) stats->heat_ms = elapsed_ms(start);
+
+		// 每个面上 X = -∇u/|∇u|，角c处的散度贡献为 (cot θ_{c+2} <c->c+1, X> + cot θ_{c+1} <c->c+2, X>) / 2
+		start = std::chrono::steady_clock::now();
+		parallel::for_each(0, face_data.size(), [&](size_t f)
+		{
+			const FaceData& data = face_data[f];
+			Vec3d grad(0.0, 0.0, 0.0);
+			for (int c = 0; c < 3; c++)
+			{
+				grad += u[data.v[c]] * (data.n % data.e[c]);
+			}
+			double norm = grad.norm();
+			Vec3d X = norm > 0.0 ? -grad / norm : Vec3d(0.0, 0.0, 0.0);
+			for (int c = 0; c < 3; c++)
+			{
+				int c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+				corner_div[3 * f + c] = 0.5 * (data.cot[c2] * (data.e[c2] | X) - data.cot[c1] * (data.e[c1] | X));
+			}
+		});
+
+		// 按顶点汇总，右端为 -∇·X（矩阵为 -L）
+		Eigen::VectorXd rhs(Eigen::Index(n));
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			double sum = 0.0;
+			for (auto vf_it = mesh.cvf_iter(VH(int(v))); vf_it.is_valid(); ++vf_it)
+			{
+				int f = (*vf_it).idx();
+				const int* corners = face_data[f].v;
+				int c = corners[0] == int(v) ? 0 : (corners[1] == int(v) ? 1 : 2);
+				sum += corner_div[3 * size_t(f) + c];
+			}
+			rhs[Eigen::Index(v)] = -sum;
+		});
+		if (stats) stats->gradient_ms = elapsed_ms(start);
+
+		start = std::chrono::steady_clock::now();
+		Eigen::VectorXd phi = poisson_solver.solve(rhs);
+		if (stats) stats->poisson_ms = elapsed_ms(start);
+
+		// φ只确定到一个常数，平移使源点处为0
+		double origin = std::numeric_limits<double>::max();
+		for (unsigned int s : sources)
+		{
+			if (s < n) origin = std::min(origin, phi[s]);
+		}
+		distance.resize(n);
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			distance[v] = u[Eigen::Index(v)] > 0.0 ? std::max(0.0, phi[Eigen::Index(v)] - origin)
+				: std::numeric_limits<double>::infinity();
+		});
+		return true;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "my_traits.h"
+#include "laplacian.h"
+#include <Eigen/Sparse>
+#include <vector>
+
+// 热方法测地距离（Crane 2013）：
+// 热扩散 (M - tL) u = δ，单位化梯度场 X = -∇u/|∇u|，再解泊松方程 L φ = ∇·X。
+// 两个矩阵只依赖网格，分解一次后每组源点只需两次回代和一遍逐面并行的梯度/散度计算
+namespace geodesics
+{
+	struct Stats
+	{
+		double setup_ms = 0.0;       // 逐面几何量和两个矩阵
+		double factorize_ms = 0.0;
+		double heat_ms = 0.0;        // 热扩散回代
+		double gradient_ms = 0.0;    // 梯度单位化和散度
+		double poisson_ms = 0.0;     // 泊松回代
+		double time_step = 0.0;
+		bool reused_factorization = false;
+	};
+
+	class HeatSolver
+	{
+	public:
+		// t = scale·h²，h为平均边长。网格很密时t会自动加大，使热核在整个包围盒对角线上不下溢
+		void set_time_scale(double scale);
+		void topology_changed();
+		void geometry_changed();
+
+		// distance为每个顶点到最近源点的测地距离；与源点不连通的顶点为无穷大。仅适用于三角形网格
+		bool compute(const Mesh& mesh, const std::vector<unsigned int>& sources, std::vector<double>& distance,
+			Stats* stats = nullptr);
+
+	private:
+		// e[k]为角k的对边（沿面的朝向），n为单位法向除以两倍面积，∇u = Σ u_k n × e[k]
+		struct FaceData
+		{
+			int v[3];
+			OpenMesh::Vec3d e[3];
+			OpenMesh::Vec3d n;
+			double cot[3];
+		};
+
+		bool prepare(const Mesh& mesh, Stats* stats);
+
+		double time_scale = 1.0;
+		bool has_pattern = false;
+		bool factorized = false;
+		bool analyzed = false;
+		double time_step = 0.0;
+
+		laplacian::SparseMatrix L;
+		Eigen::VectorXd mass;
+		std::vector<FaceData> face_data;
+		std::vector<double> corner_div;
+
+		Eigen::SimplicialLDLT<laplacian::SparseMatrix> heat_solver;
+		Eigen::SimplicialLDLT<laplacian::SparseMatrix> poisson_solver;
+	};
+}
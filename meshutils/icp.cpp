@@ -0,0 +1,317 @@
+#include "icp.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace icp
+{
+	namespace
+	{
+		typedef OpenMesh::Vec3d Vec3d;
+		typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+		typedef Eigen::Matrix<double, 6, 1> Vector6d;
+
+		// 每线程的累加量：法方程上三角21项、右端6项、残差平方和、有效对数
+		const int kUpperCount = 21;
+		const int kAccumStride = kUpperCount + 6 + 2;
+		const size_t kGrain = 1024;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		inline Eigen::Vector3d to_eigen(const Vec3d& v)
+		{
+			return Eigen::Vector3d(v[0], v[1], v[2]);
+		}
+
+		struct Correspondence
+		{
+			int target;     // 目标顶点，-1为无效
+			double dist2;
+		};
+
+		struct System
+		{
+			Matrix6d A;
+			Vector6d b;
+			double error2;   // 点到面残差平方和
+			int count;
+		};
+
+		struct Problem
+		{
+			const std::vector<Vec3d>& points;
+			const std::vector<Vec3d>& normals;
+			const std::vector<unsigned int>& samples;
+			const Target& target;
+			const Options& options;
+		};
+
+		// 前count个采样点在变换(R, t)下的最近目标顶点，按距离上限、法向和距离中位数剔除
+		void find_correspondences(const Problem& problem, size_t count, const Eigen::Matrix3d& R, const Eigen::Vector3d& t,
+			std::vector<Correspondence>& corr)
+		{
+			const Target& target = problem.target;
+			const Options& options = problem.options;
+			double max_dist = options.max_distance > 0.0 ? options.max_distance * target.extent
+				: std::numeric_limits<double>::infinity();
+			corr.resize(count);
+			parallel::for_each(0, count, [&](size_t i)
+			{
+				unsigned int v = problem.samples[i];
+				Eigen::Vector3d p = R * to_eigen(problem.points[v]) + t;
+				double d2 = 0.0;
+				int q = target.grid.nearest(Vec3d(p[0], p[1], p[2]), &d2, max_dist);
+				if (q >= 0)
+				{
+					const Vec3d& nt = target.normals[q];
+					Eigen::Vector3d ns = R * to_eigen(problem.normals[v]);
+					if (nt.sqrnorm() == 0.0 || ns.dot(to_eigen(nt)) < options.normal_threshold) q = -1;
+				}
+				corr[i].target = q;
+				corr[i].dist2 = d2;
+			}, kGrain);
+
+			if (options.reject_factor <= 0.0) return;
+			std::vector<double> dist2;
+			dist2.reserve(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				if (corr[i].target >= 0) dist2.push_back(corr[i].dist2);
+			}
+			if (dist2.empty()) return;
+			std::nth_element(dist2.begin(), dist2.begin() + dist2.size() / 2, dist2.end());
+			// 已对齐时中位数可能为0，留一点余量避免把微小误差全部剔除
+			double slack = options.tolerance * target.extent;
+			double limit = std::max(dist2[dist2.size() / 2] * options.reject_factor * options.reject_factor, slack * slack);
+			for (size_t i = 0; i < count; i++)
+			{
+				if (corr[i].dist2 > limit) corr[i].target = -1;
+			}
+		}
+
+		// 残差r = (p - q)·n，对小旋转ω和平移τ线性化：r' = r + ω·(p×n) + τ·n
+		System assemble(const Problem& problem, const std::vector<Correspondence>& corr,
+			const Eigen::Matrix3d& R, const Eigen::Vector3d& t)
+		{
+			unsigned int threads = parallel::thread_count();
+			std::vector<double> acc(size_t(threads) * kAccumStride, 0.0);
+			parallel::for_each_range(0, corr.size(), [&](size_t b, size_t e, unsigned int tid)
+			{
+				double* a = &acc[size_t(tid) * kAccumStride];
+				for (size_t i = b; i < e; i++)
+				{
+					if (corr[i].target < 0) continue;
+					Eigen::Vector3d p = R * to_eigen(problem.points[problem.samples[i]]) + t;
+					Eigen::Vector3d q = to_eigen(problem.target.points[corr[i].target]);
+					Eigen::Vector3d n = to_eigen(problem.target.normals[corr[i].target]);
+					Eigen::Vector3d c = p.cross(n);
+					double r = (p - q).dot(n);
+					double J[6] = { c[0], c[1], c[2], n[0], n[1], n[2] };
+					int k = 0;
+					for (int row = 0; row < 6; row++)
+					{
+						for (int col = row; col < 6; col++)
+						{
+							a[k++] += J[row] * J[col];
+						}
+					}
+					for (int row = 0; row < 6; row++)
+					{
+						a[kUpperCount + row] -= J[row] * r;
+					}
+					a[kUpperCount + 6] += r * r;
+					a[kUpperCount + 7] += 1.0;
+				}
+			}, kGrain);
+
+			System sys;
+			sys.A.setZero();
+			sys.b.setZero();
+			sys.error2 = 0.0;
+			double count = 0.0;
+			for (unsigned int tid = 0; tid < threads; tid++)
+			{
+				const double* a = &acc[size_t(tid) * kAccumStride];
+				int k = 0;
+				for (int row = 0; row < 6; row++)
+				{
+					for (int col = row; col < 6; col++)
+					{
+						sys.A(row, col) += a[k++];
+					}
+					sys.b[row] += a[kUpperCount + row];
+				}
+				sys.error2 += a[kUpperCount + 6];
+				count += a[kUpperCount + 7];
+			}
+			for (int row = 1; row < 6; row++)
+			{
+				for (int col = 0; col < row; col++)
+				{
+					sys.A(row, col) = sys.A(col, row);
+				}
+			}
+			sys.count = int(count);
+			return sys;
+		}
+	}
+
+	void vertex_normals(const Mesh& mesh, std::vector<Vec3d>& points, std::vector<Vec3d>& normals)
+	{
+		size_t n = mesh.n_vertices();
+		points.resize(n);
+		normals.assign(n, Vec3d(0.0, 0.0, 0.0));
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			points[v] = mesh.point(Mesh::VertexHandle(int(v)));
+		});
+
+		// 面法向取扇形三角形叉积之和（长度为面积的2倍），累加到面的每个顶点
+		std::vector<int> poly;
+		for (auto fh : mesh.faces())
+		{
+			poly.clear();
+			for (auto fv_it = mesh.cfv_iter(fh); fv_it.is_valid(); ++fv_it)
+			{
+				poly.push_back(fv_it->idx());
+			}
+			Vec3d face_normal(0.0, 0.0, 0.0);
+			for (size_t k = 1; k + 1 < poly.size(); k++)
+			{
+				face_normal += (points[poly[k]] - points[poly[0]]) % (points[poly[k + 1]] - points[poly[0]]);
+			}
+			for (int v : poly)
+			{
+				normals[v] += face_normal;
+			}
+		}
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			double len = normals[v].norm();
+			if (len > 0.0) normals[v] /= len;
+		});
+	}
+
+	void Target::build(const Mesh& mesh)
+	{
+		std::vector<Vec3d> target_points, target_normals;
+		vertex_normals(mesh, target_points, target_normals);
+		build(target_points, target_normals);
+	}
+
+	void Target::build(const std::vector<Vec3d>& target_points, const std::vector<Vec3d>& target_normals)
+	{
+		points = target_points;
+		normals = target_normals;
+		grid.build(points);
+		extent = 1.0;
+		if (points.empty()) return;
+		Vec3d lo = points[0], hi = points[0];
+		for (const Vec3d& p : points)
+		{
+			lo.minimize(p);
+			hi.maximize(p);
+		}
+		double diagonal = (hi - lo).norm();
+		if (diagonal > 0.0) extent = diagonal;
+	}
+
+	void Target::clear()
+	{
+		points.clear();
+		normals.clear();
+		grid.clear();
+		extent = 1.0;
+	}
+
+	bool align(const Mesh& source, const Target& target, const Eigen::Matrix4d& initial,
+		const Options& options, Result& result)
+	{
+		std::vector<Vec3d> points, normals;
+		vertex_normals(source, points, normals);
+		return align(points, normals, target, initial, options, result);
+	}
+
+	bool align(const std::vector<Vec3d>& source_points, const std::vector<Vec3d>& source_normals,
+		const Target& target, const Eigen::Matrix4d& initial, const Options& options, Result& result)
+	{
+		auto start = std::chrono::steady_clock::now();
+		result = Result();
+		result.transform = initial;
+		size_t n = source_points.size();
+		if (target.empty() || n == 0 || source_normals.size() != n) return false;
+
+		// 固定种子打乱顶点顺序，各级取前若干个，采样集逐级嵌套
+		std::vector<unsigned int> samples(n);
+		std::iota(samples.begin(), samples.end(), 0u);
+		std::mt19937 rng(options.seed);
+		std::shuffle(samples.begin(), samples.end(), rng);
+
+		std::vector<int> schedule = options.sample_schedule;
+		if (schedule.empty()) schedule.push_back(0);
+
+		Problem problem = { source_points, source_normals, samples, target, options };
+		Eigen::Matrix3d R = initial.block<3, 3>(0, 0);
+		Eigen::Vector3d t = initial.block<3, 1>(0, 3);
+		std::vector<Correspondence> corr;
+		bool solved = false;
+		size_t count = n;
+
+		for (size_t stage = 0; stage < schedule.size(); stage++)
+		{
+			count = schedule[stage] <= 0 ? n : std::min(n, size_t(schedule[stage]));
+			result.converged = false;
+			for (int it = 0; it < options.max_iterations; it++)
+			{
+				find_correspondences(problem, count, R, t, corr);
+				System sys = assemble(problem, corr, R, t);
+				if (sys.count < 6) break;
+				if (!solved) result.initial_rms = std::sqrt(sys.error2 / sys.count);
+
+				// 沿表面滑动等不受约束的方向右端为零，加一点阻尼让这些分量解为零而不是任意值
+				sys.A.diagonal().array() += 1e-9 * sys.A.trace();
+				Vector6d x = sys.A.ldlt().solve(sys.b);
+				if (!x.allFinite()) break;
+				solved = true;
+
+				Eigen::Vector3d omega = x.head<3>(), tau = x.tail<3>();
+				double angle = omega.norm();
+				Eigen::Matrix3d dR = angle > 0.0 ? Eigen::AngleAxisd(angle, omega / angle).toRotationMatrix()
+					: Eigen::Matrix3d::Identity();
+				R = dR * R;
+				t = dR * t + tau;
+				result.iterations++;
+				if (angle < options.tolerance && tau.norm() < options.tolerance * target.extent)
+				{
+					result.converged = true;
+					break;
+				}
+			}
+		}
+		if (!solved)
+		{
+			result.ms = elapsed_ms(start);
+			return false;
+		}
+
+		// 多次增量旋转相乘后重新正交化
+		R = Eigen::Quaterniond(R).normalized().toRotationMatrix();
+		result.transform.setIdentity();
+		result.transform.block<3, 3>(0, 0) = R;
+		result.transform.block<3, 1>(0, 3) = t;
+
+		find_correspondences(problem, count, R, t, corr);
+		System sys = assemble(problem, corr, R, t);
+		result.correspondences = sys.count;
+		result.rms = sys.count > 0 ? std::sqrt(sys.error2 / sys.count) : 0.0;
+		result.ms = elapsed_ms(start);
+		return true;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "my_traits.h"
+#include "point_grid.h"
+#include <Eigen/Dense>
+#include <vector>
+
+// 点到面ICP刚性配准：源网格的顶点采样经当前变换后在目标顶点的PointGrid上并行找最近点，
+// 按目标顶点法向线性化残差，各线程累加6×6法方程后合并求解（小角度旋转+平移）。
+// 采样数按schedule逐级增加（嵌套子集，前几级用少量点快速收敛，最后一级精修），每级内步长足够小即提前结束
+namespace icp
+{
+	// 面积加权的顶点法向（多边形面按扇形三角化）；孤立顶点法向为零
+	void vertex_normals(const Mesh& mesh, std::vector<OpenMesh::Vec3d>& points, std::vector<OpenMesh::Vec3d>& normals);
+
+	// 配准目标：顶点、法向和近邻索引，目标不变时可在多次配准间复用
+	struct Target
+	{
+		std::vector<OpenMesh::Vec3d> points;
+		std::vector<OpenMesh::Vec3d> normals;
+		PointGrid grid;
+		double extent = 1.0;   // 包围盒对角线长度，用于把平移收敛阈值换成相对量
+
+		void build(const Mesh& mesh);
+		void build(const std::vector<OpenMesh::Vec3d>& target_points, const std::vector<OpenMesh::Vec3d>& target_normals);
+		void clear();
+		bool empty() const { return points.empty(); }
+	};
+
+	struct Options
+	{
+		std::vector<int> sample_schedule = { 2000, 10000, 0 };   // 每级的采样点数，0或超过顶点数时用全部顶点
+		int max_iterations = 30;        // 每级最多迭代次数
+		double max_distance = 0.0;      // 对应点距离上限（目标extent的比例），0为不限
+		double reject_factor = 3.0;     // 距离超过中位数的这一倍数的对应点剔除，0为不剔除
+		double normal_threshold = 0.0;  // 源、目标法向点积低于此值的对应点剔除（背对的薄壁等）
+		double tolerance = 1e-6;        // 旋转角（弧度）和相对平移都小于此值时该级收敛
+		unsigned int seed = 1;          // 采样顺序的随机种子，相同种子结果可复现
+	};
+
+	struct Result
+	{
+		Eigen::Matrix4d transform = Eigen::Matrix4d::Identity();   // 作用在源网格上的刚体变换
+		double initial_rms = 0.0;       // 初始变换下的点到面均方根距离
+		double rms = 0.0;               // 结果变换下的点到面均方根距离（最后一级的采样点）
+		int correspondences = 0;        // 结果变换下的有效对应点数
+		int iterations = 0;             // 所有级的迭代次数之和
+		bool converged = false;         // 最后一级在max_iterations内收敛
+		double ms = 0.0;
+	};
+
+	// initial为源网格的初始变换；有效对应点少于6个（无法确定6个自由度）时返回false，result.transform保持initial
+	bool align(const Mesh& source, const Target& target, const Eigen::Matrix4d& initial,
+		const Options& options, Result& result);
+	bool align(const std::vector<OpenMesh::Vec3d>& source_points, const std::vector<OpenMesh::Vec3d>& source_normals,
+		const Target& target, const Eigen::Matrix4d& initial, const Options& options, Result& result);
+}
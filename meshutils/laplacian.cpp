@@ -0,0 +1,406 @@
+#include "laplacian.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace laplacian
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef Mesh::HalfedgeHandle HH;
+		typedef OpenMesh::Vec3d Vec3d;
+		typedef SparseMatrix::StorageIndex StorageIndex;
+
+		// 退化三角形上余切趋于无穷，截断到一个足够大的值
+		const double kMaxCotangent = 1e5;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// h所在三角形中h的对角的余切，边界半边为0
+		double cotangent(const Mesh& mesh, HH h)
+		{
+			if (mesh.is_boundary(h)) return 0.0;
+			const Vec3d& a = mesh.point(mesh.from_vertex_handle(h));
+			const Vec3d& b = mesh.point(mesh.to_vertex_handle(h));
+			const Vec3d& c = mesh.point(mesh.to_vertex_handle(mesh.next_halfedge_handle(h)));
+			Vec3d u = a - c, v = b - c;
+			double s = (u % v).norm();
+			double cot = (u | v) / std::max(s, 1e-300);
+			return std::max(-kMaxCotangent, std::min(kMaxCotangent, cot));
+		}
+
+		// 按已知的每列非零数分配压缩存储
+		void allocate(SparseMatrix& A, size_t n, std::vector<StorageIndex>& outer)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				outer[i + 1] += outer[i];
+			}
+			A.resize(Eigen::Index(n), Eigen::Index(n));
+			A.resizeNonZeros(outer[n]);
+			std::copy(outer.begin(), outer.end(), A.outerIndexPtr());
+		}
+
+		// A的行列都限制到自由变量上（A对称，列j即行j）
+		void restrict_to_free(const SparseMatrix& A, const std::vector<int>& local_index,
+			const std::vector<int>& free_vertices, SparseMatrix& A_ff)
+		{
+			size_t n = free_vertices.size();
+			std::vector<StorageIndex> outer(n + 1, 0);
+			parallel::for_each(0, n, [&](size_t r)
+			{
+				StorageIndex count = 0;
+				for (SparseMatrix::InnerIterator it(A, free_vertices[r]); it; ++it)
+				{
+					if (local_index[it.row()] >= 0) count++;
+				}
+				outer[r + 1] = count;
+			});
+			allocate(A_ff, n, outer);
+			parallel::for_each(0, n, [&](size_t r)
+			{
+				StorageIndex k = outer[r];
+				for (SparseMatrix::InnerIterator it(A, free_vertices[r]); it; ++it)
+				{
+					int l = local_index[it.row()];
+					if (l < 0) continue;
+					A_ff.innerIndexPtr()[k] = l;
+					A_ff.valuePtr()[k] = it.value();
+					k++;
+				}
+			});
+		}
+
+		// rhs += scale * A_fc * X_c，X为所有顶点的坐标
+		void add_fixed_part(const SparseMatrix& A, const std::vector<int>& local_index,
+			const std::vector<int>& free_vertices, const Eigen::MatrixXd& X, double scale, Eigen::MatrixXd& rhs)
+		{
+			parallel::for_each(0, free_vertices.size(), [&](size_t r)
+			{
+				for (SparseMatrix::InnerIterator it(A, free_vertices[r]); it; ++it)
+				{
+					if (local_index[it.row()] < 0) rhs.row(r) += (scale * it.value()) * X.row(it.row());
+				}
+			});
+		}
+
+		void read_points(const Mesh& mesh, Eigen::MatrixXd& X)
+		{
+			X.resize(mesh.n_vertices(), 3);
+			parallel::for_each(0, mesh.n_vertices(), [&](size_t v)
+			{
+				const Vec3d& p = mesh.point(VH(int(v)));
+				X.row(v) << p[0], p[1], p[2];
+			});
+		}
+	}
+
+	bool build_pattern(const Mesh& mesh, SparseMatrix& L)
+	{
+		for (auto fh : mesh.faces())
+		{
+			if (mesh.valence(fh) != 3) return false;
+		}
+
+		size_t n = mesh.n_vertices();
+		std::vector<StorageIndex> outer(n + 1, 0);
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			outer[v + 1] = StorageIndex(mesh.valence(VH(int(v))) + 1);
+		});
+		allocate(L, n, outer);
+
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			StorageIndex* inner = L.innerIndexPtr() + outer[v];
+			int k = 0;
+			inner[k++] = StorageIndex(v);
+			for (auto vv = mesh.cvv_iter(VH(int(v))); vv.is_valid(); ++vv)
+			{
+				inner[k++] = (*vv).idx();
+			}
+			std::sort(inner, inner + k);
+			std::fill(L.valuePtr() + outer[v], L.valuePtr() + outer[v + 1], 0.0);
+		});
+		return true;
+	}
+
+	void fill_values(const Mesh& mesh, SparseMatrix& L, Eigen::VectorXd& mass)
+	{
+		size_t n = mesh.n_vertices();
+		mass.resize(Eigen::Index(n));
+		const StorageIndex* outer = L.outerIndexPtr();
+		const StorageIndex* inner = L.innerIndexPtr();
+		double* values = L.valuePtr();
+
+		// 每列只由负责该顶点的线程写，两端各自计算同一条边的权重，结果逐位相同，矩阵严格对称
+		parallel::for_each(0, n, [&](size_t v)
+		{
+			const StorageIndex* begin = inner + outer[v];
+			const StorageIndex* end = inner + outer[v + 1];
+			double* column = values + outer[v];
+			std::fill(column, column + (end - begin), 0.0);
+
+			double diagonal = 0.0, area = 0.0;
+			for (auto voh = mesh.cvoh_iter(VH(int(v))); voh.is_valid(); ++voh)
+			{
+				HH h = *voh;
+				double w = 0.5 * (cotangent(mesh, h) + cotangent(mesh, mesh.opposite_halfedge_handle(h)));
+				StorageIndex j = mesh.to_vertex_handle(h).idx();
+				column[std::lower_bound(begin, end, j) - begin] += w;
+				diagonal += w;
+				if (!mesh.is_boundary(h))
+				{
+					const Vec3d& a = mesh.point(mesh.from_vertex_handle(h));
+					const Vec3d& b = mesh.point(mesh.to_vertex_handle(h));
+					const Vec3d& c = mesh.point(mesh.to_vertex_handle(mesh.next_halfedge_handle(h)));
+					area += 0.5 * ((b - a) % (c - a)).norm();
+				}
+			}
+			column[std::lower_bound(begin, end, StorageIndex(v)) - begin] = -diagonal;
+			mass[v] = area / 3.0;
+		});
+	}
+
+	void OperatorCache::set_solver(SolverType type)
+	{
+		if (type == solver_type) return;
+		solver_type = type;
+		analyzed = false;
+		factorized = false;
+	}
+
+	void OperatorCache::topology_changed()
+	{
+		has_pattern = false;
+		has_values = false;
+		system = System::none;
+		analyzed = false;
+		factorized = false;
+	}
+
+	void OperatorCache::geometry_changed()
+	{
+		has_values = false;
+		factorized = false;
+	}
+
+	bool OperatorCache::prepare_operator(const Mesh& mesh, SolveStats* stats)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (has_pattern && size_t(L.rows()) != mesh.n_vertices())
+		{
+			topology_changed();
+		}
+		if (stats) stats->reused_pattern = has_pattern;
+		if (!has_pattern)
+		{
+			if (!build_pattern(mesh, L)) return false;
+			has_pattern = true;
+			has_values = false;
+			system = System::none;
+			analyzed = false;
+		}
+		if (!has_values)
+		{
+			fill_values(mesh, L, mass);
+			// 孤立顶点的质量为0，给一个很小的正值保持系统正定
+			double floor = 1e-12 * std::max(mass.mean(), 1e-300);
+			mass = mass.cwiseMax(floor);
+			has_values = true;
+			factorized = false;
+		}
+		if (stats) stats->assemble_ms += elapsed_ms(start);
+		return true;
+	}
+
+	bool OperatorCache::set_region(const Mesh& mesh, System new_system, const SelectionBitset* region)
+	{
+		size_t n = mesh.n_vertices();
+		if (region && region->size() != n) return false;
+
+		std::vector<uint64_t> words;
+		if (region)
+		{
+			words.resize(region->word_count());
+			for (size_t i = 0; i < words.size(); i++)
+			{
+				words[i] = region->word(i);
+			}
+		}
+		if (new_system == system && words == region_words) return true;
+
+		system = new_system;
+		region_words.swap(words);
+		analyzed = false;
+		factorized = false;
+		local_index.assign(n, -1);
+		free_vertices.clear();
+		for (size_t v = 0; v < n; v++)
+		{
+			if (region && !region->test(v)) continue;
+			local_index[v] = int(free_vertices.size());
+			free_vertices.push_back(int(v));
+		}
+		return true;
+	}
+
+	bool OperatorCache::factorize(const SparseMatrix& A, SolveStats* stats)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (stats) stats->reused_symbolic = analyzed;
+		if (!analyzed)
+		{
+			if (solver_type == SolverType::direct)
+			{
+				ldlt.analyzePattern(A);
+			}
+			else
+			{
+				cg.analyzePattern(A);
+			}
+			analyzed = true;
+			if (stats) stats->analyze_ms += elapsed_ms(start);
+			start = std::chrono::steady_clock::now();
+		}
+
+		bool ok;
+		if (solver_type == SolverType::direct)
+		{
+			ldlt.factorize(A);
+			ok = ldlt.info() == Eigen::Success;
+		}
+		else
+		{
+			cg.setTolerance(1e-10);
+			cg.factorize(A);
+			ok = cg.info() == Eigen::Success;
+		}
+		factorized = ok;
+		if (stats)
+		{
+			stats->factorize_ms += elapsed_ms(start);
+			stats->factorizations++;
+		}
+		return ok;
+	}
+
+	bool OperatorCache::solve(const Eigen::MatrixXd& rhs, Eigen::MatrixXd& x, SolveStats* stats)
+	{
+		auto start = std::chrono::steady_clock::now();
+		bool ok;
+		if (solver_type == SolverType::direct)
+		{
+			x = ldlt.solve(rhs);
+			ok = ldlt.info() == Eigen::Success;
+		}
+		else
+		{
+			// 以当前坐标为初值
+			Eigen::MatrixXd guess = x;
+			x = cg.solveWithGuess(rhs, guess);
+			ok = cg.info() == Eigen::Success;
+			if (stats) stats->cg_iterations += int(cg.iterations());
+		}
+		if (stats) stats->solve_ms += elapsed_ms(start);
+		return ok;
+	}
+
+	bool OperatorCache::smooth(Mesh& mesh, const SelectionBitset* region, double step, int iterations, SolveStats* stats)
+	{
+		if (step <= 0.0 || iterations < 1) return false;
+		if (!prepare_operator(mesh, stats)) return false;
+		if (!set_region(mesh, System::smooth, region) || free_vertices.empty()) return false;
+
+		if (!factorized || step != time_step)
+		{
+			// A = M - t L
+			SparseMatrix A = L * (-step);
+			parallel::for_each(0, size_t(A.outerSize()), [&](size_t j)
+			{
+				for (SparseMatrix::InnerIterator it(A, Eigen::Index(j)); it; ++it)
+				{
+					if (size_t(it.row()) == j) it.valueRef() += mass[j];
+				}
+			});
+			if (region)
+			{
+				restrict_to_free(A, local_index, free_vertices, A_ff);
+			}
+			else
+			{
+				A_ff.swap(A);
+			}
+			time_step = step;
+			if (!factorize(A_ff, stats)) return false;
+		}
+
+		Eigen::MatrixXd X;
+		read_points(mesh, X);
+		size_t nf = free_vertices.size();
+		Eigen::MatrixXd x(nf, 3), mass_f(nf, 1), fixed = Eigen::MatrixXd::Zero(nf, 3);
+		for (size_t r = 0; r < nf; r++)
+		{
+			x.row(r) = X.row(free_vertices[r]);
+			mass_f(r, 0) = mass[free_vertices[r]];
+		}
+		// 固定顶点移到右端：-A_fc x_c = t L_fc x_c
+		if (region)
+		{
+			add_fixed_part(L, local_index, free_vertices, X, step, fixed);
+		}
+
+		for (int i = 0; i < iterations; i++)
+		{
+			Eigen::MatrixXd rhs = x.array().colwise() * mass_f.col(0).array();
+			rhs += fixed;
+			if (!solve(rhs, x, stats)) return false;
+		}
+
+		parallel::for_each(0, nf, [&](size_t r)
+		{
+			mesh.set_point(VH(free_vertices[r]), Vec3d(x(r, 0), x(r, 1), x(r, 2)));
+		});
+		geometry_changed();
+		return true;
+	}
+
+	bool OperatorCache::fair(Mesh& mesh, const SelectionBitset& region, SolveStats* stats)
+	{
+		if (!prepare_operator(mesh, stats)) return false;
+		if (!set_region(mesh, System::fair, &region)) return false;
+		// 没有固定顶点时解不唯一
+		if (free_vertices.empty() || free_vertices.size() == mesh.n_vertices()) return false;
+
+		auto start = std::chrono::steady_clock::now();
+		Eigen::VectorXd inv_mass = mass.cwiseInverse();
+		SparseMatrix A = (L * inv_mass.asDiagonal()) * L;
+		A.makeCompressed();
+		restrict_to_free(A, local_index, free_vertices, A_ff);
+		if (stats) stats->assemble_ms += elapsed_ms(start);
+		if (!factorized && !factorize(A_ff, stats)) return false;
+
+		Eigen::MatrixXd X;
+		read_points(mesh, X);
+		size_t nf = free_vertices.size();
+		Eigen::MatrixXd x(nf, 3), rhs = Eigen::MatrixXd::Zero(nf, 3);
+		for (size_t r = 0; r < nf; r++)
+		{
+			x.row(r) = X.row(free_vertices[r]);
+		}
+		add_fixed_part(A, local_index, free_vertices, X, -1.0, rhs);
+		if (!solve(rhs, x, stats)) return false;
+
+		parallel::for_each(0, nf, [&](size_t r)
+		{
+			mesh.set_point(VH(free_vertices[r]), Vec3d(x(r, 0), x(r, 1), x(r, 2)));
+		});
+		geometry_changed();
+		return true;
+	}
+}
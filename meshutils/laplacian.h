@@ -0,0 +1,83 @@
+#pragma once
+#include "my_traits.h"
+#include "mesh_selection.h"
+#include <Eigen/Sparse>
+#include <vector>
+
+// 余切拉普拉斯与集中质量矩阵，以及基于它们的隐式平滑和双拉普拉斯光顺。
+// 矩阵按顶点逐行并行直接写成压缩格式（每行为该顶点及其一环邻点，按编号排序），不经过三元组排序。
+namespace laplacian
+{
+	typedef Eigen::SparseMatrix<double> SparseMatrix;   // 列主序；矩阵对称，列即行
+
+	// 非零结构：每个顶点一列，包含自身和一环邻点。仅适用于三角形网格，否则返回false
+	bool build_pattern(const Mesh& mesh, SparseMatrix& L);
+	// 在已有结构上填数值：L_ij = (cot α + cot β) / 2，L_ii = -Σ L_ij；mass为相邻三角形面积之和的1/3
+	void fill_values(const Mesh& mesh, SparseMatrix& L, Eigen::VectorXd& mass);
+
+	enum class SolverType
+	{
+		direct,              // SimplicialLDLT
+		conjugate_gradient   // 不完全Cholesky预条件的共轭梯度，内存小，适合大网格
+	};
+
+	struct SolveStats
+	{
+		double assemble_ms = 0.0;
+		double analyze_ms = 0.0;
+		double factorize_ms = 0.0;
+		double solve_ms = 0.0;
+		bool reused_pattern = false;    // 拓扑未变，只重填了数值
+		bool reused_symbolic = false;   // 复用了符号分解（消元顺序和非零结构）
+		int factorizations = 0;
+		int cg_iterations = 0;
+	};
+
+	// 在多次求解间缓存矩阵和分解：拓扑不变时复用非零结构，系统类型和自由顶点集不变时复用符号分解，
+	// 数值不变时（同一次平滑的多步迭代）复用数值分解。
+	// 每次求解都以当前几何重新线性化；在外部修改了网格后调用topology_changed()或geometry_changed()
+	class OperatorCache
+	{
+	public:
+		void set_solver(SolverType type);
+		void topology_changed();
+		void geometry_changed();
+
+		// 隐式拉普拉斯平滑 (M - t L) x = M x0，iterations步共用一次分解。
+		// region为空指针时所有顶点参与，否则只移动region中的顶点，其余作为边界条件
+		bool smooth(Mesh& mesh, const SelectionBitset* region, double time_step, int iterations,
+			SolveStats* stats = nullptr);
+		// 双拉普拉斯光顺：region中的顶点满足 L M^-1 L x = 0，region外的顶点固定
+		bool fair(Mesh& mesh, const SelectionBitset& region, SolveStats* stats = nullptr);
+
+	private:
+		enum class System
+		{
+			none, smooth, fair
+		};
+
+		bool prepare_operator(const Mesh& mesh, SolveStats* stats);
+		bool set_region(const Mesh& mesh, System system, const SelectionBitset* region);
+		bool factorize(const SparseMatrix& A, SolveStats* stats);
+		bool solve(const Eigen::MatrixXd& rhs, Eigen::MatrixXd& x, SolveStats* stats);
+
+		SolverType solver_type = SolverType::direct;
+		SparseMatrix L;
+		Eigen::VectorXd mass;
+		bool has_pattern = false;
+		bool has_values = false;
+
+		// 当前分解对应的系统
+		System system = System::none;
+		std::vector<uint64_t> region_words;   // 为空表示所有顶点自由
+		double time_step = 0.0;
+		std::vector<int> local_index;         // 顶点 -> 自由变量编号，固定顶点为-1
+		std::vector<int> free_vertices;
+		SparseMatrix A_ff;
+		bool analyzed = false;
+		bool factorized = false;
+
+		Eigen::SimplicialLDLT<SparseMatrix> ldlt;
+		Eigen::ConjugateGradient<SparseMatrix, Eigen::Lower | Eigen::Upper, Eigen::IncompleteCholesky<double> > cg;
+	};
+}
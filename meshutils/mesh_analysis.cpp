@@ -0,0 +1,195 @@
+#include "mesh_analysis.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+
+namespace mesh_analysis
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef Mesh::HalfedgeHandle HH;
+		typedef Mesh::EdgeHandle EH;
+		typedef Mesh::FaceHandle FH;
+		typedef OpenMesh::Vec3d Vec3d;
+
+		// 每线程的局部累加量，最后串行合并
+		struct Partial
+		{
+			size_t count = 0;
+			size_t second = 0;
+			double area = 0.0;
+			double volume = 0.0;
+		};
+
+		size_t count_roots(const ConcurrentUnionFind& uf, const std::vector<unsigned char>& member)
+		{
+			std::vector<size_t> counts(parallel::thread_count(), 0);
+			parallel::for_each_range(0, uf.size(), [&](size_t b, size_t e, unsigned int tid)
+			{
+				for (size_t i = b; i < e; i++)
+				{
+					if (member[i] && uf.is_root((unsigned int)i)) counts[tid]++;
+				}
+			});
+			size_t total = 0;
+			for (size_t c : counts)
+			{
+				total += c;
+			}
+			return total;
+		}
+	}
+
+	ConcurrentUnionFind::ConcurrentUnionFind(size_t n) : parent(new std::atomic<unsigned int>[n]), n(n)
+	{
+		parallel::for_each(0, n, [&](size_t i)
+		{
+			parent[i].store((unsigned int)i, std::memory_order_relaxed);
+		});
+	}
+
+	unsigned int ConcurrentUnionFind::find(unsigned int x)
+	{
+		while (true)
+		{
+			unsigned int p = parent[x].load(std::memory_order_relaxed);
+			if (p == x) return x;
+			unsigned int gp = parent[p].load(std::memory_order_relaxed);
+			if (gp == p) return p;
+			// 路径减半：失败说明别的线程已经改过，不影响正确性
+			parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+			x = gp;
+		}
+	}
+
+	void ConcurrentUnionFind::unite(unsigned int a, unsigned int b)
+	{
+		while (true)
+		{
+			a = find(a);
+			b = find(b);
+			if (a == b) return;
+			if (a < b) std::swap(a, b);
+			// 只有根能被挂接；a在此期间被别的线程挂走时重新查找
+			unsigned int expected = a;
+			if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+		}
+	}
+
+	Report analyze(const Mesh& mesh)
+	{
+		auto start = std::chrono::steady_clock::now();
+		Report report;
+		report.vertices = mesh.n_vertices();
+		report.edges = mesh.n_edges();
+		report.faces = mesh.n_faces();
+
+		// 面的连通分量：每条内部边合并两侧的面
+		ConcurrentUnionFind faces(mesh.n_faces());
+		std::vector<Partial> edge_partial(parallel::thread_count());
+		parallel::for_each_range(0, mesh.n_edges(), [&](size_t b, size_t e, unsigned int tid)
+		{
+			for (size_t i = b; i < e; i++)
+			{
+				FH f0 = mesh.face_handle(mesh.halfedge_handle(EH(int(i)), 0));
+				FH f1 = mesh.face_handle(mesh.halfedge_handle(EH(int(i)), 1));
+				if (f0.is_valid() && f1.is_valid()) faces.unite(f0.idx(), f1.idx());
+				else if (f0.is_valid() || f1.is_valid()) edge_partial[tid].count++;
+				else edge_partial[tid].second++;   // 不属于任何面的边
+			}
+		});
+		std::vector<unsigned char> all_faces(mesh.n_faces(), 1);
+		report.components = count_roots(faces, all_faces);
+
+		// 边界环：边界半边沿next连成环，同一个并查集思路
+		// 不属于任何面的边两侧都是边界半边，不算作边界环
+		auto on_boundary = [&](HH h)
+		{
+			return mesh.is_boundary(h) && !mesh.is_boundary(mesh.opposite_halfedge_handle(h));
+		};
+		ConcurrentUnionFind halfedges(mesh.n_halfedges());
+		std::vector<unsigned char> boundary(mesh.n_halfedges(), 0);
+		parallel::for_each(0, mesh.n_halfedges(), [&](size_t i)
+		{
+			HH h(int(i));
+			if (!on_boundary(h)) return;
+			boundary[i] = 1;
+			HH next = mesh.next_halfedge_handle(h);
+			if (on_boundary(next)) halfedges.unite((unsigned int)i, (unsigned int)next.idx());
+		});
+		report.boundary_loops = count_roots(halfedges, boundary);
+
+		// 顶点：孤立顶点，以及出边中有多于一条边界半边的非流形顶点
+		std::vector<Partial> vertex_partial(parallel::thread_count());
+		parallel::for_each_range(0, mesh.n_vertices(), [&](size_t b, size_t e, unsigned int tid)
+		{
+			for (size_t i = b; i < e; i++)
+			{
+				VH v(int(i));
+				HH first = mesh.halfedge_handle(v);
+				if (!first.is_valid())
+				{
+					vertex_partial[tid].count++;
+					continue;
+				}
+				int boundary_out = 0;
+				HH h = first;
+				do
+				{
+					if (mesh.is_boundary(h)) boundary_out++;
+					h = mesh.next_halfedge_handle(mesh.opposite_halfedge_handle(h));
+				} while (h != first);
+				if (boundary_out > 1) vertex_partial[tid].second++;
+			}
+		});
+
+		// 面积和有向体积（扇形三角化，体积按原点处的四面体求和）
+		std::vector<Partial> face_partial(parallel::thread_count());
+		parallel::for_each_range(0, mesh.n_faces(), [&](size_t b, size_t e, unsigned int tid)
+		{
+			Partial& partial = face_partial[tid];
+			for (size_t i = b; i < e; i++)
+			{
+				HH h0 = mesh.halfedge_handle(FH(int(i)));
+				const Vec3d& p0 = mesh.point(mesh.from_vertex_handle(h0));
+				double face_area = 0.0;
+				for (HH h = mesh.next_halfedge_handle(h0); mesh.to_vertex_handle(h) != mesh.from_vertex_handle(h0);
+					h = mesh.next_halfedge_handle(h))
+				{
+					const Vec3d& p1 = mesh.point(mesh.from_vertex_handle(h));
+					const Vec3d& p2 = mesh.point(mesh.to_vertex_handle(h));
+					face_area += 0.5 * ((p1 - p0) % (p2 - p0)).norm();
+					partial.volume += (p0 | (p1 % p2)) / 6.0;
+				}
+				partial.area += face_area;
+				if (face_area == 0.0) partial.count++;
+			}
+		});
+
+		size_t loose_edges = 0;
+		for (const Partial& p : edge_partial)
+		{
+			report.boundary_edges += p.count;
+			loose_edges += p.second;
+		}
+		for (const Partial& p : vertex_partial)
+		{
+			report.isolated_vertices += p.count;
+			report.non_manifold_vertices += p.second;
+		}
+		for (const Partial& p : face_partial)
+		{
+			report.degenerate_faces += p.count;
+			report.area += p.area;
+			report.volume += p.volume;
+		}
+
+		report.closed = report.faces > 0 && report.boundary_edges == 0;
+		report.euler_characteristic = int(report.vertices - report.isolated_vertices)
+			- int(report.edges - loose_edges) + int(report.faces);
+		report.genus = (2 * int(report.components) - int(report.boundary_loops) - report.euler_characteristic) / 2;
+		report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return report;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "my_traits.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// 加载后的网格统计：连通分量、边界环、非流形元素、亏格、面积和体积。
+// 连通分量和边界环都用并行并查集求出；只按下标访问网格，不读取status，
+// 因此可以在工作线程上与界面对选择状态的修改同时进行
+namespace mesh_analysis
+{
+	struct Report
+	{
+		size_t vertices = 0;
+		size_t edges = 0;
+		size_t faces = 0;
+		size_t components = 0;            // 按面连通
+		size_t boundary_loops = 0;
+		size_t boundary_edges = 0;
+		size_t isolated_vertices = 0;
+		size_t non_manifold_vertices = 0; // 一环由多个扇形组成（OpenMesh加载时已拒绝多于两个面的边）
+		size_t degenerate_faces = 0;      // 面积为0
+		int euler_characteristic = 0;     // 不计孤立顶点
+		int genus = 0;                    // 各分量亏格之和，(2c - b - χ)/2
+		double area = 0.0;
+		double volume = 0.0;              // 有向体积，只在封闭时有意义
+		bool closed = false;
+		double milliseconds = 0.0;
+	};
+
+	// 无锁并查集：合并时用CAS把较大的根挂到较小的根下，查找时做路径减半。
+	// find/unite可以被多个线程同时调用
+	class ConcurrentUnionFind
+	{
+	public:
+		explicit ConcurrentUnionFind(size_t n);
+
+		unsigned int find(unsigned int x);
+		void unite(unsigned int a, unsigned int b);
+		bool is_root(unsigned int x) const { return parent[x].load(std::memory_order_relaxed) == x; }
+		size_t size() const { return n; }
+
+	private:
+		std::unique_ptr<std::atomic<unsigned int>[]> parent;
+		size_t n;
+	};
+
+	Report analyze(const Mesh& mesh);
+}
@@ -0,0 +1,581 @@
+#include "mesh_bvh.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+	const int kLeafSize = 4;
+	const int kBinCount = 16;
+	// 超过此深度改用中位数分割，保证遍历栈不会溢出
+	const int kMaxSahDepth = 64;
+	const int kStackSize = 128;
+
+	inline double half_area(const OpenMesh::Vec3d& bmin, const OpenMesh::Vec3d& bmax)
+	{
+		OpenMesh::Vec3d d = bmax - bmin;
+		if (d[0] < 0 || d[1] < 0 || d[2] < 0) return 0.0;
+		return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+	}
+
+	inline void grow(OpenMesh::Vec3d& bmin, OpenMesh::Vec3d& bmax, const OpenMesh::Vec3d& lo, const OpenMesh::Vec3d& hi)
+	{
+		bmin.minimize(lo);
+		bmax.maximize(hi);
+	}
+
+	inline void empty_box(OpenMesh::Vec3d& bmin, OpenMesh::Vec3d& bmax)
+	{
+		double inf = std::numeric_limits<double>::max();
+		bmin = OpenMesh::Vec3d(inf, inf, inf);
+		bmax = OpenMesh::Vec3d(-inf, -inf, -inf);
+	}
+
+	// 射线与包围盒的slab测试，返回进入距离
+	inline bool ray_box(const OpenMesh::Vec3d& bmin, const OpenMesh::Vec3d& bmax,
+		const OpenMesh::Vec3d& origin, const OpenMesh::Vec3d& inv_dir, double t_max, double& t_enter)
+	{
+		double t0 = 0.0, t1 = t_max;
+		for (int a = 0; a < 3; a++)
+		{
+			double near_t = (bmin[a] - origin[a]) * inv_dir[a];
+			double far_t = (bmax[a] - origin[a]) * inv_dir[a];
+			if (near_t > far_t) std::swap(near_t, far_t);
+			t0 = near_t > t0 ? near_t : t0;
+			t1 = far_t < t1 ? far_t : t1;
+			if (t0 > t1) return false;
+		}
+		t_enter = t0;
+		return true;
+	}
+
+	inline bool boxes_overlap(const OpenMesh::Vec3d& amin, const OpenMesh::Vec3d& amax,
+		const OpenMesh::Vec3d& bmin, const OpenMesh::Vec3d& bmax)
+	{
+		for (int a = 0; a < 3; a++)
+		{
+			if (amin[a] > bmax[a] || bmin[a] > amax[a]) return false;
+		}
+		return true;
+	}
+
+	// 点到包围盒的距离平方，点在盒内为0
+	inline double box_distance2(const OpenMesh::Vec3d& bmin, const OpenMesh::Vec3d& bmax, const OpenMesh::Vec3d& p)
+	{
+		double d2 = 0.0;
+		for (int a = 0; a < 3; a++)
+		{
+			double d = std::max(std::max(bmin[a] - p[a], 0.0), p[a] - bmax[a]);
+			d2 += d * d;
+		}
+		return d2;
+	}
+}
+
+void MeshBVH::clear()
+{
+	nodes.clear();
+	tri_order.clear();
+	tri_indices.clear();
+	tri_faces.clear();
+	vertices.clear();
+}
+
+void MeshBVH::build(const Mesh& mesh)
+{
+	std::vector<OpenMesh::Vec3d> points(mesh.n_vertices());
+	for (auto vh : mesh.vertices())
+	{
+		points[vh.idx()] = mesh.point(vh);
+	}
+
+	std::vector<unsigned int> triangles;
+	std::vector<int> faces;
+	triangles.reserve(mesh.n_faces() * 3);
+	faces.reserve(mesh.n_faces());
+	for (auto fh : mesh.faces())
+	{
+		auto fv_it = mesh.cfv_ccwbegin(fh);
+		int first = (*fv_it).idx(); ++fv_it;
+		int prev = (*fv_it).idx(); ++fv_it;
+		for (; fv_it != mesh.cfv_ccwend(fh); ++fv_it)
+		{
+			int cur = (*fv_it).idx();
+			triangles.push_back(first);
+			triangles.push_back(prev);
+			triangles.push_back(cur);
+			faces.push_back(fh.idx());
+			prev = cur;
+		}
+	}
+	build(points, triangles, faces);
+}
+
+void MeshBVH::build(const std::vector<OpenMesh::Vec3d>& points,
+	const std::vector<unsigned int>& triangles,
+	const std::vector<int>& triangle_faces)
+{
+	clear();
+	vertices = points;
+	tri_indices = triangles;
+
+	int n = int(triangles.size() / 3);
+	tri_faces = triangle_faces;
+	if (int(tri_faces.size()) != n)
+	{
+		tri_faces.resize(n);
+		for (int i = 0; i < n; i++) tri_faces[i] = i;
+	}
+	if (n == 0) return;
+
+	std::vector<OpenMesh::Vec3d> centroids(n), tri_min(n), tri_max(n);
+	tri_order.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		const OpenMesh::Vec3d& a = vertices[tri_indices[3 * i]];
+		const OpenMesh::Vec3d& b = vertices[tri_indices[3 * i + 1]];
+		const OpenMesh::Vec3d& c = vertices[tri_indices[3 * i + 2]];
+		tri_min[i] = a; tri_min[i].minimize(b); tri_min[i].minimize(c);
+		tri_max[i] = a; tri_max[i].maximize(b); tri_max[i].maximize(c);
+		centroids[i] = (a + b + c) / 3.0;
+		tri_order[i] = i;
+	}
+
+	nodes.reserve(2 * n / kLeafSize + 1);
+	build_recursive(0, n, 0, centroids, tri_min, tri_max);
+}
+
+int MeshBVH::build_recursive(int begin, int end, int depth, std::vector<OpenMesh::Vec3d>& centroids,
+	std::vector<OpenMesh::Vec3d>& tri_min, std::vector<OpenMesh::Vec3d>& tri_max)
+{
+	int index = int(nodes.size());
+	nodes.push_back(Node());
+
+	OpenMesh::Vec3d bmin, bmax, cmin, cmax;
+	empty_box(bmin, bmax);
+	empty_box(cmin, cmax);
+	for (int i = begin; i < end; i++)
+	{
+		int t = tri_order[i];
+		grow(bmin, bmax, tri_min[t], tri_max[t]);
+		grow(cmin, cmax, centroids[t], centroids[t]);
+	}
+	nodes[index].bmin = bmin;
+	nodes[index].bmax = bmax;
+
+	int count = end - begin;
+	OpenMesh::Vec3d extent = cmax - cmin;
+	int axis = 0;
+	if (extent[1] > extent[axis]) axis = 1;
+	if (extent[2] > extent[axis]) axis = 2;
+
+	if (count <= kLeafSize || extent[axis] <= 0.0)
+	{
+		nodes[index].first = begin;
+		nodes[index].count = count;
+		return index;
+	}
+
+	// 分箱SAH：在最长轴上把质心分到kBinCount个桶里，扫描得到代价最小的分割面
+	int bin_count[kBinCount] = { 0 };
+	OpenMesh::Vec3d bin_min[kBinCount], bin_max[kBinCount];
+	for (int b = 0; b < kBinCount; b++) empty_box(bin_min[b], bin_max[b]);
+
+	double scale = kBinCount / extent[axis];
+	auto bin_of = [&](int t)
+	{
+		int b = int((centroids[t][axis] - cmin[axis]) * scale);
+		return std::min(b, kBinCount - 1);
+	};
+	for (int i = begin; i < end; i++)
+	{
+		int t = tri_order[i];
+		int b = bin_of(t);
+		bin_count[b]++;
+		grow(bin_min[b], bin_max[b], tri_min[t], tri_max[t]);
+	}
+
+	double right_cost[kBinCount];
+	OpenMesh::Vec3d rmin, rmax;
+	empty_box(rmin, rmax);
+	int rcount = 0;
+	for (int b = kBinCount - 1; b > 0; b--)
+	{
+		grow(rmin, rmax, bin_min[b], bin_max[b]);
+		rcount += bin_count[b];
+		right_cost[b] = rcount * half_area(rmin, rmax);
+	}
+
+	int best_split = -1;
+	double best_cost = std::numeric_limits<double>::max();
+	OpenMesh::Vec3d lmin, lmax;
+	empty_box(lmin, lmax);
+	int lcount = 0;
+	for (int b = 0; b < kBinCount - 1 && depth < kMaxSahDepth; b++)
+	{
+		grow(lmin, lmax, bin_min[b], bin_max[b]);
+		lcount += bin_count[b];
+		if (lcount == 0 || lcount == count) continue;
+		double cost = lcount * half_area(lmin, lmax) + right_cost[b + 1];
+		if (cost < best_cost)
+		{
+			best_cost = cost;
+			best_split = b;
+		}
+	}
+
+	int mid;
+	if (best_split >= 0)
+	{
+		mid = int(std::partition(tri_order.begin() + begin, tri_order.begin() + end,
+			[&](int t) { return bin_of(t) <= best_split; }) - tri_order.begin());
+	}
+	else
+	{
+		// 质心全部落在同一个桶里（或树已过深），退化为按中位数分割
+		mid = begin + count / 2;
+		std::nth_element(tri_order.begin() + begin, tri_order.begin() + mid, tri_order.begin() + end,
+			[&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+	}
+
+	build_recursive(begin, mid, depth + 1, centroids, tri_min, tri_max);
+	int right = build_recursive(mid, end, depth + 1, centroids, tri_min, tri_max);
+	nodes[index].first = right;
+	nodes[index].count = 0;
+	return index;
+}
+
+bool MeshBVH::intersect_triangle(int tri, const OpenMesh::Vec3d& origin, const OpenMesh::Vec3d& dir,
+	double t_max, double& t, double& u, double& v) const
+{
+	// Möller-Trumbore，双面求交
+	const OpenMesh::Vec3d& a = vertices[tri_indices[3 * tri]];
+	const OpenMesh::Vec3d& b = vertices[tri_indices[3 * tri + 1]];
+	const OpenMesh::Vec3d& c = vertices[tri_indices[3 * tri + 2]];
+	OpenMesh::Vec3d e1 = b - a;
+	OpenMesh::Vec3d e2 = c - a;
+	OpenMesh::Vec3d p = dir % e2;
+	double det = e1 | p;
+	if (std::fabs(det) < 1e-20) return false;
+
+	double inv_det = 1.0 / det;
+	OpenMesh::Vec3d s = origin - a;
+	u = (s | p) * inv_det;
+	if (u < 0.0 || u > 1.0) return false;
+
+	OpenMesh::Vec3d q = s % e1;
+	v = (dir | q) * inv_det;
+	if (v < 0.0 || u + v > 1.0) return false;
+
+	t = (e2 | q) * inv_det;
+	return t >= 0.0 && t < t_max;
+}
+
+bool MeshBVH::ray_cast(const OpenMesh::Vec3d& origin, const OpenMesh::Vec3d& dir, Hit& hit, double t_max) const
+{
+	if (nodes.empty()) return false;
+
+	OpenMesh::Vec3d inv_dir;
+	for (int a = 0; a < 3; a++)
+	{
+		inv_dir[a] = dir[a] != 0.0 ? 1.0 / dir[a] : std::numeric_limits<double>::max();
+	}
+
+	double best_t = t_max, best_u = 0.0, best_v = 0.0;
+	int best_tri = -1;
+
+	int stack[kStackSize];
+	int top = 0;
+	double t_enter;
+	if (!ray_box(nodes[0].bmin, nodes[0].bmax, origin, inv_dir, best_t, t_enter)) return false;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes[stack[--top]];
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int tri = tri_order[i];
+				double t, u, v;
+				if (intersect_triangle(tri, origin, dir, best_t, t, u, v))
+				{
+					best_t = t;
+					best_u = u;
+					best_v = v;
+					best_tri = tri;
+				}
+			}
+			continue;
+		}
+
+		// 先访问较近的孩子，较远的压栈；已找到更近的交点时剪枝
+		int left = int(&node - &nodes[0]) + 1;
+		int right = node.first;
+		double t_left, t_right;
+		bool hit_left = ray_box(nodes[left].bmin, nodes[left].bmax, origin, inv_dir, best_t, t_left);
+		bool hit_right = ray_box(nodes[right].bmin, nodes[right].bmax, origin, inv_dir, best_t, t_right);
+		if (hit_left && hit_right)
+		{
+			if (t_left > t_right)
+			{
+				std::swap(left, right);
+			}
+			stack[top++] = right;
+			stack[top++] = left;
+		}
+		else if (hit_left)
+		{
+			stack[top++] = left;
+		}
+		else if (hit_right)
+		{
+			stack[top++] = right;
+		}
+	}
+
+	if (best_tri < 0) return false;
+
+	fill_hit(best_tri, OpenMesh::Vec3d(1.0 - best_u - best_v, best_u, best_v), hit);
+	hit.t = best_t;
+	hit.point = origin + dir * best_t;
+	return true;
+}
+
+void MeshBVH::fill_hit(int tri, const OpenMesh::Vec3d& barycentric, Hit& hit) const
+{
+	hit.triangle = tri;
+	hit.face = tri_faces[tri];
+	hit.barycentric = barycentric;
+	int nearest = 0;
+	for (int k = 0; k < 3; k++)
+	{
+		hit.tri_vertices[k] = int(tri_indices[3 * tri + k]);
+		if (hit.barycentric[k] > hit.barycentric[nearest]) nearest = k;
+	}
+	hit.vertex = hit.tri_vertices[nearest];
+}
+
+OpenMesh::Vec3d MeshBVH::closest_on_triangle(int tri, const OpenMesh::Vec3d& p, OpenMesh::Vec3d& barycentric) const
+{
+	// 按Voronoi区域分情况（Real-Time Collision Detection 5.1.5）
+	const OpenMesh::Vec3d& a = vertices[tri_indices[3 * tri]];
+	const OpenMesh::Vec3d& b = vertices[tri_indices[3 * tri + 1]];
+	const OpenMesh::Vec3d& c = vertices[tri_indices[3 * tri + 2]];
+	OpenMesh::Vec3d ab = b - a, ac = c - a, ap = p - a;
+	double d1 = ab | ap, d2 = ac | ap;
+	if (d1 <= 0.0 && d2 <= 0.0)
+	{
+		barycentric = OpenMesh::Vec3d(1.0, 0.0, 0.0);
+		return a;
+	}
+	OpenMesh::Vec3d bp = p - b;
+	double d3 = ab | bp, d4 = ac | bp;
+	if (d3 >= 0.0 && d4 <= d3)
+	{
+		barycentric = OpenMesh::Vec3d(0.0, 1.0, 0.0);
+		return b;
+	}
+	double vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+	{
+		double v = d1 / (d1 - d3);
+		barycentric = OpenMesh::Vec3d(1.0 - v, v, 0.0);
+		return a + ab * v;
+	}
+	OpenMesh::Vec3d cp = p - c;
+	double d5 = ab | cp, d6 = ac | cp;
+	if (d6 >= 0.0 && d5 <= d6)
+	{
+		barycentric = OpenMesh::Vec3d(0.0, 0.0, 1.0);
+		return c;
+	}
+	double vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+	{
+		double w = d2 / (d2 - d6);
+		barycentric = OpenMesh::Vec3d(1.0 - w, 0.0, w);
+		return a + ac * w;
+	}
+	double va = d3 * d6 - d5 * d4;
+	if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+	{
+		double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		barycentric = OpenMesh::Vec3d(0.0, 1.0 - w, w);
+		return b + (c - b) * w;
+	}
+	double denom = va + vb + vc;
+	if (std::fabs(denom) < 1e-300)
+	{
+		// 退化三角形
+		barycentric = OpenMesh::Vec3d(1.0, 0.0, 0.0);
+		return a;
+	}
+	double v = vb / denom, w = vc / denom;
+	barycentric = OpenMesh::Vec3d(1.0 - v - w, v, w);
+	return a + ab * v + ac * w;
+}
+
+bool MeshBVH::closest_point(const OpenMesh::Vec3d& p, Hit& hit, double max_dist) const
+{
+	if (nodes.empty()) return false;
+
+	double best_d2 = max_dist < std::sqrt(std::numeric_limits<double>::max()) ? max_dist * max_dist
+		: std::numeric_limits<double>::max();
+	int best_tri = -1;
+	OpenMesh::Vec3d best_point, best_bary;
+
+	int stack[kStackSize];
+	int top = 0;
+	if (box_distance2(nodes[0].bmin, nodes[0].bmax, p) > best_d2) return false;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = nodes[stack[--top]];
+		if (box_distance2(node.bmin, node.bmax, p) > best_d2) continue;
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int tri = tri_order[i];
+				OpenMesh::Vec3d bary;
+				OpenMesh::Vec3d q = closest_on_triangle(tri, p, bary);
+				double d2 = (q - p).sqrnorm();
+				if (d2 < best_d2)
+				{
+					best_d2 = d2;
+					best_tri = tri;
+					best_point = q;
+					best_bary = bary;
+				}
+			}
+			continue;
+		}
+
+		// 较近的孩子后压栈，先被访问
+		int left = int(&node - &nodes[0]) + 1;
+		int right = node.first;
+		double d_left = box_distance2(nodes[left].bmin, nodes[left].bmax, p);
+		double d_right = box_distance2(nodes[right].bmin, nodes[right].bmax, p);
+		if (d_left < d_right)
+		{
+			std::swap(left, right);
+			std::swap(d_left, d_right);
+		}
+		if (d_left <= best_d2) stack[top++] = left;
+		if (d_right <= best_d2) stack[top++] = right;
+	}
+
+	if (best_tri < 0) return false;
+
+	fill_hit(best_tri, best_bary, hit);
+	hit.t = std::sqrt(best_d2);
+	hit.point = best_point;
+	return true;
+}
+
+void MeshBVH::triangle_box(int tri, OpenMesh::Vec3d& bmin, OpenMesh::Vec3d& bmax) const
+{
+	const unsigned int* v = &tri_indices[3 * tri];
+	bmin = bmax = vertices[v[0]];
+	for (int k = 1; k < 3; k++)
+	{
+		bmin.minimize(vertices[v[k]]);
+		bmax.maximize(vertices[v[k]]);
+	}
+}
+
+// 节点对(a, b)的包围盒相交时调用；展开为子节点对压入out，两个都是叶子时返回false
+bool MeshBVH::expand_pair(int a, int b, std::vector<std::pair<int, int>>& out) const
+{
+	const Node& na = nodes[a];
+	const Node& nb = nodes[b];
+	if (a == b)
+	{
+		if (na.count > 0) return false;
+		int left = a + 1, right = na.first;
+		out.push_back(std::make_pair(left, left));
+		out.push_back(std::make_pair(right, right));
+		if (boxes_overlap(nodes[left].bmin, nodes[left].bmax, nodes[right].bmin, nodes[right].bmax))
+		{
+			out.push_back(std::make_pair(left, right));
+		}
+		return true;
+	}
+	if (na.count > 0 && nb.count > 0) return false;
+
+	// 展开内部节点中较大的一个
+	bool split_a = nb.count > 0 || (na.count == 0 && half_area(na.bmin, na.bmax) >= half_area(nb.bmin, nb.bmax));
+	int parent = split_a ? a : b, other = split_a ? b : a;
+	int children[2] = { parent + 1, nodes[parent].first };
+	for (int c : children)
+	{
+		if (boxes_overlap(nodes[c].bmin, nodes[c].bmax, nodes[other].bmin, nodes[other].bmax))
+		{
+			out.push_back(std::make_pair(c, other));
+		}
+	}
+	return true;
+}
+
+void MeshBVH::leaf_pairs(int a, int b, const std::function<void(int, int, unsigned int)>& f, unsigned int thread_id) const
+{
+	const Node& na = nodes[a];
+	const Node& nb = nodes[b];
+	OpenMesh::Vec3d imin, imax, jmin, jmax;
+	for (int i = 0; i < na.count; i++)
+	{
+		int ti = tri_order[na.first + i];
+		triangle_box(ti, imin, imax);
+		for (int j = (a == b ? i + 1 : 0); j < nb.count; j++)
+		{
+			int tj = tri_order[nb.first + j];
+			triangle_box(tj, jmin, jmax);
+			if (!boxes_overlap(imin, imax, jmin, jmax)) continue;
+			f(std::min(ti, tj), std::max(ti, tj), thread_id);
+		}
+	}
+}
+
+void MeshBVH::for_each_overlapping_pair(const std::function<void(int, int, unsigned int)>& f) const
+{
+	if (nodes.empty()) return;
+
+	// 从(根, 根)广度优先展开，直到子树对数量足够让各线程负载均衡
+	std::vector<std::pair<int, int>> tasks(1, std::make_pair(0, 0)), next;
+	size_t wanted = 16 * size_t(parallel::thread_count());
+	bool expanded = true;
+	while (tasks.size() < wanted && expanded)
+	{
+		expanded = false;
+		next.clear();
+		for (const std::pair<int, int>& task : tasks)
+		{
+			if (expand_pair(task.first, task.second, next)) expanded = true;
+			else next.push_back(task);
+		}
+		tasks.swap(next);
+	}
+
+	std::atomic<size_t> cursor(0);
+	parallel::for_each(0, parallel::thread_count(), [&](size_t thread_id)
+	{
+		std::vector<std::pair<int, int>> stack;
+		for (size_t t = cursor++; t < tasks.size(); t = cursor++)
+		{
+			stack.push_back(tasks[t]);
+			while (!stack.empty())
+			{
+				std::pair<int, int> pair = stack.back();
+				stack.pop_back();
+				if (!expand_pair(pair.first, pair.second, stack))
+				{
+					leaf_pairs(pair.first, pair.second, f, unsigned(thread_id));
+				}
+			}
+		}
+	}, 1);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "my_traits.h"
+#include <vector>
+#include <limits>
+#include <functional>
+
+// 三角形包围盒层次（BVH）：分箱SAH构建，节点按深度优先顺序存放在一个数组里，
+// 叶子引用tri_order中连续的一段三角形。多边形面按扇形三角化，并记录所属的面。
+class MeshBVH
+{
+public:
+	struct Hit
+	{
+		int face = -1;                 // 网格中的面索引
+		int triangle = -1;             // BVH内部的三角形序号
+		int vertex = -1;               // 命中三角形上离命中点最近的顶点
+		double t = std::numeric_limits<double>::max();
+		OpenMesh::Vec3d point;
+		OpenMesh::Vec3d barycentric;   // 对应tri_vertices[0..2]
+		int tri_vertices[3] = { -1, -1, -1 };
+	};
+
+	// 直接从网格构建（多边形扇形三角化）
+	void build(const Mesh& mesh);
+	// 从已有的三角形索引构建，triangle_faces给出每个三角形所属的面，可以为空
+	void build(const std::vector<OpenMesh::Vec3d>& points,
+		const std::vector<unsigned int>& triangles,
+		const std::vector<int>& triangle_faces);
+
+	void clear();
+	bool empty() const { return nodes.empty(); }
+	size_t triangle_count() const { return tri_indices.size() / 3; }
+
+	// 返回最近交点；dir不必归一化，t以dir的长度为单位
+	bool ray_cast(const OpenMesh::Vec3d& origin, const OpenMesh::Vec3d& dir, Hit& hit,
+		double t_max = std::numeric_limits<double>::max()) const;
+	// 返回离p最近的表面点，hit.t为距离；max_dist以外的三角形不考虑
+	bool closest_point(const OpenMesh::Vec3d& p, Hit& hit,
+		double max_dist = std::numeric_limits<double>::max()) const;
+
+	// 包围盒相交的每一对三角形(a < b)调用一次f(a, b, thread_id)。BVH与自身做双树遍历，
+	// 先展开出足够多的子树对，再由各线程动态领取
+	void for_each_overlapping_pair(const std::function<void(int, int, unsigned int)>& f) const;
+
+	const unsigned int* triangle_vertices(int tri) const { return &tri_indices[3 * tri]; }
+	int triangle_face(int tri) const { return tri_faces[tri]; }
+	const OpenMesh::Vec3d& vertex(unsigned int v) const { return vertices[v]; }
+
+private:
+	struct Node
+	{
+		OpenMesh::Vec3d bmin;
+		OpenMesh::Vec3d bmax;
+		int first;   // 叶子：tri_order中的起始位置；内部节点：右孩子下标（左孩子紧随其后）
+		int count;   // 叶子中的三角形数，内部节点为0
+	};
+
+	int build_recursive(int begin, int end, int depth, std::vector<OpenMesh::Vec3d>& centroids,
+		std::vector<OpenMesh::Vec3d>& tri_min, std::vector<OpenMesh::Vec3d>& tri_max);
+	bool intersect_triangle(int tri, const OpenMesh::Vec3d& origin, const OpenMesh::Vec3d& dir,
+		double t_max, double& t, double& u, double& v) const;
+	OpenMesh::Vec3d closest_on_triangle(int tri, const OpenMesh::Vec3d& p, OpenMesh::Vec3d& barycentric) const;
+	void fill_hit(int tri, const OpenMesh::Vec3d& barycentric, Hit& hit) const;
+	bool expand_pair(int a, int b, std::vector<std::pair<int, int>>& out) const;
+	void leaf_pairs(int a, int b, const std::function<void(int, int, unsigned int)>& f, unsigned int thread_id) const;
+	void triangle_box(int tri, OpenMesh::Vec3d& bmin, OpenMesh::Vec3d& bmax) const;
+
+	std::vector<Node> nodes;
+	std::vector<int> tri_order;
+	std::vector<unsigned int> tri_indices;
+	std::vector<int> tri_faces;
+	std::vector<OpenMesh::Vec3d> vertices;
+};
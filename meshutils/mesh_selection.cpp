@@ -0,0 +1,288 @@
+#include "mesh_selection.h"
+#include "parallel_utils.h"
+#include <algorithm>
+
+size_t SelectionBitset::count() const
+{
+	size_t n = 0;
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		uint64_t w = words[i];
+		while (w)
+		{
+			w &= w - 1;
+			n++;
+		}
+	}
+	return n;
+}
+
+bool SelectionBitset::any() const
+{
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		if (words[i]) return true;
+	}
+	return false;
+}
+
+void SelectionBitset::collect(std::vector<unsigned int>& out) const
+{
+	for (size_t wi = 0; wi < words.size(); wi++)
+	{
+		uint64_t w = words[wi];
+		while (w)
+		{
+			int bit = 0;
+			while (!((w >> bit) & 1ull)) bit++;
+			out.push_back(static_cast<unsigned int>(wi * 64 + bit));
+			w &= w - 1;
+		}
+	}
+}
+
+namespace mesh_selection
+{
+	namespace
+	{
+		// 以64位字为单位并行；f(word_index)返回新的字
+		template <typename Func>
+		void for_each_word(const SelectionBitset& src, SelectionBitset& dst, Func f)
+		{
+			parallel::for_each(0, src.word_count(), [&](size_t wi)
+			{
+				dst.word(wi) = f(wi);
+			}, 64);
+		}
+
+		inline uint64_t apply_op(uint64_t old_word, uint64_t hits, Op op)
+		{
+			switch (op)
+			{
+			case Op::add: return old_word | hits;
+			case Op::subtract: return old_word & ~hits;
+			default: return hits;
+			}
+		}
+
+		template <typename Inside>
+		void select_by(size_t n, const std::vector<unsigned char>& visible, Inside inside, Op op, SelectionBitset& selection)
+		{
+			if (selection.size() != n) selection.resize(n);
+			parallel::for_each(0, selection.word_count(), [&](size_t wi)
+			{
+				uint64_t hits = 0;
+				size_t begin = wi * 64;
+				size_t end = std::min(n, begin + 64);
+				for (size_t i = begin; i < end; i++)
+				{
+					if (visible[i] && inside(i)) hits |= 1ull << (i - begin);
+				}
+				selection.word(wi) = apply_op(selection.word(wi), hits, op);
+			}, 64);
+		}
+	}
+
+	void project_vertices(const Mesh& mesh, const Eigen::Matrix4d& mvp, int width, int height,
+		std::vector<float>& screen_xy, std::vector<unsigned char>& visible)
+	{
+		size_t n = mesh.n_vertices();
+		screen_xy.resize(2 * n);
+		visible.resize(n);
+		if (n == 0) return;
+
+		// OpenMesh的顶点坐标连续存放，可以直接视为3xN矩阵
+		Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > points(mesh.points()->data(), 3, n);
+		const Eigen::Matrix<double, 4, 3> linear = mvp.topLeftCorner<4, 3>();
+		const Eigen::Vector4d translation = mvp.col(3);
+		const double half_w = 0.5 * width;
+		const double half_h = 0.5 * height;
+
+		parallel::for_each_range(0, n, [&](size_t begin, size_t end, unsigned int)
+		{
+			const size_t block = 256;
+			Eigen::Matrix<double, 4, Eigen::Dynamic> clip(4, block);
+			for (size_t b = begin; b < end; b += block)
+			{
+				size_t len = std::min(block, end - b);
+				clip.leftCols(len).noalias() = linear * points.middleCols(b, len);
+				clip.leftCols(len).colwise() += translation;
+				for (size_t k = 0; k < len; k++)
+				{
+					double w = clip(3, k);
+					size_t i = b + k;
+					visible[i] = w > 1e-12 ? 1 : 0;
+					double inv_w = w > 1e-12 ? 1.0 / w : 0.0;
+					screen_xy[2 * i] = float((clip(0, k) * inv_w + 1.0) * half_w);
+					screen_xy[2 * i + 1] = float((1.0 - clip(1, k) * inv_w) * half_h);
+				}
+			}
+		});
+	}
+
+	void select_in_rect(const std::vector<float>& screen_xy, const std::vector<unsigned char>& visible,
+		double x0, double y0, double x1, double y1, Op op, SelectionBitset& selection)
+	{
+		if (x0 > x1) std::swap(x0, x1);
+		if (y0 > y1) std::swap(y0, y1);
+		select_by(visible.size(), visible, [&](size_t i)
+		{
+			double x = screen_xy[2 * i], y = screen_xy[2 * i + 1];
+			return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+		}, op, selection);
+	}
+
+	void select_in_polygon(const std::vector<float>& screen_xy, const std::vector<unsigned char>& visible,
+		const std::vector<OpenMesh::Vec2d>& polygon, Op op, SelectionBitset& selection)
+	{
+		if (polygon.size() < 3)
+		{
+			if (op == Op::replace) selection.resize(visible.size());
+			return;
+		}
+
+		// 先用包围盒剔除，再做奇偶规则的点在多边形内测试
+		OpenMesh::Vec2d pmin = polygon[0], pmax = polygon[0];
+		for (size_t k = 1; k < polygon.size(); k++)
+		{
+			pmin.minimize(polygon[k]);
+			pmax.maximize(polygon[k]);
+		}
+
+		select_by(visible.size(), visible, [&](size_t i)
+		{
+			double x = screen_xy[2 * i], y = screen_xy[2 * i + 1];
+			if (x < pmin[0] || x > pmax[0] || y < pmin[1] || y > pmax[1]) return false;
+			bool inside = false;
+			for (size_t a = 0, b = polygon.size() - 1; a < polygon.size(); b = a++)
+			{
+				const OpenMesh::Vec2d& pa = polygon[a];
+				const OpenMesh::Vec2d& pb = polygon[b];
+				if ((pa[1] > y) != (pb[1] > y) &&
+					x < (pb[0] - pa[0]) * (y - pa[1]) / (pb[1] - pa[1]) + pa[0])
+				{
+					inside = !inside;
+				}
+			}
+			return inside;
+		}, op, selection);
+	}
+
+	void grow(const Mesh& mesh, SelectionBitset& selection, int rings)
+	{
+		size_t n = mesh.n_vertices();
+		if (selection.size() != n) selection.resize(n);
+
+		// 每一环都从上一环的快照读取，写入新集合，线程之间没有数据竞争
+		SelectionBitset next(n);
+		for (int r = 0; r < rings; r++)
+		{
+			for_each_word(selection, next, [&](size_t wi)
+			{
+				uint64_t w = selection.word(wi);
+				size_t begin = wi * 64;
+				size_t end = std::min(n, begin + 64);
+				for (size_t i = begin; i < end; i++)
+				{
+					if ((w >> (i - begin)) & 1ull) continue;
+					Mesh::VertexHandle vh(int(i));
+					for (auto vv = mesh.cvv_iter(vh); vv.is_valid(); ++vv)
+					{
+						if (selection.test((*vv).idx()))
+						{
+							w |= 1ull << (i - begin);
+							break;
+						}
+					}
+				}
+				return w;
+			});
+			std::swap(selection, next);
+		}
+	}
+
+	void shrink(const Mesh& mesh, SelectionBitset& selection, int rings)
+	{
+		size_t n = mesh.n_vertices();
+		if (selection.size() != n) selection.resize(n);
+
+		SelectionBitset next(n);
+		for (int r = 0; r < rings; r++)
+		{
+			for_each_word(selection, next, [&](size_t wi)
+			{
+				uint64_t w = selection.word(wi);
+				size_t begin = wi * 64;
+				size_t end = std::min(n, begin + 64);
+				for (size_t i = begin; i < end; i++)
+				{
+					if (!((w >> (i - begin)) & 1ull)) continue;
+					Mesh::VertexHandle vh(int(i));
+					for (auto vv = mesh.cvv_iter(vh); vv.is_valid(); ++vv)
+					{
+						if (!selection.test((*vv).idx()))
+						{
+							w &= ~(1ull << (i - begin));
+							break;
+						}
+					}
+				}
+				return w;
+			});
+			std::swap(selection, next);
+		}
+	}
+
+	void faces_from_vertices(const Mesh& mesh, const SelectionBitset& vertices, SelectionBitset& faces)
+	{
+		size_t n = mesh.n_faces();
+		faces.resize(n);
+		parallel::for_each(0, faces.word_count(), [&](size_t wi)
+		{
+			uint64_t w = 0;
+			size_t begin = wi * 64;
+			size_t end = std::min(n, begin + 64);
+			for (size_t i = begin; i < end; i++)
+			{
+				Mesh::FaceHandle fh(int(i));
+				bool all = true;
+				for (auto fv = mesh.cfv_iter(fh); fv.is_valid(); ++fv)
+				{
+					if (!vertices.test((*fv).idx()))
+					{
+						all = false;
+						break;
+					}
+				}
+				if (all) w |= 1ull << (i - begin);
+			}
+			faces.word(wi) = w;
+		}, 64);
+	}
+
+	void write_to_status(Mesh& mesh, const SelectionBitset& vertices, const SelectionBitset& faces)
+	{
+		parallel::for_each(0, mesh.n_vertices(), [&](size_t i)
+		{
+			mesh.status(Mesh::VertexHandle(int(i))).set_selected(i < vertices.size() && vertices.test(i));
+		});
+		parallel::for_each(0, mesh.n_faces(), [&](size_t i)
+		{
+			mesh.status(Mesh::FaceHandle(int(i))).set_selected(i < faces.size() && faces.test(i));
+		});
+	}
+
+	void read_from_status(const Mesh& mesh, SelectionBitset& vertices, SelectionBitset& faces)
+	{
+		vertices.resize(mesh.n_vertices());
+		faces.resize(mesh.n_faces());
+		for (auto vh : mesh.vertices())
+		{
+			if (mesh.status(vh).selected()) vertices.set(vh.idx());
+		}
+		for (auto fh : mesh.faces())
+		{
+			if (mesh.status(fh).selected()) faces.set(fh.idx());
+		}
+	}
+}
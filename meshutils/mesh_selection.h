@@ -0,0 +1,68 @@
+#pragma once
+#include "my_traits.h"
+#include <cstdint>
+#include <vector>
+
+// 紧凑的选择集：每个元素1位，按64位字存放。
+// 以字为单位分块并行时，不同线程不会写同一个字。
+class SelectionBitset
+{
+public:
+	SelectionBitset() {}
+	explicit SelectionBitset(size_t n) { resize(n); }
+
+	void resize(size_t n)
+	{
+		n_bits = n;
+		words.assign((n + 63) / 64, 0ull);
+	}
+	void reset() { std::fill(words.begin(), words.end(), 0ull); }
+
+	size_t size() const { return n_bits; }
+	size_t word_count() const { return words.size(); }
+	uint64_t& word(size_t i) { return words[i]; }
+	uint64_t word(size_t i) const { return words[i]; }
+
+	bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1ull; }
+	void set(size_t i) { words[i >> 6] |= 1ull << (i & 63); }
+	void unset(size_t i) { words[i >> 6] &= ~(1ull << (i & 63)); }
+
+	size_t count() const;
+	bool any() const;
+	// 把置位元素的下标依次追加到out
+	void collect(std::vector<unsigned int>& out) const;
+
+private:
+	std::vector<uint64_t> words;
+	size_t n_bits = 0;
+};
+
+namespace mesh_selection
+{
+	enum class Op
+	{
+		replace, add, subtract
+	};
+
+	// 把所有顶点经mvp投影到屏幕像素坐标（y向下），块状矩阵乘法由Eigen向量化，分块并行。
+	// 位于近平面之后的点visible为0。
+	void project_vertices(const Mesh& mesh, const Eigen::Matrix4d& mvp, int width, int height,
+		std::vector<float>& screen_xy, std::vector<unsigned char>& visible);
+
+	// 框选/套索：按op把命中的顶点合并进selection
+	void select_in_rect(const std::vector<float>& screen_xy, const std::vector<unsigned char>& visible,
+		double x0, double y0, double x1, double y1, Op op, SelectionBitset& selection);
+	void select_in_polygon(const std::vector<float>& screen_xy, const std::vector<unsigned char>& visible,
+		const std::vector<OpenMesh::Vec2d>& polygon, Op op, SelectionBitset& selection);
+
+	// 按一环邻域扩张/收缩顶点选择，每次迭代并行
+	void grow(const Mesh& mesh, SelectionBitset& selection, int rings = 1);
+	void shrink(const Mesh& mesh, SelectionBitset& selection, int rings = 1);
+
+	// 所有顶点都被选中的面
+	void faces_from_vertices(const Mesh& mesh, const SelectionBitset& vertices, SelectionBitset& faces);
+
+	// 与OpenMesh的Status::selected位同步
+	void write_to_status(Mesh& mesh, const SelectionBitset& vertices, const SelectionBitset& faces);
+	void read_from_status(const Mesh& mesh, SelectionBitset& vertices, SelectionBitset& faces);
+}
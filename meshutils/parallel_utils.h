@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 基于std::thread的简单并行循环：把区间切成连续块，每个线程处理一块。
+// 回调里的thread_id从0开始且小于thread_count()，可用来索引每线程的局部缓冲。
+namespace parallel {
+
+inline unsigned int thread_count()
+{
+	unsigned int n = std::thread::hardware_concurrency();
+	return n == 0 ? 4 : n;
+}
+
+// f(range_begin, range_end, thread_id)
+template <typename Func>
+void for_each_range(std::size_t begin, std::size_t end, Func f, std::size_t min_grain = 4096)
+{
+	if (end <= begin) return;
+
+	std::size_t n = end - begin;
+	std::size_t n_threads = std::min<std::size_t>(thread_count(), (n + min_grain - 1) / min_grain);
+	if (n_threads <= 1)
+	{
+		f(begin, end, 0u);
+		return;
+	}
+
+	std::size_t chunk = (n + n_threads - 1) / n_threads;
+	std::vector<std::thread> workers;
+	workers.reserve(n_threads - 1);
+	for (std::size_t t = 1; t < n_threads; t++)
+	{
+		std::size_t b = begin + t * chunk;
+		std::size_t e = std::min(end, b + chunk);
+		if (b >= e) break;
+		unsigned int id = static_cast<unsigned int>(t);
+		workers.emplace_back([&f, b, e, id]() { f(b, e, id); });
+	}
+	f(begin, std::min(end, begin + chunk), 0u);
+
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+}
+
+// f(i)
+template <typename Func>
+void for_each(std::size_t begin, std::size_t end, Func f, std::size_t min_grain = 4096)
+{
+	for_each_range(begin, end, [&f](std::size_t b, std::size_t e, unsigned int)
+	{
+		for (std::size_t i = b; i < e; i++)
+		{
+			f(i);
+		}
+	}, min_grain);
+}
+
+} // namespace parallel
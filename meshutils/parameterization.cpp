@@ -0,0 +1,428 @@
+#include "parameterization.h"
+#include "mesh_analysis.h"
+#include "parallel_utils.h"
+#include <Eigen/SVD>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace parameterization
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef Mesh::HalfedgeHandle HH;
+		typedef OpenMesh::Vec3d Vec3d;
+		typedef Eigen::Triplet<double> Triplet;
+
+		const double kMaxCotangent = 1e5;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		double cross2(const Eigen::Vector2d& a, const Eigen::Vector2d& b)
+		{
+			return a.x() * b.y() - a.y() * b.x();
+		}
+
+		// 按local_index给自由变量编号，固定变量为-1，返回自由变量数
+		int number_free(size_t n, const int* fixed, int n_fixed, std::vector<int>& local_index)
+		{
+			local_index.assign(n, 0);
+			for (int k = 0; k < n_fixed; k++)
+			{
+				local_index[fixed[k]] = -1;
+			}
+			int count = 0;
+			for (size_t i = 0; i < n; i++)
+			{
+				if (local_index[i] == 0) local_index[i] = count++;
+			}
+			return count;
+		}
+	}
+
+	bool is_disk(const Mesh& mesh)
+	{
+		if (mesh.n_faces() == 0) return false;
+		for (auto fh : mesh.faces())
+		{
+			if (mesh.valence(fh) != 3) return false;
+		}
+
+		// 欧拉示性数为1不足以判定：圆盘加上一个环面分量同样满足。
+		// 要求单个连通分量、恰好一条边界环、亏格为0，且没有孤立或非流形顶点
+		mesh_analysis::Report report = mesh_analysis::analyze(mesh);
+		return report.components == 1 && report.boundary_loops == 1 && report.genus == 0
+			&& report.isolated_vertices == 0 && report.non_manifold_vertices == 0;
+	}
+
+	void write_texcoords(Mesh& mesh, const Eigen::MatrixXd& uv, bool normalize)
+	{
+		OpenMesh::MPropHandleT<std::vector<Mesh::TexCoord2D>> mvt_list;
+		OpenMesh::HPropHandleT<int> hvt_index;
+		if (!mesh.get_property_handle(mvt_list, "mvt_list")) mesh.add_property(mvt_list, "mvt_list");
+		if (!mesh.get_property_handle(hvt_index, "hvt_index")) mesh.add_property(hvt_index, "hvt_index");
+
+		Eigen::Vector2d lo(0.0, 0.0);
+		double scale = 1.0;
+		if (normalize && uv.rows() > 0)
+		{
+			lo = uv.colwise().minCoeff().transpose();
+			double extent = (uv.colwise().maxCoeff().transpose() - lo).maxCoeff();
+			if (extent > 0.0) scale = 1.0 / extent;
+		}
+
+		std::vector<Mesh::TexCoord2D>& list = mesh.property(mvt_list);
+		list.resize(size_t(uv.rows()));
+		parallel::for_each(0, list.size(), [&](size_t i)
+		{
+			list[i] = Mesh::TexCoord2D((uv(i, 0) - lo.x()) * scale, (uv(i, 1) - lo.y()) * scale);
+		});
+		for (auto fh : mesh.faces())
+		{
+			for (auto fh_h : mesh.fh_range(fh))
+			{
+				mesh.property(hvt_index, fh_h) = mesh.to_vertex_handle(fh_h).idx();
+			}
+		}
+	}
+
+	void Parameterizer::topology_changed()
+	{
+		has_topology = false;
+		has_geometry = false;
+		lscm_analyzed = false;
+		lscm_factorized = false;
+		arap_analyzed = false;
+		arap_factorized = false;
+	}
+
+	void Parameterizer::geometry_changed()
+	{
+		has_geometry = false;
+		lscm_factorized = false;
+		arap_factorized = false;
+	}
+
+	bool Parameterizer::compute(Mesh& mesh, const Options& options, Stats* stats)
+	{
+		if (stats) *stats = Stats();
+		auto start = std::chrono::steady_clock::now();
+		if (has_topology)
+		{
+			if (stats) stats->reused_topology = true;
+		}
+		else if (!prepare_topology(mesh))
+		{
+			return false;
+		}
+		if (!has_geometry) prepare_geometry(mesh);
+		if (stats) stats->setup_ms += elapsed_ms(start);
+
+		Eigen::MatrixXd uv;
+		if (!solve_lscm(uv, stats)) return false;
+		if (options.method == Method::arap && !solve_arap(mesh, uv, options.arap_iterations, stats)) return false;
+
+		if (stats)
+		{
+			std::vector<size_t> flipped(parallel::thread_count(), 0);
+			parallel::for_each_range(0, frames.size(), [&](size_t b, size_t e, unsigned int tid)
+			{
+				for (size_t f = b; f < e; f++)
+				{
+					const int* v = frames[f].v;
+					Eigen::Vector2d a = (uv.row(v[1]) - uv.row(v[0])).transpose();
+					Eigen::Vector2d c = (uv.row(v[2]) - uv.row(v[0])).transpose();
+					if (cross2(a, c) < 0.0) flipped[tid]++;
+				}
+			});
+			for (size_t count : flipped)
+			{
+				stats->flipped_faces += count;
+			}
+		}
+
+		write_texcoords(mesh, uv, options.normalize);
+		return true;
+	}
+
+	bool Parameterizer::prepare_topology(const Mesh& mesh)
+	{
+		if (!is_disk(mesh)) return false;
+		if (!laplacian::build_pattern(mesh, L)) return false;
+
+		// 边界半边本身不属于任何面，其对边的方向沿面的朝向
+		boundary_edges.clear();
+		HH start;
+		for (auto hh : mesh.halfedges())
+		{
+			if (mesh.is_boundary(hh))
+			{
+				start = hh;
+				break;
+			}
+		}
+		HH h = start;
+		do
+		{
+			boundary_edges.emplace_back(mesh.to_vertex_handle(h).idx(), mesh.from_vertex_handle(h).idx());
+			h = mesh.next_halfedge_handle(h);
+		} while (h != start);
+
+		// 固定点：一个边界顶点和离它最远的边界顶点。只在拓扑变化时选取，使分解的结构可以复用
+		VH first(boundary_edges[0].first);
+		VH farthest = first;
+		double best = -1.0;
+		for (const auto& edge : boundary_edges)
+		{
+			VH v(edge.first);
+			double d = (mesh.point(v) - mesh.point(first)).sqrnorm();
+			if (d > best)
+			{
+				best = d;
+				farthest = v;
+			}
+		}
+		pins[0] = first.idx();
+		pins[1] = farthest.idx();
+		if (pins[0] == pins[1]) return false;
+
+		int n = int(mesh.n_vertices());
+		int lscm_fixed[4] = { pins[0], pins[1], n + pins[0], n + pins[1] };
+		number_free(2 * size_t(n), lscm_fixed, 4, lscm_index);
+		number_free(size_t(n), pins, 1, arap_index);
+
+		lscm_analyzed = false;
+		arap_analyzed = false;
+		has_topology = true;
+		return true;
+	}
+
+	void Parameterizer::prepare_geometry(const Mesh& mesh)
+	{
+		laplacian::fill_values(mesh, L, mass);
+		pin_distance = (mesh.point(VH(pins[1])) - mesh.point(VH(pins[0]))).norm();
+
+		frames.resize(mesh.n_faces());
+		parallel::for_each(0, mesh.n_faces(), [&](size_t f)
+		{
+			FaceFrame& frame = frames[f];
+			Vec3d p[3];
+			int k = 0;
+			for (auto fv : mesh.cfv_range(Mesh::FaceHandle(int(f))))
+			{
+				frame.v[k] = fv.idx();
+				p[k] = mesh.point(fv);
+				k++;
+			}
+
+			Vec3d e1 = p[1] - p[0], e2 = p[2] - p[0];
+			double len = std::max(e1.norm(), 1e-300);
+			frame.x[0] = Eigen::Vector2d(0.0, 0.0);
+			frame.x[1] = Eigen::Vector2d(len, 0.0);
+			frame.x[2] = Eigen::Vector2d((e1 | e2) / len, (e1 % e2).norm() / len);
+
+			for (int c = 0; c < 3; c++)
+			{
+				Eigen::Vector2d a = frame.x[(c + 1) % 3] - frame.x[c];
+				Eigen::Vector2d b = frame.x[(c + 2) % 3] - frame.x[c];
+				double cot = a.dot(b) / std::max(std::abs(cross2(a, b)), 1e-300);
+				frame.cot[c] = std::max(-kMaxCotangent, std::min(kMaxCotangent, cot));
+			}
+		});
+
+		lscm_factorized = false;
+		arap_factorized = false;
+		has_geometry = true;
+	}
+
+	// 保角能量 E_D(u,v) - A(u,v)：Dirichlet能量由余切拉普拉斯给出，参数域有向面积只依赖边界边。
+	// 二次型对称半正定，固定两点后正定，可以用LDLT
+	bool Parameterizer::solve_lscm(Eigen::MatrixXd& uv, Stats* stats)
+	{
+		int n = int(L.rows());
+		// 固定点放在(0,0)和(d,0)，d为两点的空间距离，使结果的尺度与网格一致
+		Eigen::VectorXd fixed = Eigen::VectorXd::Zero(2 * n);
+		fixed[pins[1]] = pin_distance;
+
+		bool reused = lscm_factorized;
+		if (!lscm_factorized)
+		{
+			auto start = std::chrono::steady_clock::now();
+			int n_free = 2 * n - 4;
+			std::vector<Triplet> triplets;
+			triplets.reserve(size_t(2 * L.nonZeros()) + 4 * boundary_edges.size());
+			lscm_rhs.setZero(n_free);
+			auto add = [&](int row, int col, double value)
+			{
+				int r = lscm_index[row];
+				if (r < 0) return;
+				int c = lscm_index[col];
+				if (c >= 0) triplets.emplace_back(r, c, value);
+				else lscm_rhs[r] -= value * fixed[col];
+			};
+
+			for (int j = 0; j < n; j++)
+			{
+				for (laplacian::SparseMatrix::InnerIterator it(L, j); it; ++it)
+				{
+					int i = int(it.row());
+					add(i, j, -it.value());
+					add(n + i, n + j, -it.value());
+				}
+			}
+			// A = Σ (u_a v_b - u_b v_a) / 2，写成对称形式
+			for (const auto& edge : boundary_edges)
+			{
+				int a = edge.first, b = edge.second;
+				add(a, n + b, -0.5);
+				add(n + b, a, -0.5);
+				add(b, n + a, 0.5);
+				add(n + a, b, 0.5);
+			}
+
+			laplacian::SparseMatrix Q(n_free, n_free);
+			Q.setFromTriplets(triplets.begin(), triplets.end());
+			if (stats) stats->setup_ms += elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			if (!lscm_analyzed)
+			{
+				lscm_solver.analyzePattern(Q);
+				lscm_analyzed = true;
+			}
+			lscm_solver.factorize(Q);
+			if (stats) stats->factorize_ms += elapsed_ms(start);
+			if (lscm_solver.info() != Eigen::Success) return false;
+			lscm_factorized = true;
+		}
+		if (stats) stats->reused_factorization = reused;
+
+		auto start = std::chrono::steady_clock::now();
+		Eigen::VectorXd x = lscm_solver.solve(lscm_rhs);
+		if (stats) stats->solve_ms += elapsed_ms(start);
+		if (lscm_solver.info() != Eigen::Success) return false;
+
+		uv.resize(n, 2);
+		parallel::for_each(0, 2 * size_t(n), [&](size_t i)
+		{
+			int l = lscm_index[i];
+			uv(Eigen::Index(i) % n, Eigen::Index(i) / n) = l >= 0 ? x[l] : fixed[Eigen::Index(i)];
+		});
+		return true;
+	}
+
+	// 局部步：每个三角形取最接近当前雅可比的旋转R_t；
+	// 全局步：Σ_j (cot α + cot β)(u_i - u_j) = Σ_t cot θ R_t (x_i - x_j)，即 -L u = b，矩阵在迭代间不变
+	bool Parameterizer::solve_arap(const Mesh& mesh, Eigen::MatrixXd& uv, int iterations, Stats* stats)
+	{
+		size_t n = size_t(L.rows());
+		int n_free = int(n) - 1;
+
+		bool reused = arap_factorized;
+		if (!arap_factorized)
+		{
+			auto start = std::chrono::steady_clock::now();
+			std::vector<Triplet> triplets;
+			triplets.reserve(size_t(L.nonZeros()));
+			for (int j = 0; j < int(n); j++)
+			{
+				int c = arap_index[j];
+				if (c < 0) continue;
+				for (laplacian::SparseMatrix::InnerIterator it(L, j); it; ++it)
+				{
+					int r = arap_index[it.row()];
+					if (r >= 0) triplets.emplace_back(r, c, -it.value());
+				}
+			}
+			laplacian::SparseMatrix A(n_free, n_free);
+			A.setFromTriplets(triplets.begin(), triplets.end());
+			if (stats) stats->setup_ms += elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			if (!arap_analyzed)
+			{
+				arap_solver.analyzePattern(A);
+				arap_analyzed = true;
+			}
+			arap_solver.factorize(A);
+			if (stats) stats->factorize_ms += elapsed_ms(start);
+			if (arap_solver.info() != Eigen::Success) return false;
+			arap_factorized = true;
+		}
+		if (stats) stats->reused_factorization = stats->reused_factorization && reused;
+
+		std::vector<Eigen::Vector2d> corner_rhs(3 * frames.size());
+		Eigen::MatrixXd b(n_free, 2);
+		for (int iter = 0; iter < iterations; iter++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			parallel::for_each(0, frames.size(), [&](size_t f)
+			{
+				const FaceFrame& frame = frames[f];
+				Eigen::Matrix2d J = Eigen::Matrix2d::Zero();
+				for (int c = 0; c < 3; c++)
+				{
+					int i = (c + 1) % 3, j = (c + 2) % 3;
+					Eigen::Vector2d du = (uv.row(frame.v[i]) - uv.row(frame.v[j])).transpose();
+					J += frame.cot[c] * du * (frame.x[i] - frame.x[j]).transpose();
+				}
+				Eigen::JacobiSVD<Eigen::Matrix2d> svd(J, Eigen::ComputeFullU | Eigen::ComputeFullV);
+				Eigen::Matrix2d U = svd.matrixU();
+				Eigen::Matrix2d R = U * svd.matrixV().transpose();
+				if (R.determinant() < 0.0)
+				{
+					U.col(1) = -U.col(1);
+					R = U * svd.matrixV().transpose();
+				}
+				// 角c的两条边(c,j)、(c,k)分别以对角k、j的余切为权；-L的权是余切和的一半
+				for (int c = 0; c < 3; c++)
+				{
+					int j = (c + 1) % 3, k = (c + 2) % 3;
+					corner_rhs[3 * f + c] = 0.5 * R * (frame.cot[k] * (frame.x[c] - frame.x[j])
+						+ frame.cot[j] * (frame.x[c] - frame.x[k]));
+				}
+			}, 1024);
+
+			parallel::for_each(0, n, [&](size_t v)
+			{
+				int r = arap_index[v];
+				if (r < 0) return;
+				Eigen::Vector2d sum(0.0, 0.0);
+				for (auto vf : mesh.cvf_range(VH(int(v))))
+				{
+					const int* corners = frames[vf.idx()].v;
+					int c = corners[0] == int(v) ? 0 : (corners[1] == int(v) ? 1 : 2);
+					sum += corner_rhs[3 * size_t(vf.idx()) + c];
+				}
+				b.row(r) = sum.transpose();
+			});
+			// 固定顶点移到右端：b -= (-L)_fc u_c
+			for (laplacian::SparseMatrix::InnerIterator it(L, pins[0]); it; ++it)
+			{
+				int r = arap_index[it.row()];
+				if (r >= 0) b.row(r) += it.value() * uv.row(pins[0]);
+			}
+			if (stats) stats->local_ms += elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			Eigen::MatrixXd x = arap_solver.solve(b);
+			if (arap_solver.info() != Eigen::Success) return false;
+			parallel::for_each(0, n, [&](size_t v)
+			{
+				int r = arap_index[v];
+				if (r >= 0) uv.row(v) = x.row(r);
+			});
+			if (stats)
+			{
+				stats->solve_ms += elapsed_ms(start);
+				stats->arap_iterations++;
+			}
+		}
+		return true;
+	}
+}
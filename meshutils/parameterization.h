@@ -0,0 +1,90 @@
+#pragma once
+#include "my_traits.h"
+#include "laplacian.h"
+#include <Eigen/Sparse>
+#include <utility>
+#include <vector>
+
+// 圆盘拓扑三角网格的参数化：LSCM（最小二乘保角，Lévy 2002）和ARAP（Liu 2008）。
+// 结果写入load_obj/save_obj使用的mvt_list和hvt_index属性，每个顶点一个纹理坐标，没有接缝。
+namespace parameterization
+{
+	enum class Method
+	{
+		lscm,   // 固定两个边界顶点，一次线性求解
+		arap    // 以LSCM为初值，局部（逐面并行求最近旋转）/全局（余切拉普拉斯）交替迭代
+	};
+
+	struct Options
+	{
+		Method method = Method::lscm;
+		int arap_iterations = 10;
+		bool normalize = true;   // 等比缩放平移到[0,1]²
+	};
+
+	struct Stats
+	{
+		double setup_ms = 0.0;       // 拓扑检查、局部坐标和拉普拉斯矩阵
+		double factorize_ms = 0.0;
+		double solve_ms = 0.0;       // LSCM求解和ARAP全局步
+		double local_ms = 0.0;       // ARAP局部步与右端项装配
+		bool reused_topology = false;
+		bool reused_factorization = false;
+		int arap_iterations = 0;
+		size_t flipped_faces = 0;    // 参数域中朝向翻转的三角形
+	};
+
+	// 三角形、连通、恰好一条边界环、亏格为0，且没有孤立或非流形顶点
+	bool is_disk(const Mesh& mesh);
+
+	// 把每个顶点的纹理坐标（uv为n×2）写入mvt_list，hvt_index指向角点所在顶点；属性不存在时添加
+	void write_texcoords(Mesh& mesh, const Eigen::MatrixXd& uv, bool normalize);
+
+	// 在多次参数化之间缓存：拓扑不变时复用边界环、固定点和分解的符号部分，
+	// 几何不变时复用LSCM和ARAP的数值分解。外部修改网格后调用topology_changed()或geometry_changed()
+	class Parameterizer
+	{
+	public:
+		void topology_changed();
+		void geometry_changed();
+
+		bool compute(Mesh& mesh, const Options& options, Stats* stats = nullptr);
+
+	private:
+		// 三角形在自身平面内的等距二维坐标，cot[k]为角k的余切（即对边的权）
+		struct FaceFrame
+		{
+			int v[3];
+			Eigen::Vector2d x[3];
+			double cot[3];
+		};
+
+		bool prepare_topology(const Mesh& mesh);
+		void prepare_geometry(const Mesh& mesh);
+		bool solve_lscm(Eigen::MatrixXd& uv, Stats* stats);
+		bool solve_arap(const Mesh& mesh, Eigen::MatrixXd& uv, int iterations, Stats* stats);
+
+		bool has_topology = false;
+		bool has_geometry = false;
+
+		std::vector<std::pair<int, int> > boundary_edges;   // 边界边(a,b)，a->b为面一侧的方向（逆时针）
+		int pins[2] = { -1, -1 };
+		double pin_distance = 0.0;
+		laplacian::SparseMatrix L;
+		Eigen::VectorXd mass;
+		std::vector<FaceFrame> frames;
+
+		// LSCM：未知量为[u; v]，去掉两个固定顶点的四个分量
+		std::vector<int> lscm_index;
+		Eigen::VectorXd lscm_rhs;
+		bool lscm_analyzed = false;
+		bool lscm_factorized = false;
+		Eigen::SimplicialLDLT<laplacian::SparseMatrix> lscm_solver;
+
+		// ARAP全局步：-L x = b，固定pins[0]消去平移
+		std::vector<int> arap_index;
+		bool arap_analyzed = false;
+		bool arap_factorized = false;
+		Eigen::SimplicialLDLT<laplacian::SparseMatrix> arap_solver;
+	};
+}
@@ -0,0 +1,702 @@
+#include "point_cloud.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace point_cloud
+{
+	namespace
+	{
+		// 每次读入的字节数；块尾被截断的行留到下一块
+		const size_t kBlockSize = size_t(64) << 20;
+		// 每段至少这么多字节才多开一个线程
+		const size_t kMinSegment = size_t(1) << 20;
+
+		const double kPow10[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		std::string lower_extension(const std::string& path)
+		{
+			size_t dot = path.find_last_of('.');
+			size_t slash = path.find_last_of("/\\");
+			if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return std::string();
+			std::string ext = path.substr(dot + 1);
+			for (char& c : ext)
+			{
+				c = char(std::tolower((unsigned char)c));
+			}
+			return ext;
+		}
+
+		inline bool is_blank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		inline const char* skip_blanks(const char* s, const char* end)
+		{
+			while (s < end && is_blank(*s)) s++;
+			return s;
+		}
+
+		inline const char* line_end(const char* s, const char* end)
+		{
+			const char* eol = static_cast<const char*>(std::memchr(s, '\n', size_t(end - s)));
+			return eol ? eol : end;
+		}
+
+		// 十进制浮点数，不依赖locale，比strtod快得多。尾数超过19位时多余的位只调整指数，
+		// 结果与正确舍入最多差一两个ulp，对float存放的坐标没有影响。失败时返回nullptr
+		const char* parse_number(const char* s, const char* end, double& value)
+		{
+			s = skip_blanks(s, end);
+			bool negative = false;
+			if (s < end && (*s == '-' || *s == '+'))
+			{
+				negative = *s == '-';
+				s++;
+			}
+			uint64_t mantissa = 0;
+			int digits = 0;
+			int exponent = 0;
+			bool any = false;
+			for (; s < end && *s >= '0' && *s <= '9'; s++)
+			{
+				any = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + uint64_t(*s - '0');
+					if (mantissa != 0) digits++;
+				}
+				else
+				{
+					exponent++;
+				}
+			}
+			if (s < end && *s == '.')
+			{
+				for (s++; s < end && *s >= '0' && *s <= '9'; s++)
+				{
+					any = true;
+					if (digits < 19)
+					{
+						mantissa = mantissa * 10 + uint64_t(*s - '0');
+						if (mantissa != 0) digits++;
+						exponent--;
+					}
+				}
+			}
+			if (!any) return nullptr;
+			if (s < end && (*s == 'e' || *s == 'E'))
+			{
+				const char* e = s + 1;
+				bool exp_negative = false;
+				if (e < end && (*e == '-' || *e == '+'))
+				{
+					exp_negative = *e == '-';
+					e++;
+				}
+				if (e < end && *e >= '0' && *e <= '9')
+				{
+					int exp_value = 0;
+					for (; e < end && *e >= '0' && *e <= '9'; e++)
+					{
+						if (exp_value < 10000) exp_value = exp_value * 10 + (*e - '0');
+					}
+					exponent += exp_negative ? -exp_value : exp_value;
+					s = e;
+				}
+			}
+
+			double v = double(mantissa);
+			if (exponent > 0)
+			{
+				v = exponent <= 22 ? v * kPow10[exponent] : v * std::pow(10.0, exponent);
+			}
+			else if (exponent < 0)
+			{
+				v = exponent >= -22 ? v / kPow10[-exponent] : v * std::pow(10.0, exponent);
+			}
+			value = negative ? -v : v;
+			return s;
+		}
+
+		// 一行里最多max_count个数，返回读到的个数
+		int parse_numbers(const char* s, const char* end, double* values, int max_count)
+		{
+			int n = 0;
+			while (n < max_count)
+			{
+				const char* next = parse_number(s, end, values[n]);
+				if (!next) break;
+				s = next;
+				n++;
+			}
+			return n;
+		}
+
+		inline uint8_t color_byte(double v)
+		{
+			return uint8_t(std::min(255.0, std::max(0.0, v)) + 0.5);
+		}
+
+		// 一段文本的解析结果，按段的顺序合并
+		struct Segment
+		{
+			std::vector<float> positions;
+			std::vector<float> normals;
+			std::vector<uint8_t> colors;   // 每个点都有，没有颜色的点为白色
+			bool colored = false;
+		};
+
+		// 逐块读入文本，把完整的行交给process(begin, end)；process返回false时停止
+		template <typename Process>
+		void for_each_text_block(std::istream& in, Process process)
+		{
+			std::vector<char> buffer(kBlockSize);
+			size_t carry = 0;
+			for (;;)
+			{
+				if (buffer.size() < carry + kBlockSize) buffer.resize(carry + kBlockSize);
+				in.read(buffer.data() + carry, std::streamsize(kBlockSize));
+				size_t len = carry + size_t(in.gcount());
+				bool last = !in;
+				size_t cut = len;
+				if (!last)
+				{
+					while (cut > 0 && buffer[cut - 1] != '\n') cut--;
+					// 整块没有换行时只能硬切
+					if (cut == 0) cut = len;
+				}
+				if (cut > 0 && !process(buffer.data(), buffer.data() + cut)) return;
+				if (last) return;
+				carry = len - cut;
+				std::memmove(buffer.data(), buffer.data() + cut, carry);
+			}
+		}
+
+		// 把[begin, end)在行边界处切成若干段并行解析
+		template <typename Parse>
+		void parse_segments(const char* begin, const char* end, std::vector<Segment>& segments, Parse parse)
+		{
+			size_t len = size_t(end - begin);
+			size_t count = std::max<size_t>(1, std::min<size_t>(parallel::thread_count(), len / kMinSegment));
+			std::vector<const char*> cuts(count + 1);
+			cuts[0] = begin;
+			cuts[count] = end;
+			for (size_t s = 1; s < count; s++)
+			{
+				const char* p = std::max(begin + len * s / count, cuts[s - 1]);
+				const char* eol = line_end(p, end);
+				cuts[s] = eol < end ? eol + 1 : end;
+			}
+			segments.assign(count, Segment());
+			parallel::for_each(0, count, [&](size_t s)
+			{
+				parse(cuts[s], cuts[s + 1], segments[s]);
+			}, 1);
+		}
+
+		void append(std::vector<Segment>& segments, Cloud& cloud, bool& colored)
+		{
+			for (Segment& seg : segments)
+			{
+				cloud.positions.insert(cloud.positions.end(), seg.positions.begin(), seg.positions.end());
+				cloud.normals.insert(cloud.normals.end(), seg.normals.begin(), seg.normals.end());
+				cloud.colors.insert(cloud.colors.end(), seg.colors.begin(), seg.colors.end());
+				colored = colored || seg.colored;
+				seg = Segment();
+			}
+		}
+
+		// 第一条v行的坐标作为origin
+		bool find_obj_origin(const char* p, const char* end, double origin[3])
+		{
+			while (p < end)
+			{
+				const char* eol = line_end(p, end);
+				const char* s = skip_blanks(p, eol);
+				if (eol - s >= 2 && s[0] == 'v' && is_blank(s[1]) && parse_numbers(s + 1, eol, origin, 3) == 3) return true;
+				p = eol + 1;
+			}
+			return false;
+		}
+
+		void parse_obj_segment(const char* p, const char* end, const double origin[3], Segment& seg)
+		{
+			double v[6];
+			while (p < end)
+			{
+				const char* eol = line_end(p, end);
+				const char* s = skip_blanks(p, eol);
+				if (eol - s >= 2 && s[0] == 'v' && is_blank(s[1]))
+				{
+					int n = parse_numbers(s + 1, eol, v, 6);
+					if (n >= 3)
+					{
+						for (int a = 0; a < 3; a++)
+						{
+							seg.positions.push_back(float(v[a] - origin[a]));
+						}
+						uint8_t rgba[4] = { 255, 255, 255, 255 };
+						if (n == 6)
+						{
+							double scale = (v[3] <= 1.0 && v[4] <= 1.0 && v[5] <= 1.0) ? 255.0 : 1.0;
+							for (int c = 0; c < 3; c++)
+							{
+								rgba[c] = color_byte(v[3 + c] * scale);
+							}
+							seg.colored = true;
+						}
+						seg.colors.insert(seg.colors.end(), rgba, rgba + 4);
+					}
+				}
+				else if (eol - s >= 3 && s[0] == 'v' && s[1] == 'n' && is_blank(s[2]))
+				{
+					if (parse_numbers(s + 2, eol, v, 3) == 3)
+					{
+						for (int a = 0; a < 3; a++)
+						{
+							seg.normals.push_back(float(v[a]));
+						}
+					}
+				}
+				p = eol + 1;
+			}
+		}
+
+		enum PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+		struct PlyProperty
+		{
+			std::string name;
+			PlyType type;
+			size_t offset;   // 二进制记录内的字节偏移
+		};
+
+		bool ply_type(const std::string& name, PlyType& type, size_t& size)
+		{
+			if (name == "char" || name == "int8") { type = Int8; size = 1; }
+			else if (name == "uchar" || name == "uint8") { type = UInt8; size = 1; }
+			else if (name == "short" || name == "int16") { type = Int16; size = 2; }
+			else if (name == "ushort" || name == "uint16") { type = UInt16; size = 2; }
+			else if (name == "int" || name == "int32") { type = Int32; size = 4; }
+			else if (name == "uint" || name == "uint32") { type = UInt32; size = 4; }
+			else if (name == "float" || name == "float32") { type = Float32; size = 4; }
+			else if (name == "double" || name == "float64") { type = Float64; size = 8; }
+			else return false;
+			return true;
+		}
+
+		// 假定主机为小端
+		template <typename T>
+		inline double load_as_double(const char* p)
+		{
+			T v;
+			std::memcpy(&v, p, sizeof(T));
+			return double(v);
+		}
+
+		double read_binary(const char* p, PlyType type)
+		{
+			switch (type)
+			{
+			case Int8: return load_as_double<int8_t>(p);
+			case UInt8: return load_as_double<uint8_t>(p);
+			case Int16: return load_as_double<int16_t>(p);
+			case UInt16: return load_as_double<uint16_t>(p);
+			case Int32: return load_as_double<int32_t>(p);
+			case UInt32: return load_as_double<uint32_t>(p);
+			case Float32: return load_as_double<float>(p);
+			default: return load_as_double<double>(p);
+			}
+		}
+
+		// vertex元素中用到的属性在属性列表里的下标，-1为没有
+		struct PlyLayout
+		{
+			std::vector<PlyProperty> properties;
+			size_t stride = 0;
+			int position[3] = { -1, -1, -1 };
+			int normal[3] = { -1, -1, -1 };
+			int color[4] = { -1, -1, -1, -1 };
+
+			bool has_normals() const { return normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0; }
+			bool has_colors() const { return color[0] >= 0 && color[1] >= 0 && color[2] >= 0; }
+
+			void resolve()
+			{
+				const char* names[10] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha" };
+				int* slots[10] = { &position[0], &position[1], &position[2], &normal[0], &normal[1], &normal[2],
+					&color[0], &color[1], &color[2], &color[3] };
+				for (size_t i = 0; i < properties.size(); i++)
+				{
+					std::string name = properties[i].name;
+					if (name.compare(0, 8, "diffuse_") == 0) name = name.substr(8);
+					for (int k = 0; k < 10; k++)
+					{
+						if (name == names[k]) *slots[k] = int(i);
+					}
+				}
+			}
+
+			// values为按属性顺序的一个点的值
+			void store(const double* values, const double origin[3], float* p, float* n, uint8_t* c) const
+			{
+				for (int a = 0; a < 3; a++)
+				{
+					p[a] = float(values[position[a]] - origin[a]);
+				}
+				if (n)
+				{
+					for (int a = 0; a < 3; a++)
+					{
+						n[a] = float(values[normal[a]]);
+					}
+				}
+				if (c)
+				{
+					for (int k = 0; k < 4; k++)
+					{
+						if (color[k] < 0)
+						{
+							c[k] = 255;
+							continue;
+						}
+						PlyType type = properties[color[k]].type;
+						double scale = (type == Float32 || type == Float64) ? 255.0 : (type == UInt16 ? 1.0 / 257.0 : 1.0);
+						c[k] = color_byte(values[color[k]] * scale);
+					}
+				}
+			}
+		};
+
+		bool read_ply_binary(std::istream& in, const PlyLayout& layout, size_t count, Cloud& cloud)
+		{
+			bool normals = layout.has_normals();
+			bool colors = layout.has_colors();
+			cloud.positions.resize(3 * count);
+			if (normals) cloud.normals.resize(3 * count);
+			if (colors) cloud.colors.resize(4 * count);
+
+			size_t records = std::max<size_t>(1, kBlockSize / layout.stride);
+			std::vector<char> buffer(records * layout.stride);
+			size_t nprops = layout.properties.size();
+			for (size_t b = 0; b < count; b += records)
+			{
+				size_t n = std::min(records, count - b);
+				in.read(buffer.data(), std::streamsize(n * layout.stride));
+				if (size_t(in.gcount()) != n * layout.stride) return false;
+				if (b == 0)
+				{
+					for (int a = 0; a < 3; a++)
+					{
+						const PlyProperty& prop = layout.properties[layout.position[a]];
+						cloud.origin[a] = read_binary(buffer.data() + prop.offset, prop.type);
+					}
+				}
+				parallel::for_each_range(0, n, [&](size_t rb, size_t re, unsigned int)
+				{
+					std::vector<double> values(nprops);
+					for (size_t r = rb; r < re; r++)
+					{
+						const char* record = buffer.data() + r * layout.stride;
+						for (size_t k = 0; k < nprops; k++)
+						{
+							values[k] = read_binary(record + layout.properties[k].offset, layout.properties[k].type);
+						}
+						size_t i = b + r;
+						layout.store(values.data(), cloud.origin, &cloud.positions[3 * i],
+							normals ? &cloud.normals[3 * i] : nullptr, colors ? &cloud.colors[4 * i] : nullptr);
+					}
+				});
+			}
+			return true;
+		}
+
+		bool read_ply_ascii(std::istream& in, const PlyLayout& layout, size_t count, Cloud& cloud)
+		{
+			bool normals = layout.has_normals();
+			bool colors = layout.has_colors();
+			int nprops = int(layout.properties.size());
+			bool has_origin = false;
+			bool colored = false;
+			std::vector<Segment> segments;
+			// vertex之后的元素（面等）也是数字行，读够count个点就停止
+			for_each_text_block(in, [&](const char* begin, const char* end)
+			{
+				if (!has_origin)
+				{
+					std::vector<double> values(nprops);
+					for (const char* p = begin; p < end && !has_origin; )
+					{
+						const char* eol = line_end(p, end);
+						if (parse_numbers(p, eol, values.data(), nprops) == nprops)
+						{
+							for (int a = 0; a < 3; a++)
+							{
+								cloud.origin[a] = values[layout.position[a]];
+							}
+							has_origin = true;
+						}
+						p = eol + 1;
+					}
+					if (!has_origin) return true;
+				}
+				parse_segments(begin, end, segments, [&](const char* p, const char* e, Segment& seg)
+				{
+					std::vector<double> values(nprops);
+					while (p < e)
+					{
+						const char* eol = line_end(p, e);
+						if (parse_numbers(p, eol, values.data(), nprops) == nprops)
+						{
+							size_t i = seg.positions.size();
+							seg.positions.resize(i + 3);
+							if (normals) seg.normals.resize(i + 3);
+							if (colors) seg.colors.resize(i / 3 * 4 + 4);
+							layout.store(values.data(), cloud.origin, &seg.positions[i],
+								normals ? &seg.normals[i] : nullptr, colors ? &seg.colors[i / 3 * 4] : nullptr);
+						}
+						p = eol + 1;
+					}
+				});
+				append(segments, cloud, colored);
+				return cloud.size() < count;
+			});
+			if (cloud.size() < count) return false;
+			cloud.positions.resize(3 * count);
+			if (normals) cloud.normals.resize(3 * count);
+			if (colors) cloud.colors.resize(4 * count);
+			return true;
+		}
+	}
+
+	void Cloud::clear()
+	{
+		origin[0] = origin[1] = origin[2] = 0.0;
+		std::vector<float>().swap(positions);
+		std::vector<float>().swap(normals);
+		std::vector<uint8_t>().swap(colors);
+	}
+
+	bool obj_is_point_cloud(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+		bool vertices = false;
+		bool faces = false;
+		for_each_text_block(file, [&](const char* begin, const char* end)
+		{
+			for (const char* p = begin; p < end; )
+			{
+				const char* eol = line_end(p, end);
+				const char* s = skip_blanks(p, eol);
+				if (eol - s >= 2 && is_blank(s[1]))
+				{
+					if (s[0] == 'f')
+					{
+						faces = true;
+						return false;
+					}
+					if (s[0] == 'v') vertices = true;
+				}
+				p = eol + 1;
+			}
+			return true;
+		});
+		return vertices && !faces;
+	}
+
+	bool is_point_cloud_file(const std::string& path)
+	{
+		std::string ext = lower_extension(path);
+		if (ext == "ply") return true;
+		if (ext == "obj") return obj_is_point_cloud(path);
+		return false;
+	}
+
+	bool read_obj(const std::string& path, Cloud& cloud)
+	{
+		cloud.clear();
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		bool has_origin = false;
+		bool colored = false;
+		std::vector<Segment> segments;
+		for_each_text_block(file, [&](const char* begin, const char* end)
+		{
+			if (!has_origin) has_origin = find_obj_origin(begin, end, cloud.origin);
+			if (!has_origin) return true;
+			parse_segments(begin, end, segments, [&](const char* p, const char* e, Segment& seg)
+			{
+				parse_obj_segment(p, e, cloud.origin, seg);
+			});
+			append(segments, cloud, colored);
+			return true;
+		});
+
+		if (cloud.normals.size() != cloud.positions.size()) std::vector<float>().swap(cloud.normals);
+		if (!colored) std::vector<uint8_t>().swap(cloud.colors);
+		return cloud.size() > 0;
+	}
+
+	bool read_ply(const std::string& path, Cloud& cloud)
+	{
+		cloud.clear();
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		std::string line;
+		std::getline(file, line);
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line != "ply") return false;
+
+		int format = -1;   // 0为ascii，1为binary_little_endian
+		size_t count = 0;
+		bool in_vertex = false;
+		bool vertex_first = false;
+		bool seen_element = false;
+		PlyLayout layout;
+		while (std::getline(file, line))
+		{
+			std::istringstream iss(line);
+			std::string word;
+			iss >> word;
+			if (word == "format")
+			{
+				std::string name;
+				iss >> name;
+				if (name == "ascii") format = 0;
+				else if (name == "binary_little_endian") format = 1;
+				else return false;
+			}
+			else if (word == "element")
+			{
+				std::string name;
+				size_t n = 0;
+				iss >> name >> n;
+				in_vertex = name == "vertex";
+				if (!seen_element) vertex_first = in_vertex;
+				seen_element = true;
+				if (in_vertex) count = n;
+			}
+			else if (word == "property" && in_vertex)
+			{
+				std::string type_name, name;
+				iss >> type_name >> name;
+				PlyProperty prop;
+				size_t size = 0;
+				if (!ply_type(type_name, prop.type, size)) return false;
+				prop.name = name;
+				prop.offset = layout.stride;
+				layout.properties.push_back(prop);
+				layout.stride += size;
+			}
+			else if (word == "end_header")
+			{
+				break;
+			}
+		}
+		layout.resolve();
+		if (format < 0 || !vertex_first || count == 0 || layout.position[0] < 0
+			|| layout.position[1] < 0 || layout.position[2] < 0) return false;
+
+		bool ok = format == 1 ? read_ply_binary(file, layout, count, cloud) : read_ply_ascii(file, layout, count, cloud);
+		if (!ok) cloud.clear();
+		return ok;
+	}
+
+	bool read(const std::string& path, Cloud& cloud, double* ms)
+	{
+		auto start = std::chrono::steady_clock::now();
+		std::string ext = lower_extension(path);
+		bool ok = false;
+		if (ext == "ply") ok = read_ply(path, cloud);
+		else if (ext == "obj") ok = read_obj(path, cloud);
+		if (ms) *ms = elapsed_ms(start);
+		return ok;
+	}
+
+	bool bounds(const Cloud& cloud, float lo[3], float hi[3])
+	{
+		size_t n = cloud.size();
+		if (n == 0) return false;
+		const float* pos = cloud.positions.data();
+		// 每线程一份，最后合并
+		unsigned int threads = parallel::thread_count();
+		std::vector<float> partial(size_t(threads) * 6);
+		for (unsigned int t = 0; t < threads; t++)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				partial[t * 6 + a] = std::numeric_limits<float>::max();
+				partial[t * 6 + 3 + a] = -std::numeric_limits<float>::max();
+			}
+		}
+		parallel::for_each_range(0, n, [&](size_t b, size_t e, unsigned int tid)
+		{
+			float* l = &partial[size_t(tid) * 6];
+			float* h = l + 3;
+			for (size_t i = b; i < e; i++)
+			{
+				for (int a = 0; a < 3; a++)
+				{
+					l[a] = std::min(l[a], pos[3 * i + a]);
+					h[a] = std::max(h[a], pos[3 * i + a]);
+				}
+			}
+		});
+		for (int a = 0; a < 3; a++)
+		{
+			lo[a] = partial[a];
+			hi[a] = partial[3 + a];
+			for (unsigned int t = 1; t < threads; t++)
+			{
+				lo[a] = std::min(lo[a], partial[t * 6 + a]);
+				hi[a] = std::max(hi[a], partial[t * 6 + 3 + a]);
+			}
+		}
+		return true;
+	}
+
+	bool normalize(Cloud& cloud, double center[3], double& half_extent)
+	{
+		float lo[3], hi[3];
+		if (!bounds(cloud, lo, hi)) return false;
+		double offset[3];
+		half_extent = 0.0;
+		for (int a = 0; a < 3; a++)
+		{
+			offset[a] = 0.5 * (double(lo[a]) + double(hi[a]));
+			center[a] = cloud.origin[a] + offset[a];
+			half_extent = std::max(half_extent, 0.5 * (double(hi[a]) - double(lo[a])));
+		}
+		if (half_extent <= 0.0) half_extent = 1.0;
+		double inv = 1.0 / half_extent;
+		float* pos = cloud.positions.data();
+		parallel::for_each(0, cloud.size(), [&](size_t i)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				pos[3 * i + a] = float((double(pos[3 * i + a]) - offset[a]) * inv);
+			}
+		});
+		cloud.origin[0] = cloud.origin[1] = cloud.origin[2] = 0.0;
+		return true;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 没有面的点云（扫描数据）的读取。文件按大块读入，每块在行边界处切成若干段并行解析；
+// 坐标减去第一个点后以float存放，大地坐标之类的大数值也不会在转换时丢失精度
+namespace point_cloud
+{
+	struct Cloud
+	{
+		double origin[3] = { 0.0, 0.0, 0.0 };
+		std::vector<float> positions;       // 每点x y z，相对origin
+		std::vector<float> normals;         // 为空或与positions等长
+		std::vector<uint8_t> colors;        // 为空或每点RGBA四个字节
+
+		size_t size() const { return positions.size() / 3; }
+		bool has_normals() const { return !normals.empty(); }
+		bool has_colors() const { return !colors.empty(); }
+		void clear();
+	};
+
+	// OBJ里只有顶点、没有f行时按点云处理；遇到第一条f行即停止扫描
+	bool obj_is_point_cloud(const std::string& path);
+	// .ply总是按点云读取（面被忽略），.obj没有面时按点云读取
+	bool is_point_cloud_file(const std::string& path);
+
+	// OBJ的v行，可带顶点色（x y z r g b，三个分量都不超过1时按0~1解释，否则按0~255）；
+	// vn行数与v行数相同时按顺序作为点的法向，否则丢弃
+	bool read_obj(const std::string& path, Cloud& cloud);
+	// PLY的vertex元素（必须是第一个元素，不含list属性）：ascii或binary_little_endian，
+	// x y z及可选的nx ny nz、red green blue alpha，其余属性和元素忽略
+	bool read_ply(const std::string& path, Cloud& cloud);
+	// 按扩展名选择；ms为读取和解析的总耗时
+	bool read(const std::string& path, Cloud& cloud, double* ms = nullptr);
+
+	// positions的包围盒（不含origin），点云为空时返回false
+	bool bounds(const Cloud& cloud, float lo[3], float hi[3]);
+	// 包围盒中心移到原点、最长边缩放到2，之后origin为零。center为原包围盒中心，half_extent为最长边的一半（文件单位）
+	bool normalize(Cloud& cloud, double center[3], double& half_extent);
+}
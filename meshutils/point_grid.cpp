@@ -0,0 +1,407 @@
+#include "point_grid.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	typedef OpenMesh::Vec3d Vec3d;
+
+	// 每轴不超过2^21个格子，三个坐标装进一个64位键
+	const int kMaxAxisBits = 21;
+	// 自动格子边长：每个非空格子大约这么多个点
+	const double kPointsPerCell = 4.0;
+	const unsigned int kEmpty = ~0u;
+
+	int bits_for(int64_t n)
+	{
+		int bits = 1;
+		while ((int64_t(1) << bits) < n) bits++;
+		return bits;
+	}
+
+	inline size_t hash_slot(uint64_t key, int bits)
+	{
+		return size_t((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+	}
+
+	// 并行LSD基数排序，每趟8位；各线程先统计自己那一段的直方图，再按(数字, 线程)的顺序分配位置，
+	// 所以每一趟都是稳定的。所有键在某一位上相同时跳过这一趟
+	void radix_sort(std::vector<uint64_t>& keys, std::vector<unsigned int>& values, int key_bits)
+	{
+		size_t n = keys.size();
+		size_t chunks = std::max<size_t>(1, std::min<size_t>(parallel::thread_count(), n / 16384));
+		std::vector<size_t> bounds(chunks + 1);
+		for (size_t c = 0; c <= chunks; c++)
+		{
+			bounds[c] = n * c / chunks;
+		}
+		std::vector<uint64_t> tmp_keys(n);
+		std::vector<unsigned int> tmp_values(n);
+		std::vector<size_t> histogram(chunks * 256);
+		for (int shift = 0; shift < key_bits; shift += 8)
+		{
+			std::fill(histogram.begin(), histogram.end(), 0);
+			parallel::for_each(0, chunks, [&](size_t c)
+			{
+				size_t* h = &histogram[c * 256];
+				for (size_t i = bounds[c]; i < bounds[c + 1]; i++)
+				{
+					h[(keys[i] >> shift) & 0xFF]++;
+				}
+			}, 1);
+
+			size_t offset = 0;
+			bool trivial = false;
+			for (int d = 0; d < 256; d++)
+			{
+				size_t digit_total = 0;
+				for (size_t c = 0; c < chunks; c++)
+				{
+					size_t count = histogram[c * 256 + d];
+					histogram[c * 256 + d] = offset;
+					offset += count;
+					digit_total += count;
+				}
+				if (digit_total == n) trivial = true;
+			}
+			if (trivial) continue;
+
+			parallel::for_each(0, chunks, [&](size_t c)
+			{
+				size_t* pos = &histogram[c * 256];
+				for (size_t i = bounds[c]; i < bounds[c + 1]; i++)
+				{
+					size_t p = pos[(keys[i] >> shift) & 0xFF]++;
+					tmp_keys[p] = keys[i];
+					tmp_values[p] = values[i];
+				}
+			}, 1);
+			keys.swap(tmp_keys);
+			values.swap(tmp_values);
+		}
+	}
+
+	// 有序数组中插入(id, d2)，保持前count个按距离递增，最多k个
+	inline void insert_sorted(unsigned int id, double d2, int k, int& count, unsigned int* out_ids, double* out_dist2)
+	{
+		int i = count < k ? count++ : k - 1;
+		while (i > 0 && out_dist2[i - 1] > d2)
+		{
+			out_dist2[i] = out_dist2[i - 1];
+			out_ids[i] = out_ids[i - 1];
+			i--;
+		}
+		out_dist2[i] = d2;
+		out_ids[i] = id;
+	}
+}
+
+void PointGrid::clear()
+{
+	xs.clear();
+	ys.clear();
+	zs.clear();
+	ids.clear();
+	cell_keys.clear();
+	cell_begin.clear();
+	table.clear();
+	table_bits = 0;
+	dims[0] = dims[1] = dims[2] = 0;
+}
+
+void PointGrid::build(const Mesh& mesh, double cell_size, double min_cell_size)
+{
+	std::vector<Vec3d> points(mesh.n_vertices());
+	parallel::for_each(0, points.size(), [&](size_t v)
+	{
+		points[v] = mesh.point(Mesh::VertexHandle(int(v)));
+	});
+	build_sorted(points, cell_size, min_cell_size);
+}
+
+void PointGrid::build(const std::vector<OpenMesh::Vec3d>& points, double cell_size, double min_cell_size)
+{
+	build_sorted(points, cell_size, min_cell_size);
+}
+
+void PointGrid::build_sorted(const std::vector<OpenMesh::Vec3d>& points, double cell_size, double min_cell_size)
+{
+	clear();
+	size_t n = points.size();
+	if (n == 0) return;
+
+	lo = points[0];
+	Vec3d hi = lo;
+	for (const Vec3d& p : points)
+	{
+		lo.minimize(p);
+		hi.maximize(p);
+	}
+	Vec3d extent = hi - lo;
+	if (cell_size <= 0.0)
+	{
+		// 曲面面积约为包围盒表面积的一半
+		double area = extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0];
+		cell_size = std::sqrt(kPointsPerCell * area / double(n));
+		if (!(cell_size > 0.0)) cell_size = std::max(extent.max(), 1.0);
+		cell_size = std::max(cell_size, min_cell_size);
+	}
+	cell = std::max(cell_size, extent.max() / double((1 << kMaxAxisBits) - 1));
+	inv_cell = 1.0 / cell;
+	for (int a = 0; a < 3; a++)
+	{
+		dims[a] = std::min<int64_t>(int64_t(extent[a] * inv_cell) + 1, int64_t(1) << kMaxAxisBits);
+	}
+	shift_y = bits_for(dims[0]);
+	shift_z = shift_y + bits_for(dims[1]);
+	int key_bits = shift_z + bits_for(dims[2]);
+
+	std::vector<uint64_t> keys(n);
+	std::vector<unsigned int> order(n);
+	parallel::for_each(0, n, [&](size_t i)
+	{
+		int64_t c[3];
+		cell_coords(points[i], c);
+		for (int a = 0; a < 3; a++)
+		{
+			c[a] = std::max<int64_t>(0, std::min(c[a], dims[a] - 1));
+		}
+		keys[i] = uint64_t(c[0]) | (uint64_t(c[1]) << shift_y) | (uint64_t(c[2]) << shift_z);
+		order[i] = unsigned(i);
+	});
+	radix_sort(keys, order, key_bits);
+
+	// 同一格子内的点按原编号有序（基数排序稳定），坐标拆成SoA
+	ids.swap(order);
+	xs.resize(n);
+	ys.resize(n);
+	zs.resize(n);
+	parallel::for_each(0, n, [&](size_t i)
+	{
+		const Vec3d& p = points[ids[i]];
+		xs[i] = p[0];
+		ys[i] = p[1];
+		zs[i] = p[2];
+	});
+
+	for (size_t i = 0; i < n; i++)
+	{
+		if (i > 0 && keys[i] == keys[i - 1]) continue;
+		cell_keys.push_back(keys[i]);
+		cell_begin.push_back(unsigned(i));
+	}
+	cell_begin.push_back(unsigned(n));
+
+	// 格子数远少于点数，哈希表串行插入即可
+	table_bits = bits_for(int64_t(2 * cell_keys.size()));
+	table.assign(size_t(1) << table_bits, kEmpty);
+	size_t mask = table.size() - 1;
+	for (size_t c = 0; c < cell_keys.size(); c++)
+	{
+		size_t slot = hash_slot(cell_keys[c], table_bits);
+		while (table[slot] != kEmpty) slot = (slot + 1) & mask;
+		table[slot] = unsigned(c);
+	}
+}
+
+void PointGrid::cell_coords(const OpenMesh::Vec3d& q, int64_t* c) const
+{
+	// 远处的查询点钳制一下，避免整数溢出；网格外的坐标在find_cell里排除
+	const double limit = double(int64_t(1) << 40);
+	for (int a = 0; a < 3; a++)
+	{
+		double x = std::floor((q[a] - lo[a]) * inv_cell);
+		c[a] = int64_t(std::max(-limit, std::min(limit, x)));
+	}
+}
+
+int PointGrid::find_cell(int64_t x, int64_t y, int64_t z) const
+{
+	if (x < 0 || y < 0 || z < 0 || x >= dims[0] || y >= dims[1] || z >= dims[2]) return -1;
+	uint64_t key = uint64_t(x) | (uint64_t(y) << shift_y) | (uint64_t(z) << shift_z);
+	size_t mask = table.size() - 1;
+	for (size_t slot = hash_slot(key, table_bits); table[slot] != kEmpty; slot = (slot + 1) & mask)
+	{
+		if (cell_keys[table[slot]] == key) return int(table[slot]);
+	}
+	return -1;
+}
+
+double PointGrid::cell_box_distance2(int64_t x, int64_t y, int64_t z, const OpenMesh::Vec3d& q) const
+{
+	int64_t c[3] = { x, y, z };
+	double d2 = 0.0;
+	for (int a = 0; a < 3; a++)
+	{
+		double bmin = lo[a] + double(c[a]) * cell;
+		double d = std::max(0.0, std::max(bmin - q[a], q[a] - (bmin + cell)));
+		d2 += d * d;
+	}
+	return d2;
+}
+
+// 以查询点所在格子为中心逐层（切比雪夫距离r）向外搜索。第r层搜完后，
+// 块外的点离q至少为q到块边界的距离，第k近的点不比它远时停止。
+// k超过点数时按点数算，否则阈值一直是max_dist，会把整个网格搜一遍
+int PointGrid::knn(const OpenMesh::Vec3d& q, int k, unsigned int* out_ids, double* out_dist2, double max_dist) const
+{
+	if (k <= 0 || ids.empty()) return 0;
+	k = int(std::min<size_t>(size_t(k), ids.size()));
+	double bound = max_dist * max_dist;
+	int count = 0;
+	auto threshold = [&]()
+	{
+		return count < k ? bound : out_dist2[k - 1];
+	};
+
+	int64_t c[3];
+	cell_coords(q, c);
+	// 查询点在网格外时从最近的一层开始；搜到r_last时块已覆盖整个网格
+	int64_t r_first = 0, r_last = 0;
+	for (int a = 0; a < 3; a++)
+	{
+		if (c[a] < 0) r_first = std::max(r_first, -c[a]);
+		else if (c[a] >= dims[a]) r_first = std::max(r_first, c[a] - dims[a] + 1);
+		r_last = std::max(r_last, std::max(c[a], dims[a] - 1 - c[a]));
+	}
+
+	auto visit = [&](int64_t x, int64_t y, int64_t z)
+	{
+		int ci = find_cell(x, y, z);
+		if (ci < 0) return;
+		if (cell_box_distance2(x, y, z, q) > threshold()) return;
+		for (unsigned int i = cell_begin[ci]; i < cell_begin[ci + 1]; i++)
+		{
+			double dx = xs[i] - q[0], dy = ys[i] - q[1], dz = zs[i] - q[2];
+			double d2 = dx * dx + dy * dy + dz * dz;
+			if (count < k ? d2 <= bound : d2 < out_dist2[k - 1]) insert_sorted(ids[i], d2, k, count, out_ids, out_dist2);
+		}
+	};
+
+	for (int64_t r = r_first; r <= r_last; r++)
+	{
+		int64_t z0 = std::max<int64_t>(0, c[2] - r), z1 = std::min(dims[2] - 1, c[2] + r);
+		int64_t y0 = std::max<int64_t>(0, c[1] - r), y1 = std::min(dims[1] - 1, c[1] + r);
+		int64_t x0 = std::max<int64_t>(0, c[0] - r), x1 = std::min(dims[0] - 1, c[0] + r);
+		for (int64_t z = z0; z <= z1; z++)
+		{
+			for (int64_t y = y0; y <= y1; y++)
+			{
+				if (std::abs(z - c[2]) == r || std::abs(y - c[1]) == r)
+				{
+					for (int64_t x = x0; x <= x1; x++) visit(x, y, z);
+				}
+				else
+				{
+					// 层的内部只有x方向的两端
+					if (c[0] - r >= 0) visit(c[0] - r, y, z);
+					if (r > 0 && c[0] + r < dims[0]) visit(c[0] + r, y, z);
+				}
+			}
+		}
+		// 所有点都已找到
+		if (size_t(count) == ids.size()) break;
+
+		double reach = std::numeric_limits<double>::infinity();
+		for (int a = 0; a < 3; a++)
+		{
+			double low = lo[a] + double(c[a] - r) * cell;
+			double high = lo[a] + double(c[a] + r + 1) * cell;
+			reach = std::min(reach, std::min(q[a] - low, high - q[a]));
+		}
+		if (reach * reach >= threshold()) break;
+	}
+	return count;
+}
+
+int PointGrid::nearest(const OpenMesh::Vec3d& q, double* dist2, double max_dist) const
+{
+	unsigned int id;
+	double d2;
+	if (knn(q, 1, &id, &d2, max_dist) == 0) return -1;
+	if (dist2) *dist2 = d2;
+	return int(id);
+}
+
+void PointGrid::radius(const OpenMesh::Vec3d& q, double r, std::vector<unsigned int>& out) const
+{
+	out.clear();
+	if (ids.empty() || r < 0.0) return;
+	double r2 = r * r;
+	int64_t b[3], e[3];
+	cell_coords(q - Vec3d(r, r, r), b);
+	cell_coords(q + Vec3d(r, r, r), e);
+	for (int a = 0; a < 3; a++)
+	{
+		b[a] = std::max<int64_t>(b[a], 0);
+		e[a] = std::min(e[a], dims[a] - 1);
+		if (b[a] > e[a]) return;
+	}
+	for (int64_t z = b[2]; z <= e[2]; z++)
+	{
+		for (int64_t y = b[1]; y <= e[1]; y++)
+		{
+			for (int64_t x = b[0]; x <= e[0]; x++)
+			{
+				int ci = find_cell(x, y, z);
+				if (ci < 0 || cell_box_distance2(x, y, z, q) > r2) continue;
+				for (unsigned int i = cell_begin[ci]; i < cell_begin[ci + 1]; i++)
+				{
+					double dx = xs[i] - q[0], dy = ys[i] - q[1], dz = zs[i] - q[2];
+					if (dx * dx + dy * dy + dz * dz <= r2) out.push_back(ids[i]);
+				}
+			}
+		}
+	}
+}
+
+void PointGrid::knn_batch(const std::vector<OpenMesh::Vec3d>& queries, int k,
+	std::vector<int>& out_ids, std::vector<double>& out_dist2) const
+{
+	k = std::max(k, 0);
+	out_ids.assign(queries.size() * k, -1);
+	out_dist2.assign(queries.size() * k, std::numeric_limits<double>::infinity());
+	if (k == 0) return;
+	parallel::for_each_range(0, queries.size(), [&](size_t b, size_t e, unsigned int)
+	{
+		std::vector<unsigned int> found(k);
+		for (size_t i = b; i < e; i++)
+		{
+			int count = knn(queries[i], k, found.data(), &out_dist2[i * k]);
+			for (int j = 0; j < count; j++)
+			{
+				out_ids[i * k + j] = int(found[j]);
+			}
+		}
+	}, 256);
+}
+
+void PointGrid::radius_batch(const std::vector<OpenMesh::Vec3d>& queries, double r,
+	std::vector<unsigned int>& offsets, std::vector<unsigned int>& out_ids) const
+{
+	size_t n = queries.size();
+	offsets.assign(n + 1, 0);
+	out_ids.clear();
+	// for_each_range按线程编号顺序切分连续区间，各线程的结果按编号顺序拼接即为查询顺序
+	std::vector<std::vector<unsigned int>> local(parallel::thread_count());
+	parallel::for_each_range(0, n, [&](size_t b, size_t e, unsigned int tid)
+	{
+		std::vector<unsigned int> found;
+		for (size_t i = b; i < e; i++)
+		{
+			radius(queries[i], r, found);
+			offsets[i + 1] = unsigned(found.size());
+			local[tid].insert(local[tid].end(), found.begin(), found.end());
+		}
+	}, 256);
+	for (size_t i = 0; i < n; i++)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+	out_ids.reserve(offsets[n]);
+	for (const std::vector<unsigned int>& part : local)
+	{
+		out_ids.insert(out_ids.end(), part.begin(), part.end());
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "my_traits.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// 点的均匀网格近邻索引：点按格子键并行基数排序后连续存放，坐标按x/y/z分成三个数组（SoA），
+// 只为非空格子建开放寻址哈希表。构建后所有查询都是只读的，可以在多个线程上同时调用
+class PointGrid
+{
+public:
+	// cell_size<=0时按点数和包围盒自动选取（假设点分布在曲面上，每个非空格子约几个点），
+	// 并且不小于min_cell_size；以固定半径查询时传入半径，使每次查询最多访问27个格子
+	void build(const Mesh& mesh, double cell_size = 0.0, double min_cell_size = 0.0);
+	void build(const std::vector<OpenMesh::Vec3d>& points, double cell_size = 0.0, double min_cell_size = 0.0);
+
+	void clear();
+	bool empty() const { return ids.empty(); }
+	size_t size() const { return ids.size(); }
+	size_t cell_count() const { return cell_keys.size(); }
+	double cell_size() const { return cell; }
+
+	// 最近的k个点，按距离递增写入out_ids/out_dist2（原始点编号和距离平方），返回找到的个数；
+	// max_dist以外的点不考虑
+	int knn(const OpenMesh::Vec3d& q, int k, unsigned int* out_ids, double* out_dist2,
+		double max_dist = std::numeric_limits<double>::infinity()) const;
+	// 最近点编号，没有时为-1
+	int nearest(const OpenMesh::Vec3d& q, double* dist2 = nullptr,
+		double max_dist = std::numeric_limits<double>::infinity()) const;
+	// 距离不超过r的所有点（不排序），先清空out
+	void radius(const OpenMesh::Vec3d& q, double r, std::vector<unsigned int>& out) const;
+
+	// 批量查询，按查询分块并行。knn结果每个查询k个一组，不足k个时编号为-1、距离为无穷
+	void knn_batch(const std::vector<OpenMesh::Vec3d>& queries, int k,
+		std::vector<int>& out_ids, std::vector<double>& out_dist2) const;
+	// 半径查询结果按CSR存放：查询i的点为ids[offsets[i], offsets[i + 1])
+	void radius_batch(const std::vector<OpenMesh::Vec3d>& queries, double r,
+		std::vector<unsigned int>& offsets, std::vector<unsigned int>& out_ids) const;
+
+private:
+	void build_sorted(const std::vector<OpenMesh::Vec3d>& points, double cell_size, double min_cell_size);
+	void cell_coords(const OpenMesh::Vec3d& q, int64_t* c) const;
+	int find_cell(int64_t x, int64_t y, int64_t z) const;
+	double cell_box_distance2(int64_t x, int64_t y, int64_t z, const OpenMesh::Vec3d& q) const;
+
+	// 排序后的点：坐标和原始编号
+	std::vector<double> xs, ys, zs;
+	std::vector<unsigned int> ids;
+	// 非空格子：键（升序）和在排序后数组中的起始位置，cell_begin多一个尾元素
+	std::vector<uint64_t> cell_keys;
+	std::vector<unsigned int> cell_begin;
+	// 开放寻址哈希表，存格子下标，空位为~0u
+	std::vector<unsigned int> table;
+	int table_bits = 0;
+
+	OpenMesh::Vec3d lo;
+	double cell = 1.0;
+	double inv_cell = 1.0;
+	int64_t dims[3] = { 0, 0, 0 };
+	int shift_y = 0;
+	int shift_z = 0;
+};
@@ -0,0 +1,357 @@
+#include "point_octree.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace
+{
+	typedef PointOctree::Node Node;
+
+	// 每个坐标轴量化的位数，Morton码共63位，最多细分到第20层
+	const int kCodeBits = 21;
+	// 裁剪空间w的下限，相机在节点内部时节点的投影大小按此计算
+	const float kMinW = 1e-4f;
+
+	struct Entry
+	{
+		uint64_t code;    // Morton码，最高3位为根节点下的八分体
+		uint32_t index;   // 原始点编号
+		uint32_t key;     // 随机键，节点按它从小到大取自己的点
+	};
+
+	struct Task
+	{
+		uint32_t begin;
+		uint32_t end;
+		int node;
+		float inherited;   // 祖先节点落在这个节点内的点数（估计值）
+	};
+
+	double elapsed_ms(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// murmur3的32位finalizer
+	inline uint32_t hash32(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x85ebca6bu;
+		x ^= x >> 13;
+		x *= 0xc2b2ae35u;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// 21位整数的各位之间插入两个0
+	inline uint64_t spread_bits(uint64_t x)
+	{
+		x &= 0x1fffff;
+		x = (x | x << 32) & 0x1f00000000ffffull;
+		x = (x | x << 16) & 0x1f0000ff0000ffull;
+		x = (x | x << 8) & 0x100f00f00f00f00full;
+		x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+		x = (x | x << 2) & 0x1249249249249249ull;
+		return x;
+	}
+
+	// 深度为depth的节点里，点所在的子节点（bit0为x，bit1为y，bit2为z）
+	inline int octant(uint64_t code, int depth)
+	{
+		return int((code >> (3 * (kCodeBits - 1 - depth))) & 7);
+	}
+
+	bool key_less(const Entry& a, const Entry& b)
+	{
+		return a.key < b.key;
+	}
+
+	// 处理一个节点：取自己的点，其余点按八分体原地分桶（American flag sort）。
+	// 自己的点占据的细分格子数乘格子面积作为表面积估计；画到这个节点时祖先的点也在，
+	// 平均点间距按自己和祖先的点数合计计算
+	void split(std::vector<Entry>& entries, const Task& task, Node& node, int max_depth, unsigned int capacity,
+		uint32_t child_begin[8], uint32_t child_end[8], float child_inherited[8])
+	{
+		Entry* e = entries.data() + task.begin;
+		uint32_t n = task.end - task.begin;
+		bool leaf = n <= capacity || node.depth >= max_depth;
+		uint32_t own = leaf ? n : capacity;
+		if (!leaf) std::nth_element(e, e + own, e + n, key_less);
+		std::sort(e, e + own, key_less);
+
+		int levels = std::min(3, kCodeBits - node.depth);
+		uint64_t occupied[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		uint32_t own_in_child[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		for (uint32_t i = 0; i < own; i++)
+		{
+			own_in_child[octant(e[i].code, node.depth)]++;
+			unsigned int cell = 0;
+			for (int l = 0; l < levels; l++)
+			{
+				cell = (cell << 3) | unsigned(octant(e[i].code, node.depth + l));
+			}
+			occupied[cell >> 6] |= uint64_t(1) << (cell & 63);
+		}
+		int cells = 0;
+		for (int k = 0; k < 8; k++)
+		{
+			for (uint64_t bits = occupied[k]; bits; bits &= bits - 1) cells++;
+		}
+		double side = 2.0 * node.half / double(1 << levels);
+		node.spacing = float(std::sqrt(cells * side * side / (own + task.inherited)));
+		node.begin = task.begin;
+		node.count = own;
+		node.subtree_end = task.end;
+
+		for (int o = 0; o < 8; o++)
+		{
+			child_begin[o] = child_end[o] = task.end;
+		}
+		if (leaf) return;
+
+		uint32_t counts[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		for (uint32_t i = own; i < n; i++)
+		{
+			counts[octant(e[i].code, node.depth)]++;
+		}
+		uint32_t head[8], tail[8];
+		uint32_t offset = own;
+		for (int o = 0; o < 8; o++)
+		{
+			head[o] = offset;
+			offset += counts[o];
+			tail[o] = offset;
+			child_begin[o] = task.begin + head[o];
+			child_end[o] = task.begin + tail[o];
+			// 祖先的点是同一分布的随机子样本，按各子节点的点数比例分摊
+			child_inherited[o] = task.inherited * float(counts[o]) / float(n - own) + float(own_in_child[o]);
+		}
+		for (int o = 0; o < 8; o++)
+		{
+			while (head[o] < tail[o])
+			{
+				Entry v = e[head[o]];
+				int t = octant(v.code, node.depth);
+				while (t != o)
+				{
+					std::swap(v, e[head[t]++]);
+					t = octant(v.code, node.depth);
+				}
+				e[head[o]++] = v;
+			}
+		}
+	}
+
+	template <typename T>
+	void gather(std::vector<T>& values, const std::vector<uint32_t>& order, int stride)
+	{
+		if (values.empty()) return;
+		std::vector<T> sorted(values.size());
+		parallel::for_each(0, order.size(), [&](size_t i)
+		{
+			const T* src = &values[size_t(order[i]) * stride];
+			std::copy(src, src + stride, &sorted[i * stride]);
+		});
+		values.swap(sorted);
+	}
+}
+
+bool PointOctree::build(point_cloud::Cloud& cloud, const BuildOptions& options, BuildStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+	clear();
+	size_t n = cloud.size();
+	if (n == 0 || n > size_t(std::numeric_limits<int32_t>::max())) return false;
+	const float* pos = cloud.positions.data();
+
+	float lo[3], hi[3];
+	point_cloud::bounds(cloud, lo, hi);
+	double center[3], half = 0.0;
+	for (int a = 0; a < 3; a++)
+	{
+		center[a] = 0.5 * (double(lo[a]) + double(hi[a]));
+		half = std::max(half, 0.5 * (double(hi[a]) - double(lo[a])));
+	}
+	// 稍微放大，最大坐标不会量化到立方体外
+	half = half > 0.0 ? half * (1.0 + 1e-6) : 1.0;
+
+	std::vector<Entry> entries(n);
+	double scale = double(1 << kCodeBits) / (2.0 * half);
+	const double max_cell = double((1 << kCodeBits) - 1);
+	parallel::for_each(0, n, [&](size_t i)
+	{
+		uint64_t q[3];
+		for (int a = 0; a < 3; a++)
+		{
+			double c = std::floor((double(pos[3 * i + a]) - (center[a] - half)) * scale);
+			q[a] = uint64_t(std::min(max_cell, std::max(0.0, c)));
+		}
+		entries[i].code = spread_bits(q[0]) | spread_bits(q[1]) << 1 | spread_bits(q[2]) << 2;
+		entries[i].index = uint32_t(i);
+		entries[i].key = hash32(uint32_t(i) ^ hash32(options.seed));
+	});
+
+	int max_depth = std::max(0, std::min(options.max_depth, kCodeBits - 1));
+	unsigned int capacity = std::max(1u, options.capacity);
+
+	Node root;
+	for (int a = 0; a < 3; a++)
+	{
+		root.center[a] = float(center[a]);
+	}
+	root.half = float(half);
+	root.depth = 0;
+	std::fill(root.children, root.children + 8, -1);
+	node_list.push_back(root);
+
+	// 逐层处理，同一层的节点互不重叠，可以并行
+	std::vector<Task> level(1, Task{ 0, uint32_t(n), 0, 0.0f });
+	std::vector<uint32_t> ranges;
+	std::vector<float> inherited;
+	int depth = 0;
+	while (!level.empty())
+	{
+		ranges.assign(level.size() * 16, 0);
+		inherited.assign(level.size() * 8, 0.0f);
+		parallel::for_each(0, level.size(), [&](size_t t)
+		{
+			split(entries, level[t], node_list[level[t].node], max_depth, capacity,
+				&ranges[t * 16], &ranges[t * 16 + 8], &inherited[t * 8]);
+		}, 1);
+
+		std::vector<Task> next;
+		for (size_t t = 0; t < level.size(); t++)
+		{
+			for (int o = 0; o < 8; o++)
+			{
+				uint32_t b = ranges[t * 16 + o], e = ranges[t * 16 + 8 + o];
+				if (b == e) continue;
+				const Node& parent = node_list[level[t].node];
+				Node child;
+				child.half = parent.half * 0.5f;
+				for (int a = 0; a < 3; a++)
+				{
+					child.center[a] = parent.center[a] + ((o >> a) & 1 ? child.half : -child.half);
+				}
+				child.depth = parent.depth + 1;
+				std::fill(child.children, child.children + 8, -1);
+				int index = int(node_list.size());
+				node_list[level[t].node].children[o] = index;
+				node_list.push_back(child);
+				next.push_back(Task{ b, e, index, inherited[t * 8 + o] });
+			}
+		}
+		if (!next.empty()) depth++;
+		level.swap(next);
+	}
+
+	// 按节点顺序重排点的属性
+	std::vector<uint32_t> order(n);
+	parallel::for_each(0, n, [&](size_t i)
+	{
+		order[i] = entries[i].index;
+	});
+	std::vector<Entry>().swap(entries);
+	gather(cloud.positions, order, 3);
+	gather(cloud.normals, order, 3);
+	gather(cloud.colors, order, 4);
+
+	if (stats)
+	{
+		stats->ms = elapsed_ms(start);
+		stats->nodes = node_list.size();
+		stats->depth = depth;
+	}
+	return true;
+}
+
+void PointOctree::clear()
+{
+	node_list.clear();
+}
+
+size_t PointOctree::select(const View& view, std::vector<Draw>& draws) const
+{
+	draws.clear();
+	if (empty() || view.point_budget == 0) return 0;
+
+	// 视锥六个平面由mvp的行组合得到（对象空间），内侧为正
+	const float* m = view.mvp;
+	float planes[6][4];
+	for (int k = 0; k < 3; k++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			planes[2 * k][c] = m[c * 4 + 3] + m[c * 4 + k];
+			planes[2 * k + 1][c] = m[c * 4 + 3] - m[c * 4 + k];
+		}
+	}
+	const float w_row[4] = { m[3], m[7], m[11], m[15] };
+	float w_extent = std::fabs(w_row[0]) + std::fabs(w_row[1]) + std::fabs(w_row[2]);
+
+	auto visible = [&](const Node& node)
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			const float* pl = planes[p];
+			float dist = pl[0] * node.center[0] + pl[1] * node.center[1] + pl[2] * node.center[2] + pl[3];
+			float r = node.half * (std::fabs(pl[0]) + std::fabs(pl[1]) + std::fabs(pl[2]));
+			if (dist + r < 0.0f) return false;
+		}
+		return true;
+	};
+	// 立方体上w的最小值（w是坐标的仿射函数，在角点取到）
+	auto nearest_w = [&](const Node& node)
+	{
+		float w = w_row[0] * node.center[0] + w_row[1] * node.center[1] + w_row[2] * node.center[2] + w_row[3];
+		return std::max(w - node.half * w_extent, kMinW);
+	};
+
+	struct Item
+	{
+		float priority;   // 节点在屏幕上的大小，单位无关，只用于排序
+		int node;
+		int parent_draw;
+		bool operator<(const Item& other) const { return priority < other.priority; }
+	};
+	std::priority_queue<Item> queue;
+	std::vector<int> parents;
+	if (visible(node_list[0])) queue.push(Item{ node_list[0].half / nearest_w(node_list[0]), 0, -1 });
+
+	size_t total = 0;
+	while (!queue.empty() && total < view.point_budget)
+	{
+		Item item = queue.top();
+		queue.pop();
+		const Node& node = node_list[item.node];
+		uint32_t take = uint32_t(std::min<size_t>(node.count, view.point_budget - total));
+		// 只画了一部分时点更稀，点精灵按比例放大
+		float spacing = node.spacing * std::sqrt(float(node.count) / float(take));
+		draws.push_back(Draw{ node.begin, take, spacing, item.node });
+		parents.push_back(item.parent_draw);
+		total += take;
+		if (take < node.count) break;
+
+		if (node.spacing * view.pixel_scale / nearest_w(node) <= view.pixel_spacing) continue;
+		int draw = int(draws.size()) - 1;
+		for (int o = 0; o < 8; o++)
+		{
+			int c = node.children[o];
+			if (c < 0 || !visible(node_list[c])) continue;
+			queue.push(Item{ node_list[c].half / nearest_w(node_list[c]), c, draw });
+		}
+	}
+
+	// 展开过的节点，它的点和子节点的点叠在一起，点精灵按子节点的间距取，否则细节处会显得臃肿。
+	// 子节点的优先级总比父节点低，出队更晚，倒序遍历时子节点已经处理过
+	std::vector<float> child_spacing(draws.size(), 0.0f);
+	for (size_t i = draws.size(); i-- > 0; )
+	{
+		if (child_spacing[i] > 0.0f) draws[i].spacing = std::min(draws[i].spacing, child_spacing[i]);
+		if (parents[i] >= 0) child_spacing[parents[i]] = std::max(child_spacing[parents[i]], draws[i].spacing);
+	}
+	return total;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "point_cloud.h"
+#include <cstdint>
+#include <vector>
+
+// 点云的嵌套八叉树LOD：每个节点从子树的点里随机取至多capacity个作为自己的点，其余点按八分体分给子节点，
+// 所以任意一组从根开始的节点的点合起来是整个点云的子样本，越往下越密。
+// build把点云重排成先序布局：节点自己的点和整棵子树都是连续区间；节点自己的点随机排列，任意前缀都是均匀子样本。
+// 绘制时按节点的屏幕投影大小从大到小展开，点数预算用完或点间距投影已小于阈值时停止，每帧点数有上限
+class PointOctree
+{
+public:
+	struct Node
+	{
+		float center[3];
+		float half;              // 立方体的半边长
+		float spacing;           // 自己的点的平均间距（由点占据的8×8×8细分格子估计表面积）
+		uint32_t begin;          // 自己的点在重排后点云中的起点
+		uint32_t count;          // 自己的点数
+		uint32_t subtree_end;    // 子树最后一个点之后的位置
+		int32_t children[8];     // -1为空
+		int depth;
+	};
+
+	struct BuildOptions
+	{
+		unsigned int capacity = 16384;   // 每个节点自己的点数上限
+		int max_depth = 20;              // 重复点很多时在此深度停止细分（最大20）
+		unsigned int seed = 1;           // 节点取点的随机种子
+	};
+
+	struct BuildStats
+	{
+		double ms = 0.0;
+		size_t nodes = 0;
+		int depth = 0;
+	};
+
+	// 一个绘制区间；spacing为这些点在对象空间中应覆盖的间距，用来决定点精灵的大小
+	struct Draw
+	{
+		uint32_t first;
+		uint32_t count;
+		float spacing;
+		int node;
+	};
+
+	struct View
+	{
+		float mvp[16];                 // 列主序的projection * view * model
+		float pixel_scale = 1.0f;      // 对象空间长度1在裁剪空间w处投影为pixel_scale / w个像素
+		float pixel_spacing = 1.0f;    // 点间距投影小于这么多像素的节点不再展开
+		size_t point_budget = 3000000;
+	};
+
+	// 按八叉树重排cloud（坐标、法向、颜色一起）。点云为空或超过2^31-1个点时返回false
+	bool build(point_cloud::Cloud& cloud, const BuildOptions& options, BuildStats* stats = nullptr);
+	void clear();
+	bool empty() const { return node_list.empty(); }
+	const std::vector<Node>& nodes() const { return node_list; }
+	size_t point_count() const { return node_list.empty() ? 0 : node_list[0].subtree_end; }
+
+	// 选出视锥内要绘制的节点区间（父节点在子节点之前），返回总点数
+	size_t select(const View& view, std::vector<Draw>& draws) const;
+
+private:
+	std::vector<Node> node_list;
+};
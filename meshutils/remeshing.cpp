@@ -0,0 +1,747 @@
+#include "remeshing.h"
+#include "mesh_bvh.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+namespace remeshing
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef Mesh::HalfedgeHandle HH;
+		typedef Mesh::EdgeHandle EH;
+		typedef Mesh::FaceHandle FH;
+		typedef OpenMesh::Vec3d Vec3d;
+
+		// 同一轮的候选操作在各自影响区域的顶点上竞争，key最大者占有该顶点。
+		// 占有了整个区域的操作两两不相交，可以同时修改网格
+		class RegionClaims
+		{
+		public:
+			void ensure(size_t n)
+			{
+				if (n <= size) return;
+				size = std::max(n, size + size / 2);
+				claims.reset(new std::atomic<uint64_t>[size]);
+				std::atomic<uint64_t>* data = claims.get();
+				parallel::for_each(0, size, [data](size_t i) { data[i].store(0, std::memory_order_relaxed); });
+			}
+
+			void claim(int v, uint64_t key)
+			{
+				std::atomic<uint64_t>& c = claims[v];
+				uint64_t current = c.load(std::memory_order_relaxed);
+				while (current < key && !c.compare_exchange_weak(current, key, std::memory_order_relaxed)) {}
+			}
+
+			bool owns(int v, uint64_t key) const { return claims[v].load(std::memory_order_relaxed) == key; }
+			void release(int v) { claims[v].store(0, std::memory_order_relaxed); }
+
+		private:
+			std::unique_ptr<std::atomic<uint64_t>[]> claims;
+			size_t size = 0;
+		};
+
+		// 每轮重新打乱优先级，低32位为候选序号保证唯一，最高位保证非零
+		uint64_t claim_key(unsigned int id, unsigned int round)
+		{
+			uint64_t x = (uint64_t(round) << 32) | id;
+			x += 0x9e3779b97f4a7c15ULL;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+			x ^= x >> 31;
+			return (x & 0xffffffff00000000ULL) | (1ULL << 63) | id;
+		}
+
+		// region(i, verts)把候选i影响的顶点追加到verts，不再是候选时返回false。
+		// selected[i]为1的候选区域两两不相交
+		template <typename RegionFunc>
+		void select_independent(size_t count, unsigned int round, RegionClaims& claims, RegionFunc region,
+			std::vector<unsigned char>& selected)
+		{
+			selected.assign(count, 0);
+			parallel::for_each_range(0, count, [&](size_t begin, size_t end, unsigned int)
+			{
+				std::vector<int> verts;
+				for (size_t i = begin; i < end; i++)
+				{
+					verts.clear();
+					if (!region(i, verts)) continue;
+					uint64_t key = claim_key(unsigned(i), round);
+					for (int v : verts) claims.claim(v, key);
+				}
+			}, 256);
+			parallel::for_each_range(0, count, [&](size_t begin, size_t end, unsigned int)
+			{
+				std::vector<int> verts;
+				for (size_t i = begin; i < end; i++)
+				{
+					verts.clear();
+					if (!region(i, verts)) continue;
+					uint64_t key = claim_key(unsigned(i), round);
+					bool owns_all = true;
+					for (int v : verts) owns_all = owns_all && claims.owns(v, key);
+					selected[i] = owns_all ? 1 : 0;
+				}
+			}, 256);
+			parallel::for_each_range(0, count, [&](size_t begin, size_t end, unsigned int)
+			{
+				std::vector<int> verts;
+				for (size_t i = begin; i < end; i++)
+				{
+					verts.clear();
+					if (!region(i, verts)) continue;
+					for (int v : verts) claims.release(v);
+				}
+			}, 256);
+		}
+
+		double edge_length2(const Mesh& mesh, EH eh)
+		{
+			HH h = mesh.halfedge_handle(eh, 0);
+			return (mesh.point(mesh.to_vertex_handle(h)) - mesh.point(mesh.from_vertex_handle(h))).sqrnorm();
+		}
+
+		bool is_locked(const Mesh& mesh, EH eh, const Options& options)
+		{
+			return options.preserve_boundary && mesh.is_boundary(eh);
+		}
+
+		// 满足pred的未删除边，按编号排列
+		template <typename Pred>
+		std::vector<int> collect_edges(const Mesh& mesh, Pred pred)
+		{
+			std::vector<std::vector<int> > parts(parallel::thread_count());
+			parallel::for_each_range(0, mesh.n_edges(), [&](size_t begin, size_t end, unsigned int tid)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					EH eh(int(i));
+					if (!mesh.status(eh).deleted() && pred(eh)) parts[tid].push_back(int(i));
+				}
+			});
+			std::vector<int> edges;
+			for (const std::vector<int>& part : parts)
+			{
+				edges.insert(edges.end(), part.begin(), part.end());
+			}
+			return edges;
+		}
+
+		void sort_unique(std::vector<int>& v)
+		{
+			std::sort(v.begin(), v.end());
+			v.erase(std::unique(v.begin(), v.end()), v.end());
+		}
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// ---------------------------------------------------------------- 切分
+
+		// 切分边的两侧三角形（或一侧，边界边）及四个顶点
+		bool split_region(const Mesh& mesh, EH eh, std::vector<int>& verts)
+		{
+			HH h = mesh.halfedge_handle(eh, 0);
+			HH o = mesh.halfedge_handle(eh, 1);
+			verts.push_back(mesh.to_vertex_handle(h).idx());
+			verts.push_back(mesh.to_vertex_handle(o).idx());
+			if (!mesh.is_boundary(h)) verts.push_back(mesh.to_vertex_handle(mesh.next_halfedge_handle(h)).idx());
+			if (!mesh.is_boundary(o)) verts.push_back(mesh.to_vertex_handle(mesh.next_halfedge_handle(o)).idx());
+			return true;
+		}
+
+		// 在边eh中间插入顶点m，并把两侧三角形各分成两个。新边new_edges[0..2]和新面new_faces[0..1]
+		// 预先串行分配好（边界边只用两条边、一个面），这里只改连接关系，
+		// 因此区域不相交的切分可以并行执行
+		void split_edge(Mesh& mesh, EH eh, VH m, const EH* new_edges, const FH* new_faces)
+		{
+			HH h0 = mesh.halfedge_handle(eh, 0);
+			if (mesh.is_boundary(h0)) h0 = mesh.opposite_halfedge_handle(h0);
+			HH o0 = mesh.opposite_halfedge_handle(h0);
+			VH b = mesh.to_vertex_handle(h0);
+			HH h1 = mesh.next_halfedge_handle(h0);
+			HH h2 = mesh.next_halfedge_handle(h1);
+			VH c = mesh.to_vertex_handle(h1);
+			FH f0 = mesh.face_handle(h0);
+			bool boundary = mesh.is_boundary(o0);
+
+			// 边界环上o0的前驱在b的入边里找，不沿整个边界环遍历
+			HH o_prev;
+			if (boundary)
+			{
+				for (auto vih = mesh.cvih_iter(b); vih.is_valid(); ++vih)
+				{
+					if (mesh.next_halfedge_handle(*vih) == o0)
+					{
+						o_prev = *vih;
+						break;
+					}
+				}
+			}
+
+			HH e1 = mesh.halfedge_handle(new_edges[0], 0);   // m->b
+			HH e1o = mesh.halfedge_handle(new_edges[0], 1);  // b->m
+			HH g = mesh.halfedge_handle(new_edges[1], 0);    // m->c
+			HH go = mesh.halfedge_handle(new_edges[1], 1);   // c->m
+			mesh.set_vertex_handle(h0, m);
+			mesh.set_vertex_handle(e1, b);
+			mesh.set_vertex_handle(e1o, m);
+			mesh.set_vertex_handle(g, c);
+			mesh.set_vertex_handle(go, m);
+
+			// a->m->c
+			mesh.set_next_halfedge_handle(h0, g);
+			mesh.set_next_halfedge_handle(g, h2);
+			mesh.set_next_halfedge_handle(h2, h0);
+			mesh.set_face_handle(g, f0);
+			mesh.set_halfedge_handle(f0, h0);
+
+			// m->b->c
+			FH fn0 = new_faces[0];
+			mesh.set_next_halfedge_handle(e1, h1);
+			mesh.set_next_halfedge_handle(h1, go);
+			mesh.set_next_halfedge_handle(go, e1);
+			mesh.set_face_handle(e1, fn0);
+			mesh.set_face_handle(h1, fn0);
+			mesh.set_face_handle(go, fn0);
+			mesh.set_halfedge_handle(fn0, e1);
+
+			if (boundary)
+			{
+				// 边界环 ...->b->m->a->...
+				mesh.set_next_halfedge_handle(o_prev, e1o);
+				mesh.set_next_halfedge_handle(e1o, o0);
+				mesh.set_face_handle(e1o, FH());
+				mesh.set_halfedge_handle(m, o0);
+			}
+			else
+			{
+				HH o1 = mesh.next_halfedge_handle(o0);
+				HH o2 = mesh.next_halfedge_handle(o1);
+				VH d = mesh.to_vertex_handle(o1);
+				FH f1 = mesh.face_handle(o0);
+				HH k = mesh.halfedge_handle(new_edges[2], 0);   // d->m
+				HH ko = mesh.halfedge_handle(new_edges[2], 1);  // m->d
+				mesh.set_vertex_handle(k, m);
+				mesh.set_vertex_handle(ko, d);
+
+				// m->a->d
+				mesh.set_next_halfedge_handle(o1, k);
+				mesh.set_next_halfedge_handle(k, o0);
+				mesh.set_face_handle(k, f1);
+				mesh.set_halfedge_handle(f1, o0);
+
+				// b->m->d
+				FH fn1 = new_faces[1];
+				mesh.set_next_halfedge_handle(e1o, ko);
+				mesh.set_next_halfedge_handle(ko, o2);
+				mesh.set_next_halfedge_handle(o2, e1o);
+				mesh.set_face_handle(e1o, fn1);
+				mesh.set_face_handle(ko, fn1);
+				mesh.set_face_handle(o2, fn1);
+				mesh.set_halfedge_handle(fn1, e1o);
+				mesh.set_halfedge_handle(m, e1);
+			}
+			if (mesh.halfedge_handle(b) == o0) mesh.set_halfedge_handle(b, e1o);
+		}
+
+		size_t split_long_edges(Mesh& mesh, double high, const Options& options, RegionClaims& claims, int& rounds)
+		{
+			const double high2 = high * high;
+			auto is_long = [&](EH eh) { return !is_locked(mesh, eh, options) && edge_length2(mesh, eh) > high2; };
+			std::vector<int> candidates = collect_edges(mesh, is_long);
+			std::vector<unsigned char> selected;
+			size_t total = 0;
+
+			for (unsigned int round = 0; !candidates.empty(); round++)
+			{
+				rounds++;
+				claims.ensure(mesh.n_vertices());
+				select_independent(candidates.size(), round, claims, [&](size_t i, std::vector<int>& verts)
+				{
+					return split_region(mesh, EH(candidates[i]), verts);
+				}, selected);
+
+				std::vector<int> chosen, next;
+				for (size_t i = 0; i < candidates.size(); i++)
+				{
+					(selected[i] ? chosen : next).push_back(candidates[i]);
+				}
+
+				// 新元素的编号连续，按前缀和分给各个切分
+				size_t nv = mesh.n_vertices(), ne = mesh.n_edges(), nf = mesh.n_faces();
+				std::vector<unsigned int> edge_offset(chosen.size() + 1, 0), face_offset(chosen.size() + 1, 0);
+				for (size_t i = 0; i < chosen.size(); i++)
+				{
+					bool boundary = mesh.is_boundary(EH(chosen[i]));
+					edge_offset[i + 1] = edge_offset[i] + (boundary ? 2 : 3);
+					face_offset[i + 1] = face_offset[i] + (boundary ? 1 : 2);
+				}
+				mesh.reserve(nv + chosen.size(), ne + edge_offset.back(), nf + face_offset.back());
+				for (size_t i = 0; i < chosen.size(); i++)
+				{
+					mesh.new_vertex();
+				}
+				for (unsigned int i = 0; i < edge_offset.back(); i++)
+				{
+					mesh.new_edge(VH(0), VH(0));
+				}
+				for (unsigned int i = 0; i < face_offset.back(); i++)
+				{
+					mesh.new_face();
+				}
+
+				parallel::for_each(0, chosen.size(), [&](size_t i)
+				{
+					EH eh(chosen[i]);
+					HH h = mesh.halfedge_handle(eh, 0);
+					VH m(int(nv + i));
+					mesh.set_point(m, (mesh.point(mesh.to_vertex_handle(h)) + mesh.point(mesh.from_vertex_handle(h))) * 0.5);
+					EH edges[3];
+					FH faces[2];
+					for (unsigned int k = edge_offset[i]; k < edge_offset[i + 1]; k++)
+					{
+						edges[k - edge_offset[i]] = EH(int(ne + k));
+					}
+					for (unsigned int k = face_offset[i]; k < face_offset[i + 1]; k++)
+					{
+						faces[k - face_offset[i]] = FH(int(nf + k));
+					}
+					split_edge(mesh, eh, m, edges, faces);
+				}, 256);
+				total += chosen.size();
+
+				// 下一轮：落选的候选加上新顶点周围仍然过长的边
+				for (size_t i = 0; i < chosen.size(); i++)
+				{
+					for (auto ve = mesh.cve_iter(VH(int(nv + i))); ve.is_valid(); ++ve)
+					{
+						next.push_back((*ve).idx());
+					}
+				}
+				sort_unique(next);
+				next.erase(std::remove_if(next.begin(), next.end(), [&](int e) { return !is_long(EH(e)); }), next.end());
+				candidates.swap(next);
+			}
+			return total;
+		}
+
+		// ---------------------------------------------------------------- 收缩
+
+		bool adjacent(const Mesh& mesh, VH a, VH b)
+		{
+			for (auto vv = mesh.cvv_iter(a); vv.is_valid(); ++vv)
+			{
+				if (*vv == b) return true;
+			}
+			return false;
+		}
+
+		// 只读的拓扑检查，相当于OpenMesh的is_collapse_ok（后者会写status的tagged位，不能并行调用）
+		bool is_collapse_ok(const Mesh& mesh, HH h)
+		{
+			HH o = mesh.opposite_halfedge_handle(h);
+			VH v0 = mesh.from_vertex_handle(h), v1 = mesh.to_vertex_handle(h);
+			bool hb = mesh.is_boundary(h), ob = mesh.is_boundary(o);
+			VH vl = hb ? VH() : mesh.to_vertex_handle(mesh.next_halfedge_handle(h));
+			VH vr = ob ? VH() : mesh.to_vertex_handle(mesh.next_halfedge_handle(o));
+			if (vl == vr) return false;
+
+			// 三角形的另两条边都在边界上时，收缩会留下悬挂边
+			if (!hb && mesh.is_boundary(mesh.opposite_halfedge_handle(mesh.next_halfedge_handle(h)))
+				&& mesh.is_boundary(mesh.opposite_halfedge_handle(mesh.prev_halfedge_handle(h)))) return false;
+			if (!ob && mesh.is_boundary(mesh.opposite_halfedge_handle(mesh.next_halfedge_handle(o)))
+				&& mesh.is_boundary(mesh.opposite_halfedge_handle(mesh.prev_halfedge_handle(o)))) return false;
+			if (mesh.is_boundary(v0) && mesh.is_boundary(v1) && !hb && !ob) return false;
+
+			// 连接条件：公共邻点只能是两侧的对顶点
+			for (auto vv = mesh.cvv_iter(v0); vv.is_valid(); ++vv)
+			{
+				VH w = *vv;
+				if (w == v1 || w == vl || w == vr) continue;
+				if (adjacent(mesh, w, v1)) return false;
+			}
+			return true;
+		}
+
+		// v0并到v1（v1不动）：新边不能超过high，v0周围的三角形不能翻转
+		bool can_collapse(const Mesh& mesh, HH h, double high2, const Options& options)
+		{
+			VH v0 = mesh.from_vertex_handle(h), v1 = mesh.to_vertex_handle(h);
+			bool boundary_edge = mesh.is_boundary(mesh.edge_handle(h));
+			if (mesh.is_boundary(v0) && (options.preserve_boundary || !boundary_edge)) return false;
+			if (!is_collapse_ok(mesh, h)) return false;
+
+			const Vec3d& p1 = mesh.point(v1);
+			for (auto vv = mesh.cvv_iter(v0); vv.is_valid(); ++vv)
+			{
+				if ((mesh.point(*vv) - p1).sqrnorm() > high2) return false;
+			}
+			for (auto vf = mesh.cvf_iter(v0); vf.is_valid(); ++vf)
+			{
+				Vec3d p[3], q[3];
+				int k = 0;
+				bool removed = false;
+				for (auto fv = mesh.cfv_iter(*vf); fv.is_valid() && k < 3; ++fv, ++k)
+				{
+					if (*fv == v1) removed = true;
+					p[k] = mesh.point(*fv);
+					q[k] = (*fv == v0) ? p1 : p[k];
+				}
+				if (removed) continue;
+				Vec3d n0 = (p[1] - p[0]) % (p[2] - p[0]);
+				Vec3d n1 = (q[1] - q[0]) % (q[2] - q[0]);
+				if ((n0 | n1) <= 0.0) return false;
+			}
+			return true;
+		}
+
+		// 收缩改动v0、v1及其一环邻域的连接关系
+		void collapse_region(const Mesh& mesh, HH h, std::vector<int>& verts)
+		{
+			VH v0 = mesh.from_vertex_handle(h), v1 = mesh.to_vertex_handle(h);
+			verts.push_back(v0.idx());
+			verts.push_back(v1.idx());
+			for (auto vv = mesh.cvv_iter(v0); vv.is_valid(); ++vv)
+			{
+				verts.push_back((*vv).idx());
+			}
+			for (auto vv = mesh.cvv_iter(v1); vv.is_valid(); ++vv)
+			{
+				verts.push_back((*vv).idx());
+			}
+		}
+
+		size_t collapse_short_edges(Mesh& mesh, double low, double high, const Options& options,
+			RegionClaims& claims, int& rounds)
+		{
+			const double low2 = low * low, high2 = high * high;
+			auto is_short = [&](EH eh) { return !is_locked(mesh, eh, options) && edge_length2(mesh, eh) < low2; };
+			std::vector<int> candidates = collect_edges(mesh, is_short);
+			std::vector<HH> targets;
+			std::vector<unsigned char> selected;
+			size_t total = 0;
+
+			for (unsigned int round = 0; !candidates.empty(); round++)
+			{
+				rounds++;
+				claims.ensure(mesh.n_vertices());
+				// 先选方向：优先把非边界顶点并到另一端
+				targets.assign(candidates.size(), HH());
+				parallel::for_each(0, candidates.size(), [&](size_t i)
+				{
+					EH eh(candidates[i]);
+					if (mesh.status(eh).deleted() || !is_short(eh)) return;
+					for (int k = 0; k < 2; k++)
+					{
+						HH h = mesh.halfedge_handle(eh, k);
+						if (can_collapse(mesh, h, high2, options))
+						{
+							targets[i] = h;
+							return;
+						}
+					}
+				}, 256);
+
+				select_independent(candidates.size(), round, claims, [&](size_t i, std::vector<int>& verts)
+				{
+					if (!targets[i].is_valid()) return false;
+					collapse_region(mesh, targets[i], verts);
+					return true;
+				}, selected);
+
+				// OpenMesh的collapse在边界环上求前驱时会遍历整个环，碰到边界的收缩放到最后串行执行
+				std::vector<HH> interior, touching_boundary;
+				std::vector<int> next;
+				for (size_t i = 0; i < candidates.size(); i++)
+				{
+					if (!targets[i].is_valid()) continue;
+					if (!selected[i])
+					{
+						next.push_back(candidates[i]);
+						continue;
+					}
+					HH h = targets[i];
+					VH v0 = mesh.from_vertex_handle(h), v1 = mesh.to_vertex_handle(h);
+					bool boundary = mesh.is_boundary(v0) || mesh.is_boundary(v1);
+					for (auto vv = mesh.cvv_iter(v0); vv.is_valid() && !boundary; ++vv)
+					{
+						boundary = mesh.is_boundary(*vv);
+					}
+					for (auto vv = mesh.cvv_iter(v1); vv.is_valid() && !boundary; ++vv)
+					{
+						boundary = mesh.is_boundary(*vv);
+					}
+					(boundary ? touching_boundary : interior).push_back(h);
+				}
+
+				parallel::for_each(0, interior.size(), [&](size_t i) { mesh.collapse(interior[i]); }, 256);
+				for (HH h : touching_boundary)
+				{
+					mesh.collapse(h);
+				}
+				total += interior.size() + touching_boundary.size();
+
+				// 下一轮：落选的候选加上保留顶点周围仍然过短的边
+				for (const std::vector<HH>* list : { &interior, &touching_boundary })
+				{
+					for (HH h : *list)
+					{
+						for (auto ve = mesh.cve_iter(mesh.to_vertex_handle(h)); ve.is_valid(); ++ve)
+						{
+							next.push_back((*ve).idx());
+						}
+					}
+				}
+				sort_unique(next);
+				next.erase(std::remove_if(next.begin(), next.end(), [&](int e)
+				{
+					return mesh.status(EH(e)).deleted() || !is_short(EH(e));
+				}), next.end());
+				candidates.swap(next);
+			}
+			mesh.garbage_collection();
+			return total;
+		}
+
+		// ---------------------------------------------------------------- 翻转
+
+		int valence_deviation(const Mesh& mesh, VH v, int delta)
+		{
+			int target = mesh.is_boundary(v) ? 4 : 6;
+			return std::abs(int(mesh.valence(v)) + delta - target);
+		}
+
+		// 翻转后度数偏差之和减小、两个新三角形不翻折时才翻转
+		bool should_flip(const Mesh& mesh, EH eh)
+		{
+			if (mesh.is_boundary(eh)) return false;
+			HH h = mesh.halfedge_handle(eh, 0);
+			HH o = mesh.halfedge_handle(eh, 1);
+			VH a = mesh.from_vertex_handle(h), b = mesh.to_vertex_handle(h);
+			VH c = mesh.to_vertex_handle(mesh.next_halfedge_handle(h));
+			VH d = mesh.to_vertex_handle(mesh.next_halfedge_handle(o));
+			if (c == d || mesh.valence(a) <= 3 || mesh.valence(b) <= 3) return false;
+
+			int before = valence_deviation(mesh, a, 0) + valence_deviation(mesh, b, 0)
+				+ valence_deviation(mesh, c, 0) + valence_deviation(mesh, d, 0);
+			int after = valence_deviation(mesh, a, -1) + valence_deviation(mesh, b, -1)
+				+ valence_deviation(mesh, c, 1) + valence_deviation(mesh, d, 1);
+			if (after >= before) return false;
+			if (adjacent(mesh, c, d)) return false;
+
+			const Vec3d& pa = mesh.point(a);
+			const Vec3d& pb = mesh.point(b);
+			const Vec3d& pc = mesh.point(c);
+			const Vec3d& pd = mesh.point(d);
+			Vec3d n = (pb - pa) % (pc - pa) + (pa - pb) % (pd - pb);
+			Vec3d n1 = (pa - pc) % (pd - pc);
+			Vec3d n2 = (pb - pd) % (pc - pd);
+			return (n1 | n) > 0.0 && (n2 | n) > 0.0;
+		}
+
+		bool flip_region(const Mesh& mesh, EH eh, std::vector<int>& verts)
+		{
+			HH h = mesh.halfedge_handle(eh, 0);
+			HH o = mesh.halfedge_handle(eh, 1);
+			verts.push_back(mesh.to_vertex_handle(h).idx());
+			verts.push_back(mesh.to_vertex_handle(o).idx());
+			verts.push_back(mesh.to_vertex_handle(mesh.next_halfedge_handle(h)).idx());
+			verts.push_back(mesh.to_vertex_handle(mesh.next_halfedge_handle(o)).idx());
+			return true;
+		}
+
+		size_t flip_edges(Mesh& mesh, RegionClaims& claims, int& rounds)
+		{
+			std::vector<int> candidates = collect_edges(mesh, [&](EH eh) { return should_flip(mesh, eh); });
+			std::vector<unsigned char> selected;
+			size_t total = 0;
+
+			for (unsigned int round = 0; !candidates.empty(); round++)
+			{
+				rounds++;
+				select_independent(candidates.size(), round, claims, [&](size_t i, std::vector<int>& verts)
+				{
+					return flip_region(mesh, EH(candidates[i]), verts);
+				}, selected);
+
+				std::vector<int> chosen, next;
+				for (size_t i = 0; i < candidates.size(); i++)
+				{
+					(selected[i] ? chosen : next).push_back(candidates[i]);
+				}
+				parallel::for_each(0, chosen.size(), [&](size_t i)
+				{
+					EH eh(chosen[i]);
+					flip_openmesh(eh, mesh);
+				}, 256);
+				total += chosen.size();
+
+				// 下一轮：落选的候选和翻转边所在菱形的四条外边，重新判断
+				for (int e : chosen)
+				{
+					for (int k = 0; k < 2; k++)
+					{
+						HH h = mesh.halfedge_handle(EH(e), k);
+						next.push_back(mesh.edge_handle(mesh.next_halfedge_handle(h)).idx());
+						next.push_back(mesh.edge_handle(mesh.prev_halfedge_handle(h)).idx());
+					}
+				}
+				sort_unique(next);
+				next.erase(std::remove_if(next.begin(), next.end(), [&](int e) { return !should_flip(mesh, EH(e)); }), next.end());
+				candidates.swap(next);
+			}
+			return total;
+		}
+
+		// ---------------------------------------------------------------- 松弛
+
+		// 一环重心在切平面内的分量，边界顶点不动；之后投影回原曲面
+		void tangential_relaxation(Mesh& mesh, const MeshBVH* reference)
+		{
+			size_t nv = mesh.n_vertices(), nf = mesh.n_faces();
+			std::vector<Vec3d> face_normals(nf);
+			parallel::for_each(0, nf, [&](size_t f)
+			{
+				HH h = mesh.halfedge_handle(FH(int(f)));
+				const Vec3d& a = mesh.point(mesh.from_vertex_handle(h));
+				const Vec3d& b = mesh.point(mesh.to_vertex_handle(h));
+				const Vec3d& c = mesh.point(mesh.to_vertex_handle(mesh.next_halfedge_handle(h)));
+				face_normals[f] = (b - a) % (c - a);
+			});
+
+			std::vector<Vec3d> updated(nv);
+			parallel::for_each(0, nv, [&](size_t v)
+			{
+				VH vh(int(v));
+				const Vec3d& p = mesh.point(vh);
+				updated[v] = p;
+				if (mesh.is_boundary(vh) || mesh.is_isolated(vh)) return;
+
+				Vec3d centroid(0.0, 0.0, 0.0), n(0.0, 0.0, 0.0);
+				int count = 0;
+				for (auto vv = mesh.cvv_iter(vh); vv.is_valid(); ++vv, ++count)
+				{
+					centroid += mesh.point(*vv);
+				}
+				for (auto vf = mesh.cvf_iter(vh); vf.is_valid(); ++vf)
+				{
+					n += face_normals[(*vf).idx()];
+				}
+				double len = n.norm();
+				if (count == 0 || len <= 0.0) return;
+				n /= len;
+				centroid /= count;
+				Vec3d d = centroid - p;
+				updated[v] = p + d - n * (d | n);
+			});
+
+			parallel::for_each(0, nv, [&](size_t v)
+			{
+				VH vh(int(v));
+				Vec3d p = updated[v];
+				if (reference && !mesh.is_boundary(vh))
+				{
+					MeshBVH::Hit hit;
+					if (reference->closest_point(p, hit)) p = hit.point;
+				}
+				mesh.set_point(vh, p);
+			});
+		}
+	}
+
+	double mean_edge_length(const Mesh& mesh)
+	{
+		size_t ne = mesh.n_edges();
+		if (ne == 0) return 0.0;
+		std::vector<double> sums(parallel::thread_count(), 0.0);
+		std::vector<size_t> counts(parallel::thread_count(), 0);
+		parallel::for_each_range(0, ne, [&](size_t begin, size_t end, unsigned int tid)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				EH eh(int(i));
+				if (mesh.status(eh).deleted()) continue;
+				sums[tid] += std::sqrt(edge_length2(mesh, eh));
+				counts[tid]++;
+			}
+		});
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t t = 0; t < sums.size(); t++)
+		{
+			sum += sums[t];
+			count += counts[t];
+		}
+		return count > 0 ? sum / count : 0.0;
+	}
+
+	bool isotropic_remesh(Mesh& mesh, const Options& options, Stats* stats)
+	{
+		if (mesh.n_faces() == 0) return false;
+
+		bool triangles = true;
+		for (auto fh : mesh.faces())
+		{
+			if (mesh.valence(fh) != 3)
+			{
+				triangles = false;
+				break;
+			}
+		}
+		if (!triangles)
+		{
+			mesh.triangulate();
+		}
+
+		double target = options.target_length > 0.0 ? options.target_length : mean_edge_length(mesh);
+		if (target <= 0.0) return false;
+		const double low = 4.0 / 5.0 * target;
+		const double high = 4.0 / 3.0 * target;
+
+		MeshBVH reference;
+		if (options.project)
+		{
+			reference.build(mesh);
+		}
+
+		RegionClaims claims;
+		if (stats)
+		{
+			stats->target_length = target;
+			stats->passes.clear();
+		}
+		for (int iteration = 0; iteration < options.iterations; iteration++)
+		{
+			PassTiming timing;
+			auto start = std::chrono::steady_clock::now();
+			timing.splits = split_long_edges(mesh, high, options, claims, timing.rounds);
+			timing.split_ms = elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			timing.collapses = collapse_short_edges(mesh, low, high, options, claims, timing.rounds);
+			timing.collapse_ms = elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			claims.ensure(mesh.n_vertices());
+			timing.flips = flip_edges(mesh, claims, timing.rounds);
+			timing.flip_ms = elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			tangential_relaxation(mesh, options.project ? &reference : nullptr);
+			timing.relax_ms = elapsed_ms(start);
+
+			if (stats) stats->passes.push_back(timing);
+		}
+		mesh.garbage_collection();
+		return true;
+	}
+}
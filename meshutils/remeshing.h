@@ -0,0 +1,42 @@
+#pragma once
+#include "my_traits.h"
+#include <vector>
+
+// 各向同性重网格化（Botsch & Kobbelt 2004）：每次迭代依次切分长边、收缩短边、
+// 翻转边改善度数、切向松弛并投影回原曲面。
+// 拓扑操作按轮进行：每轮先并行计算候选，再按影响区域选出互不相交的一组并行执行，
+// 未选中的候选留到下一轮。
+namespace remeshing
+{
+	struct Options
+	{
+		double target_length = 0.0;     // 目标边长，<=0时取当前平均边长
+		int iterations = 10;
+		bool preserve_boundary = true;  // 边界边不切分、不收缩，边界顶点不移动
+		bool project = true;            // 松弛后投影回原始曲面
+	};
+
+	// 一次迭代中各阶段的耗时和操作数
+	struct PassTiming
+	{
+		double split_ms = 0.0;
+		double collapse_ms = 0.0;
+		double flip_ms = 0.0;
+		double relax_ms = 0.0;
+		size_t splits = 0;
+		size_t collapses = 0;
+		size_t flips = 0;
+		int rounds = 0;                 // 三个拓扑阶段的并行轮数之和
+	};
+
+	struct Stats
+	{
+		double target_length = 0.0;
+		std::vector<PassTiming> passes;
+	};
+
+	double mean_edge_length(const Mesh& mesh);
+
+	// 非三角形网格先扇形三角化；结束时做garbage_collection
+	bool isotropic_remesh(Mesh& mesh, const Options& options, Stats* stats = nullptr);
+}
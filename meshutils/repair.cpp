@@ -0,0 +1,600 @@
+#include "repair.h"
+#include "mesh_analysis.h"
+#include "laplacian.h"
+#include "point_grid.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace repair
+{
+	namespace
+	{
+		typedef Mesh::VertexHandle VH;
+		typedef Mesh::HalfedgeHandle HH;
+		typedef Mesh::EdgeHandle EH;
+		typedef Mesh::FaceHandle FH;
+		typedef OpenMesh::Vec3d Vec3d;
+
+		const double kDefaultTolerance = 1e-6;
+		// 面积不超过 kDegenerateArea·对角线² 的面视为退化
+		const double kDegenerateArea = 1e-12;
+		const int kRefinePasses = 10;
+		const int kRelaxPasses = 10;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// 各线程先排序连续的一段，再两两归并
+		template <typename T, typename Compare>
+		void parallel_sort(std::vector<T>& v, Compare less)
+		{
+			size_t n = v.size();
+			size_t chunks = std::max<size_t>(1, std::min<size_t>(parallel::thread_count(), n / 65536));
+			std::vector<size_t> bounds(chunks + 1);
+			for (size_t c = 0; c <= chunks; c++)
+			{
+				bounds[c] = n * c / chunks;
+			}
+			parallel::for_each(0, chunks, [&](size_t c)
+			{
+				std::sort(v.begin() + bounds[c], v.begin() + bounds[c + 1], less);
+			}, 1);
+			while (bounds.size() > 2)
+			{
+				parallel::for_each(0, (bounds.size() - 1) / 2, [&](size_t p)
+				{
+					std::inplace_merge(v.begin() + bounds[2 * p], v.begin() + bounds[2 * p + 1], v.begin() + bounds[2 * p + 2], less);
+				}, 1);
+				std::vector<size_t> merged;
+				for (size_t i = 0; i < bounds.size(); i += 2)
+				{
+					merged.push_back(bounds[i]);
+				}
+				if (merged.back() != n) merged.push_back(n);
+				bounds.swap(merged);
+			}
+		}
+
+		// 面片汤：面f占corners[offsets[f], offsets[f] + sizes[f])，焊接和清理都在这里原地进行
+		struct FaceSoup
+		{
+			std::vector<unsigned int> corners;
+			std::vector<int> corner_uv;         // 无纹理时为空
+			std::vector<unsigned int> offsets;
+			std::vector<unsigned int> sizes;
+			std::vector<unsigned char> keep;
+
+			size_t n_faces() const { return sizes.size(); }
+		};
+
+		void extract(const Mesh& mesh, const OpenMesh::HPropHandleT<int>* uv, FaceSoup& soup)
+		{
+			size_t nf = mesh.n_faces();
+			soup.sizes.assign(nf, 0);
+			soup.keep.assign(nf, 0);
+			parallel::for_each(0, nf, [&](size_t f)
+			{
+				FH fh(int(f));
+				if (!mesh.status(fh).deleted()) soup.sizes[f] = mesh.valence(fh);
+			});
+			soup.offsets.assign(nf + 1, 0);
+			for (size_t f = 0; f < nf; f++)
+			{
+				soup.offsets[f + 1] = soup.offsets[f] + soup.sizes[f];
+			}
+			soup.corners.resize(soup.offsets[nf]);
+			if (uv) soup.corner_uv.resize(soup.offsets[nf]);
+			parallel::for_each(0, nf, [&](size_t f)
+			{
+				if (soup.sizes[f] == 0) return;
+				unsigned int k = soup.offsets[f];
+				for (auto fh_it = mesh.cfh_iter(FH(int(f))); fh_it.is_valid(); ++fh_it, ++k)
+				{
+					soup.corners[k] = mesh.to_vertex_handle(*fh_it).idx();
+					if (uv) soup.corner_uv[k] = mesh.property(*uv, *fh_it);
+				}
+			});
+		}
+
+		// rep[v]为v所在簇的代表（簇中编号最小的顶点），返回被合并掉的顶点数
+		size_t weld(const Mesh& mesh, double tolerance, std::vector<unsigned int>& rep)
+		{
+			size_t nv = mesh.n_vertices();
+			// 格子不小于容差，每次半径查询最多访问27个格子
+			PointGrid grid;
+			grid.build(mesh, 0.0, tolerance);
+
+			// 每个顶点只和编号更小的近邻合并
+			mesh_analysis::ConcurrentUnionFind clusters(nv);
+			parallel::for_each_range(0, nv, [&](size_t b, size_t e, unsigned int)
+			{
+				std::vector<unsigned int> near;
+				for (size_t v = b; v < e; v++)
+				{
+					grid.radius(mesh.point(VH(int(v))), tolerance, near);
+					for (unsigned int u : near)
+					{
+						if (u < v) clusters.unite(u, unsigned(v));
+					}
+				}
+			});
+
+			rep.resize(nv);
+			std::vector<size_t> merged(parallel::thread_count(), 0);
+			parallel::for_each_range(0, nv, [&](size_t b, size_t e, unsigned int tid)
+			{
+				for (size_t v = b; v < e; v++)
+				{
+					rep[v] = clusters.find(unsigned(v));
+					if (rep[v] != v) merged[tid]++;
+				}
+			});
+			size_t total = 0;
+			for (size_t m : merged)
+			{
+				total += m;
+			}
+			return total;
+		}
+
+		// 顶点换成代表后去掉相邻重复的角；顶点不足3个、非相邻重复或面积为0的面为退化面
+		size_t remove_degenerate(const Mesh& mesh, const std::vector<unsigned int>& rep, double min_area,
+			bool remove_zero_area, FaceSoup& soup)
+		{
+			bool has_uv = !soup.corner_uv.empty();
+			std::vector<size_t> removed(parallel::thread_count(), 0);
+			parallel::for_each_range(0, soup.n_faces(), [&](size_t fb, size_t fe, unsigned int tid)
+			{
+				for (size_t f = fb; f < fe; f++)
+				{
+					if (soup.sizes[f] == 0) continue;
+					unsigned int b = soup.offsets[f], e = b + soup.sizes[f];
+					unsigned int* corners = &soup.corners[b];
+					unsigned int k = 0;
+					for (unsigned int i = b; i < e; i++)
+					{
+						unsigned int v = rep[soup.corners[i]];
+						if (k > 0 && corners[k - 1] == v) continue;
+						if (has_uv) soup.corner_uv[b + k] = soup.corner_uv[i];
+						corners[k++] = v;
+					}
+					while (k > 1 && corners[k - 1] == corners[0])
+					{
+						k--;
+					}
+					soup.sizes[f] = k;
+
+					bool degenerate = k < 3;
+					for (unsigned int i = 0; i < k && !degenerate; i++)
+					{
+						for (unsigned int j = i + 1; j < k; j++)
+						{
+							if (corners[i] == corners[j]) degenerate = true;
+						}
+					}
+					if (!degenerate && remove_zero_area)
+					{
+						const Vec3d& p0 = mesh.point(VH(int(corners[0])));
+						Vec3d area(0.0, 0.0, 0.0);
+						for (unsigned int i = 1; i + 1 < k; i++)
+						{
+							area += (mesh.point(VH(int(corners[i]))) - p0) % (mesh.point(VH(int(corners[i + 1]))) - p0);
+						}
+						degenerate = 0.5 * area.norm() <= min_area;
+					}
+					if (degenerate) removed[tid]++;
+					else soup.keep[f] = 1;
+				}
+			});
+			size_t total = 0;
+			for (size_t r : removed)
+			{
+				total += r;
+			}
+			return total;
+		}
+
+		// 顶点集合相同的面按排序后的顶点序列排到一起，每组保留编号最小的一个
+		size_t remove_duplicates(FaceSoup& soup)
+		{
+			std::vector<unsigned int> sorted(soup.corners.size());
+			std::vector<unsigned int> order;
+			order.reserve(soup.n_faces());
+			for (size_t f = 0; f < soup.n_faces(); f++)
+			{
+				if (soup.keep[f]) order.push_back(unsigned(f));
+			}
+			parallel::for_each(0, order.size(), [&](size_t i)
+			{
+				unsigned int f = order[i];
+				unsigned int b = soup.offsets[f], k = soup.sizes[f];
+				std::copy(soup.corners.begin() + b, soup.corners.begin() + b + k, sorted.begin() + b);
+				std::sort(sorted.begin() + b, sorted.begin() + b + k);
+			});
+			auto same = [&](unsigned int f, unsigned int g)
+			{
+				return soup.sizes[f] == soup.sizes[g] && std::equal(sorted.begin() + soup.offsets[f],
+					sorted.begin() + soup.offsets[f] + soup.sizes[f], sorted.begin() + soup.offsets[g]);
+			};
+			parallel_sort(order, [&](unsigned int f, unsigned int g)
+			{
+				if (soup.sizes[f] != soup.sizes[g]) return soup.sizes[f] < soup.sizes[g];
+				auto fb = sorted.begin() + soup.offsets[f], gb = sorted.begin() + soup.offsets[g];
+				auto mismatch = std::mismatch(fb, fb + soup.sizes[f], gb);
+				if (mismatch.first != fb + soup.sizes[f]) return *mismatch.first < *mismatch.second;
+				return f < g;
+			});
+			size_t removed = 0;
+			for (size_t i = 1; i < order.size(); i++)
+			{
+				if (same(order[i - 1], order[i]))
+				{
+					soup.keep[order[i]] = 0;
+					removed++;
+				}
+			}
+			return removed;
+		}
+
+		// 保留的面一次性写回：只加入被引用的顶点，编号保持原先的相对顺序
+		void rebuild(Mesh& mesh, const FaceSoup& soup, const OpenMesh::HPropHandleT<int>* uv, Stats& stats)
+		{
+			size_t nv = mesh.n_vertices();
+			std::vector<int> new_index(nv, -1);
+			for (size_t f = 0; f < soup.n_faces(); f++)
+			{
+				if (!soup.keep[f]) continue;
+				for (unsigned int i = 0; i < soup.sizes[f]; i++)
+				{
+					new_index[soup.corners[soup.offsets[f] + i]] = 0;
+				}
+			}
+			std::vector<Vec3d> points;
+			for (size_t v = 0; v < nv; v++)
+			{
+				if (new_index[v] < 0) continue;
+				new_index[v] = int(points.size());
+				points.push_back(mesh.point(VH(int(v))));
+			}
+			stats.unreferenced_vertices = nv - stats.welded_vertices - points.size();
+
+			mesh.clear();
+			mesh.reserve(points.size(), points.size() + soup.corners.size() / 2, soup.n_faces());
+			for (const Vec3d& p : points)
+			{
+				mesh.add_vertex(p);
+			}
+			std::vector<VH> face;
+			for (size_t f = 0; f < soup.n_faces(); f++)
+			{
+				if (!soup.keep[f]) continue;
+				unsigned int b = soup.offsets[f], k = soup.sizes[f];
+				face.clear();
+				for (unsigned int i = 0; i < k; i++)
+				{
+					face.push_back(VH(new_index[soup.corners[b + i]]));
+				}
+				FH fh = mesh.add_face(face);
+				if (!fh.is_valid())
+				{
+					stats.non_manifold_faces++;
+					continue;
+				}
+				if (!uv) continue;
+				for (auto fh_it = mesh.fh_iter(fh); fh_it.is_valid(); ++fh_it)
+				{
+					VH to = mesh.to_vertex_handle(*fh_it);
+					for (unsigned int i = 0; i < k; i++)
+					{
+						if (face[i] == to) mesh.property(*uv, *fh_it) = soup.corner_uv[b + i];
+					}
+				}
+			}
+		}
+
+		// 按最小内角切耳三角化边界环，再按Liepa的密度准则在面心处加点、翻边使补片接近周围的边长。
+		// 补片的面、边、顶点都排在原有元素之后，用编号区分
+		class HoleFiller
+		{
+		public:
+			HoleFiller(Mesh& mesh, const Options& options, Stats& stats)
+				: mesh(mesh), options(options), stats(stats)
+			{
+				has_uv = mesh.get_property_handle(hvt_index, "hvt_index") && mesh.get_property_handle(mvt_list, "mvt_list");
+			}
+
+			void run()
+			{
+				first_vertex = mesh.n_vertices();
+				first_edge = mesh.n_edges();
+				first_face = mesh.n_faces();
+				sigma.assign(first_vertex, 0.0);
+				if (has_uv) vertex_uv.assign(first_vertex, -1);
+
+				std::vector<std::vector<HH>> loops;
+				std::vector<unsigned char> visited(mesh.n_halfedges(), 0);
+				for (size_t i = 0; i < mesh.n_halfedges(); i++)
+				{
+					HH h(int(i));
+					if (visited[i] || !mesh.is_boundary(h)) continue;
+					std::vector<HH> loop;
+					HH cur = h;
+					do
+					{
+						visited[cur.idx()] = 1;
+						loop.push_back(cur);
+						cur = mesh.next_halfedge_handle(cur);
+					} while (cur != h && loop.size() <= mesh.n_halfedges());
+					loops.push_back(std::move(loop));
+				}
+
+				for (const std::vector<HH>& loop : loops)
+				{
+					if (fillable(loop) && triangulate(loop)) stats.holes_filled++;
+					else stats.holes_skipped++;
+				}
+				if (mesh.n_faces() == first_face) return;
+				refine();
+
+				if (has_uv)
+				{
+					for (size_t f = first_face; f < mesh.n_faces(); f++)
+					{
+						for (auto fh_it = mesh.fh_iter(FH(int(f))); fh_it.is_valid(); ++fh_it)
+						{
+							mesh.property(hvt_index, *fh_it) = vertex_uv[mesh.to_vertex_handle(*fh_it).idx()];
+						}
+					}
+				}
+				stats.hole_faces = mesh.n_faces() - first_face;
+			}
+
+			size_t first_new_vertex() const { return first_vertex; }
+
+		private:
+			// 太大、经过非流形顶点（同一顶点出现两次）、悬空边或面积为0的环不补
+			bool fillable(const std::vector<HH>& loop)
+			{
+				if (loop.size() < 3 || loop.size() > options.max_hole_edges) return false;
+				std::vector<int> vertices;
+				for (HH h : loop)
+				{
+					if (mesh.is_boundary(mesh.opposite_halfedge_handle(h))) return false;
+					vertices.push_back(mesh.from_vertex_handle(h).idx());
+				}
+				std::sort(vertices.begin(), vertices.end());
+				if (std::adjacent_find(vertices.begin(), vertices.end()) != vertices.end()) return false;
+				return newell_normal(loop).norm() > 0.0;
+			}
+
+			Vec3d newell_normal(const std::vector<HH>& loop) const
+			{
+				Vec3d normal(0.0, 0.0, 0.0);
+				for (HH h : loop)
+				{
+					normal += mesh.point(mesh.from_vertex_handle(h)) % mesh.point(mesh.to_vertex_handle(h));
+				}
+				return normal;
+			}
+
+			// 多边形按边界半边的方向排列，正是新面应有的朝向；normal为其Newell法向
+			double interior_angle(VH prev, VH cur, VH next, const Vec3d& normal) const
+			{
+				Vec3d a = mesh.point(prev) - mesh.point(cur);
+				Vec3d b = mesh.point(next) - mesh.point(cur);
+				double angle = std::atan2((a % b).norm(), a | b);
+				return ((b % a) | normal) >= 0.0 ? angle : 2.0 * M_PI - angle;
+			}
+
+			bool triangulate(const std::vector<HH>& loop)
+			{
+				Vec3d normal = newell_normal(loop);
+				size_t n = loop.size();
+				std::vector<VH> polygon(n);
+				for (size_t i = 0; i < n; i++)
+				{
+					polygon[i] = mesh.from_vertex_handle(loop[i]);
+					VH v = polygon[i];
+					sigma[v.idx()] = 0.5 * (mesh.calc_edge_length(loop[i]) + mesh.calc_edge_length(loop[(i + n - 1) % n]));
+					if (has_uv) vertex_uv[v.idx()] = mesh.property(hvt_index, mesh.opposite_halfedge_handle(loop[i]));
+				}
+				std::vector<double> angles(n);
+				auto update = [&](size_t i)
+				{
+					size_t m = polygon.size();
+					angles[i] = interior_angle(polygon[(i + m - 1) % m], polygon[i], polygon[(i + 1) % m], normal);
+				};
+				for (size_t i = 0; i < n; i++)
+				{
+					update(i);
+				}
+
+				// 每次切掉内角最小的耳朵；新对角线已存在于网格中的耳朵跳过
+				while (polygon.size() > 3)
+				{
+					size_t m = polygon.size();
+					size_t best = m;
+					for (size_t i = 0; i < m; i++)
+					{
+						if (best < m && angles[i] >= angles[best]) continue;
+						if (mesh.find_halfedge(polygon[(i + m - 1) % m], polygon[(i + 1) % m]).is_valid()) continue;
+						best = i;
+					}
+					if (best == m) return false;
+					if (!add_face(polygon[(best + m - 1) % m], polygon[best], polygon[(best + 1) % m])) return false;
+					polygon.erase(polygon.begin() + best);
+					angles.erase(angles.begin() + best);
+					m--;
+					update((best + m - 1) % m);
+					update(best % m);
+				}
+				return add_face(polygon[0], polygon[1], polygon[2]);
+			}
+
+			bool add_face(VH a, VH b, VH c)
+			{
+				return mesh.add_face(a, b, c).is_valid();
+			}
+
+			// Liepa的加密准则：面心到每个角的距离乘√2都超过两端的局部尺度时在面心加点
+			void refine()
+			{
+				const double alpha = std::sqrt(2.0);
+				for (int pass = 0; pass < kRefinePasses; pass++)
+				{
+					size_t splits = 0;
+					size_t nf = mesh.n_faces();
+					for (size_t f = first_face; f < nf; f++)
+					{
+						FH fh(int(f));
+						VH v[3];
+						int k = 0;
+						for (auto fv_it = mesh.cfv_iter(fh); fv_it.is_valid() && k < 3; ++fv_it)
+						{
+							v[k++] = *fv_it;
+						}
+						Vec3d center = (mesh.point(v[0]) + mesh.point(v[1]) + mesh.point(v[2])) / 3.0;
+						double scale = (sigma[v[0].idx()] + sigma[v[1].idx()] + sigma[v[2].idx()]) / 3.0;
+						bool split = true;
+						for (int c = 0; c < 3 && split; c++)
+						{
+							double d = alpha * (center - mesh.point(v[c])).norm();
+							split = d > scale && d > sigma[v[c].idx()];
+						}
+						if (!split) continue;
+
+						VH center_vertex = mesh.add_vertex(center);
+						sigma.push_back(scale);
+						if (has_uv) vertex_uv.push_back(interpolate_uv(v));
+						mesh.split(fh, center_vertex);
+						splits++;
+					}
+					if (splits == 0) break;
+					relax();
+				}
+			}
+
+			// 补片内部的边，两侧对角之和超过π时翻转（Delaunay条件）
+			void relax()
+			{
+				for (int pass = 0; pass < kRelaxPasses; pass++)
+				{
+					size_t flips = 0;
+					for (size_t e = first_edge; e < mesh.n_edges(); e++)
+					{
+						EH eh(int(e));
+						if (mesh.is_boundary(eh)) continue;
+						HH h0 = mesh.halfedge_handle(eh, 0), h1 = mesh.halfedge_handle(eh, 1);
+						const Vec3d& a = mesh.point(mesh.from_vertex_handle(h0));
+						const Vec3d& b = mesh.point(mesh.to_vertex_handle(h0));
+						const Vec3d& c = mesh.point(mesh.to_vertex_handle(mesh.next_halfedge_handle(h0)));
+						const Vec3d& d = mesh.point(mesh.to_vertex_handle(mesh.next_halfedge_handle(h1)));
+						double gamma = std::atan2(((a - c) % (b - c)).norm(), (a - c) | (b - c));
+						double delta = std::atan2(((a - d) % (b - d)).norm(), (a - d) | (b - d));
+						if (gamma + delta > M_PI + 1e-9 && flip_openmesh(eh, mesh)) flips++;
+					}
+					if (flips == 0) break;
+				}
+			}
+
+			int interpolate_uv(const VH* v)
+			{
+				std::vector<Mesh::TexCoord2D>& list = mesh.property(mvt_list);
+				Mesh::TexCoord2D sum(0.0, 0.0);
+				int count = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int index = vertex_uv[v[c].idx()];
+					if (index < 0 || index >= int(list.size())) continue;
+					sum += list[index];
+					count++;
+				}
+				if (count == 0) return -1;
+				list.push_back(sum / double(count));
+				return int(list.size()) - 1;
+			}
+
+			Mesh& mesh;
+			const Options& options;
+			Stats& stats;
+			bool has_uv = false;
+			OpenMesh::HPropHandleT<int> hvt_index;
+			OpenMesh::MPropHandleT<std::vector<Mesh::TexCoord2D>> mvt_list;
+			std::vector<double> sigma;     // 顶点的局部尺度：边界顶点取相邻两条边界边的平均长度
+			std::vector<int> vertex_uv;    // 补片中每个顶点使用的纹理坐标
+			size_t first_vertex = 0;
+			size_t first_edge = 0;
+			size_t first_face = 0;
+		};
+	}
+
+	bool repair(Mesh& mesh, const Options& options, Stats* stats)
+	{
+		Stats local;
+		Stats& s = stats ? *stats : local;
+		s = Stats();
+		if (mesh.n_vertices() == 0 || mesh.n_faces() == 0) return false;
+
+		OpenMesh::HPropHandleT<int> hvt_index;
+		const OpenMesh::HPropHandleT<int>* uv = mesh.get_property_handle(hvt_index, "hvt_index") ? &hvt_index : nullptr;
+
+		auto start = std::chrono::steady_clock::now();
+		Vec3d lo = mesh.point(VH(0)), hi = lo;
+		for (auto vh : mesh.vertices())
+		{
+			lo.minimize(mesh.point(vh));
+			hi.maximize(mesh.point(vh));
+		}
+		double diagonal = (hi - lo).norm();
+		double tolerance = options.weld_tolerance < 0.0 ? kDefaultTolerance * diagonal : options.weld_tolerance;
+
+		FaceSoup soup;
+		extract(mesh, uv, soup);
+		std::vector<unsigned int> rep;
+		s.welded_vertices = weld(mesh, tolerance, rep);
+		s.weld_ms = elapsed_ms(start);
+
+		start = std::chrono::steady_clock::now();
+		s.degenerate_faces = remove_degenerate(mesh, rep, kDegenerateArea * diagonal * diagonal, options.remove_degenerate, soup);
+		if (options.remove_duplicates) s.duplicate_faces = remove_duplicates(soup);
+		std::vector<unsigned int>().swap(rep);
+		rebuild(mesh, soup, uv, s);
+		s.clean_ms = elapsed_ms(start);
+		if (s.non_manifold_faces > 0)
+		{
+			std::cout << "repair: dropped " << s.non_manifold_faces << " faces that would create complex edges" << std::endl;
+		}
+
+		if (options.max_hole_edges == 0 || mesh.n_faces() == 0) return true;
+		start = std::chrono::steady_clock::now();
+		HoleFiller filler(mesh, options, s);
+		filler.run();
+		s.fill_ms = elapsed_ms(start);
+
+		size_t first_new = filler.first_new_vertex();
+		if (options.fair_holes && mesh.n_vertices() > first_new)
+		{
+			start = std::chrono::steady_clock::now();
+			SelectionBitset region(mesh.n_vertices());
+			for (size_t v = first_new; v < mesh.n_vertices(); v++)
+			{
+				region.set(v);
+			}
+			laplacian::OperatorCache fairing;
+			if (!fairing.fair(mesh, region))
+			{
+				std::cout << "repair: hole fairing skipped (triangle mesh required)" << std::endl;
+			}
+			s.fair_ms = elapsed_ms(start);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "my_traits.h"
+
+// 扫描网格修复：容差内的顶点焊接、退化面和重复面删除、补洞。
+// 焊接用PointGrid的半径查询找近邻顶点，再用mesh_analysis的无锁并查集合并成簇；
+// 清理后的面一次性重建成新网格（这就是唯一的一次压缩，不逐个删除元素再garbage_collection）；
+// 补洞按最小内角切耳三角化，再按Liepa 2003加密、翻边，并对新顶点做双拉普拉斯光顺
+namespace repair
+{
+	struct Options
+	{
+		double weld_tolerance = -1.0;  // 绝对距离；<0时取包围盒对角线的1e-6倍，0时只合并坐标完全相同的顶点
+		bool remove_degenerate = true; // 焊接后顶点不足3个或面积为0的面
+		bool remove_duplicates = true; // 顶点集合相同的面只保留一个（不论朝向）
+		size_t max_hole_edges = 500;   // 超过这么多边的边界环（如扫描的外轮廓）不补；0表示不补洞
+		bool fair_holes = true;        // 加密后的新顶点满足双拉普拉斯方程，仅三角形网格
+	};
+
+	struct Stats
+	{
+		size_t welded_vertices = 0;      // 被并入其他顶点的顶点
+		size_t unreferenced_vertices = 0;
+		size_t degenerate_faces = 0;
+		size_t duplicate_faces = 0;
+		size_t non_manifold_faces = 0;   // 重建时会产生复杂边、被OpenMesh拒绝的面
+		size_t holes_filled = 0;
+		size_t holes_skipped = 0;        // 太大、经过非流形顶点或面积为0的边界环
+		size_t hole_faces = 0;
+		double weld_ms = 0.0;
+		double clean_ms = 0.0;           // 退化面、重复面和重建
+		double fill_ms = 0.0;
+		double fair_ms = 0.0;
+	};
+
+	// 带hvt_index时纹理坐标索引随面保留，补洞的新顶点在mvt_list中追加插值得到的纹理坐标
+	bool repair(Mesh& mesh, const Options& options, Stats* stats = nullptr);
+}
@@ -0,0 +1,208 @@
+#include "self_intersection.h"
+#include "mesh_bvh.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace self_intersection
+{
+	namespace
+	{
+		typedef OpenMesh::Vec3d Vec3d;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// d在三角形abc所在平面的哪一侧（带符号体积的6倍）
+		inline double orient(const Vec3d& a, const Vec3d& b, const Vec3d& c, const Vec3d& d)
+		{
+			return ((b - a) % (c - a)) | (d - a);
+		}
+
+		inline bool same_strict_sign(const double* d)
+		{
+			return (d[0] > 0.0 && d[1] > 0.0 && d[2] > 0.0) || (d[0] < 0.0 && d[1] < 0.0 && d[2] < 0.0);
+		}
+
+		// 线段pq与闭三角形abc相交；线段落在三角形平面内时返回false，由共面测试处理
+		bool segment_triangle(const Vec3d& p, const Vec3d& q, const Vec3d& a, const Vec3d& b, const Vec3d& c)
+		{
+			double dp = orient(a, b, c, p), dq = orient(a, b, c, q);
+			if ((dp > 0.0 && dq > 0.0) || (dp < 0.0 && dq < 0.0)) return false;
+			if (dp == 0.0 && dq == 0.0) return false;
+			double s[3] = { orient(p, q, a, b), orient(p, q, b, c), orient(p, q, c, a) };
+			return (s[0] >= 0.0 && s[1] >= 0.0 && s[2] >= 0.0) || (s[0] <= 0.0 && s[1] <= 0.0 && s[2] <= 0.0);
+		}
+
+		// 以下为投影到法向最大分量以外两个坐标轴上的二维测试
+		struct Plane2D
+		{
+			int x, y;
+
+			explicit Plane2D(const Vec3d& normal)
+			{
+				Vec3d n(std::abs(normal[0]), std::abs(normal[1]), std::abs(normal[2]));
+				int drop = n[0] >= n[1] && n[0] >= n[2] ? 0 : (n[1] >= n[2] ? 1 : 2);
+				x = (drop + 1) % 3;
+				y = (drop + 2) % 3;
+			}
+
+			double cross(const Vec3d& o, const Vec3d& a, const Vec3d& b) const
+			{
+				return (a[x] - o[x]) * (b[y] - o[y]) - (a[y] - o[y]) * (b[x] - o[x]);
+			}
+
+			bool on_segment(const Vec3d& p, const Vec3d& a, const Vec3d& b) const
+			{
+				return std::min(a[x], b[x]) <= p[x] && p[x] <= std::max(a[x], b[x])
+					&& std::min(a[y], b[y]) <= p[y] && p[y] <= std::max(a[y], b[y]);
+			}
+
+			bool segments_intersect(const Vec3d& a, const Vec3d& b, const Vec3d& c, const Vec3d& d) const
+			{
+				double d1 = cross(c, d, a), d2 = cross(c, d, b), d3 = cross(a, b, c), d4 = cross(a, b, d);
+				if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0))) return true;
+				return (d1 == 0.0 && on_segment(a, c, d)) || (d2 == 0.0 && on_segment(b, c, d))
+					|| (d3 == 0.0 && on_segment(c, a, b)) || (d4 == 0.0 && on_segment(d, a, b));
+			}
+
+			bool inside(const Vec3d& p, const Vec3d* t) const
+			{
+				double s[3] = { cross(t[0], t[1], p), cross(t[1], t[2], p), cross(t[2], t[0], p) };
+				return (s[0] >= 0.0 && s[1] >= 0.0 && s[2] >= 0.0) || (s[0] <= 0.0 && s[1] <= 0.0 && s[2] <= 0.0);
+			}
+		};
+
+		bool coplanar_triangles(const Vec3d* P, const Vec3d* Q)
+		{
+			Plane2D plane((P[1] - P[0]) % (P[2] - P[0]));
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					if (plane.segments_intersect(P[i], P[(i + 1) % 3], Q[j], Q[(j + 1) % 3])) return true;
+				}
+			}
+			return plane.inside(P[0], Q) || plane.inside(Q[0], P);
+		}
+
+		// 没有公共顶点的两个三角形
+		bool triangles_intersect(const Vec3d* P, const Vec3d* Q)
+		{
+			double dq[3] = { orient(P[0], P[1], P[2], Q[0]), orient(P[0], P[1], P[2], Q[1]), orient(P[0], P[1], P[2], Q[2]) };
+			if (same_strict_sign(dq)) return false;
+			double dp[3] = { orient(Q[0], Q[1], Q[2], P[0]), orient(Q[0], Q[1], Q[2], P[1]), orient(Q[0], Q[1], Q[2], P[2]) };
+			if (same_strict_sign(dp)) return false;
+			if (dq[0] == 0.0 && dq[1] == 0.0 && dq[2] == 0.0) return coplanar_triangles(P, Q);
+			for (int i = 0; i < 3; i++)
+			{
+				if (segment_triangle(P[i], P[(i + 1) % 3], Q[0], Q[1], Q[2])) return true;
+				if (segment_triangle(Q[i], Q[(i + 1) % 3], P[0], P[1], P[2])) return true;
+			}
+			return false;
+		}
+
+		// 方向d严格位于以s为顶点、从e1转到e2的角内（normal给出转向）
+		bool in_sector(const Vec3d& d, const Vec3d& e1, const Vec3d& e2, const Vec3d& normal)
+		{
+			return ((e1 % d) | normal) > 0.0 && ((d % e2) | normal) > 0.0;
+		}
+
+		bool parallel_same_direction(const Vec3d& a, const Vec3d& b)
+		{
+			return (a % b).sqrnorm() == 0.0 && (a | b) > 0.0;
+		}
+
+		// P[0] == Q[0]的两个三角形：交集除公共顶点外非空时才算相交
+		bool share_vertex_intersect(const Vec3d* P, const Vec3d* Q)
+		{
+			const Vec3d& s = P[0];
+			Vec3d np = (P[1] - s) % (P[2] - s);
+			if (orient(P[0], P[1], P[2], Q[1]) == 0.0 && orient(P[0], P[1], P[2], Q[2]) == 0.0)
+			{
+				Vec3d p1 = P[1] - s, p2 = P[2] - s, q1 = Q[1] - s, q2 = Q[2] - s;
+				Vec3d nq = q1 % q2;
+				return in_sector(q1, p1, p2, np) || in_sector(q2, p1, p2, np)
+					|| in_sector(p1, q1, q2, nq) || in_sector(p2, q1, q2, nq)
+					|| (parallel_same_direction(p1, q1) && parallel_same_direction(p2, q2))
+					|| (parallel_same_direction(p1, q2) && parallel_same_direction(p2, q1));
+			}
+			return segment_triangle(P[1], P[2], Q[0], Q[1], Q[2]) || segment_triangle(Q[1], Q[2], P[0], P[1], P[2]);
+		}
+
+		// 共享边(s, t)的两个三角形，a和b为各自的第三个顶点：共面且在边的同一侧时折叠重叠
+		bool share_edge_intersect(const Vec3d& s, const Vec3d& t, const Vec3d& a, const Vec3d& b)
+		{
+			if (orient(s, t, a, b) != 0.0) return false;
+			return (((t - s) % (a - s)) | ((t - s) % (b - s))) > 0.0;
+		}
+
+		// 按公共顶点数分情况
+		bool test_pair(const MeshBVH& bvh, int ta, int tb)
+		{
+			const unsigned int* va = bvh.triangle_vertices(ta);
+			const unsigned int* vb = bvh.triangle_vertices(tb);
+			int shared = 0, ia[3], ib[3];
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					if (va[i] != vb[j]) continue;
+					ia[shared] = i;
+					ib[shared] = j;
+					shared++;
+				}
+			}
+			if (shared == 3) return true;   // 重复的面
+
+			Vec3d P[3], Q[3];
+			if (shared == 2)
+			{
+				int a = 3 - ia[0] - ia[1], b = 3 - ib[0] - ib[1];
+				return share_edge_intersect(bvh.vertex(va[ia[0]]), bvh.vertex(va[ia[1]]), bvh.vertex(va[a]), bvh.vertex(vb[b]));
+			}
+			// 有一个公共顶点时把它轮换到第0个
+			int ra = shared == 1 ? ia[0] : 0, rb = shared == 1 ? ib[0] : 0;
+			for (int k = 0; k < 3; k++)
+			{
+				P[k] = bvh.vertex(va[(ra + k) % 3]);
+				Q[k] = bvh.vertex(vb[(rb + k) % 3]);
+			}
+			return shared == 1 ? share_vertex_intersect(P, Q) : triangles_intersect(P, Q);
+		}
+	}
+
+	void find(const Mesh& mesh, std::vector<std::pair<int, int>>& face_pairs, Stats* stats)
+	{
+		face_pairs.clear();
+		if (stats) *stats = Stats();
+		auto start = std::chrono::steady_clock::now();
+		MeshBVH bvh;
+		bvh.build(mesh);
+		if (stats) stats->build_ms = elapsed_ms(start);
+
+		start = std::chrono::steady_clock::now();
+		unsigned int threads = parallel::thread_count();
+		std::vector<std::vector<std::pair<int, int>>> hits(threads);
+		std::vector<size_t> candidates(threads, 0);
+		bvh.for_each_overlapping_pair([&](int ta, int tb, unsigned int tid)
+		{
+			int fa = bvh.triangle_face(ta), fb = bvh.triangle_face(tb);
+			if (fa == fb) return;
+			candidates[tid]++;
+			if (test_pair(bvh, ta, tb)) hits[tid].push_back(std::make_pair(std::min(fa, fb), std::max(fa, fb)));
+		});
+		for (unsigned int t = 0; t < threads; t++)
+		{
+			face_pairs.insert(face_pairs.end(), hits[t].begin(), hits[t].end());
+			if (stats) stats->candidate_pairs += candidates[t];
+		}
+		// 多边形面的多个三角形可能给出同一个面对
+		std::sort(face_pairs.begin(), face_pairs.end());
+		face_pairs.erase(std::unique(face_pairs.begin(), face_pairs.end()), face_pairs.end());
+		if (stats) stats->test_ms = elapsed_ms(start);
+	}
+}
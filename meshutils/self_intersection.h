@@ -0,0 +1,20 @@
+#pragma once
+#include "my_traits.h"
+#include <utility>
+#include <vector>
+
+// 自相交检测：MeshBVH与自身做并行双树遍历作为粗测，对包围盒相交的三角形对做精确的三角形求交。
+// 共享顶点或边的相邻三角形只有在公共元素之外还重叠时才算相交（同CGAL的self_intersections）；
+// 同一多边形扇形三角化出的三角形之间不检查。谓词用double计算，不是精确谓词
+namespace self_intersection
+{
+	struct Stats
+	{
+		double build_ms = 0.0;        // BVH构建
+		double test_ms = 0.0;         // 双树遍历和三角形求交
+		size_t candidate_pairs = 0;   // 包围盒相交的三角形对
+	};
+
+	// face_pairs为相交的面对(f < g)，已排序去重
+	void find(const Mesh& mesh, std::vector<std::pair<int, int>>& face_pairs, Stats* stats = nullptr);
+}
@@ -0,0 +1,821 @@
+#include "subdivision.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace subdivision
+{
+	namespace
+	{
+		const unsigned int kInvalid = std::numeric_limits<unsigned int>::max();
+
+		// 无向边表：边e的端点为edge_vertices[2e] < edge_vertices[2e+1]，可直接作为GL_LINES索引；
+		// corner_edge[i]是角点i到同一面下一个角点的边。
+		struct EdgeTopology
+		{
+			std::vector<unsigned int> edge_vertices;
+			std::vector<unsigned char> edge_faces;     // 相邻面数，饱和到255
+			std::vector<unsigned int> corner_edge;
+
+			size_t n_edges() const { return edge_faces.size(); }
+			unsigned int v0(size_t e) const { return edge_vertices[2 * e]; }
+			unsigned int v1(size_t e) const { return edge_vertices[2 * e + 1]; }
+
+			// 边e被细分后靠近端点v的那一半
+			unsigned int child(unsigned int e, unsigned int v) const { return 2 * e + (v == v0(e) ? 0 : 1); }
+
+			void resize(size_t n_edges, size_t n_corners)
+			{
+				edge_vertices.resize(2 * n_edges);
+				edge_faces.resize(n_edges);
+				corner_edge.resize(n_corners);
+			}
+
+			void set(size_t e, unsigned int a, unsigned int b, unsigned char faces)
+			{
+				edge_vertices[2 * e] = std::min(a, b);
+				edge_vertices[2 * e + 1] = std::max(a, b);
+				edge_faces[e] = faces;
+			}
+		};
+
+		// 从任意网格建边表。每条边只登记在较小端点的桶里，桶内排序去重后按顺序编号，
+		// 同一条边在桶里出现的次数就是相邻的面数。只在第一层细分前调用一次，
+		// 之后每层的边表由derive_*直接推出。
+		void build_edges(const FlatMesh& mesh, EdgeTopology& topo)
+		{
+			size_t nv = mesh.n_vertices();
+			size_t nf = mesh.n_faces();
+
+			// 1. 统计每个桶的大小并前缀求和
+			std::vector<unsigned int> offsets(nv + 1, 0);
+			for (size_t f = 0; f < nf; f++)
+			{
+				unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+				for (unsigned int j = 0; j < k; j++)
+				{
+					unsigned int a = mesh.indices[begin + j];
+					unsigned int b = mesh.indices[begin + (j + 1) % k];
+					offsets[std::min(a, b) + 1]++;
+				}
+			}
+			for (size_t v = 0; v < nv; v++)
+			{
+				offsets[v + 1] += offsets[v];
+			}
+
+			// 2. 填桶
+			std::vector<unsigned int> bucket(offsets[nv]);
+			std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t f = 0; f < nf; f++)
+			{
+				unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+				for (unsigned int j = 0; j < k; j++)
+				{
+					unsigned int a = mesh.indices[begin + j];
+					unsigned int b = mesh.indices[begin + (j + 1) % k];
+					bucket[cursor[std::min(a, b)]++] = std::max(a, b);
+				}
+			}
+
+			// 3. 每个桶排序去重（并行），记下每条边的面数
+			std::vector<unsigned char> bucket_faces(bucket.size());
+			std::vector<unsigned int>& unique_count = cursor;
+			parallel::for_each(0, nv, [&](size_t v)
+			{
+				unsigned int* first = bucket.data() + offsets[v];
+				unsigned int n = offsets[v + 1] - offsets[v];
+				// 桶很小（约为价的一半），插入排序即可
+				for (unsigned int i = 1; i < n; i++)
+				{
+					unsigned int x = first[i];
+					unsigned int j = i;
+					while (j > 0 && first[j - 1] > x)
+					{
+						first[j] = first[j - 1];
+						j--;
+					}
+					first[j] = x;
+				}
+				unsigned char* faces = bucket_faces.data() + offsets[v];
+				unsigned int u = 0;
+				for (unsigned int i = 0; i < n; i++)
+				{
+					if (u > 0 && first[u - 1] == first[i])
+					{
+						if (faces[u - 1] < 255) faces[u - 1]++;
+					}
+					else
+					{
+						first[u] = first[i];
+						faces[u] = 1;
+						u++;
+					}
+				}
+				unique_count[v] = u;
+			}, 1024);
+
+			// 4. 编号
+			std::vector<unsigned int> edge_base(nv);
+			unsigned int n_edges = 0;
+			for (size_t v = 0; v < nv; v++)
+			{
+				edge_base[v] = n_edges;
+				n_edges += unique_count[v];
+			}
+			topo.resize(n_edges, mesh.indices.size());
+			parallel::for_each(0, nv, [&](size_t v)
+			{
+				for (unsigned int k = 0; k < unique_count[v]; k++)
+				{
+					unsigned int e = edge_base[v] + k;
+					topo.edge_vertices[2 * e] = unsigned(v);
+					topo.edge_vertices[2 * e + 1] = bucket[offsets[v] + k];
+					topo.edge_faces[e] = bucket_faces[offsets[v] + k];
+				}
+			}, 1024);
+
+			// 5. 角点到边的映射
+			parallel::for_each(0, nf, [&](size_t f)
+			{
+				unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+				for (unsigned int j = 0; j < k; j++)
+				{
+					unsigned int a = mesh.indices[begin + j];
+					unsigned int b = mesh.indices[begin + (j + 1) % k];
+					unsigned int lo = std::min(a, b), hi = std::max(a, b);
+					const unsigned int* first = bucket.data() + offsets[lo];
+					unsigned int u = 0;
+					while (first[u] != hi) u++;
+					topo.corner_edge[begin + j] = edge_base[lo] + u;
+				}
+			}, 1024);
+		}
+
+		// 细分后的边：每条旧边分成两半（编号2e、2e+1），其余为面内新边，相邻面数为2
+		void derive_child_edges(const EdgeTopology& in, size_t nv, EdgeTopology& out)
+		{
+			parallel::for_each(0, in.n_edges(), [&](size_t e)
+			{
+				unsigned int mid = unsigned(nv + e);
+				out.set(2 * e, in.v0(e), mid, in.edge_faces[e]);
+				out.set(2 * e + 1, in.v1(e), mid, in.edge_faces[e]);
+			});
+		}
+
+		// Loop：面f的三个边点之间新增三条边，编号2E + 3f + {0, 1, 2}。
+		// 最后一层只需要边（用于渲染），with_corners为false时不生成corner_edge
+		void derive_loop_edges(const FlatMesh& in, const EdgeTopology& topo, bool with_corners, EdgeTopology& out)
+		{
+			size_t nv = in.n_vertices();
+			size_t nf = in.n_faces();
+			unsigned int base = unsigned(2 * topo.n_edges());
+			out.resize(base + 3 * nf, with_corners ? 12 * nf : 0);
+			derive_child_edges(topo, nv, out);
+			parallel::for_each(0, nf, [&](size_t f)
+			{
+				const unsigned int* t = in.indices.data() + 3 * f;
+				const unsigned int* ce = topo.corner_edge.data() + 3 * f;
+				unsigned int m0 = unsigned(nv) + ce[0], m1 = unsigned(nv) + ce[1], m2 = unsigned(nv) + ce[2];
+				unsigned int i0 = base + unsigned(3 * f), i1 = i0 + 1, i2 = i0 + 2;
+				out.set(i0, m0, m2, 2);
+				out.set(i1, m1, m0, 2);
+				out.set(i2, m2, m1, 2);
+				if (!with_corners) return;
+				// 与loop_step()中输出的三角形顺序一致
+				unsigned int* o = out.corner_edge.data() + 12 * f;
+				o[0] = topo.child(ce[0], t[0]); o[1] = i0; o[2] = topo.child(ce[2], t[0]);
+				o[3] = topo.child(ce[1], t[1]); o[4] = i1; o[5] = topo.child(ce[0], t[1]);
+				o[6] = topo.child(ce[2], t[2]); o[7] = i2; o[8] = topo.child(ce[1], t[2]);
+				o[9] = i1; o[10] = i2; o[11] = i0;
+			});
+		}
+
+		// Catmull-Clark：每个角点的出边点与面点之间新增一条边，编号2E + 角点序号
+		void derive_catmull_clark_edges(const FlatMesh& in, const EdgeTopology& topo, bool with_corners, EdgeTopology& out)
+		{
+			size_t nv = in.n_vertices();
+			size_t nf = in.n_faces();
+			size_t ne = topo.n_edges();
+			unsigned int base = unsigned(2 * ne);
+			out.resize(base + in.indices.size(), with_corners ? 4 * in.indices.size() : 0);
+			derive_child_edges(topo, nv, out);
+			parallel::for_each(0, nf, [&](size_t f)
+			{
+				unsigned int begin = in.face_begin(f), k = in.face_size(f);
+				unsigned int fp = unsigned(nv + ne + f);
+				for (unsigned int j = 0; j < k; j++)
+				{
+					unsigned int c = begin + j;
+					unsigned int prev = begin + (j + k - 1) % k;
+					unsigned int v = in.indices[c];
+					out.set(base + c, unsigned(nv) + topo.corner_edge[c], fp, 2);
+					if (!with_corners) continue;
+					unsigned int* o = out.corner_edge.data() + 4 * c;
+					o[0] = topo.child(topo.corner_edge[c], v);
+					o[1] = base + c;
+					o[2] = base + prev;
+					o[3] = topo.child(topo.corner_edge[prev], v);
+				}
+			}, 1024);
+		}
+
+		// 顶点的一环信息：价、邻点坐标和、边界邻点坐标和
+		struct VertexRing
+		{
+			std::vector<unsigned int> valence;
+			std::vector<unsigned int> boundary_count;
+			std::vector<unsigned char> non_manifold;
+			std::vector<double> neighbor_sum;
+			std::vector<double> boundary_sum;
+		};
+
+		void build_rings(const FlatMesh& mesh, const EdgeTopology& topo, VertexRing& ring)
+		{
+			size_t nv = mesh.n_vertices();
+			ring.valence.assign(nv, 0);
+			ring.boundary_count.assign(nv, 0);
+			ring.non_manifold.assign(nv, 0);
+			ring.neighbor_sum.assign(3 * nv, 0.0);
+			ring.boundary_sum.assign(3 * nv, 0.0);
+
+			const double* p = mesh.points.data();
+			for (size_t e = 0; e < topo.n_edges(); e++)
+			{
+				unsigned int a = topo.v0(e), b = topo.v1(e);
+				ring.valence[a]++;
+				ring.valence[b]++;
+				for (int c = 0; c < 3; c++)
+				{
+					ring.neighbor_sum[3 * a + c] += p[3 * b + c];
+					ring.neighbor_sum[3 * b + c] += p[3 * a + c];
+				}
+				unsigned char nf = topo.edge_faces[e];
+				if (nf == 1)
+				{
+					ring.boundary_count[a]++;
+					ring.boundary_count[b]++;
+					for (int c = 0; c < 3; c++)
+					{
+						ring.boundary_sum[3 * a + c] += p[3 * b + c];
+						ring.boundary_sum[3 * b + c] += p[3 * a + c];
+					}
+				}
+				else if (nf > 2)
+				{
+					ring.non_manifold[a] = 1;
+					ring.non_manifold[b] = 1;
+				}
+			}
+		}
+
+		// 边界顶点：两个边界邻点时用3/4 + 1/8 + 1/8，其余情况（角点、非流形）保持不动
+		inline bool boundary_vertex_rule(const VertexRing& ring, const double* p, size_t v, double* out)
+		{
+			if (ring.boundary_count[v] == 0 && !ring.non_manifold[v]) return false;
+			for (int c = 0; c < 3; c++)
+			{
+				if (ring.boundary_count[v] == 2 && !ring.non_manifold[v])
+					out[c] = 0.75 * p[3 * v + c] + 0.125 * ring.boundary_sum[3 * v + c];
+				else
+					out[c] = p[3 * v + c];
+			}
+			return true;
+		}
+
+		// 每条边上两个相邻面（或对顶点）的槽位：方向a<b的一侧写0号槽，另一侧写1号槽，
+		// 流形且定向一致时两个面不会写同一个槽
+		void fill_edge_slots(const FlatMesh& mesh, const EdgeTopology& topo, bool store_face,
+			std::vector<unsigned int>& slots)
+		{
+			slots.assign(2 * topo.n_edges(), kInvalid);
+			parallel::for_each(0, mesh.n_faces(), [&](size_t f)
+			{
+				unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+				for (unsigned int j = 0; j < k; j++)
+				{
+					unsigned int a = mesh.indices[begin + j];
+					unsigned int b = mesh.indices[begin + (j + 1) % k];
+					unsigned int e = topo.corner_edge[begin + j];
+					if (topo.edge_faces[e] != 2) continue;
+					unsigned int value = store_face ? unsigned(f) : mesh.indices[begin + (j + 2) % k];
+					slots[2 * e + (a < b ? 0 : 1)] = value;
+				}
+			}, 1024);
+		}
+	}
+
+	bool FlatMesh::is_triangle_mesh() const
+	{
+		if (face_offsets.empty()) return uniform_size == 3;
+		for (size_t f = 0; f + 1 < face_offsets.size(); f++)
+		{
+			if (face_offsets[f + 1] - face_offsets[f] != 3) return false;
+		}
+		return true;
+	}
+
+	void from_openmesh(const Mesh& mesh, FlatMesh& flat)
+	{
+		size_t nv = mesh.n_vertices();
+		flat.points.resize(3 * nv);
+		if (nv > 0)
+		{
+			std::memcpy(flat.points.data(), mesh.points()->data(), 3 * nv * sizeof(double));
+		}
+
+		flat.edges.clear();
+		flat.indices.clear();
+		flat.indices.reserve(mesh.n_faces() * 4);
+		flat.face_offsets.clear();
+		flat.face_offsets.reserve(mesh.n_faces() + 1);
+		bool all_triangles = true;
+		for (auto fh : mesh.faces())
+		{
+			flat.face_offsets.push_back(unsigned(flat.indices.size()));
+			unsigned int k = 0;
+			for (auto fv_it = mesh.cfv_ccwbegin(fh); fv_it != mesh.cfv_ccwend(fh); ++fv_it)
+			{
+				flat.indices.push_back((*fv_it).idx());
+				k++;
+			}
+			all_triangles = all_triangles && k == 3;
+		}
+		flat.face_offsets.push_back(unsigned(flat.indices.size()));
+
+		if (all_triangles)
+		{
+			flat.face_offsets.clear();
+			flat.uniform_size = 3;
+		}
+	}
+
+	// 逐面add_face，用于无法直接建立半边结构的非流形网格
+	static void add_faces(const FlatMesh& flat, Mesh& mesh)
+	{
+		size_t nv = flat.n_vertices();
+		size_t nf = flat.n_faces();
+		mesh.reserve(nv, nv + nf, nf);
+
+		std::vector<Mesh::VertexHandle> handles(nv);
+		for (size_t v = 0; v < nv; v++)
+		{
+			handles[v] = mesh.add_vertex(Mesh::Point(flat.points[3 * v], flat.points[3 * v + 1], flat.points[3 * v + 2]));
+		}
+		std::vector<Mesh::VertexHandle> face;
+		for (size_t f = 0; f < nf; f++)
+		{
+			unsigned int begin = flat.face_begin(f), k = flat.face_size(f);
+			face.clear();
+			for (unsigned int j = 0; j < k; j++)
+			{
+				face.push_back(handles[flat.indices[begin + j]]);
+			}
+			mesh.add_face(face);
+		}
+	}
+
+	void to_openmesh(const FlatMesh& flat, Mesh& mesh)
+	{
+		mesh.clear();
+		size_t nv = flat.n_vertices();
+		size_t nf = flat.n_faces();
+
+		// 边表中边e对应OpenMesh的边e，半边2e从v0指向v1，2e+1反向；
+		// 每个角点就是从它出发的那条半边
+		EdgeTopology topo;
+		build_edges(flat, topo);
+		size_t ne = topo.n_edges();
+		size_t nc = flat.indices.size();
+		std::vector<unsigned int> corner_halfedge(nc);
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			unsigned int begin = flat.face_begin(f), k = flat.face_size(f);
+			for (unsigned int j = 0; j < k; j++)
+			{
+				unsigned int e = topo.corner_edge[begin + j];
+				corner_halfedge[begin + j] = 2 * e + (flat.indices[begin + j] == topo.v0(e) ? 0 : 1);
+			}
+		}, 1024);
+
+		// 半边所属的面；两个面用到同一条半边说明边非流形或定向不一致
+		bool manifold = true;
+		std::vector<unsigned int> halfedge_face(2 * ne, kInvalid);
+		for (size_t f = 0; f < nf && manifold; f++)
+		{
+			unsigned int begin = flat.face_begin(f), k = flat.face_size(f);
+			for (unsigned int j = 0; j < k; j++)
+			{
+				unsigned int& slot = halfedge_face[corner_halfedge[begin + j]];
+				if (slot != kInvalid) manifold = false;
+				slot = unsigned(f);
+			}
+		}
+
+		// 每个顶点至多一条出发的边界半边，作为顶点的半边
+		std::vector<unsigned int> vertex_halfedge(nv, kInvalid);
+		std::vector<unsigned int> corner_count(nv, 0);
+		for (size_t h = 0; h < 2 * ne && manifold; h++)
+		{
+			if (halfedge_face[h] != kInvalid) continue;
+			unsigned int e = unsigned(h / 2);
+			unsigned int from = (h & 1) ? topo.v1(e) : topo.v0(e);
+			if (vertex_halfedge[from] != kInvalid) manifold = false;
+			vertex_halfedge[from] = unsigned(h);
+		}
+		if (!manifold)
+		{
+			add_faces(flat, mesh);
+			return;
+		}
+		for (size_t c = 0; c < nc; c++)
+		{
+			unsigned int v = flat.indices[c];
+			if (vertex_halfedge[v] == kInvalid) vertex_halfedge[v] = corner_halfedge[c];
+			corner_count[v]++;
+		}
+
+		// 面内的下一条半边
+		std::vector<unsigned int> next(2 * ne, kInvalid);
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			unsigned int begin = flat.face_begin(f), k = flat.face_size(f);
+			for (unsigned int j = 0; j < k; j++)
+			{
+				next[corner_halfedge[begin + j]] = corner_halfedge[begin + (j + 1) % k];
+			}
+		}, 1024);
+
+		// 绕每个顶点一圈（对边的下一条），走到的面数必须等于它的角点数，
+		// 否则顶点处有多个扇形（非流形顶点）
+		std::vector<unsigned char> fan_ok(nv, 1);
+		parallel::for_each(0, nv, [&](size_t v)
+		{
+			unsigned int start = vertex_halfedge[v];
+			if (start == kInvalid) return;
+			unsigned int h = start, faces = 0;
+			do
+			{
+				if (halfedge_face[h] != kInvalid) faces++;
+				unsigned int o = next[h ^ 1];
+				if (o == kInvalid) break;
+				h = o;
+			} while (h != start && faces <= corner_count[v]);
+			fan_ok[v] = faces == corner_count[v];
+		}, 1024);
+		if (std::find(fan_ok.begin(), fan_ok.end(), 0) != fan_ok.end())
+		{
+			add_faces(flat, mesh);
+			return;
+		}
+
+		// 边界环：边界半边的下一条是其终点出发的边界半边
+		parallel::for_each(0, 2 * ne, [&](size_t h)
+		{
+			if (halfedge_face[h] != kInvalid) return;
+			unsigned int e = unsigned(h / 2);
+			unsigned int to = (h & 1) ? topo.v0(e) : topo.v1(e);
+			next[h] = vertex_halfedge[to];
+		});
+
+		mesh.resize(nv, ne, nf);
+		Mesh::Point* points = mesh.points();
+		if (nv > 0)
+		{
+			std::memcpy(points->data(), flat.points.data(), 3 * nv * sizeof(double));
+		}
+		parallel::for_each(0, 2 * ne, [&](size_t h)
+		{
+			Mesh::HalfedgeHandle hh = Mesh::HalfedgeHandle(int(h));
+			unsigned int e = unsigned(h / 2);
+			mesh.set_vertex_handle(hh, Mesh::VertexHandle(int((h & 1) ? topo.v0(e) : topo.v1(e))));
+			mesh.set_next_halfedge_handle(hh, Mesh::HalfedgeHandle(int(next[h])));
+			if (halfedge_face[h] != kInvalid) mesh.set_face_handle(hh, Mesh::FaceHandle(int(halfedge_face[h])));
+		});
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			mesh.set_halfedge_handle(Mesh::FaceHandle(int(f)), Mesh::HalfedgeHandle(int(corner_halfedge[flat.face_begin(f)])));
+		});
+		parallel::for_each(0, nv, [&](size_t v)
+		{
+			if (vertex_halfedge[v] != kInvalid)
+				mesh.set_halfedge_handle(Mesh::VertexHandle(int(v)), Mesh::HalfedgeHandle(int(vertex_halfedge[v])));
+		});
+	}
+
+	// 一层Loop细分，topo为输入网格的边表
+	static void loop_step(const FlatMesh& in, const EdgeTopology& topo, FlatMesh& out)
+	{
+		size_t nv = in.n_vertices();
+		size_t nf = in.n_faces();
+		VertexRing ring;
+		build_rings(in, topo, ring);
+		size_t ne = topo.n_edges();
+
+		const double* p = in.points.data();
+		out.points.resize(3 * (nv + ne));
+		double* q = out.points.data();
+
+		// 偶顶点（原顶点）：内部用Loop的beta权重
+		parallel::for_each(0, nv, [&](size_t v)
+		{
+			if (boundary_vertex_rule(ring, p, v, q + 3 * v)) return;
+			unsigned int n = ring.valence[v];
+			if (n == 0)
+			{
+				for (int c = 0; c < 3; c++) q[3 * v + c] = p[3 * v + c];
+				return;
+			}
+			double t = 0.375 + 0.25 * std::cos(2.0 * M_PI / n);
+			double beta = (0.625 - t * t) / n;
+			for (int c = 0; c < 3; c++)
+			{
+				q[3 * v + c] = (1.0 - n * beta) * p[3 * v + c] + beta * ring.neighbor_sum[3 * v + c];
+			}
+		});
+
+		// 奇顶点（边点）：内部3/8 + 3/8 + 1/8 + 1/8，边界取中点
+		std::vector<unsigned int> opposite;
+		fill_edge_slots(in, topo, false, opposite);
+		parallel::for_each(0, ne, [&](size_t e)
+		{
+			unsigned int a = topo.v0(e), b = topo.v1(e);
+			unsigned int c = opposite[2 * e], d = opposite[2 * e + 1];
+			double* r = q + 3 * (nv + e);
+			if (c != kInvalid && d != kInvalid)
+			{
+				for (int k = 0; k < 3; k++)
+					r[k] = 0.375 * (p[3 * a + k] + p[3 * b + k]) + 0.125 * (p[3 * c + k] + p[3 * d + k]);
+			}
+			else
+			{
+				for (int k = 0; k < 3; k++)
+					r[k] = 0.5 * (p[3 * a + k] + p[3 * b + k]);
+			}
+		});
+
+		// 每个三角形拆成四个
+		out.face_offsets.clear();
+		out.uniform_size = 3;
+		out.indices.resize(12 * nf);
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			const unsigned int* t = in.indices.data() + 3 * f;
+			unsigned int e0 = unsigned(nv) + topo.corner_edge[3 * f];
+			unsigned int e1 = unsigned(nv) + topo.corner_edge[3 * f + 1];
+			unsigned int e2 = unsigned(nv) + topo.corner_edge[3 * f + 2];
+			unsigned int* o = out.indices.data() + 12 * f;
+			o[0] = t[0]; o[1] = e0; o[2] = e2;
+			o[3] = t[1]; o[4] = e1; o[5] = e0;
+			o[6] = t[2]; o[7] = e2; o[8] = e1;
+			o[9] = e0; o[10] = e1; o[11] = e2;
+		});
+	}
+
+	// 一层Catmull-Clark细分，topo为输入网格的边表
+	static void catmull_clark_step(const FlatMesh& in, const EdgeTopology& topo, FlatMesh& out)
+	{
+		size_t nv = in.n_vertices();
+		size_t nf = in.n_faces();
+		VertexRing ring;
+		build_rings(in, topo, ring);
+		size_t ne = topo.n_edges();
+
+		const double* p = in.points.data();
+		out.points.resize(3 * (nv + ne + nf));
+		double* q = out.points.data();
+		double* face_points = q + 3 * (nv + ne);
+
+		// 面点：质心
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			unsigned int begin = in.face_begin(f), k = in.face_size(f);
+			double c[3] = { 0.0, 0.0, 0.0 };
+			for (unsigned int j = 0; j < k; j++)
+			{
+				unsigned int v = in.indices[begin + j];
+				c[0] += p[3 * v]; c[1] += p[3 * v + 1]; c[2] += p[3 * v + 2];
+			}
+			for (int i = 0; i < 3; i++) face_points[3 * f + i] = c[i] / k;
+		});
+
+		// 边点：内部为两端点与两侧面点的平均，边界取中点
+		std::vector<unsigned int> edge_face;
+		fill_edge_slots(in, topo, true, edge_face);
+		parallel::for_each(0, ne, [&](size_t e)
+		{
+			unsigned int a = topo.v0(e), b = topo.v1(e);
+			unsigned int f0 = edge_face[2 * e], f1 = edge_face[2 * e + 1];
+			double* r = q + 3 * (nv + e);
+			if (f0 != kInvalid && f1 != kInvalid)
+			{
+				for (int k = 0; k < 3; k++)
+					r[k] = 0.25 * (p[3 * a + k] + p[3 * b + k] + face_points[3 * f0 + k] + face_points[3 * f1 + k]);
+			}
+			else
+			{
+				for (int k = 0; k < 3; k++)
+					r[k] = 0.5 * (p[3 * a + k] + p[3 * b + k]);
+			}
+		});
+
+		// 顶点的相邻面点之和
+		std::vector<double> face_sum(3 * nv, 0.0);
+		std::vector<unsigned int> face_count(nv, 0);
+		for (size_t f = 0; f < nf; f++)
+		{
+			unsigned int begin = in.face_begin(f), k = in.face_size(f);
+			for (unsigned int j = 0; j < k; j++)
+			{
+				unsigned int v = in.indices[begin + j];
+				face_sum[3 * v] += face_points[3 * f];
+				face_sum[3 * v + 1] += face_points[3 * f + 1];
+				face_sum[3 * v + 2] += face_points[3 * f + 2];
+				face_count[v]++;
+			}
+		}
+
+		// 顶点点：(F + 2R + (n-3)P) / n
+		parallel::for_each(0, nv, [&](size_t v)
+		{
+			if (boundary_vertex_rule(ring, p, v, q + 3 * v)) return;
+			unsigned int n = ring.valence[v];
+			if (n < 3 || face_count[v] != n)
+			{
+				for (int c = 0; c < 3; c++) q[3 * v + c] = p[3 * v + c];
+				return;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				double F = face_sum[3 * v + c] / n;
+				double R = 0.5 * (p[3 * v + c] + ring.neighbor_sum[3 * v + c] / n);
+				q[3 * v + c] = (F + 2.0 * R + (n - 3.0) * p[3 * v + c]) / n;
+			}
+		});
+
+		// 每个角点生成一个四边形：顶点、出边点、面点、入边点
+		out.face_offsets.clear();
+		out.uniform_size = 4;
+		out.indices.resize(4 * in.indices.size());
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			unsigned int begin = in.face_begin(f), k = in.face_size(f);
+			unsigned int fp = unsigned(nv + ne + f);
+			for (unsigned int j = 0; j < k; j++)
+			{
+				unsigned int* o = out.indices.data() + 4 * (begin + j);
+				o[0] = in.indices[begin + j];
+				o[1] = unsigned(nv) + topo.corner_edge[begin + j];
+				o[2] = fp;
+				o[3] = unsigned(nv) + topo.corner_edge[begin + (j + k - 1) % k];
+			}
+		}, 1024);
+	}
+
+	// 多层细分：边表只在第一层从头构建，之后每层由上一层的边表直接推出；
+	// 两个FlatMesh轮流作为输入和输出
+	template <typename Step, typename Derive>
+	static void subdivide_levels(const FlatMesh& in, FlatMesh& out, int levels, Step step, Derive derive)
+	{
+		if (levels <= 0)
+		{
+			out = in;
+			return;
+		}
+
+		EdgeTopology topo, next_topo;
+		build_edges(in, topo);
+		FlatMesh scratch;
+		const FlatMesh* src = &in;
+		for (int level = 0; level < levels; level++)
+		{
+			// 最后一层写入out，向前交替，保证不会原地读写
+			FlatMesh* dst = ((levels - 1 - level) % 2 == 0) ? &out : &scratch;
+			step(*src, topo, *dst);
+			derive(*src, topo, level + 1 < levels, next_topo);
+			std::swap(topo, next_topo);
+			src = dst;
+		}
+		out.edges.swap(topo.edge_vertices);
+	}
+
+	size_t loop_face_count(const FlatMesh& in, int levels)
+	{
+		size_t nf = in.n_faces();
+		for (int level = 0; level < levels && nf <= kMaxFaces; level++) nf *= 4;
+		return nf;
+	}
+
+	size_t catmull_clark_face_count(const FlatMesh& in, int levels)
+	{
+		if (levels <= 0) return in.n_faces();
+		// 第一层每个角点一个四边形，之后每层乘4
+		size_t nf = in.indices.size();
+		for (int level = 1; level < levels && nf <= kMaxFaces; level++) nf *= 4;
+		return nf;
+	}
+
+	// 每层的面数都不超过最后一层，所以在第一层开始前检查最后一层即可覆盖每一层；
+	// 索引是unsigned int，上限同时受它限制（Catmull-Clark下一层的角点数是面数的4倍）
+	static bool within_face_limit(size_t faces, size_t max_faces)
+	{
+		return faces <= std::min(max_faces, size_t(kInvalid / 4));
+	}
+
+	bool loop(const FlatMesh& in, FlatMesh& out, int levels, size_t max_faces)
+	{
+		if (!in.is_triangle_mesh()) return false;
+		if (!within_face_limit(loop_face_count(in, levels), max_faces)) return false;
+		subdivide_levels(in, out, levels, loop_step, derive_loop_edges);
+		return true;
+	}
+
+	bool catmull_clark(const FlatMesh& in, FlatMesh& out, int levels, size_t max_faces)
+	{
+		if (!within_face_limit(catmull_clark_face_count(in, levels), max_faces)) return false;
+		subdivide_levels(in, out, levels, catmull_clark_step, derive_catmull_clark_edges);
+		return true;
+	}
+
+	void triangulate(const FlatMesh& mesh, std::vector<unsigned int>& triangles, std::vector<int>& triangle_faces)
+	{
+		size_t nf = mesh.n_faces();
+		// k边形产生k-2个三角形，因此面f的第一个三角形序号为face_begin(f) - 2f
+		size_t n_tris = mesh.indices.size() - 2 * nf;
+		triangles.resize(3 * n_tris);
+		triangle_faces.resize(n_tris);
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+			size_t t = begin - 2 * f;
+			for (unsigned int j = 2; j < k; j++, t++)
+			{
+				triangles[3 * t] = mesh.indices[begin];
+				triangles[3 * t + 1] = mesh.indices[begin + j - 1];
+				triangles[3 * t + 2] = mesh.indices[begin + j];
+				triangle_faces[t] = int(f);
+			}
+		}, 1024);
+	}
+
+	void unique_edges(const FlatMesh& mesh, std::vector<unsigned int>& edges)
+	{
+		if (!mesh.edges.empty())
+		{
+			edges = mesh.edges;
+			return;
+		}
+		EdgeTopology topo;
+		build_edges(mesh, topo);
+		edges.swap(topo.edge_vertices);
+	}
+
+	void vertex_normals(const FlatMesh& mesh, std::vector<float>& normals)
+	{
+		size_t nv = mesh.n_vertices();
+		size_t nf = mesh.n_faces();
+		const double* p = mesh.points.data();
+
+		// 面法线（未归一化，长度为面积的两倍）并行计算，累加到顶点时串行
+		std::vector<double> face_normals(3 * nf);
+		parallel::for_each(0, nf, [&](size_t f)
+		{
+			unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+			double n[3] = { 0.0, 0.0, 0.0 };
+			for (unsigned int j = 0; j < k; j++)
+			{
+				const double* a = p + 3 * mesh.indices[begin + j];
+				const double* b = p + 3 * mesh.indices[begin + (j + 1) % k];
+				n[0] += (a[1] - b[1]) * (a[2] + b[2]);
+				n[1] += (a[2] - b[2]) * (a[0] + b[0]);
+				n[2] += (a[0] - b[0]) * (a[1] + b[1]);
+			}
+			face_normals[3 * f] = n[0];
+			face_normals[3 * f + 1] = n[1];
+			face_normals[3 * f + 2] = n[2];
+		});
+
+		std::vector<double> sum(3 * nv, 0.0);
+		for (size_t f = 0; f < nf; f++)
+		{
+			unsigned int begin = mesh.face_begin(f), k = mesh.face_size(f);
+			for (unsigned int j = 0; j < k; j++)
+			{
+				unsigned int v = mesh.indices[begin + j];
+				sum[3 * v] += face_normals[3 * f];
+				sum[3 * v + 1] += face_normals[3 * f + 1];
+				sum[3 * v + 2] += face_normals[3 * f + 2];
+			}
+		}
+
+		normals.resize(3 * nv);
+		parallel::for_each(0, nv, [&](size_t v)
+		{
+			double len = std::sqrt(sum[3 * v] * sum[3 * v] + sum[3 * v + 1] * sum[3 * v + 1] + sum[3 * v + 2] * sum[3 * v + 2]);
+			double inv = len > 0.0 ? 1.0 / len : 0.0;
+			for (int c = 0; c < 3; c++) normals[3 * v + c] = float(sum[3 * v + c] * inv);
+		});
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "my_traits.h"
+#include <vector>
+
+// 基于扁平数组的细分：拓扑用预先计算的边表描述，新顶点和新面都按下标直接写入，
+// 各阶段按顶点/边/面并行，不经过OpenMesh逐个add_vertex/add_face。
+namespace subdivision
+{
+	struct FlatMesh
+	{
+		std::vector<double> points;              // x0 y0 z0 x1 y1 z1 ...
+		std::vector<unsigned int> indices;       // 各面的顶点按面连续存放
+		std::vector<unsigned int> face_offsets;  // 面f占indices[face_offsets[f], face_offsets[f+1])；为空时所有面都是uniform_size边形
+		unsigned int uniform_size = 3;
+		std::vector<unsigned int> edges;         // 可选：无重复边(v0, v1)对，细分时顺带生成；修改拓扑后须清空
+
+		size_t n_vertices() const { return points.size() / 3; }
+		size_t n_faces() const { return face_offsets.empty() ? indices.size() / uniform_size : face_offsets.size() - 1; }
+		unsigned int face_begin(size_t f) const { return face_offsets.empty() ? unsigned(f * uniform_size) : face_offsets[f]; }
+		unsigned int face_size(size_t f) const { return face_offsets.empty() ? uniform_size : face_offsets[f + 1] - face_offsets[f]; }
+		bool is_triangle_mesh() const;
+	};
+
+	void from_openmesh(const Mesh& mesh, FlatMesh& flat);
+	// 流形网格直接写入半边结构；非流形时退回逐面add_face
+	void to_openmesh(const FlatMesh& flat, Mesh& mesh);
+
+	// 细分结果默认的面数上限：约3300万个面，连同边表、OpenMesh副本和GPU缓冲已在几GB量级
+	const size_t kMaxFaces = size_t(1) << 25;
+
+	// levels次细分后的面数（超过上限后不再精确，只保证仍大于上限），用于细分前检查
+	size_t loop_face_count(const FlatMesh& in, int levels);
+	size_t catmull_clark_face_count(const FlatMesh& in, int levels);
+
+	// Loop细分levels次，仅适用于三角形网格。in与out不能是同一个对象。
+	// 每层细分前检查面数，任何一层会超过max_faces时不做细分，返回false
+	bool loop(const FlatMesh& in, FlatMesh& out, int levels = 1, size_t max_faces = kMaxFaces);
+	// Catmull-Clark细分levels次，任意多边形网格，输出全四边形；面数检查同loop()
+	bool catmull_clark(const FlatMesh& in, FlatMesh& out, int levels = 1, size_t max_faces = kMaxFaces);
+
+	// 渲染用：扇形三角化的索引和每个三角形所属的面
+	void triangulate(const FlatMesh& mesh, std::vector<unsigned int>& triangles, std::vector<int>& triangle_faces);
+	// 渲染用：无重复的边（GL_LINES索引），有缓存的edges时直接复制
+	void unique_edges(const FlatMesh& mesh, std::vector<unsigned int>& edges);
+	// 渲染用：面积加权的顶点法线
+	void vertex_normals(const FlatMesh& mesh, std::vector<float>& normals);
+}
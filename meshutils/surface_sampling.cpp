@@ -0,0 +1,491 @@
+#include "surface_sampling.h"
+#include "parallel_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+namespace surface_sampling
+{
+	namespace
+	{
+		typedef OpenMesh::Vec3d Vec3d;
+
+		// 随机采样的分块大小：每块一个随机数流
+		const size_t kChunkSize = 1 << 16;
+		const unsigned int kEmpty = ~0u;
+
+		double elapsed_ms(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// 取高53位，不依赖标准库uniform_real_distribution的实现
+		inline double uniform(std::mt19937_64& rng)
+		{
+			return double(rng() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		// 扇形三角化后的三角形和它们的面积、别名表
+		struct Surface
+		{
+			std::vector<Vec3d> points;
+			std::vector<unsigned int> triangles;   // 每3个一组
+			std::vector<int> triangle_faces;
+			std::vector<double> areas;
+			AliasTable table;
+
+			bool build(const Mesh& mesh)
+			{
+				points.resize(mesh.n_vertices());
+				parallel::for_each(0, points.size(), [&](size_t v)
+				{
+					points[v] = mesh.point(Mesh::VertexHandle(int(v)));
+				});
+
+				triangles.clear();
+				triangle_faces.clear();
+				triangles.reserve(mesh.n_faces() * 3);
+				triangle_faces.reserve(mesh.n_faces());
+				std::vector<unsigned int> poly;
+				for (auto fh : mesh.faces())
+				{
+					poly.clear();
+					for (auto fv_it = mesh.cfv_iter(fh); fv_it.is_valid(); ++fv_it)
+					{
+						poly.push_back((unsigned int)fv_it->idx());
+					}
+					for (size_t k = 2; k < poly.size(); k++)
+					{
+						triangles.push_back(poly[0]);
+						triangles.push_back(poly[k - 1]);
+						triangles.push_back(poly[k]);
+						triangle_faces.push_back(fh.idx());
+					}
+				}
+
+				areas.resize(triangle_faces.size());
+				parallel::for_each(0, areas.size(), [&](size_t t)
+				{
+					const Vec3d& a = points[triangles[3 * t]];
+					areas[t] = 0.5 * ((points[triangles[3 * t + 1]] - a) % (points[triangles[3 * t + 2]] - a)).norm();
+				});
+				return table.build(areas);
+			}
+
+			void sample(std::mt19937_64& rng, Vec3d& point, Vec3d& normal, int& face) const
+			{
+				double u1 = uniform(rng), u2 = uniform(rng);
+				size_t t = table.sample(u1, u2);
+				const Vec3d& a = points[triangles[3 * t]];
+				const Vec3d& b = points[triangles[3 * t + 1]];
+				const Vec3d& c = points[triangles[3 * t + 2]];
+				// 重心坐标(1 - √r1, √r1(1 - r2), √r1 r2)在三角形上均匀分布
+				double s = std::sqrt(uniform(rng)), r2 = uniform(rng);
+				point = a * (1.0 - s) + b * (s * (1.0 - r2)) + c * (s * r2);
+				normal = (b - a) % (c - a);
+				double len = normal.norm();
+				if (len > 0.0) normal /= len;
+				face = triangle_faces[t];
+			}
+		};
+
+		void sample_surface(const Surface& surface, size_t count, unsigned int seed, Samples& out)
+		{
+			out.points.resize(count);
+			out.normals.resize(count);
+			out.faces.resize(count);
+			size_t chunks = (count + kChunkSize - 1) / kChunkSize;
+			parallel::for_each(0, chunks, [&](size_t chunk)
+			{
+				std::seed_seq seq = { seed, (unsigned int)(chunk & 0xffffffffu), (unsigned int)(uint64_t(chunk) >> 32) };
+				std::mt19937_64 rng(seq);
+				size_t end = std::min(count, (chunk + 1) * kChunkSize);
+				for (size_t i = chunk * kChunkSize; i < end; i++)
+				{
+					surface.sample(rng, out.points[i], out.normals[i], out.faces[i]);
+				}
+			}, 1);
+		}
+
+		inline uint64_t mix(uint64_t key)
+		{
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdULL;
+			key ^= key >> 33;
+			return key;
+		}
+
+		// 哈希表的槽里同时存键，查找只需访问一次内存
+		struct Slot
+		{
+			uint64_t key;
+			unsigned int cell;
+		};
+
+		// 每个候选点最多占用的字节数：候选点本身、建格时的排序数组和order，
+		// 以及按每个候选点一个格子算的格子数据（键、起点、哈希表最多4倍槽位、坐标、分组、接受/阻挡/覆盖标记）
+		// 和同样多的输出样本
+		const size_t kBytesPerCandidate =
+			2 * (2 * sizeof(Vec3d) + sizeof(int))
+			+ sizeof(std::pair<uint64_t, unsigned int>) + sizeof(unsigned int)
+			+ sizeof(uint64_t) + sizeof(unsigned int) + 4 * sizeof(Slot) + 3 * sizeof(int64_t)
+			+ 3 * sizeof(unsigned int) + sizeof(unsigned char);
+
+		// 内存上限对应的候选点数，同时不超过unsigned int编号的范围
+		size_t max_candidates(size_t max_memory)
+		{
+			return std::min(max_memory / kBytesPerCandidate, size_t(kEmpty) - 1);
+		}
+
+		// 泊松圆盘的格子：候选点按格子键排序，只为非空格子建开放寻址哈希表
+		struct CellGrid
+		{
+			Vec3d lo;
+			double inv_cell = 1.0;
+			int64_t dims[3] = { 0, 0, 0 };
+			std::vector<uint64_t> keys;            // 非空格子的键，升序
+			std::vector<unsigned int> begin;       // 格子在order中的起点，多一个尾元素
+			std::vector<unsigned int> order;       // 按格子排序后的候选点编号，格内保持生成顺序
+			std::vector<Slot> table;
+			uint64_t mask = 0;
+
+			bool build(const std::vector<Vec3d>& points, double cell)
+			{
+				Vec3d hi = points[0];
+				lo = points[0];
+				for (const Vec3d& p : points)
+				{
+					lo.minimize(p);
+					hi.maximize(p);
+				}
+				inv_cell = 1.0 / cell;
+				double volume = 1.0;
+				for (int a = 0; a < 3; a++)
+				{
+					dims[a] = int64_t(std::floor((hi[a] - lo[a]) * inv_cell)) + 1;
+					volume *= double(dims[a]);
+				}
+				if (volume > 9.0e18) return false;
+
+				// 键相同时按编号排序，格内保持生成顺序
+				size_t n = points.size();
+				std::vector<std::pair<uint64_t, unsigned int>> sorted(n);
+				parallel::for_each(0, n, [&](size_t i)
+				{
+					int64_t c[3];
+					coords(points[i], c);
+					sorted[i] = std::make_pair(key(c[0], c[1], c[2]), (unsigned int)i);
+				});
+				std::sort(sorted.begin(), sorted.end());
+
+				order.resize(n);
+				keys.clear();
+				begin.clear();
+				for (size_t i = 0; i < n; i++)
+				{
+					order[i] = sorted[i].second;
+					uint64_t k = sorted[i].first;
+					if (keys.empty() || keys.back() != k)
+					{
+						keys.push_back(k);
+						begin.push_back((unsigned int)i);
+					}
+				}
+				begin.push_back((unsigned int)n);
+
+				size_t capacity = 16;
+				while (capacity < keys.size() * 2) capacity <<= 1;
+				mask = capacity - 1;
+				Slot empty = { 0, kEmpty };
+				table.assign(capacity, empty);
+				for (size_t c = 0; c < keys.size(); c++)
+				{
+					uint64_t slot = mix(keys[c]) & mask;
+					while (table[slot].cell != kEmpty) slot = (slot + 1) & mask;
+					table[slot].key = keys[c];
+					table[slot].cell = (unsigned int)c;
+				}
+				return true;
+			}
+
+			void coords(const Vec3d& p, int64_t* c) const
+			{
+				for (int a = 0; a < 3; a++)
+				{
+					c[a] = std::min(dims[a] - 1, std::max(int64_t(0), int64_t((p[a] - lo[a]) * inv_cell)));
+				}
+			}
+
+			uint64_t key(int64_t x, int64_t y, int64_t z) const
+			{
+				return uint64_t(x) + uint64_t(dims[0]) * (uint64_t(y) + uint64_t(dims[1]) * uint64_t(z));
+			}
+
+			void decode(uint64_t k, int64_t* c) const
+			{
+				c[0] = int64_t(k % uint64_t(dims[0]));
+				k /= uint64_t(dims[0]);
+				c[1] = int64_t(k % uint64_t(dims[1]));
+				c[2] = int64_t(k / uint64_t(dims[1]));
+			}
+
+			// 非空格子的下标，没有时为-1
+			int find(int64_t x, int64_t y, int64_t z) const
+			{
+				if (x < 0 || y < 0 || z < 0 || x >= dims[0] || y >= dims[1] || z >= dims[2]) return -1;
+				uint64_t k = key(x, y, z);
+				uint64_t slot = mix(k) & mask;
+				while (table[slot].cell != kEmpty)
+				{
+					if (table[slot].key == k) return int(table[slot].cell);
+					slot = (slot + 1) & mask;
+				}
+				return -1;
+			}
+		};
+	}
+
+	bool AliasTable::build(const std::vector<double>& weights)
+	{
+		size_t n = weights.size();
+		prob.assign(n, 0.0);
+		alias.resize(n);
+		sum = 0.0;
+		for (double w : weights) sum += w;
+		if (n == 0 || !(sum > 0.0))
+		{
+			prob.clear();
+			alias.clear();
+			return false;
+		}
+
+		// 缩放到平均值为1后分成不足1和不少于1两堆，每次用一个大的补满一个小的
+		std::vector<double> scaled(n);
+		std::vector<unsigned int> small, large;
+		for (size_t i = 0; i < n; i++)
+		{
+			scaled[i] = weights[i] * n / sum;
+			alias[i] = (unsigned int)i;
+			(scaled[i] < 1.0 ? small : large).push_back((unsigned int)i);
+		}
+		while (!small.empty() && !large.empty())
+		{
+			unsigned int s = small.back(), l = large.back();
+			small.pop_back();
+			prob[s] = scaled[s];
+			alias[s] = l;
+			scaled[l] -= 1.0 - scaled[s];
+			if (scaled[l] < 1.0)
+			{
+				large.pop_back();
+				small.push_back(l);
+			}
+		}
+		// 剩下的只差舍入误差
+		for (unsigned int i : large) prob[i] = 1.0;
+		for (unsigned int i : small) prob[i] = 1.0;
+		return true;
+	}
+
+	void Samples::clear()
+	{
+		points.clear();
+		normals.clear();
+		faces.clear();
+	}
+
+	bool random(const Mesh& mesh, size_t count, unsigned int seed, Samples& out, Stats* stats)
+	{
+		out.clear();
+		if (stats) *stats = Stats();
+		auto start = std::chrono::steady_clock::now();
+		Surface surface;
+		if (!surface.build(mesh)) return false;
+		if (stats)
+		{
+			stats->area = surface.table.total();
+			stats->setup_ms = elapsed_ms(start);
+		}
+
+		start = std::chrono::steady_clock::now();
+		sample_surface(surface, count, seed, out);
+		if (stats) stats->sample_ms = elapsed_ms(start);
+		return true;
+	}
+
+	bool poisson_disk(const Mesh& mesh, const PoissonOptions& options, Samples& out, Stats* stats)
+	{
+		out.clear();
+		if (stats) *stats = Stats();
+		if (!(options.radius > 0.0)) return false;
+		auto start = std::chrono::steady_clock::now();
+		Surface surface;
+		if (!surface.build(mesh)) return false;
+		double area = surface.table.total();
+		if (stats)
+		{
+			stats->area = area;
+			stats->setup_ms = elapsed_ms(start);
+		}
+
+		start = std::chrono::steady_clock::now();
+		double r2 = options.radius * options.radius;
+		double wanted = std::ceil(options.candidates_per_area * area / r2);
+		size_t count = size_t(std::min(wanted, double(max_candidates(options.max_memory))));
+		if (count == 0) return false;
+		Samples candidates;
+		sample_surface(surface, count, options.seed, candidates);
+		if (stats)
+		{
+			stats->candidates = count;
+			stats->sample_ms = elapsed_ms(start);
+		}
+
+		// 格子对角线等于radius，所以每格至多一个样本，冲突只可能来自各方向2格以内
+		start = std::chrono::steady_clock::now();
+		CellGrid grid;
+		if (!grid.build(candidates.points, options.radius / std::sqrt(3.0))) return false;
+		size_t cells = grid.keys.size();
+		std::vector<int64_t> cell_coords(3 * cells);
+		std::vector<std::vector<unsigned int>> phases(27);
+		unsigned int rounds = 0;
+		for (size_t c = 0; c < cells; c++)
+		{
+			int64_t* xyz = &cell_coords[3 * c];
+			grid.decode(grid.keys[c], xyz);
+			phases[(xyz[0] % 3) + 3 * (xyz[1] % 3) + 9 * (xyz[2] % 3)].push_back((unsigned int)c);
+			rounds = std::max(rounds, grid.begin[c + 1] - grid.begin[c]);
+		}
+
+		// 同组格子在某个方向上至少相差3格，测试时读到的邻格都不在本组，不会与写入冲突
+		// 邻格偏移按距离由近到远，冲突通常在近处先找到
+		std::vector<int> offsets;
+		for (int d2 = 0; d2 <= 12; d2++)
+		{
+			for (int dz = -2; dz <= 2; dz++)
+			{
+				for (int dy = -2; dy <= 2; dy++)
+				{
+					for (int dx = -2; dx <= 2; dx++)
+					{
+						if (dx * dx + dy * dy + dz * dz != d2) continue;
+						offsets.push_back(dx);
+						offsets.push_back(dy);
+						offsets.push_back(dz);
+					}
+				}
+			}
+		}
+
+		// blocker为上次否决本格候选点的样本，下一个候选点先和它比较；
+		// 样本覆盖了整个格子时格子直接作废。两者都只由处理本格的线程写
+		std::vector<unsigned int> accepted(cells, kEmpty);
+		std::vector<unsigned int> blocker(cells, kEmpty);
+		std::vector<unsigned char> covered(cells, 0);
+		double cell = options.radius / std::sqrt(3.0);
+		for (unsigned int round = 0; round < rounds; round++)
+		{
+			for (std::vector<unsigned int>& phase : phases)
+			{
+				parallel::for_each(0, phase.size(), [&](size_t i)
+				{
+					unsigned int c = phase[i];
+					if (accepted[c] != kEmpty || covered[c] || grid.begin[c] + round >= grid.begin[c + 1]) return;
+					unsigned int candidate = grid.order[grid.begin[c] + round];
+					const Vec3d& p = candidates.points[candidate];
+					if (blocker[c] != kEmpty && (candidates.points[blocker[c]] - p).sqrnorm() < r2) return;
+					const int64_t* xyz = &cell_coords[3 * c];
+					// p在本格内的位置，用来跳过离p超过radius的邻格
+					double frac[3];
+					for (int a = 0; a < 3; a++)
+					{
+						frac[a] = (p[a] - grid.lo[a]) / cell - double(xyz[a]);
+					}
+					for (size_t k = 0; k < offsets.size(); k += 3)
+					{
+						double gap2 = 0.0;
+						for (int a = 0; a < 3; a++)
+						{
+							int d = offsets[k + a];
+							double gap = d > 0 ? d - frac[a] : (d < 0 ? frac[a] - d - 1.0 : 0.0);
+							if (gap > 0.0) gap2 += gap * gap;
+						}
+						if (gap2 * cell * cell >= r2) continue;
+						int other = grid.find(xyz[0] + offsets[k], xyz[1] + offsets[k + 1], xyz[2] + offsets[k + 2]);
+						if (other < 0 || accepted[other] == kEmpty) continue;
+						const Vec3d& q = candidates.points[accepted[other]];
+						if ((q - p).sqrnorm() >= r2) continue;
+						blocker[c] = accepted[other];
+						// 格子离q最远的角也在radius以内
+						double far2 = 0.0;
+						for (int a = 0; a < 3; a++)
+						{
+							double lo = grid.lo[a] + xyz[a] * cell;
+							double d = std::max(q[a] - lo, lo + cell - q[a]);
+							far2 += d * d;
+						}
+						if (far2 < r2) covered[c] = 1;
+						return;
+					}
+					accepted[c] = candidate;
+				}, 256);
+
+				// 已接受、已覆盖或候选点用完的格子不再参加后面的轮次
+				phase.erase(std::remove_if(phase.begin(), phase.end(), [&](unsigned int c)
+				{
+					return accepted[c] != kEmpty || covered[c] || grid.begin[c] + round + 1 >= grid.begin[c + 1];
+				}), phase.end());
+			}
+		}
+
+		for (size_t c = 0; c < cells; c++)
+		{
+			if (accepted[c] == kEmpty) continue;
+			out.points.push_back(candidates.points[accepted[c]]);
+			out.normals.push_back(candidates.normals[accepted[c]]);
+			out.faces.push_back(candidates.faces[accepted[c]]);
+		}
+		if (stats)
+		{
+			stats->rounds = int(rounds);
+			stats->select_ms = elapsed_ms(start);
+		}
+		return true;
+	}
+
+	bool write_ply(const std::string& path, const Samples& samples)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file) return false;
+		file << "ply\n"
+			<< "format binary_little_endian 1.0\n"
+			<< "element vertex " << samples.size() << "\n"
+			<< "property float x\nproperty float y\nproperty float z\n"
+			<< "property float nx\nproperty float ny\nproperty float nz\n"
+			<< "end_header\n";
+
+		// 按块转换成float再写出；假定主机为小端
+		const size_t block = 1 << 16;
+		std::vector<float> buffer;
+		for (size_t b = 0; b < samples.size(); b += block)
+		{
+			size_t e = std::min(samples.size(), b + block);
+			buffer.resize(6 * (e - b));
+			for (size_t i = b; i < e; i++)
+			{
+				float* v = &buffer[6 * (i - b)];
+				for (int a = 0; a < 3; a++)
+				{
+					v[a] = float(samples.points[i][a]);
+					v[3 + a] = float(samples.normals[i][a]);
+				}
+			}
+			file.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(buffer.size() * sizeof(float)));
+		}
+		return bool(file);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "my_traits.h"
+#include <string>
+#include <vector>
+
+// 网格表面的均匀采样：按面积加权的随机采样（三角形上的别名表，每块样本一个独立的随机数流），
+// 以及基于网格的并行掷镖泊松圆盘采样。多边形面按扇形三角化；距离为三维欧氏距离而不是测地距离
+namespace surface_sampling
+{
+	// Vose别名表：O(n)构建，每次抽样O(1)
+	class AliasTable
+	{
+	public:
+		// 权重全为0或为空时返回false
+		bool build(const std::vector<double>& weights);
+		// u1、u2为[0, 1)上的均匀随机数
+		size_t sample(double u1, double u2) const
+		{
+			size_t i = size_t(u1 * prob.size());
+			if (i >= prob.size()) i = prob.size() - 1;
+			return u2 < prob[i] ? i : alias[i];
+		}
+		size_t size() const { return prob.size(); }
+		double total() const { return sum; }
+
+	private:
+		std::vector<double> prob;
+		std::vector<unsigned int> alias;
+		double sum = 0.0;
+	};
+
+	struct Samples
+	{
+		std::vector<OpenMesh::Vec3d> points;
+		std::vector<OpenMesh::Vec3d> normals;   // 所在三角形的单位法向
+		std::vector<int> faces;                 // 所在的OpenMesh面
+
+		void clear();
+		size_t size() const { return points.size(); }
+	};
+
+	struct Stats
+	{
+		double area = 0.0;
+		double setup_ms = 0.0;      // 三角化、面积和别名表
+		double sample_ms = 0.0;     // 随机采样（泊松圆盘时为候选点）
+		double select_ms = 0.0;     // 泊松圆盘：分格和掷镖
+		size_t candidates = 0;      // 泊松圆盘的候选点数
+		int rounds = 0;             // 泊松圆盘的掷镖轮数（单个格子里最多的候选点数）
+	};
+
+	// 面积加权的随机采样。样本按固定大小分块，每块的随机数流只由seed和块号决定，结果与线程数无关
+	bool random(const Mesh& mesh, size_t count, unsigned int seed, Samples& out, Stats* stats = nullptr);
+
+	struct PoissonOptions
+	{
+		double radius = 0.0;                  // 样本间的最小距离
+		double candidates_per_area = 16.0;    // 候选点数 = 此值 × 面积 / radius²
+		size_t max_memory = size_t(2) << 30;  // 候选点、格子和输出样本的内存上限（字节），决定候选点数的上限
+		unsigned int seed = 1;
+	};
+
+	// 泊松圆盘采样：先随机生成候选点，放进边长radius/√3的格子（每格至多接受一个样本），
+	// 格子按坐标模3分成27组，同组格子相距足够远可以并行测试；每轮每个空格子尝试下一个候选点。
+	// radius无效或格子数溢出时返回false；候选点数受max_memory限制时样本可能不饱和
+	bool poisson_disk(const Mesh& mesh, const PoissonOptions& options, Samples& out, Stats* stats = nullptr);
+
+	// 二进制小端PLY，每个点为float的x y z nx ny nz
+	bool write_ply(const std::string& path, const Samples& samples);
+}
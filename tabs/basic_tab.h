@@ -3,6 +3,7 @@
 #define BASIC_TAB_H
 
 #include "../glwidget/baseglwidget.h"
+#include "../menu_utils.h"
 #include <QApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -15,7 +16,12 @@
 #include <QSlider>
 #include <QRadioButton>
 #include <QCheckBox>
+#include <QSpinBox>
+#include <QComboBox>
 #include <QStackedWidget>
+#include <QListWidget>
+#include <QColorDialog>
+#include <QSignalBlocker>
 
 // 创建OpenMesh标签页
 inline QWidget* createBasicTab(BaseGLWidget* glWidget) {
@@ -28,20 +34,10 @@ inline QWidget* createBasicTab(BaseGLWidget* glWidget) {
 // 创建OBJ文件加载按钮（OpenMesh版）
 inline QWidget* createBasicModelLoadButton(BaseGLWidget* glWidget, QLabel* infoLabel, QWidget* mainWindow) {
     QPushButton *button = new QPushButton("Load OBJ File (OpenMesh)");
-    button->setStyleSheet(
-        "QPushButton {"
-        "   background-color: #505050;"
-        "   color: white;"
-        "   border: none;"
-        "   padding: 10px 20px;"
-        "   font-size: 16px;"
-        "   border-radius: 5px;"
-        "}"
-        "QPushButton:hover { background-color: #606060; }"
-    );
+    button->setStyleSheet(UIUtils::buttonStyleSheet());
     QObject::connect(button, &QPushButton::clicked, [glWidget, infoLabel, mainWindow]() {
         QString filePath = QFileDialog::getOpenFileName(
-            mainWindow, "Open OBJ File", "", "OBJ Files (*.obj)");
+            mainWindow, "Open OBJ File", "", "Meshes and Point Clouds (*.obj *.ply);;OBJ Files (*.obj);;PLY Files (*.ply)");
         
         if (!filePath.isEmpty()) {
             glWidget->loadOBJ(filePath);
@@ -69,13 +65,11 @@ inline QGroupBox* createBasicRenderingModeGroup(BaseGLWidget* glWidget) {
     
     // 连接渲染模式信号
     QObject::connect(solidRadio, &QRadioButton::clicked, [glWidget]() {
-        glWidget->currentRenderMode = BaseGLWidget::BlinnPhong;
-        glWidget->update();
+        glWidget->setRenderMode(BaseGLWidget::BlinnPhong);
     });
     
     QObject::connect(flatRadio, &QRadioButton::clicked, [glWidget]() {
-        glWidget->currentRenderMode = BaseGLWidget::FlatShading;
-        glWidget->update();
+        glWidget->setRenderMode(BaseGLWidget::FlatShading);
     });
     
     return group;
@@ -93,14 +87,1125 @@ inline QGroupBox* createBasicDisplayOptionsGroup(BaseGLWidget* glWidget) {
         glWidget->setShowWireframeOverlay(state == Qt::Checked);
     });
     
+    QCheckBox *lineOverlayCheckbox = new QCheckBox("Use Line Wireframe (GL_LINES)");
+    lineOverlayCheckbox->setStyleSheet("color: white;");
+    QObject::connect(lineOverlayCheckbox, &QCheckBox::stateChanged, [glWidget](int state) {
+        glWidget->setWireframeOverlayStyle(state == Qt::Checked ? BaseGLWidget::LineOverlay
+                                                                : BaseGLWidget::BarycentricOverlay);
+    });
+    
     QCheckBox *faceCheckbox = new QCheckBox("Hide Faces");
     faceCheckbox->setStyleSheet("color: white;");
     QObject::connect(faceCheckbox, &QCheckBox::stateChanged, [glWidget](int state) {
         glWidget->setHideFaces(state == Qt::Checked);
     });
     
+    // 交互时的帧率上限，及实际帧时间
+    QHBoxLayout *fpsLayout = new QHBoxLayout;
+    QLabel *fpsLabel = new QLabel("Max FPS (drag):");
+    fpsLabel->setStyleSheet("color: white;");
+    QSpinBox *fpsSpin = new QSpinBox;
+    fpsSpin->setRange(0, 240);
+    fpsSpin->setSpecialValueText("Unlimited");
+    fpsSpin->setValue(glWidget->scheduler()->maxInteractiveFps());
+    QObject::connect(fpsSpin, QOverload<int>::of(&QSpinBox::valueChanged), [glWidget](int fps) {
+        glWidget->setMaxInteractiveFps(fps);
+    });
+    fpsLayout->addWidget(fpsLabel);
+    fpsLayout->addWidget(fpsSpin);
+    
+    QLabel *frameTimeLabel = new QLabel("Frame: -");
+    frameTimeLabel->setStyleSheet("color: white;");
+    QObject::connect(glWidget->scheduler(), &RenderScheduler::frameTimeUpdated,
+                     frameTimeLabel, [frameTimeLabel](double frameMs, double intervalMs) {
+        QString text = QString("Frame: %1 ms").arg(frameMs, 0, 'f', 2);
+        if (intervalMs > 0.0) {
+            text += QString(" (%1 FPS)").arg(1000.0 / intervalMs, 0, 'f', 0);
+        }
+        frameTimeLabel->setText(text);
+    });
+    
     layout->addWidget(wireframeCheckbox);
+    layout->addWidget(lineOverlayCheckbox);
     layout->addWidget(faceCheckbox);
+    layout->addLayout(fpsLayout);
+    layout->addWidget(frameTimeLabel);
+    return group;
+}
+
+// 创建拾取选项组（Ctrl+左键拾取）
+inline QGroupBox* createBasicPickingGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Picking (Ctrl+Click)");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QRadioButton *vertexRadio = new QRadioButton("Vertex");
+    QRadioButton *faceRadio = new QRadioButton("Face");
+    QRadioButton *edgeRadio = new QRadioButton("Edge");
+    faceRadio->setChecked(true);
+    
+    QObject::connect(vertexRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setPickMode(BaseGLWidget::PickVertex);
+    });
+    QObject::connect(faceRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setPickMode(BaseGLWidget::PickFace);
+    });
+    QObject::connect(edgeRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setPickMode(BaseGLWidget::PickEdge);
+    });
+    
+    // 软件光栅化（如llvmpipe）下自动使用CPU射线拾取
+    QComboBox *backendCombo = new QComboBox;
+    backendCombo->addItem("Auto", BaseGLWidget::AutoPickBackend);
+    backendCombo->addItem("GPU ID Buffer", BaseGLWidget::GpuPickBackend);
+    backendCombo->addItem("CPU Ray Cast", BaseGLWidget::CpuRayPickBackend);
+    QObject::connect(backendCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+                     [glWidget, backendCombo](int index) {
+        glWidget->setPickBackend(BaseGLWidget::PickBackend(backendCombo->itemData(index).toInt()));
+    });
+    
+    QLabel *resultLabel = new QLabel("Nothing picked");
+    resultLabel->setStyleSheet("color: white;");
+    QObject::connect(glWidget, &BaseGLWidget::elementPicked, resultLabel,
+                     [resultLabel](BaseGLWidget::PickMode mode, int index) {
+        static const char* names[] = {"Vertex", "Face", "Edge"};
+        if (index < 0) {
+            resultLabel->setText("Nothing picked");
+        } else {
+            resultLabel->setText(QString("%1 #%2").arg(names[mode]).arg(index));
+        }
+    });
+    
+    layout->addWidget(vertexRadio);
+    layout->addWidget(faceRadio);
+    layout->addWidget(edgeRadio);
+    layout->addWidget(backendCombo);
+    layout->addWidget(resultLabel);
+    return group;
+}
+
+// 创建区域选择组
+inline QGroupBox* createBasicSelectionGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Selection");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QRadioButton *noneRadio = new QRadioButton("Rotate (No Selection)");
+    QRadioButton *boxRadio = new QRadioButton("Box Select");
+    QRadioButton *lassoRadio = new QRadioButton("Lasso Select");
+    noneRadio->setChecked(true);
+    
+    QObject::connect(noneRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setSelectionTool(BaseGLWidget::NoSelectionTool);
+    });
+    QObject::connect(boxRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setSelectionTool(BaseGLWidget::BoxSelection);
+    });
+    QObject::connect(lassoRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setSelectionTool(BaseGLWidget::LassoSelection);
+    });
+    
+    QHBoxLayout *ringLayout = new QHBoxLayout;
+    QPushButton *growButton = new QPushButton("Grow");
+    QPushButton *shrinkButton = new QPushButton("Shrink");
+    QPushButton *clearButton = new QPushButton("Clear");
+    growButton->setStyleSheet(buttonStyle);
+    shrinkButton->setStyleSheet(buttonStyle);
+    clearButton->setStyleSheet(buttonStyle);
+    ringLayout->addWidget(growButton);
+    ringLayout->addWidget(shrinkButton);
+    ringLayout->addWidget(clearButton);
+    
+    QObject::connect(growButton, &QPushButton::clicked, [glWidget]() {
+        glWidget->growSelection();
+    });
+    QObject::connect(shrinkButton, &QPushButton::clicked, [glWidget]() {
+        glWidget->shrinkSelection();
+    });
+    QObject::connect(clearButton, &QPushButton::clicked, [glWidget]() {
+        glWidget->clearSelection();
+    });
+    
+    QLabel *countLabel = new QLabel("Shift: add, Alt: subtract");
+    countLabel->setStyleSheet("color: white;");
+    QObject::connect(glWidget, &BaseGLWidget::selectionChanged, countLabel,
+                     [countLabel](int vertexCount, int faceCount) {
+        countLabel->setText(QString("Selected: %1 vertices, %2 faces").arg(vertexCount).arg(faceCount));
+    });
+    
+    layout->addWidget(noneRadio);
+    layout->addWidget(boxRadio);
+    layout->addWidget(lassoRadio);
+    layout->addLayout(ringLayout);
+    layout->addWidget(countLabel);
+    return group;
+}
+
+// 创建细分组：先预览，确认后写回网格
+inline QGroupBox* createBasicSubdivisionGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Subdivision");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QComboBox *schemeCombo = new QComboBox;
+    schemeCombo->addItem("Loop", BaseGLWidget::LoopSubdivision);
+    schemeCombo->addItem("Catmull-Clark", BaseGLWidget::CatmullClarkSubdivision);
+    
+    QSpinBox *levelSpin = new QSpinBox;
+    levelSpin->setRange(1, 4);
+    levelSpin->setValue(1);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *schemeLabel = new QLabel("Scheme:");
+    QLabel *levelLabel = new QLabel("Levels:");
+    schemeLabel->setStyleSheet("color: white;");
+    levelLabel->setStyleSheet("color: white;");
+    formLayout->addRow(schemeLabel, schemeCombo);
+    formLayout->addRow(levelLabel, levelSpin);
+    
+    QPushButton *previewButton = new QPushButton("Preview");
+    QPushButton *applyButton = new QPushButton("Apply");
+    QPushButton *discardButton = new QPushButton("Discard");
+    previewButton->setStyleSheet(buttonStyle);
+    applyButton->setStyleSheet(buttonStyle);
+    discardButton->setStyleSheet(buttonStyle);
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(applyButton);
+    buttonLayout->addWidget(discardButton);
+    
+    QLabel *statusLabel = new QLabel("No preview");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(previewButton, &QPushButton::clicked, [glWidget, schemeCombo, levelSpin, statusLabel]() {
+        BaseGLWidget::SubdivisionScheme scheme =
+            BaseGLWidget::SubdivisionScheme(schemeCombo->currentData().toInt());
+        QString error;
+        if (!glWidget->subdividePreview(scheme, levelSpin->value(), &error)) {
+            statusLabel->setText(error);
+        }
+    });
+    QObject::connect(applyButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        glWidget->applySubdivision();
+        statusLabel->setText("Applied");
+    });
+    QObject::connect(discardButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        glWidget->discardSubdivision();
+        statusLabel->setText("No preview");
+    });
+    QObject::connect(glWidget, &BaseGLWidget::subdivisionFinished, statusLabel,
+                     [statusLabel](int vertexCount, int faceCount, double milliseconds) {
+        statusLabel->setText(QString("%1 vertices, %2 faces (%3 ms)")
+                             .arg(vertexCount).arg(faceCount).arg(milliseconds, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(previewButton);
+    layout->addLayout(buttonLayout);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+inline QGroupBox* createBasicDecimationGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Decimation");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    // 保留的三角形比例
+    QDoubleSpinBox *ratioSpin = new QDoubleSpinBox;
+    ratioSpin->setRange(0.01, 0.99);
+    ratioSpin->setSingleStep(0.05);
+    ratioSpin->setValue(0.1);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *ratioLabel = new QLabel("Keep ratio:");
+    ratioLabel->setStyleSheet("color: white;");
+    formLayout->addRow(ratioLabel, ratioSpin);
+    
+    QCheckBox *boundaryCheck = new QCheckBox("Preserve boundary");
+    QCheckBox *seamCheck = new QCheckBox("Preserve texture seams");
+    boundaryCheck->setChecked(true);
+    seamCheck->setChecked(true);
+    boundaryCheck->setStyleSheet("color: white;");
+    seamCheck->setStyleSheet("color: white;");
+    
+    QPushButton *decimateButton = new QPushButton("Decimate");
+    decimateButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(decimateButton, &QPushButton::clicked, [glWidget, ratioSpin, boundaryCheck, seamCheck, statusLabel]() {
+        statusLabel->setText("Decimating...");
+        statusLabel->repaint();
+        if (!glWidget->decimateMesh(ratioSpin->value(), boundaryCheck->isChecked(), seamCheck->isChecked())) {
+            statusLabel->setText("No mesh loaded");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::decimationFinished, statusLabel,
+                     [statusLabel](int inputFaces, int outputFaces, int blocks, double milliseconds) {
+        statusLabel->setText(QString("%1 -> %2 faces, %3 blocks (%4 ms)")
+                             .arg(inputFaces).arg(outputFaces).arg(blocks).arg(milliseconds, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(boundaryCheck);
+    layout->addWidget(seamCheck);
+    layout->addWidget(decimateButton);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+inline QGroupBox* createBasicRemeshingGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Isotropic Remeshing");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    // 目标边长相对当前平均边长的倍数
+    QDoubleSpinBox *lengthSpin = new QDoubleSpinBox;
+    lengthSpin->setRange(0.1, 10.0);
+    lengthSpin->setSingleStep(0.1);
+    lengthSpin->setValue(1.0);
+    
+    QSpinBox *iterationSpin = new QSpinBox;
+    iterationSpin->setRange(1, 50);
+    iterationSpin->setValue(10);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *lengthLabel = new QLabel("Edge length (x mean):");
+    QLabel *iterationLabel = new QLabel("Iterations:");
+    lengthLabel->setStyleSheet("color: white;");
+    iterationLabel->setStyleSheet("color: white;");
+    formLayout->addRow(lengthLabel, lengthSpin);
+    formLayout->addRow(iterationLabel, iterationSpin);
+    
+    QCheckBox *boundaryCheck = new QCheckBox("Preserve boundary");
+    boundaryCheck->setChecked(true);
+    boundaryCheck->setStyleSheet("color: white;");
+    
+    QPushButton *remeshButton = new QPushButton("Remesh");
+    remeshButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(remeshButton, &QPushButton::clicked, [glWidget, lengthSpin, iterationSpin, boundaryCheck, statusLabel]() {
+        statusLabel->setText("Remeshing...");
+        statusLabel->repaint();
+        double length = glWidget->meanEdgeLength() * lengthSpin->value();
+        if (!glWidget->remeshIsotropic(length, iterationSpin->value(), boundaryCheck->isChecked())) {
+            statusLabel->setText("No mesh loaded");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::remeshFinished, statusLabel,
+                     [statusLabel](int faceCount, double targetLength, double milliseconds) {
+        statusLabel->setText(QString("%1 faces, edge %2 (%3 ms)")
+                             .arg(faceCount).arg(targetLength, 0, 'g', 4).arg(milliseconds, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(boundaryCheck);
+    layout->addWidget(remeshButton);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+inline QGroupBox* createBasicSmoothingGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Smoothing / Fairing");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QDoubleSpinBox *strengthSpin = new QDoubleSpinBox;
+    strengthSpin->setRange(0.01, 100.0);
+    strengthSpin->setSingleStep(0.1);
+    strengthSpin->setValue(1.0);
+    
+    QSpinBox *iterationSpin = new QSpinBox;
+    iterationSpin->setRange(1, 100);
+    iterationSpin->setValue(1);
+    
+    QComboBox *solverCombo = new QComboBox;
+    solverCombo->addItem("Direct (LDLT)", int(laplacian::SolverType::direct));
+    solverCombo->addItem("Conjugate gradient", int(laplacian::SolverType::conjugate_gradient));
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *strengthLabel = new QLabel("Strength:");
+    QLabel *iterationLabel = new QLabel("Iterations:");
+    QLabel *solverLabel = new QLabel("Solver:");
+    strengthLabel->setStyleSheet("color: white;");
+    iterationLabel->setStyleSheet("color: white;");
+    solverLabel->setStyleSheet("color: white;");
+    formLayout->addRow(strengthLabel, strengthSpin);
+    formLayout->addRow(iterationLabel, iterationSpin);
+    formLayout->addRow(solverLabel, solverCombo);
+    
+    QCheckBox *selectionCheck = new QCheckBox("Selected vertices only");
+    selectionCheck->setStyleSheet("color: white;");
+    
+    QPushButton *smoothButton = new QPushButton("Smooth");
+    QPushButton *fairButton = new QPushButton("Fair Selection");
+    smoothButton->setStyleSheet(buttonStyle);
+    fairButton->setStyleSheet(buttonStyle);
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(smoothButton);
+    buttonLayout->addWidget(fairButton);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(solverCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [glWidget, solverCombo](int) {
+        glWidget->setLaplacianSolver(laplacian::SolverType(solverCombo->currentData().toInt()));
+    });
+    QObject::connect(smoothButton, &QPushButton::clicked, [glWidget, strengthSpin, iterationSpin, selectionCheck, statusLabel]() {
+        if (!glWidget->smoothMesh(strengthSpin->value(), iterationSpin->value(), selectionCheck->isChecked())) {
+            statusLabel->setText("Smoothing failed");
+        }
+    });
+    QObject::connect(fairButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        if (!glWidget->fairSelection()) {
+            statusLabel->setText("Select a region to fair");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::laplacianSolved, statusLabel,
+                     [statusLabel](double assembleMs, double factorizeMs, double solveMs, bool reusedSymbolic) {
+        statusLabel->setText(QString("assemble %1 ms, factor %2 ms%3, solve %4 ms")
+                             .arg(assembleMs, 0, 'f', 1).arg(factorizeMs, 0, 'f', 1)
+                             .arg(reusedSymbolic ? " (cached)" : "").arg(solveMs, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(selectionCheck);
+    layout->addLayout(buttonLayout);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+// 创建UV参数化控制组
+inline QGroupBox* createBasicParameterizationGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("UV Parameterization");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QComboBox *methodCombo = new QComboBox;
+    methodCombo->addItem("LSCM (conformal)", int(parameterization::Method::lscm));
+    methodCombo->addItem("ARAP (as-rigid-as-possible)", int(parameterization::Method::arap));
+    
+    QSpinBox *iterationSpin = new QSpinBox;
+    iterationSpin->setRange(1, 200);
+    iterationSpin->setValue(10);
+    iterationSpin->setEnabled(false);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *methodLabel = new QLabel("Method:");
+    QLabel *iterationLabel = new QLabel("ARAP iterations:");
+    methodLabel->setStyleSheet("color: white;");
+    iterationLabel->setStyleSheet("color: white;");
+    formLayout->addRow(methodLabel, methodCombo);
+    formLayout->addRow(iterationLabel, iterationSpin);
+    
+    QCheckBox *uvViewCheck = new QCheckBox("Show UV view");
+    uvViewCheck->setStyleSheet("color: white;");
+    
+    QPushButton *computeButton = new QPushButton("Parameterize");
+    QPushButton *exportButton = new QPushButton("Export OBJ with UVs");
+    computeButton->setStyleSheet(buttonStyle);
+    exportButton->setStyleSheet(buttonStyle);
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(computeButton);
+    buttonLayout->addWidget(exportButton);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(methodCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [methodCombo, iterationSpin](int) {
+        iterationSpin->setEnabled(parameterization::Method(methodCombo->currentData().toInt()) == parameterization::Method::arap);
+    });
+    QObject::connect(uvViewCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setShowUVView(checked);
+    });
+    QObject::connect(computeButton, &QPushButton::clicked, [glWidget, methodCombo, iterationSpin, uvViewCheck, statusLabel]() {
+        parameterization::Method method = parameterization::Method(methodCombo->currentData().toInt());
+        if (glWidget->computeParameterization(method, iterationSpin->value())) {
+            uvViewCheck->setChecked(true);
+        } else {
+            statusLabel->setText("Needs a triangle mesh with disk topology");
+        }
+    });
+    QObject::connect(exportButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        if (!glWidget->hasTexCoords()) {
+            statusLabel->setText("No texture coordinates to export");
+            return;
+        }
+        QString filePath = QFileDialog::getSaveFileName(glWidget, "Export OBJ File", "", "OBJ Files (*.obj)");
+        if (filePath.isEmpty()) return;
+        if (glWidget->saveMesh(filePath, true)) {
+            statusLabel->setText("Exported " + QFileInfo(filePath).fileName());
+        } else {
+            statusLabel->setText("Export failed");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::parameterizationFinished, statusLabel,
+                     [statusLabel](double factorizeMs, double solveMs, double localMs, bool reusedFactorization, int flippedFaces) {
+        statusLabel->setText(QString("factor %1 ms%2, solve %3 ms, local %4 ms, %5 flipped")
+                             .arg(factorizeMs, 0, 'f', 1).arg(reusedFactorization ? " (cached)" : "")
+                             .arg(solveMs, 0, 'f', 1).arg(localMs, 0, 'f', 1).arg(flippedFaces));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(uvViewCheck);
+    layout->addLayout(buttonLayout);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+// 创建测地距离控制组
+inline QGroupBox* createBasicGeodesicGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Geodesic Distance");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QDoubleSpinBox *timeSpin = new QDoubleSpinBox;
+    timeSpin->setRange(0.1, 100.0);
+    timeSpin->setSingleStep(0.5);
+    timeSpin->setValue(1.0);
+    
+    QSpinBox *isolineSpin = new QSpinBox;
+    isolineSpin->setRange(0, 100);
+    isolineSpin->setValue(20);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *timeLabel = new QLabel("Time step (x h^2):");
+    QLabel *isolineLabel = new QLabel("Isolines:");
+    timeLabel->setStyleSheet("color: white;");
+    isolineLabel->setStyleSheet("color: white;");
+    formLayout->addRow(timeLabel, timeSpin);
+    formLayout->addRow(isolineLabel, isolineSpin);
+    
+    QCheckBox *fieldCheck = new QCheckBox("Show distance field");
+    fieldCheck->setStyleSheet("color: white;");
+    
+    QPushButton *computeButton = new QPushButton("Distance from Selection");
+    computeButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(timeSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [glWidget](double value) {
+        glWidget->setGeodesicTimeScale(value);
+    });
+    QObject::connect(isolineSpin, QOverload<int>::of(&QSpinBox::valueChanged), [glWidget](int value) {
+        glWidget->setIsolineCount(value);
+    });
+    QObject::connect(fieldCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setShowDistanceField(checked);
+    });
+    QObject::connect(computeButton, &QPushButton::clicked, [glWidget, fieldCheck, statusLabel]() {
+        if (glWidget->computeGeodesics()) {
+            fieldCheck->setChecked(true);
+        } else {
+            statusLabel->setText("Select source vertices on a triangle mesh");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::geodesicsComputed, statusLabel,
+                     [statusLabel](double maxDistance, double factorizeMs, double heatMs, double gradientMs, double poissonMs) {
+        statusLabel->setText(QString("max %1, factor %2 ms, solve %3 + %4 + %5 ms")
+                             .arg(maxDistance, 0, 'g', 4).arg(factorizeMs, 0, 'f', 1)
+                             .arg(heatMs, 0, 'f', 1).arg(gradientMs, 0, 'f', 1).arg(poissonMs, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(fieldCheck);
+    layout->addWidget(computeButton);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+// 创建网格统计组，加载或编辑后由后台分析结果填充
+inline QGroupBox* createBasicMeshInfoGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Mesh Statistics");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QLabel *statsLabel = new QLabel("No mesh loaded");
+    statsLabel->setStyleSheet("color: white;");
+    statsLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    
+    QObject::connect(glWidget, &BaseGLWidget::meshAnalyzed, statsLabel,
+                     [statsLabel](const mesh_analysis::Report& report) {
+        QString text = QString("Vertices: %1  Edges: %2  Faces: %3\n")
+                           .arg(report.vertices).arg(report.edges).arg(report.faces);
+        text += QString("Components: %1  Boundary loops: %2\n")
+                    .arg(report.components).arg(report.boundary_loops);
+        text += QString("Euler characteristic: %1  Genus: %2\n")
+                    .arg(report.euler_characteristic).arg(report.genus);
+        text += QString("Non-manifold vertices: %1  Isolated: %2  Degenerate faces: %3\n")
+                    .arg(report.non_manifold_vertices).arg(report.isolated_vertices).arg(report.degenerate_faces);
+        text += QString("Area: %1").arg(report.area, 0, 'g', 6);
+        if (report.closed) {
+            text += QString("  Volume: %1").arg(report.volume, 0, 'g', 6);
+        } else {
+            text += QString("  Open (%1 boundary edges)").arg(report.boundary_edges);
+        }
+        text += QString("\nAnalyzed in %1 ms").arg(report.milliseconds, 0, 'f', 1);
+        statsLabel->setText(text);
+    });
+    
+    layout->addWidget(statsLabel);
+    return group;
+}
+
+// 创建网格修复控制组
+inline QGroupBox* createBasicRepairGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Mesh Repair");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    // 焊接容差：平均边长的倍数
+    QDoubleSpinBox *toleranceSpin = new QDoubleSpinBox;
+    toleranceSpin->setDecimals(4);
+    toleranceSpin->setRange(0.0, 1.0);
+    toleranceSpin->setSingleStep(0.001);
+    toleranceSpin->setValue(0.001);
+    
+    QSpinBox *holeSpin = new QSpinBox;
+    holeSpin->setRange(0, 100000);
+    holeSpin->setValue(500);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *toleranceLabel = new QLabel("Weld tolerance (x edge):");
+    QLabel *holeLabel = new QLabel("Max hole edges:");
+    toleranceLabel->setStyleSheet("color: white;");
+    holeLabel->setStyleSheet("color: white;");
+    formLayout->addRow(toleranceLabel, toleranceSpin);
+    formLayout->addRow(holeLabel, holeSpin);
+    
+    QCheckBox *fairCheck = new QCheckBox("Fair filled holes");
+    fairCheck->setChecked(true);
+    fairCheck->setStyleSheet("color: white;");
+    
+    QPushButton *repairButton = new QPushButton("Repair Mesh");
+    repairButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(repairButton, &QPushButton::clicked, [glWidget, toleranceSpin, holeSpin, fairCheck, statusLabel]() {
+        statusLabel->setText("Repairing...");
+        statusLabel->repaint();
+        if (!glWidget->repairMesh(toleranceSpin->value(), holeSpin->value(), fairCheck->isChecked())) {
+            statusLabel->setText("No mesh loaded");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::repairFinished, statusLabel,
+                     [statusLabel](int weldedVertices, int removedFaces, int holesFilled, int holesSkipped, double milliseconds) {
+        statusLabel->setText(QString("welded %1 vertices, removed %2 faces, filled %3 holes (%4 skipped), %5 ms")
+                             .arg(weldedVertices).arg(removedFaces).arg(holesFilled).arg(holesSkipped)
+                             .arg(milliseconds, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(fairCheck);
+    layout->addWidget(repairButton);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+// 自相交检测组，相交的面标成红色
+inline QGroupBox* createBasicSelfIntersectionGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Self-Intersections");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QPushButton *checkButton = new QPushButton("Check Self-Intersections");
+    checkButton->setStyleSheet(buttonStyle);
+    QPushButton *clearButton = new QPushButton("Clear Highlight");
+    clearButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    statusLabel->setWordWrap(true);
+    
+    QObject::connect(checkButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        statusLabel->setText("Checking...");
+        statusLabel->repaint();
+        if (!glWidget->checkSelfIntersections()) {
+            statusLabel->setText("No mesh loaded");
+        }
+    });
+    QObject::connect(clearButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        glWidget->clearFaceHighlight();
+        statusLabel->clear();
+    });
+    QObject::connect(glWidget, &BaseGLWidget::selfIntersectionsChecked, statusLabel,
+                     [statusLabel](int intersectingPairs, int faceCount, int candidatePairs, double buildMs, double testMs) {
+        if (intersectingPairs == 0) {
+            statusLabel->setText(QString("No self-intersections (%1 candidate pairs), BVH %2 ms, tests %3 ms")
+                                 .arg(candidatePairs).arg(buildMs, 0, 'f', 1).arg(testMs, 0, 'f', 1));
+            return;
+        }
+        statusLabel->setText(QString("%1 intersecting pairs on %2 faces (%3 candidates), BVH %4 ms, tests %5 ms")
+                             .arg(intersectingPairs).arg(faceCount).arg(candidatePairs)
+                             .arg(buildMs, 0, 'f', 1).arg(testMs, 0, 'f', 1));
+    });
+    
+    layout->addWidget(checkButton);
+    layout->addWidget(clearButton);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+// ICP配准：结果先只作为显示变换，提交后才写入顶点
+inline QGroupBox* createBasicAlignmentGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("ICP Alignment");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QPushButton *targetButton = new QPushButton("Load Target");
+    targetButton->setStyleSheet(buttonStyle);
+    
+    QSpinBox *iterationSpin = new QSpinBox;
+    iterationSpin->setRange(1, 200);
+    iterationSpin->setValue(30);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *iterationLabel = new QLabel("Iterations per stage:");
+    iterationLabel->setStyleSheet("color: white;");
+    formLayout->addRow(iterationLabel, iterationSpin);
+    
+    QPushButton *alignButton = new QPushButton("Align");
+    alignButton->setStyleSheet(buttonStyle);
+    QPushButton *commitButton = new QPushButton("Commit");
+    commitButton->setStyleSheet(buttonStyle);
+    QPushButton *resetButton = new QPushButton("Reset");
+    resetButton->setStyleSheet(buttonStyle);
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(commitButton);
+    buttonLayout->addWidget(resetButton);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    statusLabel->setWordWrap(true);
+    
+    QObject::connect(targetButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        QString filePath = QFileDialog::getOpenFileName(glWidget, "Open Target OBJ File", "", "OBJ Files (*.obj)");
+        if (filePath.isEmpty()) return;
+        if (glWidget->loadAlignmentTarget(filePath)) {
+            statusLabel->setText("Target: " + QFileInfo(filePath).fileName());
+        } else {
+            statusLabel->setText("Load a mesh first, then a valid target");
+        }
+    });
+    QObject::connect(alignButton, &QPushButton::clicked, [glWidget, iterationSpin, statusLabel]() {
+        if (!glWidget->hasAlignmentTarget()) {
+            statusLabel->setText("No target loaded");
+            return;
+        }
+        statusLabel->setText("Aligning...");
+        statusLabel->repaint();
+        if (!glWidget->alignToTarget(iterationSpin->value())) {
+            statusLabel->setText("Alignment failed: too few correspondences");
+        }
+    });
+    QObject::connect(commitButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        if (!glWidget->hasPendingAlignment()) return;
+        glWidget->commitAlignment();
+        statusLabel->setText("Alignment applied to vertices");
+    });
+    QObject::connect(resetButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        glWidget->resetAlignment();
+        statusLabel->setText("Alignment reset");
+    });
+    QObject::connect(glWidget, &BaseGLWidget::alignmentFinished, statusLabel,
+                     [statusLabel](double initialRms, double rms, int iterations, int correspondences, bool converged, double milliseconds) {
+        statusLabel->setText(QString("RMS %1 -> %2, %3 iterations%4, %5 pairs (%6 ms)")
+                             .arg(initialRms, 0, 'g', 4).arg(rms, 0, 'g', 4).arg(iterations)
+                             .arg(converged ? "" : " (not converged)").arg(correspondences)
+                             .arg(milliseconds, 0, 'f', 1));
+    });
+    
+    layout->addWidget(targetButton);
+    layout->addLayout(formLayout);
+    layout->addWidget(alignButton);
+    layout->addLayout(buttonLayout);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+inline QGroupBox* createBasicSamplingGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Surface Sampling");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QComboBox *methodCombo = new QComboBox;
+    methodCombo->addItem("Random (area-weighted)");
+    methodCombo->addItem("Poisson disk");
+    
+    QSpinBox *countSpin = new QSpinBox;
+    countSpin->setRange(1, 100000000);
+    countSpin->setSingleStep(10000);
+    countSpin->setValue(100000);
+    
+    // 最小间距相对当前平均边长的倍数
+    QDoubleSpinBox *radiusSpin = new QDoubleSpinBox;
+    radiusSpin->setRange(0.05, 100.0);
+    radiusSpin->setSingleStep(0.1);
+    radiusSpin->setValue(1.0);
+    radiusSpin->setEnabled(false);
+    
+    QSpinBox *seedSpin = new QSpinBox;
+    seedSpin->setRange(0, 1000000);
+    seedSpin->setValue(1);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *methodLabel = new QLabel("Method:");
+    QLabel *countLabel = new QLabel("Samples:");
+    QLabel *radiusLabel = new QLabel("Radius (x mean edge):");
+    QLabel *seedLabel = new QLabel("Seed:");
+    methodLabel->setStyleSheet("color: white;");
+    countLabel->setStyleSheet("color: white;");
+    radiusLabel->setStyleSheet("color: white;");
+    seedLabel->setStyleSheet("color: white;");
+    formLayout->addRow(methodLabel, methodCombo);
+    formLayout->addRow(countLabel, countSpin);
+    formLayout->addRow(radiusLabel, radiusSpin);
+    formLayout->addRow(seedLabel, seedSpin);
+    
+    QCheckBox *showCheck = new QCheckBox("Show samples");
+    showCheck->setChecked(true);
+    showCheck->setStyleSheet("color: white;");
+    
+    QPushButton *sampleButton = new QPushButton("Sample");
+    sampleButton->setStyleSheet(buttonStyle);
+    QPushButton *exportButton = new QPushButton("Export PLY");
+    exportButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    statusLabel->setWordWrap(true);
+    
+    QObject::connect(methodCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [countSpin, radiusSpin](int index) {
+        countSpin->setEnabled(index == 0);
+        radiusSpin->setEnabled(index == 1);
+    });
+    QObject::connect(showCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setShowSamples(checked);
+    });
+    QObject::connect(sampleButton, &QPushButton::clicked, [glWidget, methodCombo, countSpin, radiusSpin, seedSpin, statusLabel]() {
+        statusLabel->setText("Sampling...");
+        statusLabel->repaint();
+        unsigned int seed = (unsigned int)seedSpin->value();
+        bool ok = methodCombo->currentIndex() == 0 ? glWidget->sampleSurfaceRandom(countSpin->value(), seed)
+                                                   : glWidget->sampleSurfacePoisson(radiusSpin->value(), seed);
+        if (!ok) {
+            statusLabel->setText("No mesh loaded or mesh has no area");
+        }
+    });
+    QObject::connect(exportButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        if (glWidget->sampleCount() == 0) {
+            statusLabel->setText("No samples to export");
+            return;
+        }
+        QString filePath = QFileDialog::getSaveFileName(glWidget, "Export PLY File", "", "PLY Files (*.ply)");
+        if (filePath.isEmpty()) return;
+        if (glWidget->exportSamples(filePath)) {
+            statusLabel->setText("Exported " + QFileInfo(filePath).fileName());
+        } else {
+            statusLabel->setText("Export failed");
+        }
+    });
+    QObject::connect(glWidget, &BaseGLWidget::samplingFinished, statusLabel,
+                     [statusLabel](int sampleCount, int candidates, double setupMs, double sampleMs, double selectMs) {
+        if (candidates == 0) {
+            statusLabel->setText(QString("%1 samples, setup %2 ms, sampling %3 ms")
+                                 .arg(sampleCount).arg(setupMs, 0, 'f', 1).arg(sampleMs, 0, 'f', 1));
+            return;
+        }
+        statusLabel->setText(QString("%1 samples from %2 candidates, setup %3 ms, candidates %4 ms, selection %5 ms")
+                             .arg(sampleCount).arg(candidates).arg(setupMs, 0, 'f', 1)
+                             .arg(sampleMs, 0, 'f', 1).arg(selectMs, 0, 'f', 1));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(showCheck);
+    layout->addWidget(sampleButton);
+    layout->addWidget(exportButton);
+    layout->addWidget(statusLabel);
+    return group;
+}
+
+inline QGroupBox* createBasicPointCloudGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Point Cloud");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    // 每帧最多绘制的点数，点云再大帧时间也只取决于它
+    QSpinBox *budgetSpin = new QSpinBox;
+    budgetSpin->setRange(100000, 100000000);
+    budgetSpin->setSingleStep(500000);
+    budgetSpin->setValue(3000000);
+    
+    // 点精灵直径相对节点点间距的倍数
+    QDoubleSpinBox *sizeSpin = new QDoubleSpinBox;
+    sizeSpin->setRange(0.5, 5.0);
+    sizeSpin->setSingleStep(0.1);
+    sizeSpin->setValue(1.5);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *budgetLabel = new QLabel("Point budget:");
+    QLabel *sizeLabel = new QLabel("Point size (x spacing):");
+    budgetLabel->setStyleSheet("color: white;");
+    sizeLabel->setStyleSheet("color: white;");
+    formLayout->addRow(budgetLabel, budgetSpin);
+    formLayout->addRow(sizeLabel, sizeSpin);
+    
+    QCheckBox *normalCheck = new QCheckBox("Shade with normals");
+    normalCheck->setChecked(true);
+    normalCheck->setStyleSheet("color: white;");
+    QCheckBox *colorCheck = new QCheckBox("Use point colors");
+    colorCheck->setChecked(true);
+    colorCheck->setStyleSheet("color: white;");
+    
+    QLabel *loadLabel = new QLabel("Load a PLY or a face-less OBJ file");
+    loadLabel->setStyleSheet("color: white;");
+    loadLabel->setWordWrap(true);
+    QLabel *drawLabel = new QLabel("");
+    drawLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(budgetSpin, QOverload<int>::of(&QSpinBox::valueChanged), [glWidget](int value) {
+        glWidget->setPointBudget(value);
+    });
+    QObject::connect(sizeSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [glWidget](double value) {
+        glWidget->setPointSizeScale(float(value));
+    });
+    QObject::connect(normalCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setPointNormalShading(checked);
+    });
+    QObject::connect(colorCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setPointColors(checked);
+    });
+    QObject::connect(glWidget, &BaseGLWidget::pointCloudLoaded, loadLabel,
+                     [loadLabel, drawLabel](int pointCount, int nodeCount, bool hasNormals, bool hasColors, double readMs, double buildMs) {
+        QString attributes;
+        if (hasNormals) attributes += ", normals";
+        if (hasColors) attributes += ", colors";
+        loadLabel->setText(QString("%1 points%2, %3 octree nodes\nRead %4 ms, octree %5 ms")
+                           .arg(pointCount).arg(attributes).arg(nodeCount)
+                           .arg(readMs, 0, 'f', 1).arg(buildMs, 0, 'f', 1));
+        drawLabel->setText("");
+    });
+    QObject::connect(glWidget, &BaseGLWidget::pointCloudDrawn, drawLabel, [drawLabel](int pointCount, int nodeCount) {
+        drawLabel->setText(QString("Drawn: %1 points in %2 nodes").arg(pointCount).arg(nodeCount));
+    });
+    
+    layout->addLayout(formLayout);
+    layout->addWidget(normalCheck);
+    layout->addWidget(colorCheck);
+    layout->addWidget(loadLabel);
+    layout->addWidget(drawLabel);
+    return group;
+}
+
+// 创建多对象场景控制组
+inline QGroupBox* createBasicSceneGroup(BaseGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Scene");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QPushButton *addButton = new QPushButton("Add Objects");
+    addButton->setStyleSheet(buttonStyle);
+    
+    // 勾选框控制可见性
+    QListWidget *objectList = new QListWidget;
+    objectList->setMinimumHeight(120);
+    
+    // 平移为文件单位，旋转为欧拉角（度）
+    QDoubleSpinBox *translateSpins[3];
+    QDoubleSpinBox *rotateSpins[3];
+    for (int a = 0; a < 3; a++) {
+        translateSpins[a] = new QDoubleSpinBox;
+        translateSpins[a]->setRange(-1000000.0, 1000000.0);
+        translateSpins[a]->setDecimals(3);
+        translateSpins[a]->setSingleStep(0.1);
+        rotateSpins[a] = new QDoubleSpinBox;
+        rotateSpins[a]->setRange(-180.0, 180.0);
+        rotateSpins[a]->setSingleStep(5.0);
+        rotateSpins[a]->setWrapping(true);
+    }
+    QDoubleSpinBox *scaleSpin = new QDoubleSpinBox;
+    scaleSpin->setRange(0.001, 1000.0);
+    scaleSpin->setDecimals(3);
+    scaleSpin->setSingleStep(0.1);
+    scaleSpin->setValue(1.0);
+    
+    QHBoxLayout *translateLayout = new QHBoxLayout;
+    QHBoxLayout *rotateLayout = new QHBoxLayout;
+    for (int a = 0; a < 3; a++) {
+        translateLayout->addWidget(translateSpins[a]);
+        rotateLayout->addWidget(rotateSpins[a]);
+    }
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *translateLabel = new QLabel("Translate:");
+    QLabel *rotateLabel = new QLabel("Rotate (deg):");
+    QLabel *scaleLabel = new QLabel("Scale:");
+    translateLabel->setStyleSheet("color: white;");
+    rotateLabel->setStyleSheet("color: white;");
+    scaleLabel->setStyleSheet("color: white;");
+    formLayout->addRow(translateLabel, translateLayout);
+    formLayout->addRow(rotateLabel, rotateLayout);
+    formLayout->addRow(scaleLabel, scaleSpin);
+    
+    // 阵列：选中对象的几何只上传一次，按实例绘制
+    QSpinBox *arraySpins[3];
+    QHBoxLayout *arrayLayout = new QHBoxLayout;
+    for (int a = 0; a < 3; a++) {
+        arraySpins[a] = new QSpinBox;
+        arraySpins[a]->setRange(1, 100);
+        arraySpins[a]->setValue(1);
+        arrayLayout->addWidget(arraySpins[a]);
+    }
+    QDoubleSpinBox *gapSpin = new QDoubleSpinBox;
+    gapSpin->setRange(0.0, 10.0);
+    gapSpin->setSingleStep(0.1);
+    gapSpin->setValue(0.2);
+    QLabel *arrayLabel = new QLabel("Array copies:");
+    QLabel *gapLabel = new QLabel("Array gap (x size):");
+    arrayLabel->setStyleSheet("color: white;");
+    gapLabel->setStyleSheet("color: white;");
+    formLayout->addRow(arrayLabel, arrayLayout);
+    formLayout->addRow(gapLabel, gapSpin);
+    QPushButton *arrayButton = new QPushButton("Make Array");
+    arrayButton->setStyleSheet(buttonStyle);
+    
+    QPushButton *colorButton = new QPushButton("Object Color");
+    colorButton->setStyleSheet(buttonStyle);
+    QPushButton *removeButton = new QPushButton("Remove Object");
+    removeButton->setStyleSheet(buttonStyle);
+    QPushButton *clearButton = new QPushButton("Clear Scene");
+    clearButton->setStyleSheet(buttonStyle);
+    
+    QLabel *statusLabel = new QLabel("");
+    statusLabel->setStyleSheet("color: white;");
+    statusLabel->setWordWrap(true);
+    QLabel *drawLabel = new QLabel("");
+    drawLabel->setStyleSheet("color: white;");
+    
+    // 选中对象变化时把它的变换填回输入框，不触发修改
+    auto syncEditors = [glWidget, objectList, translateSpins, rotateSpins, scaleSpin]() {
+        int row = objectList->currentRow();
+        bool valid = row >= 0 && row < glWidget->meshScene().objectCount();
+        QVector3D translation, euler;
+        float scale = 1.0f;
+        if (valid) {
+            const MeshScene::Object& object = glWidget->meshScene().object(row);
+            translation = object.translation;
+            euler = object.rotation.toEulerAngles();
+            scale = object.scale;
+        }
+        for (int a = 0; a < 3; a++) {
+            QSignalBlocker blockTranslate(translateSpins[a]);
+            QSignalBlocker blockRotate(rotateSpins[a]);
+            translateSpins[a]->setValue(translation[a]);
+            rotateSpins[a]->setValue(euler[a]);
+            translateSpins[a]->setEnabled(valid);
+            rotateSpins[a]->setEnabled(valid);
+        }
+        QSignalBlocker blockScale(scaleSpin);
+        scaleSpin->setValue(scale);
+        scaleSpin->setEnabled(valid);
+    };
+    auto applyTransform = [glWidget, objectList, translateSpins, rotateSpins, scaleSpin]() {
+        int row = objectList->currentRow();
+        if (row < 0) return;
+        QVector3D translation(translateSpins[0]->value(), translateSpins[1]->value(), translateSpins[2]->value());
+        QVector3D euler(rotateSpins[0]->value(), rotateSpins[1]->value(), rotateSpins[2]->value());
+        glWidget->setSceneObjectTransform(row, translation, euler, float(scaleSpin->value()));
+    };
+    for (int a = 0; a < 3; a++) {
+        QObject::connect(translateSpins[a], QOverload<double>::of(&QDoubleSpinBox::valueChanged), applyTransform);
+        QObject::connect(rotateSpins[a], QOverload<double>::of(&QDoubleSpinBox::valueChanged), applyTransform);
+    }
+    QObject::connect(scaleSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), applyTransform);
+    QObject::connect(objectList, &QListWidget::currentRowChanged, syncEditors);
+    QObject::connect(objectList, &QListWidget::itemChanged, [glWidget, objectList](QListWidgetItem* item) {
+        glWidget->setSceneObjectVisible(objectList->row(item), item->checkState() == Qt::Checked);
+    });
+    
+    QObject::connect(addButton, &QPushButton::clicked, [glWidget, statusLabel]() {
+        QStringList filePaths = QFileDialog::getOpenFileNames(glWidget, "Add OBJ Files", "", "OBJ Files (*.obj)");
+        int failed = 0;
+        for (const QString& filePath : filePaths) {
+            if (glWidget->addSceneObject(filePath) < 0) failed++;
+        }
+        if (failed > 0) {
+            statusLabel->setText(QString("%1 file(s) could not be loaded").arg(failed));
+        }
+    });
+    QObject::connect(arrayButton, &QPushButton::clicked, [glWidget, objectList, arraySpins, gapSpin]() {
+        glWidget->setSceneObjectArray(objectList->currentRow(), arraySpins[0]->value(), arraySpins[1]->value(),
+                                      arraySpins[2]->value(), float(gapSpin->value()));
+    });
+    QObject::connect(colorButton, &QPushButton::clicked, [glWidget, objectList]() {
+        int row = objectList->currentRow();
+        if (row < 0) return;
+        QVector3D c = glWidget->meshScene().object(row).color;
+        QColor color = QColorDialog::getColor(QColor::fromRgbF(c.x(), c.y(), c.z()), glWidget, "Select Object Color");
+        if (color.isValid()) {
+            glWidget->setSceneObjectColor(row, color);
+        }
+    });
+    QObject::connect(removeButton, &QPushButton::clicked, [glWidget, objectList]() {
+        glWidget->removeSceneObject(objectList->currentRow());
+    });
+    QObject::connect(clearButton, &QPushButton::clicked, [glWidget]() {
+        glWidget->clearScene();
+    });
+    
+    // 对象增删后重建列表
+    QObject::connect(glWidget, &BaseGLWidget::sceneChanged, objectList, [glWidget, objectList, statusLabel, syncEditors]() {
+        const MeshScene& scene = glWidget->meshScene();
+        int row = objectList->currentRow();
+        {
+            QSignalBlocker blocker(objectList);
+            objectList->clear();
+            for (int i = 0; i < scene.objectCount(); i++) {
+                QString name = scene.object(i).name;
+                if (!scene.object(i).instances.empty()) {
+                    name += QString(" (x%1)").arg(scene.object(i).instances.size());
+                }
+                QListWidgetItem *item = new QListWidgetItem(name, objectList);
+                item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+                item->setCheckState(scene.object(i).visible ? Qt::Checked : Qt::Unchecked);
+            }
+            objectList->setCurrentRow(qMin(row < 0 ? scene.objectCount() - 1 : row, scene.objectCount() - 1));
+        }
+        syncEditors();
+        statusLabel->setText(QString("%1 objects, %2 copies, %3 unique triangles, arena %4 MB")
+                             .arg(scene.objectCount()).arg(scene.copyCount()).arg(scene.triangleCount())
+                             .arg(scene.arenaBytes() / (1024.0 * 1024.0), 0, 'f', 1));
+    });
+    QObject::connect(glWidget, &BaseGLWidget::sceneDrawn, drawLabel, [drawLabel](int visibleCopies, int drawCalls) {
+        drawLabel->setText(QString("Drawn: %1 copies in %2 draw call(s)").arg(visibleCopies).arg(drawCalls));
+    });
+    syncEditors();
+    
+    layout->addWidget(addButton);
+    layout->addWidget(objectList);
+    layout->addLayout(formLayout);
+    layout->addWidget(arrayButton);
+    layout->addWidget(colorButton);
+    layout->addWidget(removeButton);
+    layout->addWidget(clearButton);
+    layout->addWidget(statusLabel);
+    layout->addWidget(drawLabel);
     return group;
 }
 
@@ -111,22 +1216,27 @@ inline QWidget* createBasicControlPanel(BaseGLWidget* glWidget, QLabel* infoLabe
     
     // 添加控件组
     layout->addWidget(createBasicModelLoadButton(glWidget, infoLabel, mainWindow));
+    layout->addWidget(createBasicMeshInfoGroup(glWidget));
+    layout->addWidget(createBasicRepairGroup(glWidget));
+    layout->addWidget(createBasicSelfIntersectionGroup(glWidget));
+    layout->addWidget(createBasicAlignmentGroup(glWidget));
     layout->addWidget(createBasicRenderingModeGroup(glWidget));
     layout->addWidget(createBasicDisplayOptionsGroup(glWidget));
+    layout->addWidget(createBasicPickingGroup(glWidget));
+    layout->addWidget(createBasicSelectionGroup(glWidget));
+    layout->addWidget(createBasicSubdivisionGroup(glWidget));
+    layout->addWidget(createBasicDecimationGroup(glWidget));
+    layout->addWidget(createBasicRemeshingGroup(glWidget));
+    layout->addWidget(createBasicSmoothingGroup(glWidget));
+    layout->addWidget(createBasicParameterizationGroup(glWidget));
+    layout->addWidget(createBasicGeodesicGroup(glWidget));
+    layout->addWidget(createBasicSamplingGroup(glWidget));
+    layout->addWidget(createBasicPointCloudGroup(glWidget));
+    layout->addWidget(createBasicSceneGroup(glWidget));
     
     // 视图重置按钮
     QPushButton *resetButton = new QPushButton("Reset View");
-    resetButton->setStyleSheet(
-        "QPushButton {"
-        "   background-color: #505050;"
-        "   color: white;"
-        "   border: none;"
-        "   padding: 10px 20px;"
-        "   font-size: 16px;"
-        "   border-radius: 5px;"
-        "}"
-        "QPushButton:hover { background-color: #606060; }"
-    );
+    resetButton->setStyleSheet(UIUtils::buttonStyleSheet());
     QObject::connect(resetButton, &QPushButton::clicked, [glWidget]() {
         glWidget->resetView();
     });
@@ -134,17 +1244,7 @@ inline QWidget* createBasicControlPanel(BaseGLWidget* glWidget, QLabel* infoLabe
     
     // 自适应视图按钮
     QPushButton *centerButton = new QPushButton("Center View");
-    centerButton->setStyleSheet(
-        "QPushButton {"
-        "   background-color: #505050;"
-        "   color: white;"
-        "   border: none;"
-        "   padding: 10px 20px;"
-        "   font-size: 16px;"
-        "   border-radius: 5px;"
-        "}"
-        "QPushButton:hover { background-color: #606060; }"
-    );
+    centerButton->setStyleSheet(UIUtils::buttonStyleSheet());
     QObject::connect(centerButton, &QPushButton::clicked, [glWidget]() {
         glWidget->centerView();
     });
@@ -3,6 +3,7 @@
 #define CGAL_TAB_H
 
 #include "../glwidget/cgalglwidget.h"
+#include "../menu_utils.h"
 #include <QApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -15,6 +16,10 @@
 #include <QSlider>
 #include <QRadioButton>
 #include <QCheckBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QProgressBar>
 
 // 创建CGAL标签页
 inline QWidget* createCGALTab(CGALGLWidget* glWidget) {
@@ -34,14 +39,49 @@ inline QGroupBox* createCGALDisplayOptionsGroup(CGALGLWidget* glWidget) {
         glWidget->setShowWireframeOverlay(state == Qt::Checked);
     });
     
+    QCheckBox *lineOverlayCheckbox = new QCheckBox("Use Line Wireframe (GL_LINES)");
+    lineOverlayCheckbox->setStyleSheet("color: white;");
+    QObject::connect(lineOverlayCheckbox, &QCheckBox::stateChanged, [glWidget](int state) {
+        glWidget->setWireframeOverlayStyle(state == Qt::Checked ? CGALGLWidget::LineOverlay
+                                                                : CGALGLWidget::BarycentricOverlay);
+    });
+    
     QCheckBox *faceCheckbox = new QCheckBox("Hide Faces");
     faceCheckbox->setStyleSheet("color: white;");
     QObject::connect(faceCheckbox, &QCheckBox::stateChanged, [glWidget](int state) {
         glWidget->setHideFaces(state == Qt::Checked);
     });
     
+    // 交互时的帧率上限，及实际帧时间
+    QHBoxLayout *fpsLayout = new QHBoxLayout;
+    QLabel *fpsLabel = new QLabel("Max FPS (drag):");
+    fpsLabel->setStyleSheet("color: white;");
+    QSpinBox *fpsSpin = new QSpinBox;
+    fpsSpin->setRange(0, 240);
+    fpsSpin->setSpecialValueText("Unlimited");
+    fpsSpin->setValue(glWidget->scheduler()->maxInteractiveFps());
+    QObject::connect(fpsSpin, QOverload<int>::of(&QSpinBox::valueChanged), [glWidget](int fps) {
+        glWidget->setMaxInteractiveFps(fps);
+    });
+    fpsLayout->addWidget(fpsLabel);
+    fpsLayout->addWidget(fpsSpin);
+    
+    QLabel *frameTimeLabel = new QLabel("Frame: -");
+    frameTimeLabel->setStyleSheet("color: white;");
+    QObject::connect(glWidget->scheduler(), &RenderScheduler::frameTimeUpdated,
+                     frameTimeLabel, [frameTimeLabel](double frameMs, double intervalMs) {
+        QString text = QString("Frame: %1 ms").arg(frameMs, 0, 'f', 2);
+        if (intervalMs > 0.0) {
+            text += QString(" (%1 FPS)").arg(1000.0 / intervalMs, 0, 'f', 0);
+        }
+        frameTimeLabel->setText(text);
+    });
+    
     layout->addWidget(wireframeCheckbox);
+    layout->addWidget(lineOverlayCheckbox);
     layout->addWidget(faceCheckbox);
+    layout->addLayout(fpsLayout);
+    layout->addWidget(frameTimeLabel);
     return group;
 }
 
@@ -60,35 +100,276 @@ inline QGroupBox* createCGALRenderingModeGroup(CGALGLWidget* glWidget) {
     
     // 连接渲染模式信号
     QObject::connect(solidRadio, &QRadioButton::clicked, [glWidget]() {
-        glWidget->currentRenderMode = CGALGLWidget::BlinnPhong;
-        glWidget->update();
+        glWidget->setRenderMode(CGALGLWidget::BlinnPhong);
     });
     
     QObject::connect(flatRadio, &QRadioButton::clicked, [glWidget]() {
-        glWidget->currentRenderMode = CGALGLWidget::FlatShading;
-        glWidget->update();
+        glWidget->setRenderMode(CGALGLWidget::FlatShading);
+    });
+    
+    // 与参考网格的距离色图
+    QRadioButton *distanceRadio = new QRadioButton("Distance Error");
+    layout->addWidget(distanceRadio);
+    QObject::connect(distanceRadio, &QRadioButton::clicked, [glWidget]() {
+        glWidget->setRenderMode(CGALGLWidget::DistanceError);
+    });
+    
+    return group;
+}
+
+// 创建网格距离对比组：加载参考网格并计算逐顶点误差与Hausdorff距离
+inline QGroupBox* createCGALDistanceGroup(CGALGLWidget* glWidget, QWidget* mainWindow) {
+    QGroupBox *group = new QGroupBox("Mesh Distance");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QPushButton *loadButton = new QPushButton("Load Reference Mesh");
+    loadButton->setStyleSheet(buttonStyle);
+    
+    QFormLayout *form = new QFormLayout;
+    QDoubleSpinBox *densitySpin = new QDoubleSpinBox;
+    densitySpin->setRange(1.0, 1e6);
+    densitySpin->setDecimals(0);
+    densitySpin->setValue(1000.0);
+    form->addRow("Samples / area unit:", densitySpin);
+    
+    QPushButton *computeButton = new QPushButton("Compute Distance");
+    computeButton->setStyleSheet(buttonStyle);
+    
+    QLabel *resultLabel = new QLabel("No reference mesh");
+    resultLabel->setStyleSheet("color: white;");
+    resultLabel->setWordWrap(true);
+    
+    layout->addWidget(loadButton);
+    layout->addLayout(form);
+    layout->addWidget(computeButton);
+    layout->addWidget(resultLabel);
+    
+    QObject::connect(loadButton, &QPushButton::clicked, [glWidget, resultLabel, mainWindow]() {
+        QString filePath = QFileDialog::getOpenFileName(
+            mainWindow, "Open Reference OBJ File", "", "OBJ Files (*.obj)");
+        
+        if (!filePath.isEmpty()) {
+            if (glWidget->loadReferenceOBJ(filePath)) {
+                resultLabel->setText("Reference: " + QFileInfo(filePath).fileName());
+            } else {
+                QMessageBox::warning(mainWindow, "Mesh Distance",
+                    "Failed to load the reference mesh. Load the primary mesh first.");
+            }
+        }
+    });
+    
+    QObject::connect(computeButton, &QPushButton::clicked, [glWidget, densitySpin, resultLabel]() {
+        CGALGLWidget::DistanceReport report;
+        if (!glWidget->computeDistanceToReference(report, densitySpin->value())) {
+            resultLabel->setText("Load a mesh and a reference mesh first");
+            return;
+        }
+        resultLabel->setText(QString(
+            "Vertex distance max %1, mean %2\n"
+            "Hausdorff: to ref %3, from ref %4\n"
+            "Time: tree %5 ms, vertices %6 ms, Hausdorff %7 ms")
+            .arg(report.maxVertexDistance, 0, 'g', 6)
+            .arg(report.meanVertexDistance, 0, 'g', 6)
+            .arg(report.hausdorffToReference, 0, 'g', 6)
+            .arg(report.hausdorffFromReference, 0, 'g', 6)
+            .arg(report.treeBuildMs)
+            .arg(report.vertexPassMs)
+            .arg(report.hausdorffMs));
+    });
+    
+    return group;
+}
+
+// 自相交检测组：相交的面在Blinn-Phong/平面着色下标红
+inline QGroupBox* createCGALSelfIntersectionGroup(CGALGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Self-Intersections");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QPushButton *checkButton = new QPushButton("Check Self-Intersections");
+    checkButton->setStyleSheet(buttonStyle);
+    QPushButton *clearButton = new QPushButton("Clear Highlight");
+    clearButton->setStyleSheet(buttonStyle);
+    
+    QLabel *resultLabel = new QLabel("");
+    resultLabel->setStyleSheet("color: white;");
+    resultLabel->setWordWrap(true);
+    
+    layout->addWidget(checkButton);
+    layout->addWidget(clearButton);
+    layout->addWidget(resultLabel);
+    
+    QObject::connect(checkButton, &QPushButton::clicked, [glWidget, resultLabel]() {
+        resultLabel->setText("Checking...");
+        resultLabel->repaint();
+        CGALGLWidget::SelfIntersectionReport report;
+        if (!glWidget->checkSelfIntersections(report)) {
+            resultLabel->setText(report.triangleMesh ? "No mesh loaded" : "Triangle mesh required");
+            return;
+        }
+        resultLabel->setText(QString("%1 intersecting pairs on %2 faces\nTime: %3 ms (%4)")
+            .arg(report.intersectingPairs)
+            .arg(report.faces)
+            .arg(report.milliseconds)
+            .arg(report.parallel ? "parallel" : "sequential"));
+    });
+    QObject::connect(clearButton, &QPushButton::clicked, [glWidget, resultLabel]() {
+        glWidget->clearFaceHighlight();
+        resultLabel->clear();
+    });
+    
+    return group;
+}
+
+// 布尔运算组：第二个操作数是上面载入的参考网格
+inline QGroupBox* createCGALBooleanGroup(CGALGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Boolean Operations");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    QString buttonStyle = UIUtils::buttonStyleSheet();
+    
+    QComboBox *opCombo = new QComboBox;
+    opCombo->addItem("Union", CGALGLWidget::BooleanUnion);
+    opCombo->addItem("Intersection", CGALGLWidget::BooleanIntersection);
+    opCombo->addItem("Difference (mesh - reference)", CGALGLWidget::BooleanDifference);
+    
+    QPushButton *runButton = new QPushButton("Apply with Reference Mesh");
+    runButton->setStyleSheet(buttonStyle);
+    
+    QProgressBar *progressBar = new QProgressBar;
+    progressBar->setRange(0, 100);
+    progressBar->setValue(0);
+    
+    QLabel *resultLabel = new QLabel("");
+    resultLabel->setStyleSheet("color: white;");
+    resultLabel->setWordWrap(true);
+    
+    layout->addWidget(opCombo);
+    layout->addWidget(runButton);
+    layout->addWidget(progressBar);
+    layout->addWidget(resultLabel);
+    
+    QObject::connect(runButton, &QPushButton::clicked, [glWidget, opCombo, runButton, progressBar, resultLabel]() {
+        if (!glWidget->hasReferenceMesh()) {
+            resultLabel->setText("Load a mesh and a reference mesh first");
+            return;
+        }
+        auto op = static_cast<CGALGLWidget::BooleanOp>(opCombo->currentData().toInt());
+        if (glWidget->startBoolean(op)) {
+            runButton->setEnabled(false);
+            progressBar->setValue(0);
+            resultLabel->setText("Running...");
+        }
+    });
+    QObject::connect(glWidget, &CGALGLWidget::booleanProgress, progressBar,
+                     [progressBar, resultLabel](int percent, const QString& stage) {
+        progressBar->setValue(percent);
+        resultLabel->setText(stage);
+    });
+    QObject::connect(glWidget, &CGALGLWidget::booleanFinished, runButton,
+                     [runButton, progressBar, resultLabel](const CGALGLWidget::BooleanReport& report) {
+        runButton->setEnabled(true);
+        progressBar->setValue(100);
+        if (!report.success) {
+            resultLabel->setText(report.error);
+            return;
+        }
+        resultLabel->setText(QString(
+            "%1 faces (%2 touching the reference)\n"
+            "Time: validate %3 ms, filter %4 ms, corefine %5 ms, total %6 ms%7")
+            .arg(report.faces)
+            .arg(report.touchingFaces)
+            .arg(report.validateMs)
+            .arg(report.filterMs)
+            .arg(report.corefineMs)
+            .arg(report.totalMs)
+            .arg(report.fixtureCached ? "\nReference validation and tree reused" : ""));
+    });
+    
+    return group;
+}
+
+inline QGroupBox* createCGALPointCloudGroup(CGALGLWidget* glWidget) {
+    QGroupBox *group = new QGroupBox("Point Cloud");
+    QVBoxLayout *layout = new QVBoxLayout(group);
+    
+    // 每帧最多绘制的点数，点云再大帧时间也只取决于它
+    QSpinBox *budgetSpin = new QSpinBox;
+    budgetSpin->setRange(100000, 100000000);
+    budgetSpin->setSingleStep(500000);
+    budgetSpin->setValue(3000000);
+    
+    // 点精灵直径相对节点点间距的倍数
+    QDoubleSpinBox *sizeSpin = new QDoubleSpinBox;
+    sizeSpin->setRange(0.5, 5.0);
+    sizeSpin->setSingleStep(0.1);
+    sizeSpin->setValue(1.5);
+    
+    QFormLayout *formLayout = new QFormLayout;
+    QLabel *budgetLabel = new QLabel("Point budget:");
+    QLabel *sizeLabel = new QLabel("Point size (x spacing):");
+    budgetLabel->setStyleSheet("color: white;");
+    sizeLabel->setStyleSheet("color: white;");
+    formLayout->addRow(budgetLabel, budgetSpin);
+    formLayout->addRow(sizeLabel, sizeSpin);
+    
+    QCheckBox *normalCheck = new QCheckBox("Shade with normals");
+    normalCheck->setChecked(true);
+    normalCheck->setStyleSheet("color: white;");
+    QCheckBox *colorCheck = new QCheckBox("Use point colors");
+    colorCheck->setChecked(true);
+    colorCheck->setStyleSheet("color: white;");
+    
+    QLabel *loadLabel = new QLabel("Load a PLY or a face-less OBJ file");
+    loadLabel->setStyleSheet("color: white;");
+    loadLabel->setWordWrap(true);
+    QLabel *drawLabel = new QLabel("");
+    drawLabel->setStyleSheet("color: white;");
+    
+    QObject::connect(budgetSpin, QOverload<int>::of(&QSpinBox::valueChanged), [glWidget](int value) {
+        glWidget->setPointBudget(value);
+    });
+    QObject::connect(sizeSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [glWidget](double value) {
+        glWidget->setPointSizeScale(float(value));
+    });
+    QObject::connect(normalCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setPointNormalShading(checked);
+    });
+    QObject::connect(colorCheck, &QCheckBox::toggled, [glWidget](bool checked) {
+        glWidget->setPointColors(checked);
+    });
+    QObject::connect(glWidget, &CGALGLWidget::pointCloudLoaded, loadLabel,
+                     [loadLabel, drawLabel](int pointCount, int nodeCount, bool hasNormals, bool hasColors, double readMs, double buildMs) {
+        QString attributes;
+        if (hasNormals) attributes += ", normals";
+        if (hasColors) attributes += ", colors";
+        loadLabel->setText(QString("%1 points%2, %3 octree nodes\nRead %4 ms, octree %5 ms")
+                           .arg(pointCount).arg(attributes).arg(nodeCount)
+                           .arg(readMs, 0, 'f', 1).arg(buildMs, 0, 'f', 1));
+        drawLabel->setText("");
+    });
+    QObject::connect(glWidget, &CGALGLWidget::pointCloudDrawn, drawLabel, [drawLabel](int pointCount, int nodeCount) {
+        drawLabel->setText(QString("Drawn: %1 points in %2 nodes").arg(pointCount).arg(nodeCount));
     });
     
+    layout->addLayout(formLayout);
+    layout->addWidget(normalCheck);
+    layout->addWidget(colorCheck);
+    layout->addWidget(loadLabel);
+    layout->addWidget(drawLabel);
     return group;
 }
 
 // 创建OBJ文件加载按钮（CGAL版）
 inline QWidget* createCGALModelLoadButton(CGALGLWidget* glWidget, QLabel* infoLabel, QWidget* mainWindow) {
     QPushButton *button = new QPushButton("Load OBJ File (CGAL)");
-    button->setStyleSheet(
-        "QPushButton {"
-        "   background-color: #505050;"
-        "   color: white;"
-        "   border: none;"
-        "   padding: 10px 20px;"
-        "   font-size: 16px;"
-        "   border-radius: 5px;"
-        "}"
-        "QPushButton:hover { background-color: #606060; }"
-    );
+    button->setStyleSheet(UIUtils::buttonStyleSheet());
     QObject::connect(button, &QPushButton::clicked, [glWidget, infoLabel, mainWindow]() {
         QString filePath = QFileDialog::getOpenFileName(
-            mainWindow, "Open OBJ File", "", "OBJ Files (*.obj)");
+            mainWindow, "Open OBJ File", "", "Meshes and Point Clouds (*.obj *.ply);;OBJ Files (*.obj);;PLY Files (*.ply)");
         
         if (!filePath.isEmpty()) {
             glWidget->loadOBJ(filePath);
@@ -108,20 +389,14 @@ inline QWidget* createCGALControlPanel(CGALGLWidget* glWidget, QLabel* infoLabel
     layout->addWidget(createCGALModelLoadButton(glWidget, infoLabel, mainWindow));
     layout->addWidget(createCGALRenderingModeGroup(glWidget));
     layout->addWidget(createCGALDisplayOptionsGroup(glWidget));
+    layout->addWidget(createCGALDistanceGroup(glWidget, mainWindow));
+    layout->addWidget(createCGALSelfIntersectionGroup(glWidget));
+    layout->addWidget(createCGALBooleanGroup(glWidget));
+    layout->addWidget(createCGALPointCloudGroup(glWidget));
     
     // 视图重置按钮
     QPushButton *resetButton = new QPushButton("Reset View");
-    resetButton->setStyleSheet(
-        "QPushButton {"
-        "   background-color: #505050;"
-        "   color: white;"
-        "   border: none;"
-        "   padding: 10px 20px;"
-        "   font-size: 16px;"
-        "   border-radius: 5px;"
-        "}"
-        "QPushButton:hover { background-color: #606060; }"
-    );
+    resetButton->setStyleSheet(UIUtils::buttonStyleSheet());
     QObject::connect(resetButton, &QPushButton::clicked, [glWidget]() {
         glWidget->resetView();
     });
@@ -129,17 +404,7 @@ inline QWidget* createCGALControlPanel(CGALGLWidget* glWidget, QLabel* infoLabel
     
     // 自适应视图按钮
     QPushButton *centerButton = new QPushButton("Center View");
-    centerButton->setStyleSheet(
-        "QPushButton {"
-        "   background-color: #505050;"
-        "   color: white;"
-        "   border: none;"
-        "   padding: 10px 20px;"
-        "   font-size: 16px;"
-        "   border-radius: 5px;"
-        "}"
-        "QPushButton:hover { background-color: #606060; }"
-    );
+    centerButton->setStyleSheet(UIUtils::buttonStyleSheet());
     QObject::connect(centerButton, &QPushButton::clicked, [glWidget]() {
         glWidget->centerView();
     });
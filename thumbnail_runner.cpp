@@ -0,0 +1,521 @@
+// thumbnail_runner.cpp
+#include "thumbnail_runner.h"
+#include "meshutils/my_traits.h"
+#include "meshutils/parallel_utils.h"
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QSurfaceFormat>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QColor>
+#include <QImage>
+#include <QDir>
+#include <QSet>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ThumbnailRunner {
+
+    namespace {
+
+        // 读取线程上准备好的绘制数据：三角形索引和归一化到原点处单位球内的顶点
+        struct PreparedMesh {
+            QString path;
+            bool ok = false;
+            std::vector<float> positions;
+            std::vector<float> normals;       // 仅平滑着色时计算
+            std::vector<unsigned int> indices;
+            size_t faces = 0;
+            double loadMs = 0.0;
+        };
+
+        PreparedMesh prepareMesh(const QString& path, bool smooth) {
+            PreparedMesh prepared;
+            prepared.path = path;
+            QElapsedTimer timer;
+            timer.start();
+
+            // OpenMesh的IOManager和各格式的读取器是全进程共享的单例，解析状态存在成员里，
+            // 只有解析本身串行，包围盒、三角化和法线仍在各读取线程上并行
+            static std::mutex readMutex;
+            Mesh mesh;
+            bool loaded;
+            {
+                std::lock_guard<std::mutex> lock(readMutex);
+                loaded = Mesh_doubleIO::load_mesh(mesh, path.toLocal8Bit().constData(), false);
+            }
+            if (!loaded || mesh.n_faces() == 0) {
+                return prepared;
+            }
+            prepared.faces = mesh.n_faces();
+
+            Mesh::Point min = mesh.point(*mesh.vertices_begin());
+            Mesh::Point max = min;
+            for (auto vh : mesh.vertices()) {
+                min.minimize(mesh.point(vh));
+                max.maximize(mesh.point(vh));
+            }
+            Mesh::Point center = (min + max) * 0.5;
+            double radius = 0.0;
+            for (auto vh : mesh.vertices()) {
+                radius = std::max(radius, (mesh.point(vh) - center).sqrnorm());
+            }
+            radius = radius > 0.0 ? std::sqrt(radius) : 1.0;
+
+            prepared.positions.resize(mesh.n_vertices() * 3);
+            for (auto vh : mesh.vertices()) {
+                Mesh::Point p = (mesh.point(vh) - center) / radius;
+                float* dst = &prepared.positions[3 * vh.idx()];
+                dst[0] = float(p[0]);
+                dst[1] = float(p[1]);
+                dst[2] = float(p[2]);
+            }
+
+            // 多边形按扇形三角化，与BaseGLWidget::prepareFaceIndices相同
+            prepared.indices.reserve(mesh.n_faces() * 3);
+            for (auto fh : mesh.faces()) {
+                auto fv_it = mesh.fv_ccwbegin(fh);
+                int vertexCount = mesh.valence(fh);
+                if (vertexCount < 3) continue;
+                unsigned int centerIdx = (*fv_it).idx();
+                ++fv_it;
+                unsigned int prevIdx = (*fv_it).idx();
+                ++fv_it;
+                for (int i = 2; i < vertexCount; i++, ++fv_it) {
+                    unsigned int currentIdx = (*fv_it).idx();
+                    prepared.indices.push_back(centerIdx);
+                    prepared.indices.push_back(prevIdx);
+                    prepared.indices.push_back(currentIdx);
+                    prevIdx = currentIdx;
+                }
+            }
+
+            // 面积加权的顶点法线
+            if (smooth) {
+                prepared.normals.assign(prepared.positions.size(), 0.0f);
+                const float* p = prepared.positions.data();
+                for (size_t t = 0; t + 2 < prepared.indices.size(); t += 3) {
+                    const unsigned int* tri = &prepared.indices[t];
+                    QVector3D a(p[3 * tri[0]], p[3 * tri[0] + 1], p[3 * tri[0] + 2]);
+                    QVector3D b(p[3 * tri[1]], p[3 * tri[1] + 1], p[3 * tri[1] + 2]);
+                    QVector3D c(p[3 * tri[2]], p[3 * tri[2] + 1], p[3 * tri[2] + 2]);
+                    QVector3D n = QVector3D::crossProduct(b - a, c - a);
+                    for (int k = 0; k < 3; ++k) {
+                        float* dst = &prepared.normals[3 * tri[k]];
+                        dst[0] += n.x();
+                        dst[1] += n.y();
+                        dst[2] += n.z();
+                    }
+                }
+                for (size_t i = 0; i < prepared.normals.size(); i += 3) {
+                    float* n = &prepared.normals[i];
+                    float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                    if (len > 0.0f) {
+                        n[0] /= len;
+                        n[1] /= len;
+                        n[2] /= len;
+                    }
+                }
+            }
+
+            prepared.ok = true;
+            prepared.loadMs = timer.nsecsElapsed() / 1e6;
+            return prepared;
+        }
+
+        // 离屏上下文、FBO和缓冲区在所有网格之间复用
+        class OffscreenRenderer : protected QOpenGLExtraFunctions {
+        public:
+            ~OffscreenRenderer() {
+                if (!context.isValid() || !context.makeCurrent(&surface)) return;
+                msaaFbo.reset();
+                resolveFbo.reset();
+                vao.destroy();
+                vbo.destroy();
+                nbo.destroy();
+                ebo.destroy();
+                context.doneCurrent();
+            }
+
+            bool initialize(const QSize& imageSize, int samples, bool smoothShading, QString& error) {
+                size = imageSize;
+                smooth = smoothShading;
+
+                // 着色器为#version 430 core，Mesa的llvmpipe在核心模式下支持
+                QSurfaceFormat format;
+                format.setVersion(4, 3);
+                format.setProfile(QSurfaceFormat::CoreProfile);
+                format.setDepthBufferSize(24);
+                context.setFormat(format);
+                if (!context.create()) {
+                    error = "Failed to create an OpenGL 4.3 core context";
+                    return false;
+                }
+                surface.setFormat(context.format());
+                surface.create();
+                if (!surface.isValid() || !context.makeCurrent(&surface)) {
+                    error = "Failed to make the offscreen context current";
+                    return false;
+                }
+                initializeOpenGLFunctions();
+
+                QOpenGLFramebufferObjectFormat fboFormat;
+                fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+                fboFormat.setSamples(samples);
+                fboFormat.setInternalTextureFormat(GL_RGBA8);
+                msaaFbo.reset(new QOpenGLFramebufferObject(size, fboFormat));
+                if (!msaaFbo->isValid()) {
+                    error = "Failed to create the framebuffer object";
+                    return false;
+                }
+                if (msaaFbo->format().samples() > 0) {
+                    resolveFbo.reset(new QOpenGLFramebufferObject(size));
+                }
+
+                // 与BaseGLWidget的平面着色和Blinn-Phong使用同一份着色器
+                if (smooth) {
+                    program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/blinnphong.vert");
+                    program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/blinnphong.frag");
+                } else {
+                    program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/glwidget/shaders/flat.vert");
+                    program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/glwidget/shaders/flat.frag");
+                }
+                if (!program.link()) {
+                    error = "Shader link failed: " + program.log();
+                    return false;
+                }
+
+                vao.create();
+                vbo.create();
+                nbo.create();
+                ebo.create();
+                glEnable(GL_DEPTH_TEST);
+                return true;
+            }
+
+            QString rendererName() {
+                return QString::fromLatin1(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+            }
+
+            // 缓冲区对象保留，每个网格只重新分配数据
+            void upload(const PreparedMesh& mesh) {
+                vao.bind();
+                vbo.bind();
+                vbo.allocate(mesh.positions.data(), int(mesh.positions.size() * sizeof(float)));
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+                if (smooth) {
+                    nbo.bind();
+                    nbo.allocate(mesh.normals.data(), int(mesh.normals.size() * sizeof(float)));
+                    glEnableVertexAttribArray(1);
+                    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+                }
+                ebo.bind();
+                ebo.allocate(mesh.indices.data(), int(mesh.indices.size() * sizeof(unsigned int)));
+                vao.release();
+                indexCount = GLsizei(mesh.indices.size());
+            }
+
+            // 网格已在单位球内：相机距离使球正好落在较窄方向的视场内
+            QImage render(float azimuth, float elevation) {
+                const float fov = 45.0f;
+                float aspect = size.width() / float(size.height());
+                float halfFov = qDegreesToRadians(fov) * 0.5f;
+                float halfFovX = std::atan(std::tan(halfFov) * aspect);
+                float distance = 1.05f / std::sin(std::min(halfFov, halfFovX));
+
+                QMatrix4x4 model, view, projection;
+                model.rotate(elevation, 1.0f, 0.0f, 0.0f);
+                model.rotate(azimuth, 0.0f, 1.0f, 0.0f);
+                view.lookAt(QVector3D(0, 0, distance), QVector3D(0, 0, 0), QVector3D(0, 1, 0));
+                projection.perspective(fov, aspect, std::max(0.01f, distance - 1.1f), distance + 1.1f);
+
+                // 与BaseGLWidget::paintGL相同的三个光源
+                QVector3D lightPositions[3] = {
+                    QVector3D(10.0f, 10.0f, -10.0f),
+                    QVector3D(-10.0f, 10.0f, -10.0f),
+                    QVector3D(0.0f, 0.0f, 10.0f)
+                };
+                QVector3D lightColors[3] = {
+                    QVector3D(1.0f, 1.0f, 1.0f),
+                    QVector3D(1.0f, 1.0f, 1.0f),
+                    QVector3D(1.0f, 1.0f, 1.0f)
+                };
+
+                msaaFbo->bind();
+                glViewport(0, 0, size.width(), size.height());
+                glClearColor(background.redF(), background.greenF(), background.blueF(), 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                program.bind();
+                vao.bind();
+                program.setUniformValue("model", model);
+                program.setUniformValue("view", view);
+                program.setUniformValue("projection", projection);
+                if (smooth) {
+                    program.setUniformValue("normalMatrix", model.normalMatrix());
+                }
+                for (int i = 0; i < 3; i++) {
+                    program.setUniformValue(QString("lightPositions[%1]").arg(i).toStdString().c_str(), lightPositions[i]);
+                    program.setUniformValue(QString("lightColors[%1]").arg(i).toStdString().c_str(), lightColors[i]);
+                }
+                program.setUniformValue("viewPos", QVector3D(0, 0, distance));
+                program.setUniformValue("objectColor", color);
+                program.setUniformValue("specularEnabled", true);
+                program.setUniformValue("faceColorsEnabled", false);
+                glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+                vao.release();
+                program.release();
+                msaaFbo->release();
+
+                if (resolveFbo) {
+                    QOpenGLFramebufferObject::blitFramebuffer(resolveFbo.get(), msaaFbo.get());
+                    return resolveFbo->toImage();
+                }
+                return msaaFbo->toImage();
+            }
+
+            QVector3D color = QVector3D(0.88f, 0.84f, 0.76f);
+            QColor background = QColor(0, 85, 127);
+
+        private:
+            QOffscreenSurface surface;
+            QOpenGLContext context;
+            std::unique_ptr<QOpenGLFramebufferObject> msaaFbo;
+            std::unique_ptr<QOpenGLFramebufferObject> resolveFbo;
+            QOpenGLShaderProgram program;
+            QOpenGLVertexArrayObject vao;
+            QOpenGLBuffer vbo = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+            QOpenGLBuffer nbo = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+            QOpenGLBuffer ebo = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+            GLsizei indexCount = 0;
+            QSize size;
+            bool smooth = false;
+        };
+
+        // "r,g,b"，各分量0~255
+        bool parseColor(const QString& text, QColor& color) {
+            QStringList parts = text.split(',');
+            if (parts.size() != 3) return false;
+            int rgb[3];
+            for (int i = 0; i < 3; ++i) {
+                bool ok = false;
+                rgb[i] = parts[i].trimmed().toInt(&ok);
+                if (!ok || rgb[i] < 0 || rgb[i] > 255) return false;
+            }
+            color = QColor(rgb[0], rgb[1], rgb[2]);
+            return true;
+        }
+
+    } // namespace
+
+    bool isThumbnailInvocation(int argc, char *argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--thumbnails") == 0) return true;
+        }
+        return false;
+    }
+
+    int run(int argc, char *argv[]) {
+        // 没有显示服务器时使用offscreen平台插件；EGL无窗口渲染可改设QT_QPA_PLATFORM=eglfs
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty("DISPLAY")
+            && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        QGuiApplication app(argc, argv);
+        QTextStream out(stdout);
+        QTextStream err(stderr);
+
+        QCommandLineParser parser;
+        parser.setApplicationDescription("Headless thumbnail rendering");
+        parser.addHelpOption();
+        parser.addPositionalArgument("output", "Output directory for the PNG files");
+        parser.addPositionalArgument("inputs", "Mesh files or directories of .obj/.off/.ply files", "<inputs...>");
+        QCommandLineOption thumbnailsOption("thumbnails", "Render thumbnails without GUI");
+        QCommandLineOption sizeOption("size", "Image size, N or WxH (default 512)", "size");
+        QCommandLineOption viewsOption("views", "Turntable views per mesh around the vertical axis (default 1)", "count");
+        QCommandLineOption azimuthOption("azimuth", "Azimuth of the first view in degrees (default 30)", "degrees");
+        QCommandLineOption elevationOption("elevation", "Camera elevation in degrees (default 20)", "degrees");
+        QCommandLineOption smoothOption("smooth", "Blinn-Phong shading with vertex normals instead of flat shading");
+        QCommandLineOption colorOption("color", "Surface colour r,g,b (0-255)", "rgb");
+        QCommandLineOption backgroundOption("background", "Background colour r,g,b (0-255)", "rgb");
+        QCommandLineOption samplesOption("samples", "MSAA samples (default 4, 0 = off)", "count");
+        QCommandLineOption prefetchOption("prefetch", "Meshes loaded ahead on worker threads while rendering (default 2, 0 = sequential)", "count");
+        parser.addOptions({thumbnailsOption, sizeOption, viewsOption, azimuthOption, elevationOption, smoothOption,
+                           colorOption, backgroundOption, samplesOption, prefetchOption});
+        parser.process(app);
+
+        const QStringList args = parser.positionalArguments();
+        if (args.size() < 2) {
+            err << "Expected <output> <inputs...>\n";
+            return 1;
+        }
+
+        QSize size(512, 512);
+        if (parser.isSet(sizeOption)) {
+            QStringList parts = parser.value(sizeOption).toLower().split('x');
+            int w = parts[0].toInt();
+            int h = parts.size() > 1 ? parts[1].toInt() : w;
+            if (w <= 0 || h <= 0) {
+                err << "Invalid --size " << parser.value(sizeOption) << '\n';
+                return 1;
+            }
+            size = QSize(w, h);
+        }
+        int views = parser.isSet(viewsOption) ? std::max(1, parser.value(viewsOption).toInt()) : 1;
+        float azimuth = parser.isSet(azimuthOption) ? parser.value(azimuthOption).toFloat() : 30.0f;
+        float elevation = parser.isSet(elevationOption) ? parser.value(elevationOption).toFloat() : 20.0f;
+        int samples = parser.isSet(samplesOption) ? std::max(0, parser.value(samplesOption).toInt()) : 4;
+        size_t prefetch = parser.isSet(prefetchOption) ? size_t(std::max(0, parser.value(prefetchOption).toInt())) : 2;
+        bool smooth = parser.isSet(smoothOption);
+
+        QColor surfaceColor(224, 214, 194);
+        QColor background(0, 85, 127);
+        if ((parser.isSet(colorOption) && !parseColor(parser.value(colorOption), surfaceColor))
+            || (parser.isSet(backgroundOption) && !parseColor(parser.value(backgroundOption), background))) {
+            err << "Colours must be given as r,g,b with components 0-255\n";
+            return 1;
+        }
+
+        // 目录按文件名排序展开
+        QStringList files;
+        for (int i = 1; i < args.size(); ++i) {
+            QFileInfo info(args[i]);
+            if (info.isDir()) {
+                QDir dir(args[i]);
+                for (const QString& name : dir.entryList({"*.obj", "*.off", "*.ply"}, QDir::Files, QDir::Name)) {
+                    files << dir.filePath(name);
+                }
+            } else {
+                files << args[i];
+            }
+        }
+        if (files.isEmpty()) {
+            err << "No input meshes\n";
+            return 1;
+        }
+        // 输出名取文件名去掉扩展名；重名时（不同目录下同名，或同名不同格式）依次加扩展名和序号，
+        // 按小写比较，避免在不区分大小写的文件系统上互相覆盖
+        QStringList outputNames;
+        QSet<QString> usedNames;
+        for (const QString& file : files) {
+            QFileInfo info(file);
+            QString name = info.completeBaseName();
+            if (usedNames.contains(name.toLower())) {
+                name = info.completeBaseName() + "_" + info.suffix();
+                for (int n = 2; usedNames.contains(name.toLower()); ++n) {
+                    name = QString("%1_%2_%3").arg(info.completeBaseName()).arg(info.suffix()).arg(n);
+                }
+            }
+            usedNames.insert(name.toLower());
+            outputNames << name;
+        }
+        QDir outputDir(args[0]);
+        if (!outputDir.mkpath(".")) {
+            err << "Cannot create output directory " << args[0] << '\n';
+            return 1;
+        }
+
+        OffscreenRenderer renderer;
+        QString error;
+        if (!renderer.initialize(size, samples, smooth, error)) {
+            err << error << '\n';
+            err << "On servers without a display try QT_QPA_PLATFORM=offscreen (under Xvfb) or QT_QPA_PLATFORM=eglfs, "
+                   "and LIBGL_ALWAYS_SOFTWARE=1 for Mesa llvmpipe\n";
+            return 1;
+        }
+        renderer.color = QVector3D(surfaceColor.redF(), surfaceColor.greenF(), surfaceColor.blueF());
+        renderer.background = background;
+        out << "Renderer: " << renderer.rendererName() << ", " << files.size() << " meshes, " << views
+            << " view(s) at " << size.width() << "x" << size.height() << '\n';
+
+        QElapsedTimer total;
+        total.start();
+
+        // 读取队列：当前网格之外最多预读prefetch个；prefetch为0时推迟到get()在本线程上读取
+        std::deque<std::future<PreparedMesh>> loads;
+        int next = 0;
+        auto launchLoads = [&]() {
+            while (next < files.size() && loads.size() < prefetch + 1) {
+                loads.push_back(std::async(prefetch > 0 ? std::launch::async : std::launch::deferred,
+                                           prepareMesh, files[next++], smooth));
+            }
+        };
+
+        // PNG编码在工作线程上进行，同时在途的数量不超过线程数
+        std::deque<std::future<bool>> writes;
+        size_t maxWrites = parallel::thread_count();
+        int writeFailures = 0;
+        auto drainWrites = [&](size_t keep) {
+            while (writes.size() > keep) {
+                if (!writes.front().get()) writeFailures++;
+                writes.pop_front();
+            }
+        };
+
+        int rendered = 0, failed = 0, images = 0;
+        int current = 0;   // 读取按文件顺序完成，与outputNames一一对应
+        double waitMs = 0.0, renderMs = 0.0;
+        launchLoads();
+        while (!loads.empty()) {
+            QElapsedTimer timer;
+            timer.start();
+            PreparedMesh mesh = loads.front().get();
+            loads.pop_front();
+            launchLoads();
+            waitMs += timer.nsecsElapsed() / 1e6;
+            QString baseName = outputNames[current++];
+
+            if (!mesh.ok) {
+                err << "Failed to load " << mesh.path << '\n';
+                failed++;
+                continue;
+            }
+
+            timer.restart();
+            renderer.upload(mesh);
+            for (int v = 0; v < views; ++v) {
+                QImage image = renderer.render(azimuth + 360.0f * v / views, elevation);
+                QString path = views == 1 ? outputDir.filePath(baseName + ".png")
+                                          : outputDir.filePath(QString("%1_%2.png").arg(baseName).arg(v, 3, 10, QChar('0')));
+                drainWrites(maxWrites - 1);
+                writes.push_back(std::async(std::launch::async, [image, path]() { return image.save(path, "PNG"); }));
+                images++;
+            }
+            double meshMs = timer.nsecsElapsed() / 1e6;
+            renderMs += meshMs;
+            rendered++;
+            out << QFileInfo(mesh.path).fileName() << ": " << mesh.faces << " faces, load " << mesh.loadMs
+                << " ms, render " << meshMs << " ms\n";
+        }
+        drainWrites(0);
+
+        double seconds = total.nsecsElapsed() / 1e9;
+        out << "Rendered " << rendered << " meshes (" << images << " images) in " << seconds << " s, "
+            << (seconds > 0.0 ? images / seconds : 0.0) << " images/s; waited " << waitMs << " ms for loading, "
+            << renderMs << " ms rendering\n";
+        if (failed > 0 || writeFailures > 0) {
+            err << failed << " meshes failed to load, " << writeFailures << " images failed to write\n";
+            return 1;
+        }
+        return 0;
+    }
+
+} // namespace ThumbnailRunner
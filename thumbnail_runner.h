@@ -0,0 +1,16 @@
+// thumbnail_runner.h
+#pragma once
+#ifndef THUMBNAIL_RUNNER_H
+#define THUMBNAIL_RUNNER_H
+
+// 无窗口缩略图模式：objViewer --thumbnails <输出目录> <网格或目录...>
+// 用QOffscreenSurface上的GL上下文和FBO渲染，着色器与BaseGLWidget相同（资源中的flat/blinnphong），
+// 所有网格共用一个上下文；下一个网格的读取与当前网格的渲染、PNG编码在不同线程上并行
+namespace ThumbnailRunner {
+    // 命令行中是否带有--thumbnails，需在创建QApplication之前判断
+    bool isThumbnailInvocation(int argc, char *argv[]);
+    // 执行渲染，返回进程退出码
+    int run(int argc, char *argv[]);
+}
+
+#endif // THUMBNAIL_RUNNER_H